@@ -0,0 +1,8 @@
+// The built-in per-frame uniforms, which are written once per frame and bound at the reserved set 3 by
+// plume::graphics::FrameUniforms. The layout must not change.
+layout (std140, set = 3, binding = 0) uniform pl_frame_uniforms
+{
+	float pl_time;			// seconds since the application started
+	vec2 pl_resolution;		// size of the window in pixels
+	vec2 pl_mouse;			// mouse position, normalized to [0..1]
+};
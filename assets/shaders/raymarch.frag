@@ -10,14 +10,10 @@ layout (location = 1) in vec2 vs_texcoord;
 // Outputs
 layout (location = 0) out vec4 o_color;
 
-layout(std430, push_constant) uniform push_constants
-{
-	float time;
-	vec2 mouse;
-} constants;
+#include "include/frame_uniforms.glsl"
 
 const float pi = 3.141592653589793;
-const uint MAX_STEPS = 128u;
+layout (constant_id = 0) const uint MAX_STEPS = 128u;
 const float MAX_TRACE_DISTANCE = 32.0;
 const float MIN_HIT_DISTANCE = 0.0001;
 
@@ -99,7 +95,7 @@ float noise(in vec2 p)
     return val * 0.5 + 0.5;
 }
 
-#define NUM_OCTAVES 7
+layout (constant_id = 1) const int NUM_OCTAVES = 7;
 
 float noise(in vec3 x)
 {
@@ -237,10 +233,10 @@ float sdf_blob(in vec3 p) {
  */
 vec2 map(in vec3 p)
 {
-	float t = constants.time;
+	float t = pl_time;
 	float s = sin(t);
 	float c = cos(t);
-    vec2 m = constants.mouse;
+    vec2 m = pl_mouse;
 
 	// Displacers
 	float freq = m.x;
@@ -328,8 +324,8 @@ float ambient_occlusion(in vec3 p, in vec3 n)
 void main()
 {
 	vec2 uv = vs_texcoord * 2.0 - 1.0;
-    float t = constants.time;
-	vec2 m = constants.mouse;
+    float t = pl_time;
+	vec2 m = pl_mouse;
 	float s = sin(t * 0.25);
 	float c = cos(t * 0.25);
 	float orbit = 8.0;
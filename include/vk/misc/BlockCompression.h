@@ -0,0 +1,105 @@
+/*
+*
+* MIT License
+*
+* Copyright(c) 2017 Michael Walczyk
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files(the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions :
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*
+*/
+
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <stdexcept>
+
+namespace plume
+{
+
+	namespace utils
+	{
+
+		//! The block-compressed encodings that can be decoded on the CPU. This is used as a fallback when a device
+		//! cannot sample a compressed format directly. Every format here uses 4x4 texel blocks.
+		enum class BlockFormat
+		{
+			BLOCK_BC1_RGB,		// 8 bytes per block, 1-bit "alpha" indices decode to opaque black
+			BLOCK_BC1_RGBA,		// 8 bytes per block, 1-bit alpha
+			BLOCK_BC2,			// 16 bytes per block, explicit 4-bit alpha
+			BLOCK_BC3,			// 16 bytes per block, interpolated alpha
+			BLOCK_BC4_UNORM,	// 8 bytes per block, single channel
+			BLOCK_BC4_SNORM,	// 8 bytes per block, single signed channel
+			BLOCK_BC5_UNORM,	// 16 bytes per block, two channels
+			BLOCK_BC5_SNORM,	// 16 bytes per block, two signed channels
+			BLOCK_BC7,			// 16 bytes per block, 8 modes
+			BLOCK_ETC2_RGB,		// 8 bytes per block
+			BLOCK_ETC2_RGB_A1,	// 8 bytes per block, punch-through alpha
+			BLOCK_ETC2_RGBA,	// 16 bytes per block, EAC alpha followed by ETC2 color
+			BLOCK_EAC_R,		// 8 bytes per block, single channel
+			BLOCK_EAC_RG		// 16 bytes per block, two channels
+		};
+
+		//! Trades encoding speed for quality. `QUALITY_FAST` fits endpoints to the bounding box of each block, 
+		//! `QUALITY_NORMAL` fits them along the principal axis and refines them once, and `QUALITY_HIGH` 
+		//! refines them repeatedly and searches additional modes (i.e. BC7 mode 1 partitions).
+		enum class EncodeQuality
+		{
+			QUALITY_FAST,
+			QUALITY_NORMAL,
+			QUALITY_HIGH
+		};
+
+		//! Returns the number of bytes occupied by a single 4x4 block of the specified format.
+		size_t get_block_size(BlockFormat format);
+
+		//! Returns `true` if the decoded texels of `format` should be interpreted as signed bytes (i.e. the 
+		//! fallback image should use a *_SNORM format).
+		inline bool is_signed_block_format(BlockFormat format)
+		{
+			return format == BlockFormat::BLOCK_BC4_SNORM || format == BlockFormat::BLOCK_BC5_SNORM;
+		}
+
+		//! Decodes a single block into 16 RGBA8 texels, stored row by row in `texels`. Channels that 
+		//! are not present in the encoding are written as 0 (color) or 255 (alpha), which matches what 
+		//! the sampler would return for the compressed format.
+		void decode_block(BlockFormat format, const uint8_t* block, uint8_t texels[64]);
+
+		//! Decodes a whole surface of `width` x `height` texels into RGBA8 texels, starting at `destination`, 
+		//! with rows `row_pitch` bytes apart. Partial blocks on the right and bottom edges are cropped. Rows of 
+		//! blocks are decoded in parallel on the worker pool.
+		void decode_blocks(BlockFormat format, const uint8_t* blocks, uint32_t width, uint32_t height, uint8_t* destination, size_t row_pitch);
+
+		//! Returns `true` if `encode_block()` supports the specified format: BC1, BC3, unsigned BC4/BC5, and BC7.
+		bool is_encodable_block_format(BlockFormat format);
+
+		//! Encodes 16 RGBA8 texels, stored row by row in `texels`, into a single block. BC4 encodes the red 
+		//! channel and BC5 the red and green channels. For BC1 with alpha, texels with alpha below 128 become
+		//! transparent. BC7 blocks are encoded with mode 6 (and mode 1 for opaque blocks at `QUALITY_HIGH`).
+		void encode_block(BlockFormat format, const uint8_t texels[64], uint8_t* block, EncodeQuality quality = EncodeQuality::QUALITY_NORMAL);
+
+		//! Encodes a surface of `width` x `height` RGBA8 texels, whose rows are `row_pitch` bytes apart, into 
+		//! `blocks`, which must hold `get_block_size(format)` bytes for every (partial) 4x4 block. Partial blocks 
+		//! along the right and bottom edges are padded by repeating the last column and row. Rows of blocks are 
+		//! encoded in parallel on the worker pool.
+		void encode_blocks(BlockFormat format, const uint8_t* source, uint32_t width, uint32_t height, size_t row_pitch, uint8_t* blocks, EncodeQuality quality = EncodeQuality::QUALITY_NORMAL);
+
+	} // namespace utils
+
+} // namespace plume
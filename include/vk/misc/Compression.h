@@ -0,0 +1,62 @@
+/*
+*
+* MIT License
+*
+* Copyright(c) 2017 Michael Walczyk
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files(the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions :
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*
+*/
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace plume
+{
+
+	namespace utils
+	{
+
+		//! General-purpose compression methods. LZ4 (block format) is implemented in-tree and is always 
+		//! available. Zstandard requires libzstd and is only available when the toolkit is built with
+		//! `PLUME_WITH_ZSTD` defined.
+		enum class CompressionMethod
+		{
+			COMPRESSION_NONE,
+			COMPRESSION_LZ4,
+			COMPRESSION_ZSTD
+		};
+
+		//! Returns `true` if this build can compress and decompress data with the specified method.
+		bool is_compression_supported(CompressionMethod method);
+
+		//! Compresses `size` bytes. `level` is only used by Zstandard (0 selects its default level). Throws if
+		//! the method is not supported.
+		std::vector<uint8_t> compress(CompressionMethod method, const uint8_t* src, size_t size, int level = 0);
+
+		//! Decompresses `src_size` bytes into exactly `dst_size` bytes at `dst`. Throws if the compressed data 
+		//! is malformed or does not decompress to exactly `dst_size` bytes.
+		void decompress(CompressionMethod method, const uint8_t* src, size_t src_size, uint8_t* dst, size_t dst_size);
+
+	} // namespace utils
+
+} // namespace plume
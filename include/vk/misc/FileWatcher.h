@@ -0,0 +1,106 @@
+/*
+*
+* MIT License
+*
+* Copyright(c) 2017 Michael Walczyk
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files(the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions :
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*
+*/
+
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <set>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace plume
+{
+
+	namespace fsys
+	{
+
+		//! Reports changes to a set of files on disk, i.e. shader sources that should be recompiled when they 
+		//! are saved. On Linux, the directories that contain the files are watched with inotify, so files that
+		//! editors save by writing a temporary file and renaming it over the original are still reported. On 
+		//! other platforms, the modification times of the files are compared every time the watcher is polled.
+		//!
+		//! The watcher never blocks: changes are collected by calling `poll()` (i.e. once per frame). All 
+		//! functions are thread-safe.
+		class FileWatcher
+		{
+		public:
+
+			//! Throws if the operating system's notification facility cannot be initialized.
+			FileWatcher();
+
+			FileWatcher(const FileWatcher& other) = delete;
+
+			FileWatcher& operator=(const FileWatcher& other) = delete;
+
+			~FileWatcher();
+
+			//! Starts watching the file at `path` (a path on disk). Watching a file more than once has no effect. 
+			//! Returns `false` if the file's directory cannot be watched (i.e. it does not exist), which is only 
+			//! detected with inotify.
+			bool watch(const std::string& path);
+
+			//! Stops watching the file at `path`.
+			void unwatch(const std::string& path);
+
+			//! Returns `true` if the file at `path` is being watched and `false` otherwise.
+			bool is_watched(const std::string& path) const;
+
+			//! Returns the paths of the watched files that have been written, created, or replaced since the last
+			//! call (each path is reported once, no matter how many times it changed). Never blocks.
+			std::vector<std::string> poll();
+
+		private:
+
+			//! Splits `path` into the directory that contains it (empty for the current directory) and its name.
+			static std::pair<std::string, std::string> split_path(const std::string& path);
+
+			//! The inverse of `split_path()`.
+			static std::string join_path(const std::string& directory, const std::string& name);
+
+			mutable std::mutex m_mutex;
+			std::set<std::string> m_paths;
+
+#if defined(__linux__)
+			int m_inotify_fd;
+
+			//! Maps each inotify watch descriptor to every spelling of the directory that it watches (inotify returns 
+			//! the same descriptor for i.e. "shaders" and "./shaders"), and each spelling back to its descriptor.
+			std::map<int, std::set<std::string>> m_watched_directories;
+			std::map<std::string, int> m_watch_descriptors;
+#else
+			//! The last modification time that was seen for each watched file (0 if it did not exist).
+			std::map<std::string, int64_t> m_modification_times;
+
+			static int64_t get_modification_time(const std::string& path);
+#endif
+		};
+
+	} // namespace fsys
+
+} // namespace plume
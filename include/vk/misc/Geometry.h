@@ -65,6 +65,47 @@ namespace plume
 
 		using VertexAttributeSet = std::vector<VertexAttribute>;
 
+		//! An interleaved vertex format that only contains the attributes that a vertex shader actually reads, 
+		//! packed in the order that they are added (see graphics::ShaderModule::get_vertex_format()). For example, a
+		//! depth prepass whose vertex shader only reads positions fetches 12 bytes per vertex instead of the 44 
+		//! bytes that every attribute takes.
+		class VertexFormat
+		{
+		public:
+
+			VertexFormat() :
+				m_stride(0)
+			{}
+
+			//! Adds `attribute`, which the shader reads from `location`, at the end of each vertex. Custom 
+			//! attributes are not supported, since Geometry has no data for them.
+			VertexFormat& attribute(uint32_t location, VertexAttribute attribute);
+
+			//! Adds a location that the shader declares but never reads. Vulkan still requires an attribute 
+			//! description for it, so it is pointed at the first 4 bytes of each vertex, which costs no extra 
+			//! vertex data (its value is never used).
+			VertexFormat& unread_location(uint32_t location);
+
+			//! Returns the attributes that are read, in the order that they are packed.
+			const VertexAttributeSet& get_attributes() const { return m_attributes; }
+
+			//! Returns the size of each vertex in bytes.
+			uint32_t get_stride() const { return m_stride; }
+
+			//! Returns the binding description of the single vertex buffer (or none if no attributes are read).
+			std::vector<vk::VertexInputBindingDescription> get_binding_descriptions(uint32_t binding = 0) const;
+
+			//! Returns one attribute description per location, all of which read from `binding`.
+			std::vector<vk::VertexInputAttributeDescription> get_attribute_descriptions(uint32_t binding = 0) const;
+
+		private:
+
+			VertexAttributeSet m_attributes;
+			std::vector<vk::VertexInputAttributeDescription> m_attribute_descriptions;
+			std::vector<uint32_t> m_unread_locations;
+			uint32_t m_stride;
+		};
+
 		class Geometry
 		{
 		public:
@@ -87,6 +128,10 @@ namespace plume
 			//! This is most useful for uploading vertex data into a buffer object.
 			std::vector<float> get_packed_vertex_attributes();
 
+			//! Same as above, but only packs the attributes in `format` (in its order), so that the vertex buffer
+			//! does not carry any data that the vertex shader does not read.
+			std::vector<float> get_packed_vertex_attributes(const VertexFormat& format) const;
+
 			//! Returns a vector containing all of this geometry's vertex positions.
 			const std::vector<glm::vec3>& get_positions() const { return m_positions; }
 
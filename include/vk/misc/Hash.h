@@ -0,0 +1,153 @@
+/*
+*
+* MIT License
+*
+* Copyright(c) 2017 Michael Walczyk
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files(the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions :
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*
+*/
+
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+namespace plume
+{
+
+	namespace utils
+	{
+
+		namespace detail
+		{
+
+			const uint64_t xxh_prime_1 = 0x9E3779B185EBCA87ULL;
+			const uint64_t xxh_prime_2 = 0xC2B2AE3D27D4EB4FULL;
+			const uint64_t xxh_prime_3 = 0x165667B19E3779F9ULL;
+			const uint64_t xxh_prime_4 = 0x85EBCA77C2B2AE63ULL;
+			const uint64_t xxh_prime_5 = 0x27D4EB2F165667C5ULL;
+
+			inline uint64_t rotl64(uint64_t x, int r) { return (x << r) | (x >> (64 - r)); }
+
+			inline uint64_t read64(const uint8_t* p) { uint64_t v; memcpy(&v, p, sizeof(v)); return v; }
+
+			inline uint32_t read32(const uint8_t* p) { uint32_t v; memcpy(&v, p, sizeof(v)); return v; }
+
+			inline uint64_t xxh_round(uint64_t acc, uint64_t input)
+			{
+				acc += input * xxh_prime_2;
+				acc = rotl64(acc, 31);
+				return acc * xxh_prime_1;
+			}
+
+			inline uint64_t xxh_merge_round(uint64_t acc, uint64_t val)
+			{
+				acc ^= xxh_round(0, val);
+				return acc * xxh_prime_1 + xxh_prime_4;
+			}
+
+		} // namespace detail
+
+		//! Computes the 64-bit xxHash (XXH64) of `size` bytes. This is used throughout the toolkit to build content
+		//! hashes (for caches, pack file indices, etc.), so the output must remain stable across platforms and runs.
+		//! Note that this assumes a little-endian host.
+		inline uint64_t hash_bytes(const void* data, size_t size, uint64_t seed = 0)
+		{
+			using namespace detail;
+
+			const uint8_t* p = reinterpret_cast<const uint8_t*>(data);
+			const uint8_t* const end = p + size;
+			uint64_t h64;
+
+			if (size >= 32)
+			{
+				const uint8_t* const limit = end - 32;
+				uint64_t v1 = seed + xxh_prime_1 + xxh_prime_2;
+				uint64_t v2 = seed + xxh_prime_2;
+				uint64_t v3 = seed;
+				uint64_t v4 = seed - xxh_prime_1;
+
+				do
+				{
+					v1 = xxh_round(v1, read64(p)); p += 8;
+					v2 = xxh_round(v2, read64(p)); p += 8;
+					v3 = xxh_round(v3, read64(p)); p += 8;
+					v4 = xxh_round(v4, read64(p)); p += 8;
+				} while (p <= limit);
+
+				h64 = rotl64(v1, 1) + rotl64(v2, 7) + rotl64(v3, 12) + rotl64(v4, 18);
+				h64 = xxh_merge_round(h64, v1);
+				h64 = xxh_merge_round(h64, v2);
+				h64 = xxh_merge_round(h64, v3);
+				h64 = xxh_merge_round(h64, v4);
+			}
+			else
+			{
+				h64 = seed + xxh_prime_5;
+			}
+
+			h64 += static_cast<uint64_t>(size);
+
+			while (p + 8 <= end)
+			{
+				h64 ^= xxh_round(0, read64(p));
+				h64 = rotl64(h64, 27) * xxh_prime_1 + xxh_prime_4;
+				p += 8;
+			}
+
+			if (p + 4 <= end)
+			{
+				h64 ^= static_cast<uint64_t>(read32(p)) * xxh_prime_1;
+				h64 = rotl64(h64, 23) * xxh_prime_2 + xxh_prime_3;
+				p += 4;
+			}
+
+			while (p < end)
+			{
+				h64 ^= (*p) * xxh_prime_5;
+				h64 = rotl64(h64, 11) * xxh_prime_1;
+				++p;
+			}
+
+			h64 ^= h64 >> 33;
+			h64 *= xxh_prime_2;
+			h64 ^= h64 >> 29;
+			h64 *= xxh_prime_3;
+			h64 ^= h64 >> 32;
+
+			return h64;
+		}
+
+		//! Computes the 64-bit hash of a string's characters.
+		inline uint64_t hash_string(const std::string& str, uint64_t seed = 0)
+		{
+			return hash_bytes(str.data(), str.size(), seed);
+		}
+
+		//! Mixes the hash `value` into `seed`, so that several hashes can be combined into a single key.
+		inline uint64_t hash_combine(uint64_t seed, uint64_t value)
+		{
+			return detail::xxh_merge_round(seed, value);
+		}
+
+	} // namespace utils
+
+} // namespace plume
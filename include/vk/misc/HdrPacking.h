@@ -0,0 +1,75 @@
+/*
+*
+* MIT License
+*
+* Copyright(c) 2017 Michael Walczyk
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files(the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions :
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*
+*/
+
+#pragma once
+
+#include <cstdint>
+
+#include "Platform.h"
+
+namespace plume
+{
+
+	namespace utils
+	{
+
+		//! Converts a 32-bit float to a 16-bit (IEEE 754 binary16) float, rounding to nearest even. Values
+		//! beyond the largest finite half (65504) become infinity.
+		uint16_t float_to_half(float value);
+
+		//! Converts a 16-bit float to a 32-bit float. The conversion is exact.
+		float half_to_float(uint16_t value);
+
+		//! Packs an RGB triplet into vk::Format::eB10G11R11UfloatPack32: unsigned floats with 6 (red and green)
+		//! or 5 (blue) mantissa bits and a 5-bit exponent each. Negative values and NaNs become 0, and values 
+		//! that are too large become the largest finite value.
+		uint32_t pack_b10g11r11(float r, float g, float b);
+
+		void unpack_b10g11r11(uint32_t packed, float rgb[3]);
+
+		//! Packs an RGB triplet into vk::Format::eE5B9G9R9UfloatPack32: 9-bit mantissas that share a single 
+		//! 5-bit exponent, as described in the Vulkan specification. Negative values and NaNs become 0.
+		uint32_t pack_e5b9g9r9(float r, float g, float b);
+
+		void unpack_e5b9g9r9(uint32_t packed, float rgb[3]);
+
+		//! Returns `true` if `pack_hdr_texels()` can produce the specified format: 
+		//! vk::Format::eR32G32B32A32Sfloat, vk::Format::eR16G16B16A16Sfloat, vk::Format::eB10G11R11UfloatPack32, 
+		//! or vk::Format::eE5B9G9R9UfloatPack32.
+		bool is_packed_hdr_format(vk::Format format);
+
+		//! Returns the number of bytes that each texel occupies in the specified HDR format (16, 8, or 4). 
+		//! Throws if `is_packed_hdr_format(format)` is `false`.
+		size_t get_packed_hdr_texel_size(vk::Format format);
+
+		//! Converts `count` float texels with `src_channels` channels each into the specified HDR format. Missing
+		//! color channels replicate the first channel and a missing alpha channel is 1. The 3-channel formats 
+		//! drop alpha. Uses F16C (see Simd.h) for float to half conversion when it is available.
+		void pack_hdr_texels(vk::Format format, const float* src, uint32_t src_channels, size_t count, void* dst);
+
+	} // namespace utils
+
+} // namespace plume
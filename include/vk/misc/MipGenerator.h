@@ -0,0 +1,115 @@
+/*
+*
+* MIT License
+*
+* Copyright(c) 2017 Michael Walczyk
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files(the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions :
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*
+*/
+
+#pragma once
+
+#include <vector>
+
+#include "ResourceManager.h"
+
+namespace plume
+{
+
+	namespace fsys
+	{
+
+		//! The reconstruction filter used to downsample each mipmap level. `FILTER_BOX` averages 2x2 texels, 
+		//! `FILTER_KAISER` is a Kaiser-windowed sinc (sharp, with little ringing), and `FILTER_LANCZOS` is a 
+		//! 3-lobed Lanczos filter (sharpest, but may ring around high-contrast edges).
+		enum class MipFilter
+		{
+			FILTER_BOX,
+			FILTER_KAISER,
+			FILTER_LANCZOS
+		};
+
+		//! Builds mipmap chains on the CPU, for formats that the device cannot blit and for offline cooking. 
+		//! Each level is filtered from the previous (unquantized) level in linear space. Rows are filtered in 
+		//! parallel on the worker pool. Once every level has been filtered, the levels are converted back to 
+		//! their storage format in parallel, one level per task.
+		class MipGenerator
+		{
+		public:
+
+			class Options
+			{
+			public:
+
+				Options() :
+					m_filter(MipFilter::FILTER_KAISER),
+					m_srgb(false),
+					m_preserve_alpha_coverage(false),
+					m_alpha_reference(0.5f),
+					m_max_levels(0)
+				{}
+
+				//! Sets the downsampling filter.
+				Options& filter(MipFilter filter) { m_filter = filter; return *this; }
+
+				//! Treat the color channels (but not alpha) of 8-bit images as sRGB-encoded, so that they are 
+				//! converted to linear space before filtering and back to sRGB afterwards. Ignored for HDR images.
+				Options& srgb(bool srgb = true) { m_srgb = srgb; return *this; }
+
+				//! Rescale the alpha channel of each level so that the fraction of texels with alpha above 
+				//! `alpha_reference` matches the base level. This keeps alpha-tested cutouts (foliage, fences) 
+				//! from thinning out and disappearing at a distance.
+				Options& preserve_alpha_coverage(float alpha_reference = 0.5f)
+				{
+					m_preserve_alpha_coverage = true;
+					m_alpha_reference = alpha_reference;
+					return *this;
+				}
+
+				//! Limits the number of levels produced (including the base level). By default, the chain 
+				//! continues down to 1x1.
+				Options& max_levels(uint32_t max_levels) { m_max_levels = max_levels; return *this; }
+
+			private:
+
+				MipFilter m_filter;
+				bool m_srgb;
+				bool m_preserve_alpha_coverage;
+				float m_alpha_reference;
+				uint32_t m_max_levels;
+
+				friend class MipGenerator;
+			};
+
+			//! Returns the full mipmap chain for `image`, starting with a copy of `image` itself. Every level 
+			//! has the same number of channels as `image`. The alpha channel is the last channel of 2 and
+			//! 4-channel images.
+			static std::vector<ImageResource> generate(const ImageResource& image, const Options& options = Options());
+
+			//! Same as above, for floating-point images.
+			static std::vector<ImageResourceHDR> generate(const ImageResourceHDR& image, const Options& options = Options());
+
+			//! Returns the number of levels in a full mipmap chain for an image of the specified dimensions.
+			static uint32_t get_level_count(uint32_t width, uint32_t height);
+		};
+
+	} // namespace fsys
+
+} // namespace plume
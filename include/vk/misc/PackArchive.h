@@ -0,0 +1,180 @@
+/*
+*
+* MIT License
+*
+* Copyright(c) 2017 Michael Walczyk
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files(the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions :
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*
+*/
+
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "Compression.h"
+#include "ResourceManager.h"
+
+namespace plume
+{
+
+	namespace fsys
+	{
+
+		//! A read-only archive that packs many asset files into a single file, so that loading them costs one
+		//! `open()` and one mapping instead of one per asset, and so that assets that are loaded together sit
+		//! next to each other on disk.
+		//!
+		//! The archive starts with a fixed-size header, followed by the entries' contents (each aligned to the
+		//! alignment given at build time), a table of entry names, and an index that is sorted by the hash of 
+		//! each entry's name (so lookups are a binary search). Entries can be stored uncompressed, in which case
+		//! `map_entry()` returns a view straight into the archive's mapping, or compressed with LZ4 / Zstandard
+		//! in independent chunks, which are decompressed in parallel on the worker pool.
+		//!
+		//! All multi-byte fields are little-endian. Entry names are relative to the directory that the archive
+		//! was built from, use '/' as a separator, and are matched exactly (after `normalize_path()`).
+		class PackArchive
+		{
+		public:
+
+			//! A file that will be added to an archive: `name` is the path that it will be looked up by, and 
+			//! `path` is the full path of the file on disk.
+			struct Source
+			{
+				std::string name;
+				std::string path;
+			};
+
+			//! Summary of an archive that was written by `build()`.
+			struct BuildStatistics
+			{
+				size_t entry_count = 0;
+				size_t compressed_entry_count = 0;
+				uint64_t raw_bytes = 0;
+				uint64_t stored_bytes = 0;
+				uint64_t archive_bytes = 0;
+			};
+
+			//! Maps the archive at `path` (a full path) and reads its index. Throws if the file is not a valid
+			//! archive.
+			explicit PackArchive(const std::string& path);
+
+			PackArchive(const PackArchive& other) = delete;
+
+			PackArchive& operator=(const PackArchive& other) = delete;
+
+			//! Returns `true` if the archive contains an entry called `name` and `false` otherwise.
+			bool contains(const std::string& name) const;
+
+			//! Returns the contents of the entry called `name`. Uncompressed entries are returned as views of 
+			//! the archive's mapping (no copy is made), and compressed entries are decompressed into a new host 
+			//! allocation. Either way, the returned resource keeps the archive's mapping alive. Throws if the 
+			//! entry does not exist or its data is malformed.
+			MappedFileResource map_entry(const std::string& name, MappedFileResource::AccessPattern access_pattern = MappedFileResource::AccessPattern::ACCESS_SEQUENTIAL) const;
+
+			//! Same as `map_entry()`, but always copies the contents into a FileResource.
+			FileResource read_entry(const std::string& name) const;
+
+			//! Asks the operating system to start reading the (stored) contents of the entry called `name` into the 
+			//! page cache, without waiting for the reads to complete. Does nothing if there is no such entry.
+			void prefetch_entry(const std::string& name) const;
+
+			//! Returns the uncompressed size of the entry called `name`, in bytes. Throws if it does not exist.
+			size_t get_entry_size(const std::string& name) const;
+
+			//! Returns the number of entries in the archive.
+			size_t get_entry_count() const { return m_entries.size(); }
+
+			//! Returns the names of all of the entries in the archive, in index order.
+			std::vector<std::string> get_entry_names() const;
+
+			//! Returns the full path of the archive.
+			const std::string& get_path() const { return m_mapping->get_path(); }
+
+			//! Decompresses every entry and compares it against the content hash that was recorded when the
+			//! archive was built. Returns the names of the entries that do not match (an empty list means that
+			//! the archive is intact).
+			std::vector<std::string> verify() const;
+
+			//! Converts `path` to the form that entry names are stored in: backslashes become forward slashes, 
+			//! "." components and leading or repeated separators are removed, and ".." components cancel out the
+			//! component before them (i.e. "./shaders/../common//noise.glsl" becomes "common/noise.glsl").
+			static std::string normalize_path(const std::string& path);
+
+			//! Returns the hash that the index is sorted by for the entry called `name` (which must already be
+			//! normalized).
+			static uint64_t hash_path(const std::string& name);
+
+			//! Writes an archive containing `sources` to `output_path`. Each entry is compressed with `method`
+			//! (`level` is forwarded to utils::compress()) unless that would save less than ~5% of its size, in 
+			//! which case it is stored uncompressed. Entries are aligned to `alignment` bytes, which must be a 
+			//! power of two and at least 16. Throws if two sources share a name or a source cannot be read.
+			static BuildStatistics build(const std::string& output_path,
+										 const std::vector<Source>& sources,
+										 utils::CompressionMethod method = utils::CompressionMethod::COMPRESSION_LZ4,
+										 int level = 0,
+										 size_t alignment = 16);
+
+			//! The size of the chunks that `build()` splits compressed entries into. Chunks are compressed and 
+			//! decompressed independently, which is what allows them to be processed in parallel.
+			static const uint32_t default_chunk_size = 256 * 1024;
+
+		private:
+
+			//! An entry in the archive's index, exactly as it is stored on disk.
+			struct Entry
+			{
+				uint64_t path_hash;
+				uint64_t offset;			// Offset of the entry's data from the start of the archive.
+				uint64_t stored_size;		// Number of bytes occupied in the archive (including the chunk table).
+				uint64_t size;				// Uncompressed size.
+				uint64_t content_hash;		// Hash of the uncompressed contents (see utils::hash_bytes()).
+				uint32_t name_offset;		// Offset of the entry's name in the name table.
+				uint32_t name_length;
+				uint32_t compression;		// A utils::CompressionMethod.
+				uint32_t chunk_count;		// Zero for uncompressed entries.
+				uint8_t reserved[8];
+			};
+
+			static_assert(sizeof(Entry) == 64, "Pack archive index entries must be 64 bytes");
+
+			//! Returns the index entry called `name` (which must already be normalized) or `nullptr`.
+			const Entry* find(const std::string& name) const;
+
+			//! Same as `find()`, but throws if there is no such entry.
+			const Entry& find_or_throw(const std::string& name) const;
+
+			std::string get_name(const Entry& entry) const;
+
+			//! Decompresses the chunks of `entry` into `dst`, which must hold `entry.size` bytes.
+			void decompress_entry(const Entry& entry, uint8_t* dst) const;
+
+			std::shared_ptr<const MappedFileResource> m_mapping;
+			std::vector<Entry> m_entries;
+			const char* m_names;
+			size_t m_names_size;
+			uint32_t m_chunk_size;
+		};
+
+	} // namespace fsys
+
+} // namespace plume
@@ -0,0 +1,153 @@
+/*
+*
+* MIT License
+*
+* Copyright(c) 2017 Michael Walczyk
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files(the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions :
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*
+*/
+
+#pragma once
+
+#include <algorithm>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "Hash.h"
+#include "ResourceManager.h"
+
+namespace plume
+{
+
+	namespace fsys
+	{
+
+		//! A reference-counted handle to a cached resource. While at least one handle to a resource is alive,
+		//! the cache will never evict it.
+		template<class T>
+		using CacheHandle = std::shared_ptr<const T>;
+
+		//! Counters exposed by the resource cache for telemetry. Byte counts refer to the size of the decoded
+		//! resources in host memory.
+		struct CacheStatistics
+		{
+			uint64_t hits = 0;				// Requests that were served without touching the filesystem.
+			uint64_t misses = 0;			// Requests that required reading (and possibly decoding) a file.
+			uint64_t deduplications = 0;	// Misses whose file contents matched a resource that was already resident.
+			uint64_t evictions = 0;			// Resources that were evicted to stay within the memory budget.
+			uint64_t bytes_loaded = 0;		// Total number of bytes decoded on misses.
+			uint64_t bytes_served = 0;		// Total number of bytes handed out on hits and deduplications.
+			uint64_t bytes_evicted = 0;		// Total number of bytes released by evictions.
+			size_t resident_bytes = 0;		// Number of bytes currently held by the cache.
+			size_t peak_resident_bytes = 0;	// The largest value that `resident_bytes` has reached.
+			size_t budget_bytes = 0;		// The configured CPU memory budget.
+			size_t resident_entries = 0;	// Number of unique resources currently held by the cache.
+		};
+
+		//! A content-addressed cache for decoded resources. Requests are keyed by the file name plus any load
+		//! options (i.e. `force_alpha`). On a miss, the file is memory-mapped and hashed: if another file with 
+		//! the same contents (and options) was already decoded, that resource is shared instead of decoding it
+		//! a second time.
+		//!
+		//! The cache tries to stay within a CPU memory budget. Once the budget is exceeded, resources that are
+		//! not referenced by any outstanding CacheHandle are evicted in least-recently-used order. Resources 
+		//! that are still referenced are never evicted, so the budget is a soft limit. All functions are
+		//! thread-safe.
+		class ResourceCache
+		{
+		public:
+
+			//! Constructs a cache with a CPU memory budget of `budget_bytes` (256 MB by default).
+			explicit ResourceCache(size_t budget_bytes = 256 * 1024 * 1024);
+
+			ResourceCache(const ResourceCache& other) = delete;
+
+			ResourceCache& operator=(const ResourceCache& other) = delete;
+
+			//! Returns the binary file at path `ResourceManager::default_path` + `file_name`, loading it if necessary.
+			CacheHandle<FileResource> load_binary_file(const std::string& file_name);
+
+			//! Returns the decoded image at path `ResourceManager::default_path` + `file_name`, loading it if necessary.
+			CacheHandle<ImageResource> load_image(const std::string& file_name, bool force_alpha = true);
+
+			//! Returns the decoded HDR image at path `ResourceManager::default_path` + `file_name`, loading it if necessary.
+			CacheHandle<ImageResourceHDR> load_image_hdr(const std::string& file_name, bool force_alpha = true);
+
+			//! Forgets any resources that were loaded from `file_name` (with any set of load options), so that the 
+			//! next request re-reads the file. Outstanding handles remain valid.
+			void invalidate(const std::string& file_name);
+
+			//! Sets the CPU memory budget and immediately evicts unreferenced resources if necessary.
+			void set_budget(size_t budget_bytes);
+
+			//! Returns the CPU memory budget, in bytes.
+			size_t get_budget() const;
+
+			//! Evicts unreferenced resources (least-recently-used first) until the resident size is at or below 
+			//! `target_bytes`. Returns the number of bytes that were released.
+			size_t trim(size_t target_bytes);
+
+			//! Evicts every unreferenced resource.
+			void clear() { trim(0); }
+
+			//! Returns a snapshot of the cache's counters.
+			CacheStatistics get_statistics() const;
+
+			//! Resets the hit, miss, and byte counters (but not the resident totals).
+			void reset_statistics();
+
+		private:
+
+			//! A single decoded resource, shared by every request key whose file contents hash to `content_hash`.
+			struct Entry
+			{
+				std::shared_ptr<const void> resource;
+				size_t size;
+				std::vector<std::string> keys;
+				std::list<uint64_t>::iterator lru_position;
+			};
+
+			//! Type-erased load path shared by all resource types. `decode` converts the mapped file into a 
+			//! resource and `size_of` reports the resource's host memory footprint.
+			template<class T, class DecodeFunc, class SizeFunc>
+			CacheHandle<T> load(const std::string& file_name, const std::string& options, DecodeFunc decode, SizeFunc size_of);
+
+			//! Marks `entry` as the most recently used resource. Must be called with `m_mutex` held.
+			void touch(Entry& entry);
+
+			//! Must be called with `m_mutex` held.
+			size_t trim_unlocked(size_t target_bytes);
+
+			static std::string build_key(const std::string& file_name, const std::string& options) { return file_name + '|' + options; }
+
+			mutable std::mutex m_mutex;
+			std::unordered_map<std::string, uint64_t> m_keys_to_content;
+			std::unordered_map<uint64_t, Entry> m_entries;
+			std::list<uint64_t> m_lru;
+			CacheStatistics m_statistics;
+		};
+
+	} // namespace fsys
+
+} // namespace plume
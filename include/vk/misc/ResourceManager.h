@@ -30,8 +30,11 @@
 #include <fstream>
 #include <string>
 #include <iostream>
+#include <limits>
+#include <memory>
 
-#include "shaderc/shaderc.hpp"
+#include "HdrPacking.h"
+#include "ThreadPool.h"
 
 namespace plume
 {
@@ -44,6 +47,108 @@ namespace plume
 			std::vector<uint8_t> contents;
 		};
 
+		//! Basic information about an encoded image file, which can be queried without decoding the file.
+		struct ImageInfo
+		{
+			uint32_t width;
+			uint32_t height;
+			uint32_t channels_in_file;
+			bool is_hdr;
+		};
+
+		//! A caller-provided block of memory that decoded pixels are written into: usually a mapped staging
+		//! buffer or the mapped memory of a linear image. Rows are `row_pitch` bytes apart, and `size` is the
+		//! total number of bytes that may be written (used for bounds checking).
+		struct PixelDestination
+		{
+			void* data;
+			size_t row_pitch;
+			size_t size;
+		};
+
+		//! A read-only view of a file that has been memory-mapped into the address space of this process. Pages
+		//! are faulted in lazily by the operating system, so the contents of the file are never copied into an
+		//! intermediate host allocation: consumers (shader modules, image decoders, upload paths) read straight
+		//! from the page cache. The mapping is released when this object is destroyed.
+		class MappedFileResource
+		{
+		public:
+
+			//! Hints passed to the operating system (via `madvise()` on POSIX systems) about how the mapped
+			//! range will be accessed.
+			enum class AccessPattern
+			{
+				ACCESS_NORMAL,
+				ACCESS_SEQUENTIAL,
+				ACCESS_RANDOM,
+				ACCESS_WILL_NEED,
+				ACCESS_DONT_NEED
+			};
+
+			MappedFileResource() = default;
+
+			//! Maps the entire file at `path` (note that this is a full path, not one relative to the
+			//! resource manager's default path). Throws if the file cannot be opened or mapped.
+			MappedFileResource(const std::string& path, AccessPattern access_pattern = AccessPattern::ACCESS_SEQUENTIAL);
+
+			//! Wraps memory that is owned by another object instead of a mapping of its own: i.e. an entry in a
+			//! pack archive, which is either a view into the archive's mapping or a decompressed copy. `owner` is 
+			//! kept alive for as long as the returned resource (or anything it is moved into) exists. Access hints 
+			//! (see `advise()`) are only forwarded to the operating system if `is_file_backed` is `true`, meaning 
+			//! that `data` points into a file mapping rather than into heap memory.
+			static MappedFileResource from_memory(const std::string& path, const uint8_t* data, size_t size, std::shared_ptr<const void> owner, bool is_file_backed);
+
+			~MappedFileResource();
+
+			MappedFileResource(const MappedFileResource& other) = delete;
+
+			MappedFileResource& operator=(const MappedFileResource& other) = delete;
+
+			MappedFileResource(MappedFileResource&& other) noexcept;
+
+			MappedFileResource& operator=(MappedFileResource&& other) noexcept;
+
+			//! Returns a pointer to the first byte of the mapping. The pointer is page-aligned (or, for pack archive
+			//! entries, aligned to at least 16 bytes), so it is safe to reinterpret it as a pointer to 32-bit words 
+			//! (i.e. SPIR-V).
+			const uint8_t* data() const { return m_data; }
+
+			//! Returns the size of the mapped file in bytes.
+			size_t size() const { return m_size; }
+
+			//! Returns `true` if the mapped file is empty (or nothing has been mapped) and `false` otherwise.
+			bool empty() const { return m_size == 0; }
+
+			const uint8_t* begin() const { return m_data; }
+
+			const uint8_t* end() const { return m_data + m_size; }
+
+			//! Returns the full path of the file that was mapped.
+			const std::string& get_path() const { return m_path; }
+
+			//! Advise the operating system about how the byte range [`offset`, `offset` + `length`) will be
+			//! accessed. By default, the hint applies to the entire mapping. This is a no-op on platforms that
+			//! do not support it.
+			void advise(AccessPattern access_pattern, size_t offset = 0, size_t length = 0) const;
+
+		private:
+
+			void release();
+
+			std::string m_path;
+			const uint8_t* m_data = nullptr;
+			size_t m_size = 0;
+
+			//! Set if this resource is a view of memory owned by another object (see `from_memory()`).
+			std::shared_ptr<const void> m_owner;
+			bool m_is_file_backed = true;
+
+#if defined(_WIN32)
+			void* m_file_handle = nullptr;
+			void* m_mapping_handle = nullptr;
+#endif
+		};
+
 		struct ImageResource
 		{
 			uint32_t width;
@@ -60,10 +165,59 @@ namespace plume
 			std::vector<float> contents;
 		};
 
+		//! A handle to a resource that is being loaded asynchronously. Handles are cheap to copy: all copies refer
+		//! to the same load. If the load fails (or is cancelled before it starts), the exception is rethrown by
+		//! `get()`.
+		template<class T>
+		class LoadHandle
+		{
+		public:
+
+			LoadHandle() = default;
+
+			LoadHandle(std::shared_future<T> future, utils::CancellationToken token) :
+				m_future(future),
+				m_token(token)
+			{}
+
+			//! Returns `true` if this handle refers to a load and `false` if it was default constructed.
+			bool is_valid() const { return m_future.valid(); }
+
+			//! Returns `true` if the load has finished (successfully or not) and `false` otherwise. Never blocks.
+			bool is_ready() const { return m_future.wait_for(std::chrono::seconds(0)) == std::future_status::ready; }
+
+			//! Blocks the calling thread until the load has finished.
+			void wait() const { m_future.wait(); }
+
+			//! Blocks the calling thread until the load has finished and returns the loaded resource.
+			const T& get() const { return m_future.get(); }
+
+			//! Requests cancellation of the load. A load that has not started yet will be skipped entirely, and a
+			//! load that is in progress will be abandoned between the I/O and decode steps.
+			void cancel() const { m_token.cancel(); }
+
+			//! Returns `true` if cancellation has been requested and `false` otherwise.
+			bool is_cancelled() const { return m_token.is_cancelled(); }
+
+		private:
+
+			std::shared_future<T> m_future;
+			utils::CancellationToken m_token;
+		};
+
+		class ResourceCache;
+
+		class VirtualFileSystem;
+
 		class ResourceManager
 		{
 		public:
 
+			//! A callback that is invoked on the thread that calls `process_uploads()` once an asynchronous load 
+			//! has finished, i.e. to copy the decoded resource into a buffer or image.
+			template<class T>
+			using UploadFuncType = std::function<void(const T&)>;
+
 			static std::string default_path;
 
 			static ResourceManager& resource_manager()
@@ -75,22 +229,126 @@ namespace plume
 			//! Sets the base path that will be used for loading assets. This is "../assets/" by default.
 			static void set_default_path(const std::string& path) { default_path = path; }
 
-			//! Loads a binary file at path `ResourceManager::default_path` + `file_name`.
+			//! Returns the virtual file system that every function taking a file name resolves it through. It 
+			//! starts out with `ResourceManager::default_path` mounted at the lowest possible priority, so any 
+			//! directory, pack archive, or in-memory overlay that is mounted on top of it takes precedence. If no
+			//! mount point contains a file, it is looked up at `ResourceManager::default_path` + `file_name`.
+			static VirtualFileSystem& get_file_system();
+
+			//! Queues `file_names` to be read into the page cache on a background thread, so that loading them 
+			//! later does not stall on the disk (see VirtualFileSystem::prefetch()).
+			static void prefetch(const std::vector<std::string>& file_names);
+
+			//! Loads a binary file at path `ResourceManager::default_path` + `file_name` (or from a mount point).
 			static FileResource load_binary_file(const std::string& file_name);
 
+			//! Memory-maps a file at path `ResourceManager::default_path` + `file_name` (or returns a view of it from
+			//! a mount point). Unlike `load_binary_file()`, the contents of the file are not copied into a host 
+			//! allocation unless they are stored compressed.
+			static MappedFileResource map_file(const std::string& file_name, MappedFileResource::AccessPattern access_pattern = MappedFileResource::AccessPattern::ACCESS_SEQUENTIAL);
+
+			//! Creates the directory at `path` along with any missing parents. Unlike the functions that load files,
+			//! this takes a path on disk rather than a name relative to `ResourceManager::default_path`.
+			static void create_directories(const std::string& path);
+
+			//! Writes `size` bytes to the file at `path` (a path on disk) by writing a temporary file and renaming it
+			//! into place, so that a concurrent or interrupted write never leaves a partial file behind. Returns 
+			//! `false` if the file could not be written.
+			static bool write_file_atomic(const std::string& path, const void* data, size_t size);
+
 			//! Loads an image file at path `ResourceManager::default_path` + `file_name`.
 			static ImageResource load_image(const std::string& file_name, bool force_alpha = true);
 
+			//! Decodes an image file that has already been mapped into memory.
+			static ImageResource load_image(const MappedFileResource& mapped, bool force_alpha = true);
+
 			//! Loads an HDR (floating-point) image file at path `ResourceManager::default_path` + `file_name`.
 			static ImageResourceHDR load_image_hdr(const std::string& file_name, bool force_alpha = true);
 
+			//! Returns the dimensions and channel count of an image file without decoding it. This can be used to 
+			//! size a staging buffer before calling `decode_image()` or `decode_image_hdr()`.
+			static ImageInfo get_image_info(const MappedFileResource& mapped);
+
+			//! Decodes an image file straight into `destination`, honoring its row pitch. Each texel is written as 
+			//! 4 (`force_alpha` = true) or 3 8-bit channels. The decoder's output is expanded and written in a 
+			//! single pass that is split into strips of rows across the worker pool, so the pixels are never 
+			//! copied into an intermediate ImageResource. Returns the decoded image's info.
+			static ImageInfo decode_image(const MappedFileResource& mapped, const PixelDestination& destination, bool force_alpha = true);
+
+			//! Same as `decode_image()`, but each channel is written as a 32-bit float.
+			static ImageInfo decode_image_hdr(const MappedFileResource& mapped, const PixelDestination& destination, bool force_alpha = true);
+
+			//! Same as `decode_image()`, but each texel is converted to `format` as it is written: 
+			//! vk::Format::eR16G16B16A16Sfloat, vk::Format::eB10G11R11UfloatPack32, or vk::Format::eE5B9G9R9UfloatPack32
+			//! (see utils::pack_hdr_texels()). These take 1/2 to 1/4 of the memory of 32-bit float RGBA.
+			static ImageInfo decode_image_hdr(const MappedFileResource& mapped, const PixelDestination& destination, vk::Format format);
+
+			//! Converts an HDR image that has already been decoded into `format`, writing it straight into `destination`.
+			static void pack_image_hdr(const ImageResourceHDR& image, const PixelDestination& destination, vk::Format format);
+
+			//! Decodes an HDR (floating-point) image file that has already been mapped into memory.
+			static ImageResourceHDR load_image_hdr(const MappedFileResource& mapped, bool force_alpha = true);
+
+			//! Loads a binary file on a worker thread. If `on_loaded` is provided, it will be queued for execution 
+			//! by `process_uploads()` once the load has finished.
+			static LoadHandle<FileResource> load_binary_file_async(const std::string& file_name,
+																   utils::TaskPriority priority = utils::TaskPriority::PRIORITY_NORMAL,
+																   UploadFuncType<FileResource> on_loaded = {});
+
+			//! Reads and decodes an image file on a worker thread. If `on_loaded` is provided, it will be queued 
+			//! for execution by `process_uploads()` once the image has been decoded.
+			static LoadHandle<ImageResource> load_image_async(const std::string& file_name,
+															  bool force_alpha = true,
+															  utils::TaskPriority priority = utils::TaskPriority::PRIORITY_NORMAL,
+															  UploadFuncType<ImageResource> on_loaded = {});
+
+			//! Reads and decodes an HDR (floating-point) image file on a worker thread. If `on_loaded` is provided, 
+			//! it will be queued for execution by `process_uploads()` once the image has been decoded.
+			static LoadHandle<ImageResourceHDR> load_image_hdr_async(const std::string& file_name,
+																	 bool force_alpha = true,
+																	 utils::TaskPriority priority = utils::TaskPriority::PRIORITY_NORMAL,
+																	 UploadFuncType<ImageResourceHDR> on_loaded = {});
+
+			//! Invokes the upload callbacks of (at most `max_uploads`) asynchronous loads that have finished, in 
+			//! the order that the loads were requested. Loads that are still in flight are skipped. This should be 
+			//! called regularly (i.e. once per frame) from the thread that records GPU work. Callbacks belonging to loads that failed or were cancelled 
+			//! are discarded. Returns the number of callbacks that were invoked.
+			static size_t process_uploads(size_t max_uploads = std::numeric_limits<size_t>::max());
+
+			//! Returns the number of asynchronous loads whose upload callbacks have not been invoked yet.
+			static size_t get_pending_upload_count();
+
+			//! Returns the cache shared by the entire application. Loads that go through the cache are deduplicated
+			//! and kept resident (within the cache's memory budget) until they are no longer referenced.
+			static ResourceCache& get_cache();
+
+			//! Returns the worker pool that performs all asynchronous I/O and decoding.
+			static utils::ThreadPool& get_thread_pool() { return utils::ThreadPool::global(); }
+
 			ResourceManager(const ResourceManager& other) = delete;
 
 			ResourceManager& operator=(const ResourceManager& other) = delete;
 
 		private:
 
+			//! An entry in the upload queue: `is_ready` polls the underlying future, and `run` invokes the 
+			//! user's callback (returning `false` if the load did not succeed).
+			struct PendingUpload
+			{
+				std::function<bool()> is_ready;
+				std::function<bool()> run;
+			};
+
 			ResourceManager() = default;
+
+			//! Runs `loader` on the worker pool and (optionally) registers `on_loaded` with the upload queue.
+			template<class T>
+			static LoadHandle<T> load_async(std::function<T(const utils::CancellationToken&)> loader,
+											utils::TaskPriority priority,
+											UploadFuncType<T> on_loaded);
+
+			std::mutex m_upload_mutex;
+			std::deque<PendingUpload> m_pending_uploads;
 		};
 
 	} // namespace fsys
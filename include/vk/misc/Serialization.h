@@ -0,0 +1,104 @@
+/*
+*
+* MIT License
+*
+* Copyright(c) 2017 Michael Walczyk
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files(the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions :
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*
+*/
+
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+namespace plume
+{
+
+	namespace utils
+	{
+
+		//! Helpers for the simple binary formats of the toolkit's on-disk caches (i.e. the shader cache and the
+		//! reflection cache). Values are written in host byte order, and strings as a 32-bit length followed by the
+		//! characters. The `consume` functions read from [`it`, `end`), advance `it`, and return `false` (rather
+		//! than throwing) if there aren't enough bytes, so that a truncated or corrupt entry is simply a cache miss.
+		namespace serialization
+		{
+
+			//! Appends the bytes of a trivially copyable value to `buffer`.
+			template<class T>
+			void append(std::string& buffer, const T& value)
+			{
+				buffer.append(reinterpret_cast<const char*>(&value), sizeof(T));
+			}
+
+			//! Appends a string to `buffer` as a 32-bit length followed by the characters.
+			inline void append_string(std::string& buffer, const std::string& value)
+			{
+				append(buffer, static_cast<uint32_t>(value.size()));
+				buffer += value;
+			}
+
+			//! Reads a value of type T.
+			template<class T>
+			bool consume(const uint8_t*& it, const uint8_t* end, T& value)
+			{
+				if (static_cast<size_t>(end - it) < sizeof(T))
+				{
+					return false;
+				}
+				memcpy(&value, it, sizeof(T));
+				it += sizeof(T);
+				return true;
+			}
+
+			//! Reads a string written by `append_string()`.
+			inline bool consume_string(const uint8_t*& it, const uint8_t* end, std::string& value)
+			{
+				uint32_t length;
+				if (!consume(it, end, length) || static_cast<size_t>(end - it) < length)
+				{
+					return false;
+				}
+				value.assign(reinterpret_cast<const char*>(it), length);
+				it += length;
+				return true;
+			}
+
+			//! Returns `true` if `count` elements of at least `min_element_size` bytes each could fit in the rest of the 
+			//! entry. Check every count read from disk with this before allocating, so that a corrupt entry cannot 
+			//! trigger a huge allocation.
+			inline bool fits_count(const uint8_t* it, const uint8_t* end, size_t min_element_size, uint32_t count)
+			{
+				return count <= static_cast<size_t>(end - it) / min_element_size;
+			}
+
+			//! Reads a list count, rejecting counts that could not possibly fit in the rest of the entry.
+			inline bool consume_count(const uint8_t*& it, const uint8_t* end, size_t min_element_size, uint32_t& count)
+			{
+				return consume(it, end, count) && fits_count(it, end, min_element_size, count);
+			}
+
+		} // namespace serialization
+
+	} // namespace utils
+
+} // namespace plume
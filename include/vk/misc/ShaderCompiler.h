@@ -0,0 +1,355 @@
+/*
+*
+* MIT License
+*
+* Copyright(c) 2017 Michael Walczyk
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files(the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions :
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*
+*/
+
+#pragma once
+
+#include <atomic>
+#include <map>
+#include <mutex>
+#include <set>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "shaderc/shaderc.hpp"
+
+#include "Platform.h"
+#include "ResourceManager.h"
+
+namespace plume
+{
+
+	namespace fsys
+	{
+
+		//! Optimization levels that are forwarded to shaderc. OPTIMIZATION_PERFORMANCE runs the spirv-opt 
+		//! performance passes (inlining, dead code elimination, constant folding, etc.), while OPTIMIZATION_SIZE 
+		//! runs the passes that shrink the binary.
+		enum class ShaderOptimization
+		{
+			OPTIMIZATION_NONE,
+			OPTIMIZATION_SIZE,
+			OPTIMIZATION_PERFORMANCE
+		};
+
+		//! A file that a shader was compiled from: its name (which can be passed to ResourceManager::map_file())
+		//! and the hash of its contents at the time of compilation.
+		struct ShaderDependency
+		{
+			std::string name;
+			uint64_t content_hash;
+		};
+
+		//! The include graph of one or more shaders. An edge from A to B means that A contains an `#include` 
+		//! directive that was resolved to B. Files are identified by the names that ShaderDependency uses.
+		class ShaderIncludeGraph
+		{
+		public:
+
+			void add_edge(const std::string& includer, const std::string& included);
+
+			//! Adds every edge of `other` to this graph.
+			void merge(const ShaderIncludeGraph& other);
+
+			//! Returns the files that `file_name` includes directly.
+			std::vector<std::string> get_includes(const std::string& file_name) const;
+
+			//! Returns the files that include `file_name` directly.
+			std::vector<std::string> get_includers(const std::string& file_name) const;
+
+			//! Returns every file that `file_name` includes, directly or indirectly.
+			std::vector<std::string> get_transitive_includes(const std::string& file_name) const;
+
+			//! Returns every file that includes `file_name`, directly or indirectly: i.e. every file that has to be
+			//! recompiled when `file_name` changes.
+			std::vector<std::string> get_transitive_includers(const std::string& file_name) const;
+
+			//! Returns every edge as an (includer, included) pair, sorted by includer.
+			std::vector<std::pair<std::string, std::string>> get_edges() const;
+
+			bool empty() const { return m_includes.empty(); }
+
+		private:
+
+			//! Walks the graph breadth-first from `file_name` along `adjacency`.
+			static std::vector<std::string> traverse(const std::map<std::string, std::set<std::string>>& adjacency, const std::string& file_name);
+
+			std::map<std::string, std::set<std::string>> m_includes;
+			std::map<std::string, std::set<std::string>> m_includers;
+		};
+
+		//! The result of compiling a GLSL shader to SPIR-V.
+		struct ShaderBinary
+		{
+			std::vector<uint32_t> code;
+			vk::ShaderStageFlagBits stage;
+
+			//! The source file (if it was compiled from a file) followed by every file that it included, directly
+			//! or indirectly, in the order that they were first included.
+			std::vector<ShaderDependency> dependencies;
+
+			//! How the dependencies include one another. The root of the graph is the name of the source file (or
+			//! the source name given to ShaderCompiler::compile_source()).
+			ShaderIncludeGraph include_graph;
+
+			//! If debug info was stripped from `code` (see ShaderCompiler::Options::strip_debug_info()), the SPIR-V
+			//! before stripping, which still names every variable, block member, and specialization constant so 
+			//! that it can be used for reflection. Empty otherwise.
+			std::vector<uint32_t> reflection_code;
+
+			//! `true` if the SPIR-V was read from the on-disk cache rather than compiled.
+			bool from_cache;
+		};
+
+		//! Counters exposed by the shader compiler for telemetry.
+		struct ShaderCompilerStatistics
+		{
+			uint64_t cache_hits = 0;		// Requests that were served from the on-disk cache.
+			uint64_t cache_misses = 0;		// Requests that had to be compiled (including those with the cache disabled).
+			uint64_t cache_writes = 0;		// Compiled shaders that were written to the on-disk cache.
+		};
+
+		//! The result of compiling a batch of shaders (see ShaderCompiler::compile_batch()).
+		struct ShaderBatchResult
+		{
+			//! One binary per job, in the order that the jobs were given. The binaries of jobs that failed are empty.
+			std::vector<ShaderBinary> binaries;
+
+			//! One entry per job: the compiler's diagnostics if the job failed, or an empty string otherwise.
+			std::vector<std::string> errors;
+
+			size_t failure_count = 0;
+
+			//! The time that the batch took from start to finish.
+			double wall_seconds = 0.0;
+
+			//! The sum of the times that the individual jobs took, i.e. roughly the time that the batch would have
+			//! taken if it had been compiled on a single thread.
+			double serial_seconds = 0.0;
+
+			bool succeeded() const { return failure_count == 0; }
+
+			//! Throws a single exception whose message lists the diagnostics of every job that failed (if any).
+			void throw_if_failed() const;
+		};
+
+		//! Compiles GLSL shaders to SPIR-V at runtime with shaderc. Source files (and the files that they 
+		//! `#include`) are read through ResourceManager, so they are resolved against its virtual file system.
+		//!
+		//! If a cache directory is provided, every compiled shader is stored on disk, along with the name and
+		//! content hash of each file that it depends on. The entry is looked up by a hash of the file name, stage,
+		//! and compile options (defines, include directories, optimization level, etc.). When a shader is requested 
+		//! again, the recorded dependencies are re-hashed: if none of them have changed, the cached SPIR-V is
+		//! returned without invoking the compiler at all, and otherwise only that shader is recompiled.
+		class ShaderCompiler
+		{
+		public:
+
+			class Options
+			{
+			public:
+
+				Options() :
+					m_optimization(ShaderOptimization::OPTIMIZATION_NONE),
+					m_generate_debug_info(false),
+					m_strip_debug_info(false),
+					m_warnings_as_errors(false)
+				{}
+
+				//! Returns options for fast shaders: the performance passes, with names kept for debugging tools.
+				static Options performance_preset()
+				{
+					return Options().optimization(ShaderOptimization::OPTIMIZATION_PERFORMANCE);
+				}
+
+				//! Returns options for small shaders in release builds: the size passes, with all debug info 
+				//! (including names) stripped.
+				static Options size_preset()
+				{
+					return Options().optimization(ShaderOptimization::OPTIMIZATION_SIZE).strip_debug_info();
+				}
+
+				//! Adds a preprocessor macro, as if by `#define name value`.
+				Options& define(const std::string& name, const std::string& value = "")
+				{
+					m_defines[name] = value;
+					return *this;
+				}
+
+				//! Adds a directory (relative to the root of the virtual file system) that `#include <...>` 
+				//! directives are resolved against. Directories are searched in the order that they were added.
+				Options& include_directory(const std::string& directory)
+				{
+					m_include_directories.push_back(directory);
+					return *this;
+				}
+
+				Options& optimization(ShaderOptimization optimization)
+				{
+					m_optimization = optimization;
+					return *this;
+				}
+
+				Options& generate_debug_info(bool generate_debug_info = true)
+				{
+					m_generate_debug_info = generate_debug_info;
+					return *this;
+				}
+
+				//! Strips all debug instructions (names, source text, and line information) from the compiled SPIR-V 
+				//! with spirv-tools. Reflection still sees the names: the unstripped SPIR-V is kept alongside the 
+				//! stripped code (see ShaderBinary::reflection_code), and ShaderModule reflects it instead.
+				Options& strip_debug_info(bool strip_debug_info = true)
+				{
+					m_strip_debug_info = strip_debug_info;
+					return *this;
+				}
+
+				Options& warnings_as_errors(bool warnings_as_errors = true)
+				{
+					m_warnings_as_errors = warnings_as_errors;
+					return *this;
+				}
+
+				//! Returns a hash of every option, which forms part of each cache key.
+				uint64_t hash() const;
+
+			private:
+
+				// Sorted, so that the order in which macros are defined does not change the hash.
+				std::map<std::string, std::string> m_defines;
+				std::vector<std::string> m_include_directories;
+				ShaderOptimization m_optimization;
+				bool m_generate_debug_info;
+				bool m_strip_debug_info;
+				bool m_warnings_as_errors;
+
+				friend class ShaderCompiler;
+			};
+
+			//! A single shader in a batch: a file name, its stage, and the options (i.e. defines) to compile it with.
+			struct Job
+			{
+				//! Infers the stage from the extension of `file_name` (see `infer_stage()`).
+				Job(const std::string& file_name, const Options& options = Options()) :
+					file_name(file_name),
+					stage(infer_stage(file_name)),
+					options(options)
+				{}
+
+				Job(const std::string& file_name, vk::ShaderStageFlagBits stage, const Options& options = Options()) :
+					file_name(file_name),
+					stage(stage),
+					options(options)
+				{}
+
+				std::string file_name;
+				vk::ShaderStageFlagBits stage;
+				Options options;
+			};
+
+			//! Constructs a compiler that caches SPIR-V in `cache_directory` (a path on disk, which is created if 
+			//! it does not exist). If `cache_directory` is empty, every request is compiled from scratch. All of the
+			//! compiler's functions are thread-safe.
+			explicit ShaderCompiler(const std::string& cache_directory = "");
+
+			ShaderCompiler(const ShaderCompiler& other) = delete;
+
+			ShaderCompiler& operator=(const ShaderCompiler& other) = delete;
+
+			//! Compiles the GLSL file called `file_name`, inferring its stage from its extension (see 
+			//! `infer_stage()`). Throws if the stage cannot be inferred or the shader fails to compile, in which 
+			//! case the exception's message contains the compiler's diagnostics.
+			ShaderBinary compile_file(const std::string& file_name, const Options& options = Options());
+
+			//! Same as above, but with an explicit stage.
+			ShaderBinary compile_file(const std::string& file_name, vk::ShaderStageFlagBits stage, const Options& options = Options());
+
+			//! Compiles GLSL source code held in memory. `source_name` is used in diagnostics and as the base for
+			//! resolving relative `#include` directives.
+			ShaderBinary compile_source(const std::string& source, const std::string& source_name, vk::ShaderStageFlagBits stage, const Options& options = Options());
+
+			//! Compiles every job in `jobs` across the worker pool (the calling thread participates as well). Each
+			//! worker thread uses its own instance of the underlying compiler. A job that fails does not affect 
+			//! the others: its diagnostics are collected in the result, which keeps the order of `jobs`.
+			ShaderBatchResult compile_batch(const std::vector<Job>& jobs);
+
+			//! Infers a shader stage from the extension of `file_name`: ".vert", ".tesc", ".tese", ".geom", ".frag",
+			//! or ".comp", optionally followed by ".glsl" (i.e. "shader.frag.glsl"). Throws for any other extension.
+			static vk::ShaderStageFlagBits infer_stage(const std::string& file_name);
+
+			//! Returns `true` if compiled shaders are cached on disk and `false` otherwise.
+			bool is_cache_enabled() const { return !m_cache_directory.empty(); }
+
+			//! Returns the directory that compiled shaders are cached in (which is empty if caching is disabled).
+			const std::string& get_cache_directory() const { return m_cache_directory; }
+
+			//! Returns a snapshot of the compiler's counters.
+			ShaderCompilerStatistics get_statistics() const;
+
+			//! Returns the merged include graph of every shader that this compiler has compiled (or read from its
+			//! cache) so far.
+			ShaderIncludeGraph get_include_graph() const;
+
+			//! Returns the names of the shaders compiled so far that depend on `file_name`, directly or through
+			//! includes (including `file_name` itself, if it is a shader). These are the shaders that need to be 
+			//! requested again after `file_name` changes: their cache entries will be found to be stale and they 
+			//! will be recompiled, while every other shader keeps being served from the cache.
+			std::vector<std::string> get_dependent_shaders(const std::string& file_name) const;
+
+		private:
+
+			//! Shared implementation of `compile_file()` and `compile_source()`. If `source` is `nullptr`, the
+			//! source is read from the file called `source_name`.
+			ShaderBinary compile(const std::string& source_name, const std::string* source, vk::ShaderStageFlagBits stage, const Options& options);
+
+			//! Returns the path of the cache entry for `cache_key`.
+			std::string get_cache_path(uint64_t cache_key) const;
+
+			//! Reads the cache entry for `cache_key` into `binary`. Returns `false` if there is no entry or any of
+			//! its dependencies have changed.
+			bool read_cache(uint64_t cache_key, ShaderBinary& binary) const;
+
+			//! Writes a cache entry. Failures are ignored: the cache is purely an optimization.
+			void write_cache(uint64_t cache_key, const ShaderBinary& binary);
+
+			//! Records the include graph of a shader that was just compiled or read from the cache.
+			void record_shader(const std::string& name, const ShaderBinary& binary);
+
+			std::string m_cache_directory;
+
+			std::atomic<uint64_t> m_cache_hits;
+			std::atomic<uint64_t> m_cache_misses;
+			std::atomic<uint64_t> m_cache_writes;
+
+			mutable std::mutex m_graph_mutex;
+			ShaderIncludeGraph m_include_graph;
+			std::set<std::string> m_shader_names;
+		};
+
+	} // namespace fsys
+
+} // namespace plume
@@ -0,0 +1,171 @@
+/*
+*
+* MIT License
+*
+* Copyright(c) 2017 Michael Walczyk
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files(the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions :
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*
+*/
+
+#pragma once
+
+#include <future>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "ShaderCompiler.h"
+
+namespace plume
+{
+
+	namespace fsys
+	{
+
+		//! A permutation axis declared by a shader. For example:
+		//!
+		//!					#pragma variant USE_NORMAL_MAP
+		//!					#pragma variant SHADOW_QUALITY LOW MEDIUM HIGH
+		//!
+		//! An axis without values is a boolean keyword with the values "0" and "1": when it is "1", the keyword
+		//! is defined as a macro (so it can be tested with `#ifdef`). An axis with values defines the keyword as
+		//! the index of the selected value, as well as `<keyword>_<value>` (i.e. `SHADOW_QUALITY_HIGH`). Values 
+		//! may start with a digit, as in `#pragma variant SAMPLE_COUNT 1 2 4` (which defines `SAMPLE_COUNT_4`).
+		struct ShaderVariantAxis
+		{
+			std::string name;
+			std::vector<std::string> values;
+			bool is_boolean;
+
+			//! The position and width of this axis's field within a variant key.
+			uint32_t shift;
+			uint32_t bits;
+		};
+
+		//! All of the variants of a single shader file. The axes are parsed from the `#pragma variant` directives
+		//! in the file itself (not the files that it includes), and every combination of axis values is identified 
+		//! by a small integer key in which each axis occupies a fixed bit field. Keys are meant to be built once 
+		//! (with `make_key()`) and then used to fetch variants in O(1) with `get()`.
+		//!
+		//! Variants are compiled lazily, the first time that they are requested, through a ShaderCompiler (so 
+		//! they are stored in and served from its on-disk cache). The set records which variants were requested, 
+		//! so that a later run can compile them all up-front (in parallel) from a usage manifest. All functions 
+		//! are thread-safe: concurrent requests for the same variant wait for a single compilation.
+		class ShaderVariantSet
+		{
+		public:
+
+			using VariantKey = uint32_t;
+
+			//! The maximum number of key bits across all axes, which bounds the number of variants at 65536.
+			static const uint32_t max_key_bits = 16;
+
+			//! Reads the shader file called `file_name` and parses its permutation axes. Every variant is compiled
+			//! with `base_options` plus the defines of its axis values. `compiler` must outlive the set. Throws if
+			//! a directive is malformed or the axes need more than `max_key_bits` bits.
+			ShaderVariantSet(ShaderCompiler& compiler, const std::string& file_name, const ShaderCompiler::Options& base_options = ShaderCompiler::Options());
+
+			ShaderVariantSet(const ShaderVariantSet& other) = delete;
+
+			ShaderVariantSet& operator=(const ShaderVariantSet& other) = delete;
+
+			//! Returns the variant with the specified key, compiling it if this is the first request. Throws if the
+			//! key is invalid or the variant fails to compile (a later request will try again).
+			std::shared_ptr<const ShaderBinary> get(VariantKey key);
+
+			//! Builds a key from a set of axis names and value names. Axes that are not mentioned take their first 
+			//! value ("0" for boolean axes). Throws if an axis or value does not exist.
+			VariantKey make_key(const std::map<std::string, std::string>& values) const;
+
+			//! Returns `key` with the axis called `axis` set to `value`. Throws if the axis or value does not exist.
+			VariantKey with(VariantKey key, const std::string& axis, const std::string& value) const;
+
+			//! Returns a human-readable form of `key`, i.e. "USE_NORMAL_MAP=1 SHADOW_QUALITY=HIGH". This is also 
+			//! the form that keys take in usage manifests.
+			std::string describe(VariantKey key) const;
+
+			//! Parses the output of `describe()`.
+			VariantKey parse_key(const std::string& description) const;
+
+			//! Returns `true` if `key` selects a valid value on every axis and `false` otherwise.
+			bool is_valid_key(VariantKey key) const;
+
+			//! Compiles the variants with the specified keys in parallel (skipping any that are already compiled).
+			//! Throws (after every variant has been attempted) if any of them fail to compile.
+			void precompile(const std::vector<VariantKey>& keys);
+
+			//! Reads a usage manifest (see `get_usage_manifest()`) through the resource manager and precompiles
+			//! every variant of this shader that it lists. Returns the number of variants that were listed.
+			size_t precompile_from_manifest(const std::string& manifest_name);
+
+			//! Returns a usage manifest listing every variant that has been requested so far, one per line, in the
+			//! form "<file name> <key description>". The manifests of several sets can simply be concatenated.
+			std::string get_usage_manifest() const;
+
+			//! Discards every compiled variant that depends on the file called `file_name` (the shader itself or any
+			//! file that it includes, directly or indirectly) and returns the number of variants discarded. The 
+			//! next request for one of them recompiles it, while variants that do not include the file are kept.
+			//! Variants that are still being compiled are left alone. Note that a change to the shader file itself
+			//! may add or remove axes, in which case the set should be recreated instead.
+			size_t invalidate(const std::string& file_name);
+
+			//! Returns the keys of every variant that has been requested so far, in the order of first request.
+			std::vector<VariantKey> get_used_keys() const;
+
+			const std::string& get_file_name() const { return m_file_name; }
+
+			vk::ShaderStageFlagBits get_stage() const { return m_stage; }
+
+			const std::vector<ShaderVariantAxis>& get_axes() const { return m_axes; }
+
+			//! Returns the total number of variants (the product of the number of values on each axis).
+			size_t get_variant_count() const;
+
+		private:
+
+			using BinaryFuture = std::shared_future<std::shared_ptr<const ShaderBinary>>;
+
+			//! Returns the compile options for the variant with the specified key.
+			ShaderCompiler::Options get_options(VariantKey key) const;
+
+			const ShaderVariantAxis& find_axis(const std::string& name) const;
+
+			ShaderCompiler& m_compiler;
+			std::string m_file_name;
+			vk::ShaderStageFlagBits m_stage;
+			ShaderCompiler::Options m_base_options;
+			std::vector<ShaderVariantAxis> m_axes;
+			uint32_t m_key_bits;
+
+			//! Indexed directly by key. A slot is empty until its variant is first requested.
+			mutable std::mutex m_mutex;
+			std::vector<BinaryFuture> m_slots;
+
+			//! Whether each slot has been requested through `get()` (indexed by key, like the slots), along with the 
+			//! requested keys in the order of first request.
+			std::vector<bool> m_is_used;
+			std::vector<VariantKey> m_used_keys;
+		};
+
+	} // namespace fsys
+
+} // namespace plume
@@ -0,0 +1,44 @@
+/*
+*
+* MIT License
+*
+* Copyright(c) 2017 Michael Walczyk
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files(the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions :
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*
+*/
+
+#pragma once
+
+// Compile-time detection of the x86 instruction set extensions that the CPU-side image code (block 
+// compression, mipmap generation, etc.) can take advantage of. Every SIMD path has a scalar fallback, 
+// so these macros only select between implementations.
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+	#define PLUME_SSE2
+	#include <emmintrin.h>
+#endif
+
+// F16C (hardware float <-> half conversion) is not implied by any baseline target, so it must be enabled
+// explicitly (i.e. `-mf16c`, `-march=native`, or `/arch:AVX2` with MSVC). The PLUME_WITH_F16C CMake option
+// does this for the tools.
+#if defined(__F16C__) || (defined(_MSC_VER) && defined(__AVX2__))
+	#define PLUME_F16C
+	#include <immintrin.h>
+#endif
@@ -0,0 +1,137 @@
+/*
+*
+* MIT License
+*
+* Copyright(c) 2017 Michael Walczyk
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files(the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions :
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*
+*/
+
+#pragma once
+
+#include <memory>
+
+#include "Platform.h"
+#include "ResourceManager.h"
+#include "BlockCompression.h"
+
+namespace plume
+{
+
+	namespace fsys
+	{
+
+		//! A single mipmap level of a single array layer (or cube face) within a texture.
+		struct TextureSubresource
+		{
+			uint32_t mip_level;
+			uint32_t array_layer;
+			vk::Extent3D extent;
+
+			//! The byte offset of this subresource's first block, relative to `TextureResource::data()`.
+			size_t offset;
+
+			//! The number of bytes occupied by this subresource (including all depth slices).
+			size_t size;
+		};
+
+		//! A texture loaded from a GPU-ready container (DDS or KTX2). The texel blocks are not decoded: 
+		//! each subresource refers directly to the memory-mapped file, so it can be copied straight into 
+		//! a staging buffer. Transcoded textures own their texels instead (see `contents`).
+		struct TextureResource
+		{
+			vk::Format format;
+			vk::ImageType image_type;
+			vk::Extent3D extent;
+
+			//! The number of array layers, including cube faces (i.e. a single cube map has 6 layers).
+			uint32_t array_layers;
+			uint32_t mip_levels;
+			bool is_cube;
+
+			//! All subresources, ordered by mipmap level and then by array layer.
+			std::vector<TextureSubresource> subresources;
+
+			std::shared_ptr<const MappedFileResource> file;
+			std::vector<uint8_t> contents;
+
+			//! Returns a pointer to the memory that subresource offsets are relative to.
+			const uint8_t* data() const { return file ? file->data() : contents.data(); }
+
+			//! Returns a pointer to the first block of `subresource`.
+			const uint8_t* data(const TextureSubresource& subresource) const { return data() + subresource.offset; }
+		};
+
+		class TextureLoader
+		{
+		public:
+
+			//! Loads a DDS or KTX2 file at path `ResourceManager::default_path` + `file_name`. The container
+			//! type is determined by the file's magic number, not its extension. All mipmap levels, array 
+			//! layers, and cube faces are loaded. KTX2 files must not use supercompression.
+			static TextureResource load(const std::string& file_name);
+
+			//! Parses a DDS or KTX2 container that has already been mapped into memory. The returned texture 
+			//! keeps the mapping alive.
+			static TextureResource load(std::shared_ptr<const MappedFileResource> mapped);
+
+			//! Returns `true` if textures of the specified format can be decoded on the CPU by `transcode()`.
+			static bool can_transcode(vk::Format format);
+
+			//! Returns the (uncompressed) format that `transcode()` produces for textures of the specified format.
+			static vk::Format get_transcoded_format(vk::Format format);
+
+			//! Decodes every subresource of a block-compressed texture into 8-bit RGBA texels. This is used as 
+			//! a fallback when the device cannot sample the texture's format. sRGB-encoded formats transcode to 
+			//! vk::Format::eR8G8B8A8Srgb and signed formats to vk::Format::eR8G8B8A8Snorm. Throws if the format 
+			//! has no CPU decoder (ASTC and BC6H).
+			static TextureResource transcode(const TextureResource& texture);
+
+			//! Wraps a decoded image as a single-level, single-layer texture of 8-bit RGBA texels. Images with 
+			//! fewer than 4 channels are expanded (grey to RGB, missing alpha to opaque).
+			static TextureResource from_image(const ImageResource& image, bool is_srgb = false);
+
+			//! Same as above, but each image becomes a mipmap level (i.e. the output of `MipGenerator::generate()`).
+			static TextureResource from_image(const std::vector<ImageResource>& mip_chain, bool is_srgb = false);
+
+			//! Returns `true` if `encode()` can compress textures into the specified format: BC1, BC3, BC4, BC5, 
+			//! and BC7 (unsigned and sRGB variants).
+			static bool can_encode(vk::Format format);
+
+			//! Compresses every subresource of a texture with 8-bit RGBA texels (i.e. vk::Format::eR8G8B8A8Unorm 
+			//! or vk::Format::eR8G8B8A8Srgb) into the specified block-compressed format. Subresources are encoded
+			//! in parallel on the worker pool, as are the rows of blocks within each subresource.
+			static TextureResource encode(const TextureResource& texture, vk::Format format, utils::EncodeQuality quality = utils::EncodeQuality::QUALITY_NORMAL);
+
+			//! Writes a texture to disk at `file_path`. The container is chosen by extension: ".dds" (always 
+			//! with a DX10 header) or ".ktx2" (uncompressed, with a basic data format descriptor).
+			static void save(const std::string& file_path, const TextureResource& texture);
+
+		private:
+
+			static TextureResource load_dds(std::shared_ptr<const MappedFileResource> mapped);
+			static TextureResource load_ktx2(std::shared_ptr<const MappedFileResource> mapped);
+			static std::vector<uint8_t> save_dds(const TextureResource& texture);
+			static std::vector<uint8_t> save_ktx2(const TextureResource& texture);
+		};
+
+	} // namespace fsys
+
+} // namespace plume
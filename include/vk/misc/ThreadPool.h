@@ -0,0 +1,185 @@
+/*
+*
+* MIT License
+*
+* Copyright(c) 2017 Michael Walczyk
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files(the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions :
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*
+*/
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace plume
+{
+
+	namespace utils
+	{
+
+		//! Tasks submitted to a ThreadPool are dequeued strictly by priority class: a worker will only pick up
+		//! a `PRIORITY_NORMAL` task when there are no `PRIORITY_HIGH` tasks waiting, and so on. Within a class,
+		//! tasks run in submission order.
+		enum class TaskPriority
+		{
+			PRIORITY_HIGH,
+			PRIORITY_NORMAL,
+			PRIORITY_LOW
+		};
+
+		//! Thrown (through the task's future) when a task is cancelled before it gets a chance to run.
+		class TaskCancelled : public std::runtime_error
+		{
+		public:
+
+			TaskCancelled() : std::runtime_error("The task was cancelled before it completed") {}
+		};
+
+		//! A shared flag used to request cancellation of one or more tasks. Cancellation is cooperative: a task 
+		//! that has already started will only stop if it polls `is_cancelled()` (or calls `throw_if_cancelled()`).
+		class CancellationToken
+		{
+		public:
+
+			CancellationToken() :
+				m_cancelled(std::make_shared<std::atomic<bool>>(false))
+			{}
+
+			//! Request cancellation of every task that shares this token.
+			void cancel() const { m_cancelled->store(true); }
+
+			//! Returns `true` if cancellation has been requested and `false` otherwise.
+			bool is_cancelled() const { return m_cancelled->load(); }
+
+			//! Throws a TaskCancelled exception if cancellation has been requested.
+			void throw_if_cancelled() const
+			{
+				if (is_cancelled())
+				{
+					throw TaskCancelled();
+				}
+			}
+
+		private:
+
+			std::shared_ptr<std::atomic<bool>> m_cancelled;
+		};
+
+		//! A fixed-size pool of worker threads that execute tasks from a set of prioritized queues.
+		class ThreadPool
+		{
+		public:
+
+			//! Construct a pool with `thread_count` workers. By default, one worker is created per hardware thread.
+			explicit ThreadPool(size_t thread_count = std::thread::hardware_concurrency());
+
+			//! Drains any tasks that are still queued and joins all of the worker threads.
+			~ThreadPool();
+
+			ThreadPool(const ThreadPool& other) = delete;
+
+			ThreadPool& operator=(const ThreadPool& other) = delete;
+
+			//! Enqueue a callable for execution on one of the worker threads. Returns a future that will hold
+			//! the callable's result (or the exception that it threw).
+			template<class F>
+			auto submit(F&& func, TaskPriority priority = TaskPriority::PRIORITY_NORMAL) -> std::future<typename std::result_of<F()>::type>
+			{
+				using result_type = typename std::result_of<F()>::type;
+
+				// std::function requires a copyable target, so the packaged task is held by a shared pointer.
+				auto task = std::make_shared<std::packaged_task<result_type()>>(std::forward<F>(func));
+				std::future<result_type> future = task->get_future();
+
+				enqueue([task]() { (*task)(); }, priority);
+
+				return future;
+			}
+
+			//! Same as `submit()`, but the task will fail with a TaskCancelled exception if `token` is cancelled
+			//! before a worker picks it up.
+			template<class F>
+			auto submit(F&& func, const CancellationToken& token, TaskPriority priority = TaskPriority::PRIORITY_NORMAL) -> std::future<typename std::result_of<F()>::type>
+			{
+				using result_type = typename std::result_of<F()>::type;
+
+				return submit([token, func = std::forward<F>(func)]() mutable -> result_type
+				{
+					token.throw_if_cancelled();
+					return func();
+				}, priority);
+			}
+
+			//! Splits the index range [`begin`, `end`) into chunks of (at most) `grain_size` indices and runs
+			//! `func(chunk_begin, chunk_end)` for each chunk across the pool. The calling thread participates
+			//! in the work and this function returns once every chunk has been processed.
+			void parallel_for(size_t begin, size_t end, size_t grain_size, const std::function<void(size_t, size_t)>& func);
+
+			//! Blocks the calling thread until all of the queues are empty and no worker is executing a task.
+			void wait_idle();
+
+			//! Returns the number of worker threads owned by this pool.
+			size_t get_thread_count() const { return m_workers.size(); }
+
+			//! Returns the number of tasks that are waiting to be executed.
+			size_t get_pending_task_count() const;
+
+			//! Returns a pool that is shared by the entire toolkit (resource loading, shader compilation, etc.).
+			static ThreadPool& global()
+			{
+				static ThreadPool pool;
+				return pool;
+			}
+
+		private:
+
+			void enqueue(std::function<void()> task, TaskPriority priority);
+
+			void worker_loop();
+
+			//! Pops the highest priority task (if any) into `task`. Must be called with `m_mutex` held.
+			bool pop_task(std::function<void()>& task);
+
+			//! Must be called with `m_mutex` held.
+			size_t get_pending_task_count_unlocked() const;
+
+			std::vector<std::thread> m_workers;
+			std::array<std::deque<std::function<void()>>, 3> m_queues;
+			mutable std::mutex m_mutex;
+			std::condition_variable m_task_available;
+			std::condition_variable m_idle;
+			size_t m_active_tasks;
+			bool m_stopping;
+		};
+
+	} // namespace utils
+
+} // namespace plume
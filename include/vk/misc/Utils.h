@@ -58,6 +58,25 @@ namespace plume
 		//! Translate an image format into the appropriate aspect mask flags.
 		vk::ImageAspectFlags format_to_aspect_mask(vk::Format format);
 
+		//! Describes the memory layout of an image format: the dimensions of a single block of texels and the 
+		//! number of bytes that block occupies. Uncompressed formats have 1x1 blocks.
+		struct FormatBlockInfo
+		{
+			uint32_t block_width;
+			uint32_t block_height;
+			uint32_t block_size;
+		};
+
+		//! Returns the block dimensions and size of an image format. Throws if the format is not one that 
+		//! the texture loaders understand.
+		FormatBlockInfo get_format_block_info(vk::Format format);
+
+		//! Determine whether or not an image format is block-compressed (BCn, ETC2/EAC, or ASTC).
+		bool is_block_compressed_format(vk::Format format);
+
+		//! Determine whether or not an image format stores sRGB-encoded color.
+		bool is_srgb_format(vk::Format format);
+
 		//! Translates a sample count (integer) into the correspond vk::SampleCountFlagBits. 
 		//! A `count` of 4 would return vk::SampleCountFlagBits::e4, for example.
 		vk::SampleCountFlagBits sample_count_to_flags(uint32_t count);
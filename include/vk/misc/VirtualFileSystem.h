@@ -0,0 +1,281 @@
+/*
+*
+* MIT License
+*
+* Copyright(c) 2017 Michael Walczyk
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files(the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions :
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*
+*/
+
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "PackArchive.h"
+#include "ResourceManager.h"
+
+namespace plume
+{
+
+	namespace fsys
+	{
+
+		//! A source of files that can be mounted into a VirtualFileSystem. File names are relative to the root
+		//! of the mount point and have already been normalized (see PackArchive::normalize_path()) by the time 
+		//! they reach it. All functions must be thread-safe.
+		class MountPoint
+		{
+		public:
+
+			virtual ~MountPoint() = default;
+
+			//! Returns `true` if this mount point can provide the file called `file_name` and `false` otherwise.
+			virtual bool exists(const std::string& file_name) const = 0;
+
+			//! Returns a read-only view of the file called `file_name`. Throws if it does not exist.
+			virtual MappedFileResource map(const std::string& file_name, MappedFileResource::AccessPattern access_pattern) const = 0;
+
+			//! Returns a copy of the file called `file_name`. Throws if it does not exist. By default, this copies
+			//! the result of `map()`.
+			virtual FileResource read(const std::string& file_name) const;
+
+			//! Asks the operating system to start reading the file called `file_name` into the page cache, so that
+			//! a later `map()` or `read()` does not stall on the disk. This may block while the reads are queued, 
+			//! but it should not wait for them to complete. Does nothing if the file does not exist.
+			virtual void prefetch(const std::string& file_name) const = 0;
+
+			//! Returns a human-readable description of the mount point (i.e. for logging).
+			virtual std::string describe() const = 0;
+
+			//! Returns the path on disk that the file called `file_name` is served from, or an empty string if it
+			//! is not backed by a loose file (i.e. an archive entry or a file held in memory). By default, files
+			//! are not backed by loose files.
+			virtual std::string get_disk_path(const std::string& /* file_name */) const { return std::string(); }
+		};
+
+		//! A mount point that serves loose files from a directory on disk.
+		class DirectoryMount : public MountPoint
+		{
+		public:
+
+			//! `root` is the path of the directory, with or without a trailing separator.
+			explicit DirectoryMount(const std::string& root);
+
+			bool exists(const std::string& file_name) const override;
+
+			MappedFileResource map(const std::string& file_name, MappedFileResource::AccessPattern access_pattern) const override;
+
+			FileResource read(const std::string& file_name) const override;
+
+			//! Uses `readahead()` on Linux, `posix_fadvise()` on other POSIX systems, and `PrefetchVirtualMemory()` 
+			//! on Windows.
+			void prefetch(const std::string& file_name) const override;
+
+			std::string describe() const override { return "directory " + m_root; }
+
+			std::string get_disk_path(const std::string& file_name) const override { return get_full_path(file_name); }
+
+			//! Returns the full path of the file called `file_name` (whether or not it exists).
+			std::string get_full_path(const std::string& file_name) const { return m_root + file_name; }
+
+		private:
+
+			std::string m_root;
+		};
+
+		//! A mount point that serves the entries of a pack archive.
+		class ArchiveMount : public MountPoint
+		{
+		public:
+
+			//! Opens the pack archive at `path` (a full path). Throws if it is not a valid archive.
+			explicit ArchiveMount(const std::string& path);
+
+			bool exists(const std::string& file_name) const override { return m_archive.contains(file_name); }
+
+			MappedFileResource map(const std::string& file_name, MappedFileResource::AccessPattern access_pattern) const override { return m_archive.map_entry(file_name, access_pattern); }
+
+			FileResource read(const std::string& file_name) const override { return m_archive.read_entry(file_name); }
+
+			void prefetch(const std::string& file_name) const override { m_archive.prefetch_entry(file_name); }
+
+			std::string describe() const override { return "archive " + m_archive.get_path(); }
+
+			const PackArchive& get_archive() const { return m_archive; }
+
+		private:
+
+			PackArchive m_archive;
+		};
+
+		//! A mount point that serves files held in host memory, i.e. generated assets or edits that should 
+		//! override the files on disk without writing them out. Files can be added and removed at any time: 
+		//! resources that were mapped before a file was replaced or removed keep referring to the old contents.
+		class MemoryMount : public MountPoint
+		{
+		public:
+
+			//! Adds the file called `file_name` (replacing it if it already exists).
+			void add_file(const std::string& file_name, std::vector<uint8_t> contents);
+
+			//! Removes the file called `file_name`. Returns `true` if it existed and `false` otherwise.
+			bool remove_file(const std::string& file_name);
+
+			//! Removes every file.
+			void clear();
+
+			bool exists(const std::string& file_name) const override;
+
+			MappedFileResource map(const std::string& file_name, MappedFileResource::AccessPattern access_pattern) const override;
+
+			//! Files are already resident, so there is nothing to do.
+			void prefetch(const std::string& /* file_name */) const override {}
+
+			std::string describe() const override { return "memory"; }
+
+		private:
+
+			std::shared_ptr<const std::vector<uint8_t>> find(const std::string& file_name) const;
+
+			mutable std::mutex m_mutex;
+			std::unordered_map<std::string, std::shared_ptr<const std::vector<uint8_t>>> m_files;
+		};
+
+		//! Resolves file names against an ordered list of mount points. Mount points with a higher priority are
+		//! searched first, and mount points with equal priority are searched in reverse mount order (so that the
+		//! most recently mounted one wins). This makes it possible to layer, for example, an in-memory overlay 
+		//! over a patch archive over the game's main archive over a directory of loose files.
+		//!
+		//! The file system also owns a background thread that warms the page cache for files that will be 
+		//! needed soon (see `prefetch()`), so that cold-cache disk latency is hidden behind other work. All 
+		//! functions are thread-safe.
+		class VirtualFileSystem
+		{
+		public:
+
+			//! Identifies a mount point for `unmount()`.
+			using MountId = uint32_t;
+
+			VirtualFileSystem();
+
+			//! Cancels any outstanding prefetches and joins the prefetch thread.
+			~VirtualFileSystem();
+
+			VirtualFileSystem(const VirtualFileSystem& other) = delete;
+
+			VirtualFileSystem& operator=(const VirtualFileSystem& other) = delete;
+
+			//! Adds `mount_point` to the search order with the specified `priority`.
+			MountId mount(std::shared_ptr<const MountPoint> mount_point, int priority = 0);
+
+			//! Mounts the directory at `root`.
+			MountId mount_directory(const std::string& root, int priority = 0);
+
+			//! Mounts the pack archive at `path` (a full path). Throws if it cannot be opened.
+			MountId mount_archive(const std::string& path, int priority = 0);
+
+			//! Mounts `memory_mount`, which the caller can keep populating after it has been mounted.
+			MountId mount_memory(std::shared_ptr<MemoryMount> memory_mount, int priority = 0);
+
+			//! Removes a mount point from the search order. Resources that were already obtained from it remain 
+			//! valid. Returns `true` if `id` was mounted and `false` otherwise.
+			bool unmount(MountId id);
+
+			//! Removes every mount point.
+			void unmount_all();
+
+			//! Returns the number of mount points.
+			size_t get_mount_count() const;
+
+			//! Returns the first mount point (in search order) that contains `file_name`, or `nullptr`.
+			std::shared_ptr<const MountPoint> resolve(const std::string& file_name) const;
+
+			//! Returns `true` if any mount point contains `file_name` and `false` otherwise.
+			bool exists(const std::string& file_name) const { return resolve(file_name) != nullptr; }
+
+			//! Maps the file called `file_name` from the first mount point that contains it. Throws if none do.
+			MappedFileResource map_file(const std::string& file_name, MappedFileResource::AccessPattern access_pattern = MappedFileResource::AccessPattern::ACCESS_SEQUENTIAL) const;
+
+			//! Reads the file called `file_name` from the first mount point that contains it. Throws if none do.
+			FileResource read_file(const std::string& file_name) const;
+
+			//! Returns the path on disk of the file called `file_name`, as served by the first mount point that 
+			//! contains it (i.e. to watch it for changes), or an empty string if no mount point contains it or it
+			//! is not a loose file.
+			std::string get_disk_path(const std::string& file_name) const;
+
+			//! Queues `file_names` to be read into the page cache by the prefetch thread, in order. Returns 
+			//! immediately. Files that do not exist are skipped, so it is fine to prefetch speculatively.
+			void prefetch(const std::vector<std::string>& file_names);
+
+			//! Reads the manifest called `manifest_name` (a text file that lists one file name per line; blank lines
+			//! and lines starting with '#' are ignored) and prefetches every file that it lists. Throws if the 
+			//! manifest does not exist. Returns the number of files that were queued.
+			size_t prefetch_manifest(const std::string& manifest_name);
+
+			//! Discards any prefetches that have not started yet.
+			void cancel_prefetch();
+
+			//! Blocks the calling thread until every queued prefetch has been issued.
+			void wait_prefetch_idle();
+
+			//! Returns the number of files that are waiting to be prefetched.
+			size_t get_pending_prefetch_count() const;
+
+		private:
+
+			struct MountRecord
+			{
+				MountId id;
+				int priority;
+				std::shared_ptr<const MountPoint> mount_point;
+			};
+
+			using MountList = std::vector<MountRecord>;
+
+			//! Returns the current search order. Lookups work on an immutable snapshot, so they never hold the 
+			//! lock while touching the filesystem.
+			std::shared_ptr<const MountList> get_mounts() const;
+
+			void prefetch_loop();
+
+			mutable std::mutex m_mount_mutex;
+			std::shared_ptr<const MountList> m_mounts;
+			MountId m_next_mount_id;
+
+			mutable std::mutex m_prefetch_mutex;
+			std::condition_variable m_prefetch_available;
+			std::condition_variable m_prefetch_idle;
+			std::deque<std::string> m_prefetch_queue;
+			bool m_prefetch_active;
+			bool m_stopping;
+			std::thread m_prefetch_thread;
+		};
+
+	} // namespace fsys
+
+} // namespace plume
@@ -101,6 +101,13 @@ namespace plume
 				upload_immediately(data.data(), sizeof(T) * data.size(), offset);
 			}
 
+			//! Maps a range of the buffer's device memory into host address space, so that it can be written
+			//! directly (i.e. when filling a staging buffer). Call `unmap()` when finished.
+			void* map(vk::DeviceSize offset = 0, vk::DeviceSize size = VK_WHOLE_SIZE) { return m_device_memory->map(offset, size); }
+
+			//! Unmaps the buffer's device memory.
+			void unmap() { m_device_memory->unmap(); }
+
 			//! Returns a vk::DescriptorBufferInfo for this buffer object. By default, `offset` is set to zero, and `range` is set to
 			//! the special value VK_WHOLE_SIZE, meaning that the descriptor will access the entire extent of this buffer's memory.
 			vk::DescriptorBufferInfo build_descriptor_info(vk::DeviceSize offset = 0, vk::DeviceSize range = VK_WHOLE_SIZE) const;
@@ -0,0 +1,389 @@
+/*
+*
+* MIT License
+*
+* Copyright(c) 2017 Michael Walczyk
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files(the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions :
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*
+*/
+
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+#include "glm.hpp"
+
+#include "ShaderModule.h"
+
+namespace plume
+{
+
+	namespace graphics
+	{
+
+		//! The memory layout rules of a uniform or storage buffer block, i.e. `layout (std140) uniform` or 
+		//! `layout (std430) buffer`. Under std140, arrays (and the columns of matrices) are padded to 16 bytes per
+		//! element and structs are aligned to 16 bytes. std430 (the default for storage buffers and push constants)
+		//! drops that padding, so a `float[4]` takes 16 bytes instead of 64.
+		enum class LayoutStandard
+		{
+			LAYOUT_STD140,
+			LAYOUT_STD430
+		};
+
+		//! The layout of a single member, as it is compared against the reflected block members (see 
+		//! ShaderModule::BlockMember) by `BufferLayout::validate()`.
+		struct BufferMemberLayout
+		{
+			uint32_t offset;
+			uint32_t size;
+			uint32_t array_stride;
+			uint32_t matrix_stride;
+			bool is_struct;
+		};
+
+		//! Throws if `members` (flattened in the same order as ShaderModule::BlockLayout::members) or 
+		//! `declared_size` do not match the reflected `block`.
+		void validate_buffer_layout(const ShaderModule::BlockLayout& block, const std::vector<BufferMemberLayout>& members, uint32_t declared_size);
+
+		//! Rounds `value` up to the next multiple of `alignment` (which must be a power of two).
+		constexpr uint32_t align_up(uint32_t value, uint32_t alignment)
+		{
+			return (value + alignment - 1) & ~(alignment - 1);
+		}
+
+		//! Describes how a C++ type is laid out in a buffer block under `Standard`: its alignment, size (in the
+		//! block, including any padding between array elements or matrix columns), the number of bytes that 
+		//! actually hold data, and how to write a value. This is specialized below for scalars, glm vectors and 
+		//! matrices, `std::array`s (which stand in for GLSL arrays), and nested BufferLayouts (structs), and can be
+		//! specialized for other types.
+		template<LayoutStandard Standard, class T>
+		struct BufferLayoutRules;
+
+		template<LayoutStandard Standard, class T, uint32_t ComponentCount>
+		struct VectorLayoutRules
+		{
+			using value_type = T;
+
+			static constexpr uint32_t get_component_size() { return static_cast<uint32_t>(sizeof(T) / ComponentCount); }
+
+			//! Two-component vectors are aligned to twice the component size, while three- and four-component 
+			//! vectors are aligned to four times the component size (under both standards).
+			static constexpr uint32_t get_alignment() { return get_component_size() * (ComponentCount == 1 ? 1 : (ComponentCount == 2 ? 2 : 4)); }
+
+			static constexpr uint32_t get_size() { return static_cast<uint32_t>(sizeof(T)); }
+
+			static constexpr uint32_t get_data_size() { return static_cast<uint32_t>(sizeof(T)); }
+
+			static void write(uint8_t* destination, const T& value)
+			{
+				memcpy(destination, &value, sizeof(T));
+			}
+
+			static void describe(uint32_t offset, std::vector<BufferMemberLayout>& members)
+			{
+				members.push_back({ offset, get_size(), 0, 0, false });
+			}
+		};
+
+		//! Column-major matrices are laid out as an array of column vectors.
+		template<LayoutStandard Standard, class T, class Column, uint32_t ColumnCount>
+		struct MatrixLayoutRules
+		{
+			using value_type = T;
+
+			static constexpr uint32_t get_column_stride()
+			{
+				return Standard == LayoutStandard::LAYOUT_STD140 ? align_up(BufferLayoutRules<Standard, Column>::get_alignment(), 16) : BufferLayoutRules<Standard, Column>::get_alignment();
+			}
+
+			static constexpr uint32_t get_alignment() { return get_column_stride(); }
+
+			static constexpr uint32_t get_size() { return get_column_stride() * ColumnCount; }
+
+			static constexpr uint32_t get_data_size() { return static_cast<uint32_t>(sizeof(Column)) * ColumnCount; }
+
+			static void write(uint8_t* destination, const T& value)
+			{
+				for (uint32_t column = 0; column < ColumnCount; ++column)
+				{
+					memcpy(destination + column * get_column_stride(), &value[column], sizeof(Column));
+				}
+			}
+
+			static void describe(uint32_t offset, std::vector<BufferMemberLayout>& members)
+			{
+				members.push_back({ offset, get_size(), 0, get_column_stride(), false });
+			}
+		};
+
+		template<LayoutStandard Standard> struct BufferLayoutRules<Standard, float> : VectorLayoutRules<Standard, float, 1> {};
+		template<LayoutStandard Standard> struct BufferLayoutRules<Standard, double> : VectorLayoutRules<Standard, double, 1> {};
+		template<LayoutStandard Standard> struct BufferLayoutRules<Standard, int32_t> : VectorLayoutRules<Standard, int32_t, 1> {};
+		template<LayoutStandard Standard> struct BufferLayoutRules<Standard, uint32_t> : VectorLayoutRules<Standard, uint32_t, 1> {};
+		template<LayoutStandard Standard> struct BufferLayoutRules<Standard, glm::vec2> : VectorLayoutRules<Standard, glm::vec2, 2> {};
+		template<LayoutStandard Standard> struct BufferLayoutRules<Standard, glm::vec3> : VectorLayoutRules<Standard, glm::vec3, 3> {};
+		template<LayoutStandard Standard> struct BufferLayoutRules<Standard, glm::vec4> : VectorLayoutRules<Standard, glm::vec4, 4> {};
+		template<LayoutStandard Standard> struct BufferLayoutRules<Standard, glm::dvec2> : VectorLayoutRules<Standard, glm::dvec2, 2> {};
+		template<LayoutStandard Standard> struct BufferLayoutRules<Standard, glm::dvec3> : VectorLayoutRules<Standard, glm::dvec3, 3> {};
+		template<LayoutStandard Standard> struct BufferLayoutRules<Standard, glm::dvec4> : VectorLayoutRules<Standard, glm::dvec4, 4> {};
+		template<LayoutStandard Standard> struct BufferLayoutRules<Standard, glm::ivec2> : VectorLayoutRules<Standard, glm::ivec2, 2> {};
+		template<LayoutStandard Standard> struct BufferLayoutRules<Standard, glm::ivec3> : VectorLayoutRules<Standard, glm::ivec3, 3> {};
+		template<LayoutStandard Standard> struct BufferLayoutRules<Standard, glm::ivec4> : VectorLayoutRules<Standard, glm::ivec4, 4> {};
+		template<LayoutStandard Standard> struct BufferLayoutRules<Standard, glm::uvec2> : VectorLayoutRules<Standard, glm::uvec2, 2> {};
+		template<LayoutStandard Standard> struct BufferLayoutRules<Standard, glm::uvec3> : VectorLayoutRules<Standard, glm::uvec3, 3> {};
+		template<LayoutStandard Standard> struct BufferLayoutRules<Standard, glm::uvec4> : VectorLayoutRules<Standard, glm::uvec4, 4> {};
+		template<LayoutStandard Standard> struct BufferLayoutRules<Standard, glm::mat2> : MatrixLayoutRules<Standard, glm::mat2, glm::vec2, 2> {};
+		template<LayoutStandard Standard> struct BufferLayoutRules<Standard, glm::mat3> : MatrixLayoutRules<Standard, glm::mat3, glm::vec3, 3> {};
+		template<LayoutStandard Standard> struct BufferLayoutRules<Standard, glm::mat4> : MatrixLayoutRules<Standard, glm::mat4, glm::vec4, 4> {};
+
+		//! A GLSL array, i.e. `std::array<glm::vec3, 4>` for `vec3 positions[4]`. Arrays of arrays are supported.
+		template<LayoutStandard Standard, class Element, size_t ElementCount>
+		struct BufferLayoutRules<Standard, std::array<Element, ElementCount>>
+		{
+			using element_rules = BufferLayoutRules<Standard, Element>;
+			using value_type = std::array<typename element_rules::value_type, ElementCount>;
+
+			static_assert(ElementCount > 0, "Arrays in buffer blocks must have at least one element");
+
+			static constexpr uint32_t get_alignment()
+			{
+				return Standard == LayoutStandard::LAYOUT_STD140 ? align_up(element_rules::get_alignment(), 16) : element_rules::get_alignment();
+			}
+
+			static constexpr uint32_t get_stride() { return align_up(element_rules::get_size(), get_alignment()); }
+
+			static constexpr uint32_t get_size() { return get_stride() * static_cast<uint32_t>(ElementCount); }
+
+			static constexpr uint32_t get_data_size() { return element_rules::get_data_size() * static_cast<uint32_t>(ElementCount); }
+
+			static void write(uint8_t* destination, const value_type& value)
+			{
+				for (size_t i = 0; i < ElementCount; ++i)
+				{
+					element_rules::write(destination + i * get_stride(), value[i]);
+				}
+			}
+
+			//! The element is described first (with the offsets of nested members relative to the first element, as
+			//! in ShaderModule::BlockMember), then its size and stride are replaced by those of the whole array.
+			static void describe(uint32_t offset, std::vector<BufferMemberLayout>& members)
+			{
+				const size_t index = members.size();
+				element_rules::describe(offset, members);
+				members[index].size = get_size();
+				members[index].array_stride = get_stride();
+			}
+		};
+
+		//! The layout of a uniform buffer, storage buffer, or push constants block with the given members (in 
+		//! declaration order), computed at compile time. For example:
+		//!
+		//!					layout (std140, set = 0, binding = 0) uniform camera_data
+		//!					{
+		//!						mat4 view;			// offset 0
+		//!						vec3 position;		// offset 64
+		//!						float exposure;		// offset 76 (packed into the vec3's padding)
+		//!						vec4 lights[4];		// offset 80
+		//!					} camera;
+		//!
+		//! is described by:
+		//!
+		//!					using CameraLayout = Std140Layout<glm::mat4, glm::vec3, float, std::array<glm::vec4, 4>>;
+		//!
+		//!					static_assert(CameraLayout::get_offset(3) == 80, "");
+		//!					CameraLayout::write(buffer.map(), view, position, exposure, lights);
+		//!
+		//! Nested structs are described by nesting layouts (with the same standard), and their values are passed
+		//! as `std::tuple`s. A runtime array at the end of a storage buffer is described by an array of one 
+		//! element (which gives its offset and stride). Use `validate()` once (i.e. after loading the shader) to
+		//! check the description against the reflected block, and `get_padding_size()` to find out how many bytes
+		//! are wasted on padding.
+		template<LayoutStandard Standard, class... Members>
+		class BufferLayout
+		{
+		public:
+
+			static_assert(sizeof...(Members) > 0, "A buffer layout must have at least one member");
+
+			using value_type = std::tuple<typename BufferLayoutRules<Standard, Members>::value_type...>;
+
+			static constexpr size_t get_member_count() { return sizeof...(Members); }
+
+			//! Returns the offset of the member at `index` in bytes.
+			static constexpr uint32_t get_offset(size_t index)
+			{
+				const uint32_t alignments[] = { BufferLayoutRules<Standard, Members>::get_alignment()... };
+				const uint32_t sizes[] = { BufferLayoutRules<Standard, Members>::get_size()... };
+
+				uint32_t offset = 0;
+				for (size_t i = 0; i < index; ++i)
+				{
+					offset = align_up(offset, alignments[i]) + sizes[i];
+				}
+
+				return align_up(offset, alignments[index]);
+			}
+
+			//! Returns the alignment of the block when it is nested inside of another block.
+			static constexpr uint32_t get_alignment()
+			{
+				const uint32_t alignments[] = { BufferLayoutRules<Standard, Members>::get_alignment()... };
+
+				uint32_t alignment = Standard == LayoutStandard::LAYOUT_STD140 ? 16 : 1;
+				for (uint32_t member_alignment : alignments)
+				{
+					alignment = member_alignment > alignment ? member_alignment : alignment;
+				}
+
+				return alignment;
+			}
+
+			//! Returns the size of the block as declared in the shader: the end of its last member.
+			static constexpr uint32_t get_declared_size()
+			{
+				const uint32_t sizes[] = { BufferLayoutRules<Standard, Members>::get_size()... };
+				return get_offset(sizeof...(Members) - 1) + sizes[sizeof...(Members) - 1];
+			}
+
+			//! Returns the size of the block rounded up to its alignment, which is the stride of an array of blocks.
+			static constexpr uint32_t get_size() { return align_up(get_declared_size(), get_alignment()); }
+
+			//! Returns the number of bytes that hold data, i.e. `get_size()` minus any padding.
+			static constexpr uint32_t get_data_size()
+			{
+				const uint32_t data_sizes[] = { BufferLayoutRules<Standard, Members>::get_data_size()... };
+
+				uint32_t data_size = 0;
+				for (uint32_t member_data_size : data_sizes)
+				{
+					data_size += member_data_size;
+				}
+
+				return data_size;
+			}
+
+			//! Returns the number of bytes of padding in the block (including any between array elements, matrix
+			//! columns, and the members of nested blocks).
+			static constexpr uint32_t get_padding_size() { return get_size() - get_data_size(); }
+
+			//! Writes every member to `destination` (i.e. mapped buffer memory, which must be at least `get_size()` 
+			//! bytes) at its offset, in a single pass. Padding bytes are left untouched.
+			static void write(void* destination, const typename BufferLayoutRules<Standard, Members>::value_type&... values)
+			{
+				write_members(static_cast<uint8_t*>(destination), std::index_sequence_for<Members...>{}, values...);
+			}
+
+			//! Same as above, with the members in a tuple (which is how nested blocks are passed).
+			static void write(void* destination, const value_type& values)
+			{
+				write_tuple(static_cast<uint8_t*>(destination), values, std::index_sequence_for<Members...>{});
+			}
+
+			//! Returns the packed block as an array of bytes (with zeroed padding), i.e. to pass to 
+			//! Buffer::upload_immediately().
+			static auto pack(const typename BufferLayoutRules<Standard, Members>::value_type&... values)
+			{
+				std::array<uint8_t, get_size()> bytes{};
+				write(bytes.data(), values...);
+				return bytes;
+			}
+
+			//! Appends the layout of every member to `members`, with nested members following their parent.
+			static void describe(uint32_t offset, std::vector<BufferMemberLayout>& members)
+			{
+				describe_members(offset, members, std::index_sequence_for<Members...>{});
+			}
+
+			//! Throws if this description does not match the reflected `block`: i.e. if a member has a different 
+			//! offset, size, array stride, or matrix stride in the shader (which usually means that the shader
+			//! declares a different type or uses a different layout standard).
+			static void validate(const ShaderModule::BlockLayout& block)
+			{
+				std::vector<BufferMemberLayout> members;
+				describe(0, members);
+				validate_buffer_layout(block, members, get_declared_size());
+			}
+
+		private:
+
+			template<size_t... Indices, class... Values>
+			static void write_members(uint8_t* destination, std::index_sequence<Indices...>, const Values&... values)
+			{
+				// Expands to one call per member (this is the usual C++14 stand-in for a fold expression).
+				const int expansion[] = { (BufferLayoutRules<Standard, Members>::write(destination + get_offset(Indices), values), 0)... };
+				(void)expansion;
+			}
+
+			template<size_t... Indices>
+			static void write_tuple(uint8_t* destination, const value_type& values, std::index_sequence<Indices...> indices)
+			{
+				write_members(destination, indices, std::get<Indices>(values)...);
+			}
+
+			template<size_t... Indices>
+			static void describe_members(uint32_t offset, std::vector<BufferMemberLayout>& members, std::index_sequence<Indices...>)
+			{
+				const int expansion[] = { (BufferLayoutRules<Standard, Members>::describe(offset + get_offset(Indices), members), 0)... };
+				(void)expansion;
+			}
+		};
+
+		//! A block nested inside of another block (i.e. a struct member), which must use the same standard.
+		template<LayoutStandard Standard, LayoutStandard NestedStandard, class... Members>
+		struct BufferLayoutRules<Standard, BufferLayout<NestedStandard, Members...>>
+		{
+			static_assert(Standard == NestedStandard, "Nested blocks must use the same layout standard as the block that contains them");
+
+			using layout = BufferLayout<NestedStandard, Members...>;
+			using value_type = typename layout::value_type;
+
+			static constexpr uint32_t get_alignment() { return layout::get_alignment(); }
+
+			static constexpr uint32_t get_size() { return layout::get_size(); }
+
+			static constexpr uint32_t get_data_size() { return layout::get_data_size(); }
+
+			static void write(uint8_t* destination, const value_type& value)
+			{
+				layout::write(destination, value);
+			}
+
+			static void describe(uint32_t offset, std::vector<BufferMemberLayout>& members)
+			{
+				members.push_back({ offset, get_size(), 0, 0, true });
+				layout::describe(offset, members);
+			}
+		};
+
+		template<class... Members>
+		using Std140Layout = BufferLayout<LayoutStandard::LAYOUT_STD140, Members...>;
+
+		template<class... Members>
+		using Std430Layout = BufferLayout<LayoutStandard::LAYOUT_STD430, Members...>;
+
+	} // namespace graphics
+
+} // namespace plume
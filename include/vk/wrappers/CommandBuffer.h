@@ -157,8 +157,26 @@ namespace plume
 			template<class T>
 			void update_push_constant_ranges(const Pipeline& pipeline, vk::ShaderStageFlags stage_flags, uint32_t offset, uint32_t size, const T& data)
 			{
-				// TODO: does this actually work?
-				//m_command_buffer_handle.pushConstants(pipeline->get_pipeline_layout_handle(), stage_flags, offset, size, &data);
+				get_handle().pushConstants(pipeline.get_pipeline_layout_handle(), stage_flags, offset, size, &data);
+			}
+
+			//! Pushes the entire push constants block of `pipeline` with a single call. `T` must be the struct that 
+			//! was registered with the pipeline (see PushConstantLayout), whose layout was validated against the 
+			//! shaders when the pipeline was created, so there are no lookups here.
+			template<class T>
+			void push_constants(const Pipeline& pipeline, const T& block)
+			{
+				if (!pipeline.get_push_constant_layout().is_type<T>())
+				{
+					throw std::runtime_error("The push constant block does not match the struct that was registered with the pipeline");
+				}
+
+				const vk::PushConstantRange& range = pipeline.get_push_constant_range();
+				get_handle().pushConstants(pipeline.get_pipeline_layout_handle(),
+										   range.stageFlags,
+										   range.offset,
+										   range.size,
+										   reinterpret_cast<const uint8_t*>(&block) + range.offset);
 			}
 
 			//! During shader reflection, the pipeline object grabs and stores information about the available push
@@ -198,6 +216,10 @@ namespace plume
 								   vk::ImageSubresourceRange image_subresource_range = Image::build_single_layer_subresource(vk::ImageAspectFlagBits::eDepth | vk::ImageAspectFlagBits::eStencil));
 
 
+			//! Copy regions of a buffer into an image (i.e. from a staging buffer into an optimally tiled image). 
+			//! The image must be in either vk::ImageLayout::eTransferDstOptimal or vk::ImageLayout::eGeneral.
+			void copy_buffer_to_image(const Buffer& buffer, const Image& image, const std::vector<vk::BufferImageCopy>& regions);
+
 			//! Use an image memory barrier to transition an image from one layout to another. This function can also be 
 			//! used to transfer ownership from one queue family to another. Note that if `src_queue` and `dst_queue` are
 			//! the same, then the image barrier's `srcQueueFamilyIndex` and `dstQueueFamilyIndex` will be set to the special
@@ -60,6 +60,9 @@ namespace plume
 
 			vk::CommandPool get_handle() const { return m_command_pool_handle.get(); };
 
+			//! Returns the type of the queue that command buffers allocated from this pool must be submitted to.
+			QueueType get_queue_type() const { return m_queue_type; }
+
 			// TODO: this should notify all command buffers that have been allocated from this pool, which means
 			// that the command pool class needs to maintain a list of all command buffer objects.
 			void reset_pool()
@@ -71,6 +74,7 @@ namespace plume
 
 			const Device* m_device_ptr;
 			vk::UniqueCommandPool m_command_pool_handle;
+			QueueType m_queue_type;
 		};
 
 	} // namespace graphics
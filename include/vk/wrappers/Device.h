@@ -46,6 +46,7 @@ namespace plume
 		class CommandBuffer;
 		class Fence;
 		class Semaphore;
+		class Submission;
 		class Swapchain;
 
 		class Device
@@ -59,14 +60,37 @@ namespace plume
 				std::vector<vk::PresentModeKHR> m_present_modes;
 			};
 
+			//! The entry points for timeline semaphores. These come from either Vulkan 1.2 or the VK_KHR_timeline_semaphore
+			//! extension (whose entry points are not exported by the loader), so they are loaded when the device is created.
+			struct TimelineSemaphoreFunctions
+			{
+				PFN_vkGetSemaphoreCounterValue get_semaphore_counter_value = nullptr;
+				PFN_vkWaitSemaphores wait_semaphores = nullptr;
+				PFN_vkSignalSemaphore signal_semaphore = nullptr;
+			};
+
 			Device() = default; 
 
-			//! Construct a logical device around a physical device (GPU).
+			//! Construct a logical device around a physical device (GPU). `instance_api_version` is the API version of the 
+			//! instance that `physical_device` was enumerated from (see `Instance::get_api_version()`): the device will 
+			//! not use any features beyond it.
 			Device(vk::PhysicalDevice physical_device,
 				   vk::SurfaceKHR surface,
 				   vk::QueueFlags required_queue_flags = vk::QueueFlagBits::eGraphics | vk::QueueFlagBits::eTransfer,
 				   bool use_swapchain = true,
-				   const std::vector<const char*>& required_device_extensions = {});
+				   const std::vector<const char*>& required_device_extensions = {},
+				   uint32_t instance_api_version = VK_API_VERSION_1_0);
+
+			//! Same as above, but takes the API version from `instance`.
+			Device(const Instance& instance,
+				   vk::PhysicalDevice physical_device,
+				   vk::SurfaceKHR surface,
+				   vk::QueueFlags required_queue_flags = vk::QueueFlagBits::eGraphics | vk::QueueFlagBits::eTransfer,
+				   bool use_swapchain = true,
+				   const std::vector<const char*>& required_device_extensions = {}) :
+
+				Device(physical_device, surface, required_queue_flags, use_swapchain, required_device_extensions, instance.get_api_version())
+			{}
 
 			~Device();
 
@@ -100,11 +124,19 @@ namespace plume
 			//! Depth formats are not necessarily supported by the system. Retrieve the highest precision format available.
 			vk::Format get_supported_depth_format() const { return m_gpu_details.get_supported_depth_format(); }
 
+			//! Returns `true` if timeline semaphores (see `TimelineSemaphore`) were enabled on this device. This requires
+			//! either Vulkan 1.2, or Vulkan 1.1 and the VK_KHR_timeline_semaphore extension (for both the instance and 
+			//! the physical device).
+			bool supports_timeline_semaphores() const { return m_supports_timeline_semaphores; }
+
+			//! Returns the timeline semaphore entry points, which are null unless `supports_timeline_semaphores()`.
+			const TimelineSemaphoreFunctions& get_timeline_semaphore_functions() const { return m_timeline_semaphore_functions; }
+
 			//! Returns the numeric index of the queue family that the queue `type` belongs to.
 			uint32_t get_queue_family_index(QueueType type) const { return m_queue_families_mapping.at(type).index; }
 
 			//! Returns the handle to the queue object associated with queue `type`.
-			vk::Queue get_queue_handle(QueueType type) { return m_queue_families_mapping[type].handle; }
+			vk::Queue get_queue_handle(QueueType type) const { return m_queue_families_mapping.at(type).handle; }
 
 			//! Retrieves the numeric index of the next available swapchain image.
 			uint32_t acquire_next_swapchain_image(const Swapchain& swapchain, 
@@ -115,7 +147,7 @@ namespace plume
 
 			//! Submit a command buffer and wait idle on the specified queue. Note that, as the name suggests, this function
 			//! should not be used for command buffer submissions that occur with high frequency (i.e. every frame).
-			void one_time_submit(QueueType type, const CommandBuffer& command_buffer);
+			void one_time_submit(QueueType type, const CommandBuffer& command_buffer) const;
 
 			//! Submit a command buffer on the specified queue with a wait semaphore and signal semaphore.
 			void submit_with_semaphores(QueueType type,
@@ -125,6 +157,13 @@ namespace plume
 										const Fence& fence,
 										vk::PipelineStageFlags pipeline_stage_flags = vk::PipelineStageFlagBits::eColorAttachmentOutput);
 
+			//! Submit one or more batches of work on the specified queue with a single call. Each batch may wait on and 
+			//! signal any number of binary and timeline semaphores.
+			void submit(QueueType type, const std::vector<Submission>& submissions);
+
+			//! Submit one or more batches of work on the specified queue and signal `fence` once all of them have completed.
+			void submit(QueueType type, const std::vector<Submission>& submissions, const Fence& fence);
+
 			void present(const Swapchain& swapchain, uint32_t image_index, const Semaphore& wait);
 
 			//! Wait for all commands submitted on a particular queue to finish.
@@ -200,6 +239,8 @@ namespace plume
 
 			GPUDetails m_gpu_details;
 			std::vector<const char*> m_required_device_extensions;
+			bool m_supports_timeline_semaphores = false;
+			TimelineSemaphoreFunctions m_timeline_semaphore_functions;
 
 			std::map<QueueType, QueueInternals> m_queue_families_mapping =
 			{
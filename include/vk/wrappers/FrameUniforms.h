@@ -0,0 +1,116 @@
+/*
+*
+* MIT License
+*
+* Copyright(c) 2017 Michael Walczyk
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files(the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions :
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*
+*/
+
+#pragma once
+
+#include "glm.hpp"
+
+#include "Buffer.h"
+#include "BufferLayout.h"
+#include "CommandBuffer.h"
+#include "DescriptorPool.h"
+#include "Pipeline.h"
+#include "Window.h"
+
+namespace plume
+{
+
+	namespace graphics
+	{
+
+		//! Owns the built-in per-frame uniforms, which any shader can read by declaring (or including 
+		//! `include/frame_uniforms.glsl`):
+		//!
+		//!					layout (std140, set = 3, binding = 0) uniform pl_frame_uniforms
+		//!					{
+		//!						float pl_time;
+		//!						vec2 pl_resolution;
+		//!						vec2 pl_mouse;
+		//!					};
+		//!
+		//! The values are written once per frame into the next slot of a ring-allocated uniform buffer, and the
+		//! block is bound as a dynamic uniform buffer, so moving to the next slot only changes the dynamic offset.
+		//! Pipelines recognize the block through reflection (see ShaderModule::get_frame_uniforms_block()), so 
+		//! `bind()` can be called for every pipeline and only binds the reserved set for those that use it. This
+		//! replaces pushing the same time and mouse values with every draw.
+		class FrameUniforms
+		{
+		public:
+
+			//! The memory layout of the block (see above).
+			using Layout = Std140Layout<float, glm::vec2, glm::vec2>;
+
+			//! The descriptor set and binding of the block. Set 3 is the last of the 4 sets that every device 
+			//! supports, so sets 0-2 remain available to the application.
+			static const uint32_t reserved_set = 3;
+			static const uint32_t reserved_binding = 0;
+
+			//! `frames_in_flight` is the number of slots in the ring, which must be at least the number of frames
+			//! that may still be executing on the device when the next one is updated (0 is treated as 1).
+			FrameUniforms(const Device& device, uint32_t frames_in_flight = 3);
+
+			FrameUniforms(const FrameUniforms&) = delete;
+			FrameUniforms& operator=(const FrameUniforms&) = delete;
+
+			~FrameUniforms();
+
+			//! Advances to the next slot of the ring and fills it with the elapsed time (see utils::app), the size
+			//! of `window` in pixels, and its mouse position (normalized to [0..1]). Call this once per frame, 
+			//! before recording any draws that read the uniforms.
+			void update(const Window& window);
+
+			//! Same as above, but with explicit values.
+			void update(float time, const glm::vec2& resolution, const glm::vec2& mouse);
+
+			//! Binds the current slot at `reserved_set` if `pipeline` uses the frame uniforms, and does nothing
+			//! otherwise.
+			void bind(CommandBuffer& command_buffer, const Pipeline& pipeline) const;
+
+			//! Returns the dynamic offset of the current slot, for binding the descriptor set manually.
+			uint32_t get_dynamic_offset() const { return m_current_slot * m_slot_stride; }
+
+			vk::DescriptorSet get_descriptor_set() const { return m_descriptor_set; }
+
+			uint32_t get_frames_in_flight() const { return m_frames_in_flight; }
+
+		private:
+
+			const Device* m_device_ptr;
+			uint32_t m_frames_in_flight;
+			uint32_t m_slot_stride;
+			uint32_t m_current_slot;
+
+			Buffer m_buffer;
+			uint8_t* m_mapped_ptr;
+
+			std::shared_ptr<DescriptorSetLayoutBuilder> m_layout_builder;
+			DescriptorPool m_descriptor_pool;
+			vk::DescriptorSet m_descriptor_set;
+		};
+
+	} // namespace graphics
+
+} // namespace plume
@@ -29,6 +29,7 @@
 #include "DeviceMemory.h"
 #include "ResourceManager.h"
 #include "Sampler.h"
+#include "TextureLoader.h"
 #include "Utils.h"
 
 namespace plume
@@ -37,10 +38,16 @@ namespace plume
 	namespace graphics
 	{
 
+		class CommandPool;
+
 		class Image
 		{
 		public:
 
+			//! A function that fills the first array layer and mipmap level of a host accessible image. It is 
+			//! handed the image's mapped memory, with the row pitch reported by the driver.
+			using PixelWriterFuncType = std::function<void(const fsys::PixelDestination&)>;
+
 			Image() = default; 
 
 			//! Construct an image whose device local memory store will be uninitialized. Note that
@@ -55,8 +62,9 @@ namespace plume
 				  vk::ImageTiling image_tiling = vk::ImageTiling::eOptimal,
 				  uint32_t sample_count = 1);
 
-			//! Construct an image that will be pre-initialized with the user supplied data. The resulting 
-			//! image will be 2D with depth, array layers, and mipmap levels equal to 1.
+			//! Construct an image that will be pre-initialized with the user supplied data. We assume that the 
+			//! image data has four channels (RGBA). The resulting image will be 2D with depth, array layers, and 
+			//! mipmap levels equal to 1.
 			template<typename T>
 			Image(const Device& device,
 				  vk::ImageType image_type,
@@ -65,72 +73,42 @@ namespace plume
 				  vk::Extent3D dimensions,
 				  const std::vector<T>& pixels) :
 
-				m_device_ptr(&device),
-				m_image_type(image_type),
-				m_image_usage_flags(image_usage_flags),
-				m_format(format),
-				m_dimensions(dimensions),
-				m_array_layers(1),
-				m_mip_levels(1),
-				m_image_tiling(vk::ImageTiling::eLinear),
-				m_sample_count(vk::SampleCountFlagBits::e1),
-				m_current_layout(vk::ImageLayout::ePreinitialized),
-				m_is_host_accessible(true)
-			{
-				check_image_parameters();
-
-				vk::ImageCreateInfo image_create_info;
-				image_create_info.arrayLayers = m_array_layers;
-				image_create_info.extent = m_dimensions;
-				image_create_info.format = m_format;
-				image_create_info.initialLayout = m_current_layout;
-				image_create_info.imageType = m_image_type;
-				image_create_info.mipLevels = m_mip_levels;
-				image_create_info.pQueueFamilyIndices = nullptr;
-				image_create_info.queueFamilyIndexCount = 0;
-				image_create_info.samples = m_sample_count;
-				image_create_info.sharingMode = (image_create_info.pQueueFamilyIndices) ? vk::SharingMode::eConcurrent : vk::SharingMode::eExclusive;
-				image_create_info.tiling = m_image_tiling;
-				image_create_info.usage = m_image_usage_flags;
-
-				m_image_handle = m_device_ptr->get_handle().createImageUnique(image_create_info);
-
-				initialize_device_memory_with_flags(device, vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent);
-
-				// Fill the first array layer and mipmap level.
-				vk::ImageSubresource image_subresource;
-				image_subresource.aspectMask = utils::format_to_aspect_mask(m_format);
-				image_subresource.arrayLayer = 0;
-				image_subresource.mipLevel = 0;
-
-				vk::SubresourceLayout subresource_layout = m_device_ptr->get_handle().getImageSubresourceLayout(m_image_handle.get(), image_subresource);
-
-				// We assume that the image data has four channels (RGBA). We also need to account for the bit depth
-				// of the image data: floats are 4 bits, for example.
-				const size_t channels = 4;
-				constexpr size_t bit_multipler = sizeof(T);
-
-				// Fill the image with the provided data.
-				void* mapped_ptr = m_device_memory->map(0, m_device_memory->get_allocation_size());
-
-				// The subresource has no additional padding, so we can directly copy the pixel data into the image.
-				// This usually happens when the requested image is a power-of-two texture.
-				VkDeviceSize image_size = m_dimensions.width * m_dimensions.height * channels;
-				if (subresource_layout.rowPitch == m_dimensions.width * channels)
-				{
-					memcpy(mapped_ptr, pixels.data(), static_cast<size_t>(image_size));
-				}
-				else
-				{
-					uint8_t* data_as_bytes = reinterpret_cast<uint8_t*>(mapped_ptr);
-					for (size_t i = 0; i < m_dimensions.height; ++i)
-					{
-						memcpy(&data_as_bytes[i * subresource_layout.rowPitch], &pixels[i * m_dimensions.width * channels], m_dimensions.width * channels * bit_multipler);
-					}
-				}
+				Image(device, image_type, image_usage_flags, format, dimensions, pixels.data(), sizeof(T) * 4) {}
 
-				m_device_memory->unmap();
-			}
+			//! Construct an image that will be pre-initialized with the tightly packed texels pointed to by `pixels`,
+			//! where each texel is `texel_size` bytes. The texels are copied directly into the image's mapped memory,
+			//! so `pixels` may point into a memory-mapped file (see fsys::MappedFileResource). The resulting image 
+			//! will be 2D with depth, array layers, and mipmap levels equal to 1.
+			Image(const Device& device,
+				  vk::ImageType image_type,
+				  vk::ImageUsageFlags image_usage_flags,
+				  vk::Format format,
+				  vk::Extent3D dimensions,
+				  const void* pixels,
+				  size_t texel_size);
+
+			//! Construct a linear, host accessible image whose first array layer and mipmap level is filled 
+			//! in-place by `pixel_writer`. This lets a decoder write directly into the image's memory without 
+			//! any intermediate copies.
+			Image(const Device& device,
+				  vk::ImageType image_type,
+				  vk::ImageUsageFlags image_usage_flags,
+				  vk::Format format,
+				  vk::Extent3D dimensions,
+				  const PixelWriterFuncType& pixel_writer);
+
+			//! Construct an image by decoding a memory-mapped LDR or HDR image file directly into the image's 
+			//! memory (see fsys::ResourceManager::decode_image()). The number of channels written is determined 
+			//! by `force_alpha`, so `format` should be a 4-channel (or 3-channel) 8-bit or 32-bit float format. 
+			//! HDR files may also be stored as vk::Format::eR16G16B16A16Sfloat, vk::Format::eB10G11R11UfloatPack32, 
+			//! or vk::Format::eE5B9G9R9UfloatPack32: texels are converted as they are written (`force_alpha` is
+			//! ignored). The resulting image will be 2D with depth, array layers, and mipmap levels equal to 1.
+			Image(const Device& device,
+				  vk::ImageType image_type,
+				  vk::ImageUsageFlags image_usage_flags,
+				  vk::Format format,
+				  const fsys::MappedFileResource& mapped,
+				  bool force_alpha = true);
 
 			//! Construct an image from the contents of an LDR image file. The resulting image will be 2D
 			//! with depth, array layers, and mipmap levels equal to 1.
@@ -140,17 +118,34 @@ namespace plume
 				  vk::Format format,
 				  const fsys::ImageResource& resource) :
 
-				Image(device, image_type, image_usage_flags, format, { resource.width, resource.height, 1 }, resource.contents) {}
+				Image(device, image_type, image_usage_flags, format, { resource.width, resource.height, 1 }, resource.contents.data(), resource.channels * sizeof(uint8_t)) {}
 
 			//! Construct an image from the contents of an HDR image file. The resulting image will be 2D
-			//! with depth, array layers, and mipmap levels equal to 1.
+			//! with depth, array layers, and mipmap levels equal to 1. If `format` is one of the packed HDR 
+			//! formats (see utils::is_packed_hdr_format()), the texels are converted as they are written into 
+			//! the image's memory. Otherwise, they are copied as-is.
 			Image(const Device& device,
 				  vk::ImageType image_type,
 				  vk::ImageUsageFlags image_usage_flags,
 				  vk::Format format,
-				  const fsys::ImageResourceHDR& resource) :
+				  const fsys::ImageResourceHDR& resource);
 
-				Image(device, image_type, image_usage_flags, format, { resource.width, resource.height, 1 }, resource.contents) {}
+			//! Construct an optimally tiled image from a texture container (see fsys::TextureLoader), with all of 
+			//! its mipmap levels and array layers. Block-compressed texels are passed through to the device as-is. 
+			//! If the device cannot sample the texture's format, the texture is decoded on the CPU first (see 
+			//! fsys::TextureLoader::transcode()). The texels are uploaded through a staging buffer on the command 
+			//! pool's queue, and the image is left in vk::ImageLayout::eShaderReadOnlyOptimal.
+			Image(const Device& device,
+				  const CommandPool& command_pool,
+				  vk::ImageUsageFlags image_usage_flags,
+				  const fsys::TextureResource& texture);
+
+			//! Returns `true` if the device supports sampling images of the specified format with optimal tiling.
+			static bool is_format_sampleable(const Device& device, vk::Format format)
+			{
+				const vk::FormatProperties format_properties = device.get_physical_device_format_properties(format);
+				return static_cast<bool>(format_properties.optimalTilingFeatures & vk::FormatFeatureFlagBits::eSampledImage);
+			}
 
 			//! Helper function for creating an image subresource range that corresponds to the first layer 
 			//! and mipmap level of an arbitrary image.
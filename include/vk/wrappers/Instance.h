@@ -70,7 +70,8 @@ namespace plume
 				//! only the VK_EXT_debug_report instance extension is enabled.
 				Options& append_required_extensions(const char* extension) { m_required_extensions.push_back(extension); return *this; }
 
-				//! Specify a complete VkApplicationInfo structure that will be used to create this instance.
+				//! Specify a complete VkApplicationInfo structure that will be used to create this instance. By default, 
+				//! the API version is Vulkan 1.2, or the version of the loader if it is older (see `get_loader_api_version()`).
 				Options& application_info(const vk::ApplicationInfo& application_info) { m_application_info = application_info; return *this; }
 
 				//! Specify the logging level that will be observed by the validation layers. By default, 
@@ -94,6 +95,14 @@ namespace plume
 
 			vk::Instance get_handle() const { return m_instance_handle.get(); }
 
+			//! Returns the Vulkan API version that this instance was created with. Devices can only use the features
+			//! of the lower of this version and the version of their physical device.
+			uint32_t get_api_version() const { return m_api_version; }
+
+			//! Returns the highest Vulkan API version supported by the loader. A Vulkan 1.0 loader rejects instances
+			//! that request any later version.
+			static uint32_t get_loader_api_version();
+
 			//! Returns a vector of structs specifying the extension properties of the instance, such as the name and
 			//! version of a particular extension.
 			const std::vector<vk::ExtensionProperties>& get_instance_extension_properties() const { return m_instance_extension_properties; }
@@ -118,6 +127,7 @@ namespace plume
 
 			vk::UniqueInstance m_instance_handle;
 			VkDebugReportCallbackEXT m_debug_report_callback;
+			uint32_t m_api_version;
 
 			std::vector<vk::ExtensionProperties> m_instance_extension_properties;
 			std::vector<vk::LayerProperties> m_instance_layer_properties;
@@ -26,8 +26,14 @@
 
 #pragma once
 
+#include <functional>
 #include <iterator>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
 #include <string>
+#include <type_traits>
 
 #include "DescriptorPool.h"
 #include "Device.h"
@@ -71,6 +77,186 @@ namespace plume
 			vk::UniquePipelineLayout m_pipeline_layout_handle;
 		};
 
+		//! A set of values for the specialization constants of a pipeline's shader stages. Constants can be set 
+		//! by ID (their `constant_id` layout qualifier) or by name (which relies on the debug names in the SPIR-V
+		//! used for reflection: shaders compiled for size keep these in their unstripped reflection code, so name 
+		//! lookups work for them too). For example:
+		//!
+		//!					layout (constant_id = 0) const uint MAX_STEPS = 128u;
+		//!
+		//! can be set with either `set(0, 64u)` or `set("MAX_STEPS", 64u)`. Values must have the type that the
+		//! shader declares (signed and unsigned integers of the same size are interchangeable): this is checked 
+		//! against the reflected constants when the pipeline is built, as is the existence of every constant.
+		//! Constants that are not set keep the default value from the shader.
+		class SpecializationConstants
+		{
+		public:
+
+			//! The map entries and data for a single shader stage. `get_info()` points into this struct, so it
+			//! must remain alive (and unmoved) until the pipeline has been created.
+			struct StageData
+			{
+				std::vector<vk::SpecializationMapEntry> entries;
+				std::vector<uint8_t> data;
+
+				vk::SpecializationInfo get_info() const;
+			};
+
+			SpecializationConstants& set(uint32_t constant_id, bool value) { return set_value(constant_id, make_value(value)); }
+			SpecializationConstants& set(uint32_t constant_id, int32_t value) { return set_value(constant_id, make_value(value)); }
+			SpecializationConstants& set(uint32_t constant_id, uint32_t value) { return set_value(constant_id, make_value(value)); }
+			SpecializationConstants& set(uint32_t constant_id, int64_t value) { return set_value(constant_id, make_value(value)); }
+			SpecializationConstants& set(uint32_t constant_id, uint64_t value) { return set_value(constant_id, make_value(value)); }
+			SpecializationConstants& set(uint32_t constant_id, float value) { return set_value(constant_id, make_value(value)); }
+			SpecializationConstants& set(uint32_t constant_id, double value) { return set_value(constant_id, make_value(value)); }
+
+			SpecializationConstants& set(const std::string& name, bool value) { return set_value(name, make_value(value)); }
+			SpecializationConstants& set(const std::string& name, int32_t value) { return set_value(name, make_value(value)); }
+			SpecializationConstants& set(const std::string& name, uint32_t value) { return set_value(name, make_value(value)); }
+			SpecializationConstants& set(const std::string& name, int64_t value) { return set_value(name, make_value(value)); }
+			SpecializationConstants& set(const std::string& name, uint64_t value) { return set_value(name, make_value(value)); }
+			SpecializationConstants& set(const std::string& name, float value) { return set_value(name, make_value(value)); }
+			SpecializationConstants& set(const std::string& name, double value) { return set_value(name, make_value(value)); }
+
+			//! Returns `true` if no constants have been set.
+			bool empty() const { return m_values_by_id.empty() && m_values_by_name.empty(); }
+
+			//! Returns a string that uniquely identifies the values in this set, which is used to cache pipelines 
+			//! by their specialization constants.
+			std::string get_key() const;
+
+			//! Builds the map entries and data of every stage in `modules` (in the same order). Throws if a value
+			//! does not match the type of its constant, or if a constant does not exist in any of the modules.
+			std::vector<StageData> build(const std::vector<std::shared_ptr<ShaderModule>>& modules) const;
+
+		private:
+
+			struct Value
+			{
+				ShaderModule::BaseType base_type;
+				uint32_t size;
+				uint64_t bits;
+			};
+
+			static Value make_value(bool value);
+			static Value make_value(int32_t value);
+			static Value make_value(uint32_t value);
+			static Value make_value(int64_t value);
+			static Value make_value(uint64_t value);
+			static Value make_value(float value);
+			static Value make_value(double value);
+
+			SpecializationConstants& set_value(uint32_t constant_id, const Value& value) { m_values_by_id[constant_id] = value; return *this; }
+
+			SpecializationConstants& set_value(const std::string& name, const Value& value) { m_values_by_name[name] = value; return *this; }
+
+			//! Appends a map entry for `constant` to `stage_data`, or throws if `value` has the wrong type.
+			static void append(const ShaderModule::SpecializationConstant& constant, const Value& value, StageData& stage_data);
+
+			std::map<uint32_t, Value> m_values_by_id;
+			std::map<std::string, Value> m_values_by_name;
+		};
+
+		//! Describes how a C++ struct maps onto the push constants block of a pipeline's shader stages, so that the 
+		//! whole block can be pushed with a single call (see CommandBuffer::push_constants()). For example:
+		//!
+		//!					layout (std430, push_constant) uniform push_constants
+		//!					{
+		//!						float time;		// offset 0
+		//!						vec2 mouse;		// offset 8
+		//!					} constants;
+		//!
+		//! can be mirrored by:
+		//!
+		//!					struct Constants { float time; float padding; glm::vec2 mouse; };
+		//!
+		//!					auto layout = PushConstantLayout::create<Constants>()
+		//!									.member("time", &Constants::time)
+		//!									.member("mouse", &Constants::mouse);
+		//!
+		//! When the pipeline is created, the offset and size of each member are checked against the reflected block
+		//! of every stage, every top-level member of the block must be registered, and the struct must be at least 
+		//! as large as the block, so a struct that has drifted from the shader is caught once rather than per draw.
+		class PushConstantLayout
+		{
+		public:
+
+			struct Member
+			{
+				std::string name;
+				uint32_t offset;
+				uint32_t size;
+			};
+
+			PushConstantLayout() :
+				m_type_id(nullptr),
+				m_size(0)
+			{}
+
+			//! Creates an empty layout for the struct `T`, which must be trivially copyable.
+			template<class T>
+			static PushConstantLayout create()
+			{
+				static_assert(std::is_trivially_copyable<T>::value, "Push constant blocks must be trivially copyable");
+				return PushConstantLayout(get_type_id<T>(), static_cast<uint32_t>(sizeof(T)));
+			}
+
+			//! Registers the member `pointer` of `T` against the block member called `name` (which may be nested,
+			//! i.e. "parent.child").
+			template<class T, class M>
+			PushConstantLayout& member(const std::string& name, M T::* pointer)
+			{
+				if (m_type_id != get_type_id<T>())
+				{
+					throw std::runtime_error("Push constant member " + name + " does not belong to the struct that this layout was created for");
+				}
+
+				// Like `offsetof()`, but for a pointer to member: the instance is never constructed or read from.
+				typename std::aligned_storage<sizeof(T), alignof(T)>::type storage;
+				const uint8_t* base = reinterpret_cast<const uint8_t*>(&storage);
+				const uint8_t* address = reinterpret_cast<const uint8_t*>(&(reinterpret_cast<const T*>(&storage)->*pointer));
+
+				m_members.push_back({ name, static_cast<uint32_t>(address - base), static_cast<uint32_t>(sizeof(M)) });
+				return *this;
+			}
+
+			//! Returns `true` if this layout was created for the struct `T` and `false` otherwise.
+			template<class T>
+			bool is_type() const { return m_type_id == get_type_id<T>(); }
+
+			//! Returns `true` if no struct has been registered (i.e. the layout was default constructed).
+			bool empty() const { return m_type_id == nullptr; }
+
+			//! Returns the size of the struct in bytes.
+			uint32_t get_size() const { return m_size; }
+
+			const std::vector<Member>& get_members() const { return m_members; }
+
+			//! Throws if the registered members do not match `block` (see above).
+			void validate(const ShaderModule::BlockLayout& block) const;
+
+		private:
+
+			using TypeId = const void*;
+
+			PushConstantLayout(TypeId type_id, uint32_t size) :
+				m_type_id(type_id),
+				m_size(size)
+			{}
+
+			//! Returns a value that is unique to `T`: the address of a static variable that is instantiated once per type.
+			template<class T>
+			static TypeId get_type_id()
+			{
+				static const char id = 0;
+				return &id;
+			}
+
+			TypeId m_type_id;
+			uint32_t m_size;
+			std::vector<Member> m_members;
+		};
+
 		//! Each pipeline is controlled by a monolithic object created from a description of all of the shader
 		//! stages and any relevant fixed-function stages. Linking the whole pipeline together allows the optimization
 		//! of shaders based on their inputs/outputs and eliminates expensive draw time state validation.
@@ -109,10 +295,18 @@ namespace plume
 				return m_push_constants_mapping.at(name);
 			}
 
+			//! Returns the single push constant range that covers every push constant used by any stage of this 
+			//! pipeline (with the stage flags of all of those stages), or a range of size 0 if there are none.
+			const vk::PushConstantRange& get_push_constant_range() const { return m_push_constant_range; }
+
+			//! Returns the layout of the struct that was registered for this pipeline's push constants (which is
+			//! empty if none was registered).
+			const PushConstantLayout& get_push_constant_layout() const { return m_push_constant_layout; }
+
 			//! Returns a descriptor set layout that holds information about the descriptor set with the given index.
 			virtual const vk::DescriptorSetLayout& get_descriptor_set_layout(uint32_t set) const final
 			{
-				return m_descriptor_set_layouts_mapping.at(set);
+				return m_descriptor_set_layouts_mapping.at(set).get();
 			}
 
 			//! Returns `true` if this pipeline owns any descriptor set layouts and `false` otherwise. If a pipeline
@@ -120,21 +314,33 @@ namespace plume
 			//! shader modules and create an appropriate pipeline layout.
 			bool has_cached_layouts() { return m_descriptor_set_layouts_mapping.size() > 0; }
 
+			//! Returns `true` if any stage of this pipeline reads the built-in per-frame uniforms, which are bound 
+			//! at a reserved set by FrameUniforms::bind().
+			bool uses_frame_uniforms() const { return m_uses_frame_uniforms; }
+
 			friend std::ostream& operator<<(std::ostream& stream, const Pipeline& pipeline);
 
 		protected:
 
 			//! Builds the struct required to create a new vk::ShaderModule handle. For now, we assume that the entry point for 
-			//! each shader module is always "main."
-			vk::PipelineShaderStageCreateInfo build_shader_stage_create_info(const std::shared_ptr<ShaderModule>& module);
+			//! each shader module is always "main." If `specialization_info` is not `nullptr`, it must remain valid until the
+			//! pipeline has been created.
+			vk::PipelineShaderStageCreateInfo build_shader_stage_create_info(const std::shared_ptr<ShaderModule>& module, const vk::SpecializationInfo* specialization_info = nullptr);
 
 			//! Given a shader module and shader stage, add all of the module's push constants to the pipeline object's global map.
 			void add_push_constants_to_global_map(const std::shared_ptr<ShaderModule>& module);
 
+			//! Merges the push constants of every stage into a single range (see `get_push_constant_range()`) and, if
+			//! `layout` is not empty, validates it against the push constants block of each of `modules`.
+			void build_push_constant_range(const std::vector<std::shared_ptr<ShaderModule>>& modules, const PushConstantLayout& layout);
+
 			//! Given a shader module and shader stage, add all of the module's descriptors to the pipeline object's global map.
+			//! The built-in frame uniforms are given the dynamic uniform buffer binding that FrameUniforms expects, and
+			//! any other descriptor at their reserved set is an error.
 			void add_descriptors_to_global_map(const std::shared_ptr<ShaderModule>& module);
 
-			//! Generate all of the descriptor set layout handles.		
+			//! Generate all of the descriptor set layout handles. Sets below the highest one that no stage uses are
+			//! given empty layouts, since the pipeline layout identifies each set by its position.
 			void build_descriptor_set_layouts();
 
 			const Device* m_device_ptr;
@@ -142,8 +348,11 @@ namespace plume
 			vk::UniquePipelineLayout m_pipeline_layout_handle;
 
 			std::map<std::string, vk::PushConstantRange> m_push_constants_mapping;
+			vk::PushConstantRange m_push_constant_range;
+			PushConstantLayout m_push_constant_layout;
 			std::map<uint32_t, std::vector<vk::DescriptorSetLayoutBinding>> m_descriptors_mapping;
-			std::map<uint32_t, vk::DescriptorSetLayout> m_descriptor_set_layouts_mapping;
+			std::map<uint32_t, vk::UniqueDescriptorSetLayout> m_descriptor_set_layouts_mapping;
+			bool m_uses_frame_uniforms = false;
 		};
 
 		class GraphicsPipeline : public Pipeline
@@ -301,6 +510,21 @@ namespace plume
 				//! Specify which subpass of the render pass that this pipeline will be associated with.
 				Options& subpass_index(uint32_t index) { m_subpass_index = index; return *this; }
 
+				//! Set the values of the specialization constants of the attached shader stages, replacing any that
+				//! were set previously.
+				Options& specialization_constants(const SpecializationConstants& constants) { m_specialization_constants = constants; return *this; }
+
+				//! Set the value of a single specialization constant by ID or by name (see SpecializationConstants).
+				template<class T>
+				Options& specialization_constant(uint32_t constant_id, T value) { m_specialization_constants.set(constant_id, value); return *this; }
+
+				template<class T>
+				Options& specialization_constant(const std::string& name, T value) { m_specialization_constants.set(name, value); return *this; }
+
+				//! Register the struct that mirrors the push constants block of the attached shader stages, which is
+				//! validated when the pipeline is created (see PushConstantLayout).
+				Options& push_constant_layout(const PushConstantLayout& layout) { m_push_constant_layout = layout; return *this; }
+
 			private:
 
 				vk::PipelineColorBlendStateCreateInfo		m_color_blend_state_create_info;	// TODO: this needs to be re-worked.
@@ -325,6 +549,9 @@ namespace plume
 				std::vector<std::shared_ptr<ShaderModule>> m_shader_stages;
 				uint32_t m_subpass_index;
 
+				SpecializationConstants m_specialization_constants;
+				PushConstantLayout m_push_constant_layout;
+
 				friend class GraphicsPipeline;
 			};
 
@@ -375,7 +602,10 @@ namespace plume
 
 			ComputePipeline() = default; 
 
-			ComputePipeline(const Device& device, const std::shared_ptr<ShaderModule>& compute_shader_module);
+			ComputePipeline(const Device& device, 
+							const std::shared_ptr<ShaderModule>& compute_shader_module, 
+							const SpecializationConstants& constants = SpecializationConstants(), 
+							const PushConstantLayout& push_constant_layout = PushConstantLayout());
 
 			vk::PipelineBindPoint get_pipeline_bind_point() const override { return vk::PipelineBindPoint::eCompute; }
 
@@ -383,6 +613,65 @@ namespace plume
 
 		};
 
+		//! Builds pipelines that only differ in the values of their specialization constants on demand and caches
+		//! them by those values, so that a shader can be specialized (i.e. per quality level) without compiling a 
+		//! new source variant, and each specialization is only built once. For example:
+		//!
+		//!		SpecializedPipelineCache<GraphicsPipeline> pipelines{ [&](const SpecializationConstants& constants) {
+		//!			return std::make_unique<GraphicsPipeline>(device, render_pass, GraphicsPipeline::Options(options).specialization_constants(constants));
+		//!		} };
+		//!		const auto& pipeline = pipelines.get(SpecializationConstants().set("MAX_STEPS", 64u));
+		//!
+		//! References returned by `get()` remain valid for the lifetime of the cache. All functions are thread-safe.
+		template<class PipelineType>
+		class SpecializedPipelineCache
+		{
+		public:
+
+			using FactoryFuncType = std::function<std::unique_ptr<PipelineType>(const SpecializationConstants&)>;
+
+			SpecializedPipelineCache(FactoryFuncType factory) :
+				m_factory(factory)
+			{}
+
+			//! Returns the pipeline specialized with `constants`, building it if this is the first request.
+			const PipelineType& get(const SpecializationConstants& constants)
+			{
+				const std::string key = constants.get_key();
+
+				std::lock_guard<std::mutex> lock(m_mutex);
+
+				auto it = m_pipelines.find(key);
+				if (it == m_pipelines.end())
+				{
+					it = m_pipelines.emplace(key, m_factory(constants)).first;
+				}
+
+				return *it->second;
+			}
+
+			//! Returns the number of pipelines that have been built.
+			size_t size() const
+			{
+				std::lock_guard<std::mutex> lock(m_mutex);
+				return m_pipelines.size();
+			}
+
+			//! Destroys every pipeline. Note that this invalidates every reference returned by `get()`.
+			void clear()
+			{
+				std::lock_guard<std::mutex> lock(m_mutex);
+				m_pipelines.clear();
+			}
+
+		private:
+
+			FactoryFuncType m_factory;
+
+			mutable std::mutex m_mutex;
+			std::map<std::string, std::unique_ptr<PipelineType>> m_pipelines;
+		};
+
 	} // namespace graphics
 
 } // namespace plume
\ No newline at end of file
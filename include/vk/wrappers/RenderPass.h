@@ -92,6 +92,27 @@ namespace plume
 				return subpass_dependency;
 			}
 
+			//! Like the default dependency, but also orders the depth / stencil tests and writes of this subpass after 
+			//! those of any previously submitted render pass. Use this when the color or depth / stencil attachments are
+			//! shared between frames in flight, so that one frame's clear does not race with the previous frame's writes.
+			static vk::SubpassDependency create_color_depth_subpass_dependency()
+			{
+				const vk::PipelineStageFlags stage_mask = vk::PipelineStageFlagBits::eColorAttachmentOutput | 
+														  vk::PipelineStageFlagBits::eEarlyFragmentTests | 
+														  vk::PipelineStageFlagBits::eLateFragmentTests;
+
+				vk::SubpassDependency subpass_dependency;
+				subpass_dependency.srcSubpass = VK_SUBPASS_EXTERNAL;
+				subpass_dependency.dstSubpass = 0;
+				subpass_dependency.srcStageMask = stage_mask;
+				subpass_dependency.srcAccessMask = vk::AccessFlagBits::eColorAttachmentWrite | vk::AccessFlagBits::eDepthStencilAttachmentWrite;
+				subpass_dependency.dstStageMask = stage_mask;
+				subpass_dependency.dstAccessMask = vk::AccessFlagBits::eColorAttachmentRead | vk::AccessFlagBits::eColorAttachmentWrite |
+												   vk::AccessFlagBits::eDepthStencilAttachmentRead | vk::AccessFlagBits::eDepthStencilAttachmentWrite;
+
+				return subpass_dependency;
+			}
+
 			//! Factory method for constructing a new shared RenderPassBuilder. Note that a single RenderPassBuilder
 			//! can be owned by multiple RenderPass instances, which is why shared pointer semantics are enforced.
 			static std::shared_ptr<RenderPassBuilder> create()
@@ -0,0 +1,183 @@
+/*
+*
+* MIT License
+*
+* Copyright(c) 2017 Michael Walczyk
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files(the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions :
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*
+*/
+
+#pragma once
+
+#include <functional>
+#include <future>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "FileWatcher.h"
+#include "Pipeline.h"
+#include "ShaderCompiler.h"
+#include "ShaderModule.h"
+#include "Synchronization.h"
+
+namespace plume
+{
+
+	namespace graphics
+	{
+
+		//! Rebuilds pipelines while the application is running whenever the source of one of their shaders (or a
+		//! file that it includes) is saved. For example:
+		//!
+		//!		ShaderHotReloader reloader{ device, compiler };
+		//!		auto id = reloader.add({ { "shaders/raymarch.vert", options }, { "shaders/raymarch.frag", options } }, [&](const auto& modules) {
+		//!			return std::make_unique<GraphicsPipeline>(device, render_pass, GraphicsPipeline::Options(options).attach_shader_stages(modules));
+		//!		});
+		//!
+		//!		// Once per frame, before recording:
+		//!		reloader.update(fence_of_the_previous_frame);
+		//!		command_buffer.bind_pipeline(reloader.get(id));
+		//!
+		//! Changes are picked up by a FileWatcher. Only the pipelines whose shaders depend on a changed file are 
+		//! rebuilt, on the toolkit's thread pool: their shaders are requested from the ShaderCompiler again, which
+		//! only recompiles the stale ones and serves the rest from its cache. Rendering continues with the old 
+		//! pipeline in the meantime. A finished pipeline is swapped in by `update()`, so the swap always happens 
+		//! between frames, and the old pipeline is destroyed once the fence of the last frame that could have used
+		//! it has signaled, rather than by waiting for the device to go idle. If a shader fails to compile (or the 
+		//! factory throws), the old pipeline is kept and the error is reported by `update()`.
+		class ShaderHotReloader
+		{
+		public:
+
+			//! Builds a pipeline from shader modules that were created from the jobs' binaries (in the same order).
+			//! Rebuilds call it on a worker thread, so anything that it captures must not be modified while the 
+			//! reloader is in use.
+			using FactoryFuncType = std::function<std::unique_ptr<Pipeline>(const std::vector<std::shared_ptr<ShaderModule>>&)>;
+
+			//! Identifies a pipeline that was registered with `add()`.
+			using PipelineId = size_t;
+
+			//! The outcome of a rebuild, as reported by `update()`.
+			struct ReloadEvent
+			{
+				PipelineId id;
+				bool succeeded;
+
+				//! The compiler's diagnostics (or the factory's exception message) if the rebuild failed.
+				std::string error;
+
+				//! The time from the change being noticed to the rebuild finishing (or failing) on the worker thread.
+				double seconds;
+			};
+
+			ShaderHotReloader(const Device& device, fsys::ShaderCompiler& compiler);
+
+			ShaderHotReloader(const ShaderHotReloader& other) = delete;
+
+			ShaderHotReloader& operator=(const ShaderHotReloader& other) = delete;
+
+			//! Waits for any rebuilds that are still running. Retired pipelines are destroyed immediately, so the
+			//! device must not be using them anymore (i.e. call Device::wait_idle() first).
+			~ShaderHotReloader();
+
+			//! Compiles `jobs` (through the compiler's cache), builds the initial pipeline with `factory` on the
+			//! calling thread, and starts watching every file that the shaders were compiled from. Throws if a 
+			//! shader fails to compile.
+			PipelineId add(const std::vector<fsys::ShaderCompiler::Job>& jobs, FactoryFuncType factory);
+
+			//! Returns the live pipeline registered as `id`. The reference remains valid until the `update()` that
+			//! replaces it, so it should be fetched again every frame.
+			const Pipeline& get(PipelineId id) const { return *m_entries.at(id).pipeline; }
+
+			//! Returns the shader modules that the live pipeline registered as `id` was built from.
+			const std::vector<std::shared_ptr<ShaderModule>>& get_shader_modules(PipelineId id) const { return m_entries.at(id).modules; }
+
+			//! Call this once per frame, at a frame boundary (before recording any commands that use the pipelines). 
+			//! It destroys retired pipelines whose fence has signaled, swaps in any pipelines that have finished 
+			//! rebuilding, and starts rebuilding the pipelines that depend on files that changed since the last call.
+			//! `last_submitted` must be the fence of the most recent submission that may use the pipelines: it 
+			//! guards the pipelines that are replaced by this call. Never blocks.
+			std::vector<ReloadEvent> update(const Fence& last_submitted);
+
+			//! Returns the number of pipelines that are being rebuilt.
+			size_t get_pending_count() const;
+
+			//! Returns the number of replaced pipelines that are waiting for their fence.
+			size_t get_retired_count() const { return m_retired.size(); }
+
+		private:
+
+			//! The result of a rebuild, which is produced on the thread pool.
+			struct Build
+			{
+				std::unique_ptr<Pipeline> pipeline;
+				std::vector<std::shared_ptr<ShaderModule>> modules;
+				std::vector<std::string> dependencies;
+			};
+
+			struct Entry
+			{
+				std::vector<fsys::ShaderCompiler::Job> jobs;
+				FactoryFuncType factory;
+
+				std::unique_ptr<Pipeline> pipeline;
+				std::vector<std::shared_ptr<ShaderModule>> modules;
+
+				//! The rebuild in progress (if any), and how long it took, which the worker records as soon as the
+				//! rebuild finishes (or fails) so that the time spent waiting for `update()` is not included.
+				std::future<Build> pending;
+				std::shared_ptr<double> pending_seconds;
+
+				//! Set if a file changed again while a rebuild was in progress, which then has to be started over.
+				bool is_stale;
+			};
+
+			struct RetiredPipeline
+			{
+				std::unique_ptr<Pipeline> pipeline;
+				const Fence* fence;
+			};
+
+			//! Compiles `jobs`, creates their shader modules, and calls `factory`. Throws on failure.
+			static Build build(const Device& device, fsys::ShaderCompiler& compiler, const std::vector<fsys::ShaderCompiler::Job>& jobs, const FactoryFuncType& factory);
+
+			//! Starts rebuilding `entry` on the thread pool.
+			void launch(Entry& entry);
+
+			//! Watches the files called `dependencies` (names in the virtual file system) that are loose files on disk.
+			void watch(const std::vector<std::string>& dependencies);
+
+			const Device* m_device_ptr;
+			fsys::ShaderCompiler* m_compiler_ptr;
+
+			fsys::FileWatcher m_watcher;
+
+			//! Maps the path on disk of each watched file to its name in the virtual file system.
+			std::map<std::string, std::string> m_watched_names;
+
+			std::vector<Entry> m_entries;
+			std::vector<RetiredPipeline> m_retired;
+		};
+
+	} // namespace graphics
+
+} // namespace plume
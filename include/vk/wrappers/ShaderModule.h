@@ -30,7 +30,9 @@
 #include "shaderc/shaderc.hpp"
 
 #include "Device.h"
+#include "Geometry.h"
 #include "ResourceManager.h"
+#include "ShaderCompiler.h"
 
 namespace plume
 {
@@ -47,6 +49,31 @@ namespace plume
 
 		public:
 
+			//! The scalar type of a reflected variable, block member, or specialization constant.
+			enum class BaseType
+			{
+				BASE_TYPE_BOOL,
+				BASE_TYPE_INT,
+				BASE_TYPE_UINT,
+				BASE_TYPE_INT64,
+				BASE_TYPE_UINT64,
+				BASE_TYPE_FLOAT,
+				BASE_TYPE_DOUBLE,
+				BASE_TYPE_STRUCT,
+				BASE_TYPE_OTHER
+			};
+
+			//! The kind of resource that a block (see BlockLayout) is bound as.
+			enum class BlockType
+			{
+				BLOCK_TYPE_UNIFORM_BUFFER,
+				BLOCK_TYPE_STORAGE_BUFFER,
+				BLOCK_TYPE_PUSH_CONSTANT
+			};
+
+			//! Returned in place of a specialization constant ID when there is none.
+			static const uint32_t no_constant_id = 0xFFFFFFFF;
+
 			//! A struct representing a memmber within a push constants block inside of a GLSL shader. For example:
 			//!
 			//!					layout (std430, push_constant) uniform push_constants
@@ -73,6 +100,115 @@ namespace plume
 				uint32_t layout_location;
 				uint32_t size;
 				std::string name;
+
+				//! `true` if the shader actually reads the input, which it may declare without using (i.e. when the
+				//! declarations are shared between several shaders).
+				bool is_read;
+			};
+
+			//! A struct representing an output of a shader stage. For example:
+			//!
+			//!					layout (location = 0) out vec4 o_color;
+			struct StageOutput
+			{
+				uint32_t layout_location;
+				uint32_t size;
+				std::string name;
+			};
+
+			//! A struct representing a member of a uniform buffer, storage buffer, or push constants block. The
+			//! members of nested structs are listed right after the struct member itself, with names of the form
+			//! "parent.child" and offsets relative to the start of the block. For arrays of structs, the offsets 
+			//! of the nested members are those of the first element: add a multiple of the parent's `array_stride`
+			//! to address the others.
+			struct BlockMember
+			{
+				std::string name;
+				uint32_t offset;
+
+				//! The size of the member in bytes, including every array element. This is 0 for runtime arrays.
+				uint32_t size;
+
+				BaseType base_type;
+
+				//! The number of components in each column (i.e. 3 for a `vec3` or a `mat4x3`).
+				uint32_t vector_size;
+
+				//! The number of columns (1 for anything that is not a matrix).
+				uint32_t columns;
+
+				//! The number of array elements (the product of every dimension), 0 if the member is not an array,
+				//! or `runtime_array_size` if it is an unsized array (only valid as the last member of a storage 
+				//! buffer).
+				uint32_t array_size;
+
+				//! The distance in bytes between consecutive array elements, or 0 if the member is not an array.
+				uint32_t array_stride;
+
+				//! The distance in bytes between consecutive columns (or rows, for row-major matrices), or 0 if the
+				//! member is not a matrix.
+				uint32_t matrix_stride;
+
+				bool is_row_major;
+			};
+
+			//! Stands in for the array size of an unsized (runtime) array.
+			static const uint32_t runtime_array_size = 0xFFFFFFFF;
+
+			//! The memory layout of a uniform buffer, storage buffer, or push constants block, as declared in the
+			//! shader (i.e. with std140 or std430 rules applied). For example:
+			//!
+			//!					layout (set = 0, binding = 0) uniform camera_data
+			//!					{
+			//!						mat4 view;			// offset 0, matrix stride 16
+			//!						vec3 position;		// offset 64
+			//!						float lights[4];	// offset 80, array stride 16
+			//!					} camera;
+			struct BlockLayout
+			{
+				std::string name;
+				BlockType block_type;
+
+				//! The descriptor set and binding of the block (both 0 for push constants blocks).
+				uint32_t layout_set;
+				uint32_t layout_binding;
+
+				//! The declared size of the block in bytes, excluding any runtime array at its end.
+				uint32_t size;
+
+				std::vector<BlockMember> members;
+
+				//! Returns the member called `name` (which may be nested, i.e. "parent.child") or `nullptr` if 
+				//! there is no such member.
+				const BlockMember* find_member(const std::string& name) const;
+			};
+
+			//! A struct representing a specialization constant. For example:
+			//!
+			//!					layout (constant_id = 3) const int sample_count = 8;
+			struct SpecializationConstant
+			{
+				uint32_t constant_id;
+				std::string name;
+				BaseType base_type;
+
+				//! The size of the constant in bytes: 4, or 8 for 64-bit types (booleans are 4 bytes, as in 
+				//! VkSpecializationMapEntry).
+				uint32_t size;
+
+				//! The bits of the constant's default value, i.e. a `float` default should be read back with 
+				//! `memcpy()` from the low 4 bytes.
+				uint64_t default_value;
+			};
+
+			//! The local workgroup size of a compute shader. Each dimension may be overridden by a specialization 
+			//! constant (i.e. `layout (local_size_x_id = 0) in;`), in which case `constant_ids` holds its ID.
+			struct WorkgroupSize
+			{
+				uint32_t x;
+				uint32_t y;
+				uint32_t z;
+				uint32_t constant_ids[3];
 			};
 
 			//! A struct representing a descriptor inside of a GLSL shader. For example:
@@ -91,10 +227,55 @@ namespace plume
 				vk::DescriptorSetLayoutBinding layout_binding;
 			};
 
+			//! Counters describing the reflection cache (see `set_reflection_cache_directory()`), which are shared
+			//! by every shader module.
+			struct ReflectionStatistics
+			{
+				//! The number of modules whose reflection data was read from the cache.
+				uint64_t cache_hits;
+
+				//! The number of modules that were reflected with spirv-cross.
+				uint64_t cache_misses;
+
+				//! The total time spent reflecting modules with spirv-cross.
+				double reflection_seconds;
+
+				//! The total time spent reading reflection data from the cache.
+				double cache_load_seconds;
+
+				//! The time that the cache saved: the time that spirv-cross took to reflect the modules that were
+				//! read from the cache (as measured when their entries were written), minus `cache_load_seconds`.
+				double seconds_saved;
+			};
+
+			//! Sets the directory in which the results of reflection are cached, keyed by the hash of the SPIR-V.
+			//! Modules whose SPIR-V has been seen before load their push constants, stage inputs, descriptors, etc.
+			//! from the cache instead of parsing the SPIR-V with spirv-cross. This is usually the same directory 
+			//! that the ShaderCompiler caches SPIR-V in. The cache is disabled if `directory` is empty (the default).
+			static void set_reflection_cache_directory(const std::string& directory);
+
+			//! Returns a snapshot of the reflection cache's counters.
+			static ReflectionStatistics get_reflection_statistics();
+
 			//! Factory method for constructing a new shared ShaderModule.
 			static std::shared_ptr<ShaderModule> create(const Device& device, const fsys::FileResource& resouce)
 			{
-				return std::shared_ptr<ShaderModule>(new ShaderModule(device, resouce));
+				return std::shared_ptr<ShaderModule>(new ShaderModule(device, resouce.contents.data(), resouce.contents.size()));
+			}
+
+			//! Factory method for constructing a new shared ShaderModule from a memory-mapped SPIR-V file. The
+			//! SPIR-V is handed to the driver straight from the mapped pages.
+			static std::shared_ptr<ShaderModule> create(const Device& device, const fsys::MappedFileResource& resource)
+			{
+				return std::shared_ptr<ShaderModule>(new ShaderModule(device, resource.data(), resource.size()));
+			}
+
+			//! Factory method for constructing a new shared ShaderModule from GLSL that was compiled at runtime. If 
+			//! debug info was stripped from the binary, reflection is performed on its unstripped code, so names 
+			//! are still available.
+			static std::shared_ptr<ShaderModule> create(const Device& device, const fsys::ShaderBinary& binary)
+			{
+				return std::shared_ptr<ShaderModule>(new ShaderModule(device, reinterpret_cast<const uint8_t*>(binary.code.data()), binary.code.size() * sizeof(uint32_t), binary.reflection_code));
 			}
 
 			vk::ShaderModule get_handle() const { return m_shader_module_handle.get(); }
@@ -111,26 +292,82 @@ namespace plume
 			//! Retrieve a list of low-level details about the descriptors contained within this GLSL shader.
 			const std::vector<Descriptor>& get_descriptors() const { return m_descriptors; }
 
+			//! Retrieve a list of the user-defined inputs of this shader stage, sorted by location.
+			const std::vector<StageInput>& get_stage_inputs() const { return m_stage_inputs; }
+
+			//! Returns the interleaved vertex format that contains exactly the attributes that this vertex shader 
+			//! reads, packed in the order of their locations. Inputs are matched to geometry attributes by name if
+			//! they use one of the built-in names (`pl_position`, `pl_color`, `pl_normal`, or `pl_texcoord`) and by
+			//! location otherwise (in the order of geom::VertexAttribute). Throws if this is not a vertex shader or
+			//! an input that is read does not correspond to any attribute.
+			geom::VertexFormat get_vertex_format() const;
+
+			//! Retrieve a list of the user-defined outputs of this shader stage, sorted by location.
+			const std::vector<StageOutput>& get_stage_outputs() const { return m_stage_outputs; }
+
+			//! Retrieve the memory layouts of every uniform buffer, storage buffer, and push constants block.
+			const std::vector<BlockLayout>& get_blocks() const { return m_blocks; }
+
+			//! Returns the block called `name` or `nullptr` if there is no such block.
+			const BlockLayout* find_block(const std::string& name) const;
+
+			//! Returns the push constants block or `nullptr` if this shader does not declare one.
+			const BlockLayout* get_push_constant_block() const;
+
+			//! Returns the uniform block that holds the built-in per-frame uniforms (`pl_time`, `pl_resolution`, and
+			//! `pl_mouse`), which is recognized by the names of its members, or `nullptr` if this shader does not
+			//! declare one (see FrameUniforms).
+			const BlockLayout* get_frame_uniforms_block() const;
+
+			//! Retrieve a list of the specialization constants declared in this shader, sorted by ID.
+			const std::vector<SpecializationConstant>& get_specialization_constants() const { return m_specialization_constants; }
+
+			//! Returns the specialization constant called `name` or `nullptr` if there is no such constant.
+			const SpecializationConstant* find_specialization_constant(const std::string& name) const;
+
+			//! Returns the local workgroup size of this shader. This is only meaningful for compute shaders 
+			//! (for other stages it is 1 x 1 x 1 with no specialization constants).
+			const WorkgroupSize& get_workgroup_size() const { return m_workgroup_size; }
+
 			//! Returns the shader stage corresponding to this module (i.e. vk::ShaderStageFlagBits::eVertex).
 			vk::ShaderStageFlagBits get_stage() const { return m_shader_stage; }
 
 		private:
 
-			ShaderModule(const Device& device, const fsys::FileResource& resouce);
+			//! Note that `size` is the size of the SPIR-V binary in bytes, not words.
+			//! `reflection_code`, if not empty, is reflected instead of the module's code (i.e. because the names
+			//! have been stripped from the latter).
+			ShaderModule(const Device& device, const uint8_t* code, size_t size, const std::vector<uint32_t>& reflection_code = {});
+
+			void perform_reflection(const std::vector<uint32_t>& code);
 
-			void perform_reflection();
+			//! Reads the reflection data stored at `path`. Returns `false` (leaving the module's reflection data 
+			//! empty) if the file does not exist, is corrupt, or does not belong to this module's SPIR-V.
+			//! `reflection_nanoseconds` receives the time that spirv-cross took when the entry was written.
+			bool load_reflection(const std::string& path, uint64_t code_hash, uint64_t& reflection_nanoseconds);
+
+			//! Writes this module's reflection data to `path`. Failures are ignored.
+			void save_reflection(const std::string& path, uint64_t code_hash, uint64_t reflection_nanoseconds) const;
 
 			//! Used during reflection to convert a shader resource into a descriptor struct.
 			void resource_to_descriptor(const spirv_cross::CompilerGLSL& compiler, const spirv_cross::Resource& resource, vk::DescriptorType descriptor_type);
 
+			//! Used during reflection to record the memory layout of a uniform buffer, storage buffer, or push 
+			//! constants block.
+			void resource_to_block(const spirv_cross::CompilerGLSL& compiler, const spirv_cross::Resource& resource, BlockType block_type);
+
 			const Device* m_device_ptr;
 			vk::UniqueShaderModule m_shader_module_handle;
 
 			std::vector<uint32_t> m_shader_code;
 			std::vector<std::string> m_entry_points;
 			std::vector<StageInput> m_stage_inputs;
+			std::vector<StageOutput> m_stage_outputs;
 			std::vector<PushConstant> m_push_constants;
 			std::vector<Descriptor> m_descriptors;
+			std::vector<BlockLayout> m_blocks;
+			std::vector<SpecializationConstant> m_specialization_constants;
+			WorkgroupSize m_workgroup_size;
 			vk::ShaderStageFlagBits m_shader_stage;
 		};
 
@@ -26,6 +26,8 @@
 
 #pragma once
 
+#include <vector>
+
 #include "Device.h"
 
 namespace plume
@@ -124,6 +126,107 @@ namespace plume
 			vk::UniqueEvent m_event_handle;
 		};
 
+		//! Timeline semaphores are semaphores whose state is a monotonically increasing 64-bit counter, rather than a 
+		//! binary signaled / unsignaled state. A queue submission can wait for the counter to reach a particular value
+		//! and signal (set) it to a larger value once its work has completed. Unlike binary semaphores, the counter can 
+		//! also be waited on, signaled, and queried from the host. This means that a single timeline semaphore can 
+		//! replace a fence per operation: each piece of work (i.e. an async compute dispatch, a transfer, or a readback) 
+		//! is simply assigned the next point on the timeline with `advance()`.
+		//!
+		//! Timeline semaphores require Vulkan 1.2 or VK_KHR_timeline_semaphore (see `Device::supports_timeline_semaphores()`). Note that they cannot
+		//! be used for swapchain image acquisition or presentation, which still require binary semaphores.
+		class TimelineSemaphore
+		{
+		public:
+
+			TimelineSemaphore() = default; 
+
+			TimelineSemaphore(const Device& device, uint64_t initial_value = 0);
+
+			vk::Semaphore get_handle() const { return m_semaphore_handle.get(); };
+
+			//! Returns the next point on this timeline, i.e. a value one greater than the last value returned by this
+			//! function (or the initial value). Use this as the signal value of the next operation to add to the timeline.
+			uint64_t advance() { return ++m_last_value; }
+
+			//! Returns the last point returned by `advance()` (or the initial value). Once the counter reaches this
+			//! value, all of the work that has been added to the timeline so far has completed.
+			uint64_t get_last_value() const { return m_last_value; }
+
+			//! Returns the current value of the semaphore's counter, which may lag behind `get_last_value()` while work
+			//! is still executing on the device.
+			uint64_t get_value() const;
+
+			//! Returns `true` if the counter has reached (at least) `value`.
+			bool is_reached(uint64_t value) const { return get_value() >= value; }
+
+			//! Sets the counter to `value` from the host. `value` must be greater than the current value of the counter
+			//! and less than any value that a pending queue submission will signal.
+			void signal(uint64_t value);
+
+			//! Forces the host to wait on the counter to reach (at least) `value`. Returns `false` if `timeout` (in 
+			//! nanoseconds) elapsed first.
+			bool wait_for(uint64_t value, uint64_t timeout = std::numeric_limits<uint64_t>::max()) const;
+
+		private:
+
+			const Device* m_device_ptr;
+			vk::UniqueSemaphore m_semaphore_handle;
+			uint64_t m_last_value = 0;
+		};
+
+		//! A single batch of work for `Device::submit()`: the command buffers to execute, the semaphores to wait on 
+		//! before executing them, and the semaphores to signal once they have completed. Binary and timeline semaphores
+		//! can be mixed freely within a batch. For example:
+		//!
+		//!		const uint64_t simulated = timeline.advance();
+		//!		device.submit(QueueType::COMPUTE, { Submission().command_buffer(simulate).signal(timeline, simulated) });
+		//!		device.submit(QueueType::GRAPHICS, { Submission().command_buffer(draw)
+		//!														.wait(image_available, vk::PipelineStageFlagBits::eColorAttachmentOutput)
+		//!														.wait(timeline, simulated, vk::PipelineStageFlagBits::eVertexInput)
+		//!														.signal(render_complete)
+		//!														.signal(timeline, timeline.advance()) });
+		//!
+		//! The semaphores and command buffers must outlive the call to `Device::submit()`.
+		class Submission
+		{
+		public:
+
+			//! Adds a command buffer to execute, in the order that they are added.
+			Submission& command_buffer(const CommandBuffer& command_buffer);
+
+			//! Waits for a binary semaphore to be signaled before the stages in `stage_flags` execute.
+			Submission& wait(const Semaphore& semaphore, vk::PipelineStageFlags stage_flags);
+
+			//! Waits for a timeline semaphore to reach (at least) `value` before the stages in `stage_flags` execute.
+			Submission& wait(const TimelineSemaphore& semaphore, uint64_t value, vk::PipelineStageFlags stage_flags);
+
+			//! Signals a binary semaphore once all of the command buffers in this batch have completed.
+			Submission& signal(const Semaphore& semaphore);
+
+			//! Sets a timeline semaphore's counter to `value` once all of the command buffers in this batch have completed.
+			Submission& signal(const TimelineSemaphore& semaphore, uint64_t value);
+
+			//! Returns `true` if this batch waits on or signals at least one timeline semaphore.
+			bool uses_timeline_semaphores() const { return m_uses_timeline_semaphores; }
+
+		private:
+
+			std::vector<vk::CommandBuffer> m_command_buffers;
+
+			//! The values of the wait and signal semaphores, stored in parallel with the semaphores themselves. Values
+			//! for binary semaphores are ignored. 
+			std::vector<vk::Semaphore> m_wait_semaphores;
+			std::vector<uint64_t> m_wait_values;
+			std::vector<vk::PipelineStageFlags> m_wait_stage_flags;
+			std::vector<vk::Semaphore> m_signal_semaphores;
+			std::vector<uint64_t> m_signal_values;
+
+			bool m_uses_timeline_semaphores = false;
+
+			friend class Device;
+		};
+
 	} // namespace graphics
 
 } // namespace plume
\ No newline at end of file
@@ -27,16 +27,19 @@
 #pragma once
 
 #include "Buffer.h"
+#include "BufferLayout.h"
 #include "CommandBuffer.h"
 #include "CommandPool.h"
 #include "DescriptorPool.h"
 #include "Device.h"
+#include "FrameUniforms.h"
 #include "Framebuffer.h"
 #include "Image.h"
 #include "Instance.h"
 #include "Pipeline.h"
 #include "RenderPass.h"
 #include "Sampler.h"
+#include "ShaderHotReloader.h"
 #include "ShaderModule.h"
 #include "Swapchain.h"
 #include "Synchronization.h"
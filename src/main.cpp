@@ -5,18 +5,13 @@
 
 #include "gtc/matrix_transform.hpp"  
 
-struct UniformBufferData
-{
-	glm::mat4 model;
-	glm::mat4 view;
-	glm::mat4 projection;
-};
-
-UniformBufferData ubo_data;
+// The layout of uniform_buffer_object (model, view, and projection matrices) in raymarch.vert.
+using UniformBufferLayout = pl::graphics::Std140Layout<glm::mat4, glm::mat4, glm::mat4>;
 
 static const uint32_t width = 800;
 static const uint32_t height = 800;
 static const uint32_t msaa = 8;
+static const uint32_t frames_in_flight = 2;
 const std::string base_shader_path = "shaders/";
 
 int main()
@@ -28,7 +23,7 @@ int main()
 	 ***********************************************************************************/
 	pl::graphics::Instance instance;
 	pl::graphics::Window window{ instance, width, height };
-	pl::graphics::Device device{ instance.get_physical_devices()[0], window.get_surface_handle() };
+	pl::graphics::Device device{ instance, instance.get_physical_devices()[0], window.get_surface_handle() };
 	pl::graphics::Swapchain swapchain{ device, window.get_surface_handle(), width, height };
 
         auto swapchain_image_views = swapchain.get_image_view_handles();
@@ -50,7 +45,7 @@ int main()
 	rpb->append_attachment_to_subpass("color_inter", pl::graphics::AttachmentCategory::CATEGORY_COLOR);
 	rpb->append_attachment_to_subpass("color_final", pl::graphics::AttachmentCategory::CATEGORY_RESOLVE);
 	rpb->append_attachment_to_subpass("depth", pl::graphics::AttachmentCategory::CATEGORY_DEPTH_STENCIL);
-	rpb->end_subpass_record();
+	rpb->end_subpass_record(pl::graphics::RenderPassBuilder::create_color_depth_subpass_dependency());	// the multisample and depth images are shared by all frames in flight
 
 	pl::graphics::RenderPass render_pass{ device, rpb };
 
@@ -60,29 +55,44 @@ int main()
 	 *
 	 ***********************************************************************************/
 	pl::geom::Rect geometry = pl::geom::Rect();
-	pl::graphics::Buffer vbo{ device, vk::BufferUsageFlagBits::eVertexBuffer, geometry.get_packed_vertex_attributes() };
 	pl::graphics::Buffer ibo{ device, vk::BufferUsageFlagBits::eIndexBuffer, geometry.get_indices() };
-	pl::graphics::Buffer ubo{ device, vk::BufferUsageFlagBits::eUniformBuffer, sizeof(UniformBufferData), nullptr };
-
-	ubo_data =
+	pl::graphics::Buffer ubo{ device, vk::BufferUsageFlagBits::eUniformBuffer, UniformBufferLayout::get_size(), nullptr };
+
+	// The buffer's memory is host coherent, so the matrices can be written straight into the mapping.
+	UniformBufferLayout::write(ubo.map(),
+							   glm::mat4(1.0f),
+							   glm::lookAt({ 0.0f, 0.0, 3.0f },{ 0.0f, 0.0, 0.0f }, glm::vec3(0.0f, 1.0f, 0.0f)),
+							   glm::perspective(45.0f, window.get_aspect_ratio(), 0.1f, 1000.0f));
+	ubo.unmap();
+
+	// Release builds strip debug info from the SPIR-V: reflection still works, since it runs on the unstripped code.
+#if defined(NDEBUG)
+	const auto shader_options = pl::fsys::ShaderCompiler::Options::size_preset();
+#else
+	const auto shader_options = pl::fsys::ShaderCompiler::Options::performance_preset();
+#endif
+	pl::fsys::ShaderCompiler shader_compiler{ "shader_cache/" };
+	const std::vector<pl::fsys::ShaderCompiler::Job> shader_jobs = { { base_shader_path + "raymarch.vert", shader_options }, { base_shader_path + "raymarch.frag", shader_options } };
+	auto shader_batch = shader_compiler.compile_batch(shader_jobs);
+	shader_batch.throw_if_failed();
+
+	pl::graphics::ShaderModule::set_reflection_cache_directory(shader_compiler.get_cache_directory());
+	auto v_shader = pl::graphics::ShaderModule::create(device, shader_batch.binaries[0]);
+	auto f_shader = pl::graphics::ShaderModule::create(device, shader_batch.binaries[1]);
+
+	// Catch any mismatch between the layout above and the shader now, rather than as garbled matrices on screen.
+	if (const auto* block = v_shader->find_block("uniform_buffer_object"))
 	{
-		glm::mat4(1.0f),
-		glm::lookAt({ 0.0f, 0.0, 3.0f },{ 0.0f, 0.0, 0.0f }, glm::vec3(0.0f, 1.0f, 0.0f)),
-		glm::perspective(45.0f, window.get_aspect_ratio(), 0.1f, 1000.0f)
-	};
-	ubo.upload_immediately(&ubo_data, sizeof(ubo_data));
-
-	auto binds = geometry.get_vertex_input_binding_descriptions();
-	auto attrs = geometry.get_vertex_input_attribute_descriptions();
+		UniformBufferLayout::validate(*block);
+	}
 
-	auto v_resource = pl::fsys::ResourceManager::load_binary_file(base_shader_path + "raymarch.vert.spv");
-	auto f_resource = pl::fsys::ResourceManager::load_binary_file(base_shader_path + "raymarch.frag.spv");
-	auto v_shader = pl::graphics::ShaderModule::create(device, v_resource);
-	auto f_shader = pl::graphics::ShaderModule::create(device, f_resource);
+	// Only upload (and fetch) the attributes that the vertex shader actually reads.
+	const auto vertex_format = v_shader->get_vertex_format();
+	pl::graphics::Buffer vbo{ device, vk::BufferUsageFlagBits::eVertexBuffer, geometry.get_packed_vertex_attributes(vertex_format) };
 
 	auto pipeline_options = pl::graphics::GraphicsPipeline::Options()
-							.vertex_input_binding_descriptions(binds)
-							.vertex_input_attribute_descriptions(attrs)
+							.vertex_input_binding_descriptions(vertex_format.get_binding_descriptions())
+							.vertex_input_attribute_descriptions(vertex_format.get_attribute_descriptions())
 							.viewports({ window.get_fullscreen_viewport() })
 							.scissors({ window.get_fullscreen_scissor_rect2d() })
 							.attach_shader_stages({ v_shader, f_shader })
@@ -90,7 +100,28 @@ int main()
 							.cull_back()
 							.depth_test_enabled()
 							.samples(msaa);
-	pl::graphics::GraphicsPipeline pipeline{ device, render_pass, pipeline_options };
+
+	// The raymarching shader's step and octave counts are specialization constants, so each quality level is built
+	// from the same SPIR-V.
+	const uint32_t max_steps[] = { 32u, 64u, 128u };
+	const int32_t num_octaves[] = { 3, 5, 7 };
+	const size_t quality_level = 2;
+	const auto specialization_constants = pl::graphics::SpecializationConstants()
+										  .set("MAX_STEPS", max_steps[quality_level])
+										  .set("NUM_OCTAVES", num_octaves[quality_level]);
+
+	// Saving either shader (or a file that it includes) rebuilds the pipeline in the background while the demo keeps running.
+	pl::graphics::ShaderHotReloader shader_reloader{ device, shader_compiler };
+	const auto pipeline_id = shader_reloader.add(shader_jobs, [&](const std::vector<std::shared_ptr<pl::graphics::ShaderModule>>& modules) -> std::unique_ptr<pl::graphics::Pipeline> {
+		// The vertex buffer was packed for the original vertex inputs, so a reload that changes them is rejected.
+		if (modules[0]->get_vertex_format().get_attributes() != vertex_format.get_attributes())
+		{
+			throw std::runtime_error("The inputs of raymarch.vert changed: restart the demo to rebuild its vertex buffer");
+		}
+		return std::make_unique<pl::graphics::GraphicsPipeline>(device, render_pass, pl::graphics::GraphicsPipeline::Options(pipeline_options)
+																.attach_shader_stages(modules)
+																.specialization_constants(specialization_constants));
+	});
 
 	/***********************************************************************************
 	 *
@@ -189,19 +220,59 @@ int main()
 	* Render loop
 	*
 	***********************************************************************************/
-	pl::graphics::Semaphore image_available_sem{ device };
-	pl::graphics::Semaphore render_complete_sem{ device };
+	// The time, resolution, and mouse position that raymarch.frag reads are written once per frame, rather than pushed with every draw.
+	pl::graphics::FrameUniforms frame_uniforms{ device, frames_in_flight };
+
+	// Each frame in flight has its own command buffer, semaphore, and fence, so the CPU can record the next frame while
+	// the GPU is still rendering the previous one. The semaphores that presentation waits on belong to the swapchain 
+	// images instead: a frame's semaphore cannot be signaled again until the image that waited on it is re-acquired.
+	std::vector<pl::graphics::CommandBuffer> command_buffers;
+	std::vector<pl::graphics::Semaphore> image_available_sems;
+	std::vector<pl::graphics::Fence> frame_fences;
+	for (uint32_t i = 0; i < frames_in_flight; ++i)
+	{
+		command_buffers.emplace_back(device, command_pool);
+		image_available_sems.emplace_back(device);
+		frame_fences.emplace_back(device, true);
+	}
 
-	// Create a fence for each framebuffer.
-	std::vector<pl::graphics::Fence> fences{ framebuffers.size() };
+	std::vector<pl::graphics::Semaphore> render_complete_sems;
+	for (size_t i = 0; i < swapchain_image_views.size(); ++i)
+	{
+		render_complete_sems.emplace_back(device);
+	}
 
+	uint32_t frame_counter = 0;
 	while (!window.should_close())
 	{
+		const uint32_t frame = frame_counter % frames_in_flight;
+		const uint32_t previous_frame = (frame_counter + frames_in_flight - 1) % frames_in_flight;
+
 		// Check the windowing system for any user interaction.
 		window.poll_events();
+
+		// Wait for the last frame that used this frame's resources to finish.
+		frame_fences[frame].wait_for();
+
+		// Swap in any pipelines that were rebuilt after a shader changed: the pipelines that they replace may still be
+		// in use by the previous frame, so they are destroyed once its fence has signaled.
+		for (const auto& event : shader_reloader.update(frame_fences[previous_frame]))
+		{
+			if (event.succeeded)
+			{
+				std::cout << "Reloaded shaders in " << event.seconds << " s\n";
+			}
+			else
+			{
+				std::cerr << "Failed to reload shaders, keeping the previous pipeline:\n" << event.error << "\n";
+			}
+		}
+		const auto& pipeline = shader_reloader.get(pipeline_id);
+
+		frame_uniforms.update(window);
 		
 		// Get the index of the next available image.
-		uint32_t image_index = device.acquire_next_swapchain_image(swapchain, image_available_sem);
+		uint32_t image_index = device.acquire_next_swapchain_image(swapchain, image_available_sems[frame]);
 
 		// Set the clear values for each of this framebuffer's attachments:
 		// 1. multisample color attachment
@@ -211,28 +282,31 @@ int main()
 												   pl::utils::clear_color::black(),			// color (resolve)
 												   pl::utils::clear_depth::depth_one() };	// depth
 		
-		// Set up a new command buffer and record draw calls.
-		pl::graphics::CommandBuffer command_buffer{ device, command_pool };
+		// Re-record this frame's command buffer.
+		pl::graphics::CommandBuffer& command_buffer = command_buffers[frame];
+		command_buffer.reset();
 		{
 			pl::graphics::ScopedRecord record(command_buffer);
 			command_buffer.begin_render_pass(render_pass, framebuffers[image_index], clear_vals);
 			command_buffer.bind_pipeline(pipeline);
 			command_buffer.bind_vertex_buffer(vbo);
 			command_buffer.bind_index_buffer(ibo);
-			command_buffer.update_push_constant_ranges(pipeline, "time", pl::utils::app::get_elapsed_seconds());
-			command_buffer.update_push_constant_ranges(pipeline, "mouse", window.get_mouse_position(true, true));
 			command_buffer.bind_descriptor_sets(pipeline, set_id, { descriptor_set });
+			frame_uniforms.bind(command_buffer, pipeline);
 			command_buffer.draw_indexed(static_cast<uint32_t>(geometry.num_indices()));
 			command_buffer.end_render_pass();
 		}
-		device.submit_with_semaphores(pl::graphics::QueueType::GRAPHICS, command_buffer, image_available_sem, render_complete_sem, {});
-		
-		// Wait for all work on this queue to finish.
-		device.wait_idle_queue(pl::graphics::QueueType::GRAPHICS);
+		frame_fences[frame].reset();
+		device.submit_with_semaphores(pl::graphics::QueueType::GRAPHICS, command_buffer, image_available_sems[frame], render_complete_sems[image_index], frame_fences[frame]);
 
 		// Present the rendered image to the swapchain.
-		device.present(swapchain, image_index, render_complete_sem);
+		device.present(swapchain, image_index, render_complete_sems[image_index]);
+
+		++frame_counter;
 	}
 
+	// Nothing can be destroyed while the device is still using it.
+	device.wait_idle();
+
 	return 0;
 }
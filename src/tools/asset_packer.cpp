@@ -0,0 +1,213 @@
+/*
+*
+* MIT License
+*
+* Copyright(c) 2017 Michael Walczyk
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files(the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions :
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*
+*/
+
+// An offline tool that packs every file under an assets directory into a single pack archive, which can then
+// be mounted with `ResourceManager::mount_archive()` in place of the loose files.
+//
+// Usage: asset_packer <assets_dir> <output.pack> [--compression none|lz4|zstd] [--level <n>] [--alignment <n>]
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#if defined(_WIN32)
+	#ifndef NOMINMAX
+		#define NOMINMAX
+	#endif
+	#include <windows.h>
+#else
+	#include <dirent.h>
+	#include <sys/stat.h>
+#endif
+
+#include "PackArchive.h"
+
+using namespace plume;
+
+namespace
+{
+
+	void print_usage()
+	{
+		printf("Usage: asset_packer <assets_dir> <output.pack> [options]\n"
+			   "  --compression none|lz4|zstd   per-entry compression method (default: lz4)\n"
+			   "  --level <n>                   compression level, only used by zstd (default: 0)\n"
+			   "  --alignment <n>               alignment of each entry in bytes (default: 16)\n");
+	}
+
+	utils::CompressionMethod parse_compression(const std::string& name)
+	{
+		if (name == "none") return utils::CompressionMethod::COMPRESSION_NONE;
+		if (name == "lz4")  return utils::CompressionMethod::COMPRESSION_LZ4;
+		if (name == "zstd") return utils::CompressionMethod::COMPRESSION_ZSTD;
+
+		throw std::runtime_error("Unknown compression method: " + name);
+	}
+
+	//! Recursively collects every regular file under `root` + `relative`, naming each one by its path relative to `root`.
+	void collect_files(const std::string& root, const std::string& relative, std::vector<fsys::PackArchive::Source>& sources)
+	{
+		const std::string directory = relative.empty() ? root : root + "/" + relative;
+
+#if defined(_WIN32)
+		WIN32_FIND_DATAA find_data;
+		HANDLE find_handle = FindFirstFileA((directory + "/*").c_str(), &find_data);
+		if (find_handle == INVALID_HANDLE_VALUE)
+		{
+			throw std::runtime_error("Failed to open directory: " + directory);
+		}
+
+		do
+		{
+			const std::string name = find_data.cFileName;
+			if (name == "." || name == "..")
+			{
+				continue;
+			}
+
+			const std::string child = relative.empty() ? name : relative + "/" + name;
+			if (find_data.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY)
+			{
+				collect_files(root, child, sources);
+			}
+			else
+			{
+				sources.push_back({ child, root + "/" + child });
+			}
+		} while (FindNextFileA(find_handle, &find_data));
+
+		FindClose(find_handle);
+#else
+		DIR* dir = opendir(directory.c_str());
+		if (!dir)
+		{
+			throw std::runtime_error("Failed to open directory: " + directory);
+		}
+
+		while (dirent* dir_entry = readdir(dir))
+		{
+			const std::string name = dir_entry->d_name;
+			if (name == "." || name == "..")
+			{
+				continue;
+			}
+
+			const std::string child = relative.empty() ? name : relative + "/" + name;
+			const std::string full_path = root + "/" + child;
+
+			struct stat file_stat;
+			if (stat(full_path.c_str(), &file_stat) != 0)
+			{
+				continue;
+			}
+
+			if (S_ISDIR(file_stat.st_mode))
+			{
+				collect_files(root, child, sources);
+			}
+			else if (S_ISREG(file_stat.st_mode))
+			{
+				sources.push_back({ child, full_path });
+			}
+		}
+
+		closedir(dir);
+#endif
+	}
+
+} // anonymous
+
+int main(int argc, char** argv)
+{
+	if (argc < 3)
+	{
+		print_usage();
+		return 1;
+	}
+
+	std::string assets_dir = argv[1];
+	const std::string output_path = argv[2];
+	std::string compression_name = "lz4";
+	int level = 0;
+	size_t alignment = 16;
+
+	for (int i = 3; i < argc; ++i)
+	{
+		if (!strcmp(argv[i], "--compression") && i + 1 < argc) compression_name = argv[++i];
+		else if (!strcmp(argv[i], "--level") && i + 1 < argc) level = atoi(argv[++i]);
+		else if (!strcmp(argv[i], "--alignment") && i + 1 < argc) alignment = static_cast<size_t>(atoll(argv[++i]));
+		else
+		{
+			print_usage();
+			return 1;
+		}
+	}
+
+	while (assets_dir.size() > 1 && (assets_dir.back() == '/' || assets_dir.back() == '\\'))
+	{
+		assets_dir.pop_back();
+	}
+
+	try
+	{
+		const utils::CompressionMethod method = parse_compression(compression_name);
+
+		std::vector<fsys::PackArchive::Source> sources;
+		collect_files(assets_dir, "", sources);
+
+		// Sort by path, so that files in the same directory (which tend to be loaded together) end up next to 
+		// each other in the archive, and so that the output doesn't depend on the order of directory listings.
+		std::sort(sources.begin(), sources.end(), [](const fsys::PackArchive::Source& a, const fsys::PackArchive::Source& b)
+		{
+			return a.name < b.name;
+		});
+
+		const auto start = std::chrono::high_resolution_clock::now();
+		const fsys::PackArchive::BuildStatistics statistics = fsys::PackArchive::build(output_path, sources, method, level, alignment);
+		const double seconds = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+
+		printf("Packed %zu file(s) (%zu compressed) from %s into %s in %.3f s: %.2f MB -> %.2f MB (%.1f%%)\n",
+			   statistics.entry_count,
+			   statistics.compressed_entry_count,
+			   assets_dir.c_str(),
+			   output_path.c_str(),
+			   seconds,
+			   static_cast<double>(statistics.raw_bytes) / (1024.0 * 1024.0),
+			   static_cast<double>(statistics.archive_bytes) / (1024.0 * 1024.0),
+			   statistics.raw_bytes > 0 ? 100.0 * static_cast<double>(statistics.archive_bytes) / static_cast<double>(statistics.raw_bytes) : 100.0);
+	}
+	catch (const std::exception& e)
+	{
+		fprintf(stderr, "asset_packer: %s\n", e.what());
+		return 1;
+	}
+
+	return 0;
+}
@@ -0,0 +1,175 @@
+/*
+*
+* MIT License
+*
+* Copyright(c) 2017 Michael Walczyk
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files(the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions :
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*
+*/
+
+// An offline tool that compares the SPIR-V optimization presets side by side. Every shader named on the command line
+// is compiled (from scratch, without a cache) with each preset, and the tool reports how long the batch took to
+// compile and how large the resulting SPIR-V is, along with the size of the unstripped code that is kept for
+// reflection when debug info is stripped. Each preset is compiled `--runs` times and the fastest run is reported.
+//
+// The tool runs without a Vulkan device (like the other offline tools, it is not linked against the loader), so it 
+// does not measure how long the driver takes to create shader modules and pipelines from each preset's SPIR-V. That 
+// cost has to be measured in the application, where the pipeline state that the driver compiles against is known.
+//
+// Shader names are relative to `assets_dir` (i.e. "shaders/pbr.frag"), exactly as they are passed to 
+// ShaderCompiler at runtime.
+//
+// Usage: shader_bench <assets_dir> <shader>... [--include <dir>] [--runs <count>]
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "ShaderCompiler.h"
+
+using namespace plume;
+
+namespace
+{
+
+	void print_usage()
+	{
+		printf("Usage: shader_bench <assets_dir> <shader>... [options]\n"
+			   "  --include <dir>                 add an include directory, relative to assets_dir (may be repeated)\n"
+			   "  --runs <count>                  number of times to compile each preset (default: 3)\n");
+	}
+
+	struct PresetResult
+	{
+		double wall_seconds;
+		double serial_seconds;
+		size_t code_bytes;
+		size_t reflection_code_bytes;
+	};
+
+	//! Compiles every job `runs` times with `options` and returns the fastest run. Throws if any job fails to compile.
+	PresetResult run_preset(const std::vector<std::string>& shader_names, const fsys::ShaderCompiler::Options& options, int runs)
+	{
+		std::vector<fsys::ShaderCompiler::Job> jobs;
+		for (const auto& shader_name : shader_names)
+		{
+			jobs.push_back({ shader_name, options });
+		}
+
+		PresetResult best = {};
+		for (int run = 0; run < runs; ++run)
+		{
+			// No cache directory, so that every run actually compiles the shaders.
+			fsys::ShaderCompiler compiler;
+			const fsys::ShaderBatchResult result = compiler.compile_batch(jobs);
+			result.throw_if_failed();
+
+			if (run == 0 || result.wall_seconds < best.wall_seconds)
+			{
+				best.wall_seconds = result.wall_seconds;
+				best.serial_seconds = result.serial_seconds;
+			}
+
+			best.code_bytes = 0;
+			best.reflection_code_bytes = 0;
+			for (const auto& binary : result.binaries)
+			{
+				best.code_bytes += binary.code.size() * sizeof(uint32_t);
+				best.reflection_code_bytes += binary.reflection_code.size() * sizeof(uint32_t);
+			}
+		}
+
+		return best;
+	}
+
+} // anonymous
+
+int main(int argc, char** argv)
+{
+	if (argc < 3)
+	{
+		print_usage();
+		return 1;
+	}
+
+	std::string assets_dir = argv[1];
+	std::vector<std::string> shader_names;
+	std::vector<std::string> include_directories;
+	int runs = 3;
+
+	for (int i = 2; i < argc; ++i)
+	{
+		if (!strcmp(argv[i], "--include") && i + 1 < argc) include_directories.push_back(argv[++i]);
+		else if (!strcmp(argv[i], "--runs") && i + 1 < argc) runs = std::max(atoi(argv[++i]), 1);
+		else if (strncmp(argv[i], "--", 2) != 0) shader_names.push_back(argv[i]);
+		else
+		{
+			print_usage();
+			return 1;
+		}
+	}
+
+	while (assets_dir.size() > 1 && (assets_dir.back() == '/' || assets_dir.back() == '\\'))
+	{
+		assets_dir.pop_back();
+	}
+
+	if (shader_names.empty())
+	{
+		print_usage();
+		return 1;
+	}
+
+	try
+	{
+		fsys::ResourceManager::set_default_path(assets_dir + "/");
+
+		const std::pair<const char*, fsys::ShaderCompiler::Options> presets[] =
+		{
+			{ "none", fsys::ShaderCompiler::Options() },
+			{ "performance", fsys::ShaderCompiler::Options::performance_preset() },
+			{ "size", fsys::ShaderCompiler::Options::size_preset() }
+		};
+
+		printf("%-12s %12s %12s %14s %18s\n", "preset", "wall (s)", "serial (s)", "SPIR-V (bytes)", "reflection (bytes)");
+		for (const auto& preset : presets)
+		{
+			fsys::ShaderCompiler::Options options = preset.second;
+			for (const auto& include_directory : include_directories)
+			{
+				options.include_directory(include_directory);
+			}
+
+			const PresetResult result = run_preset(shader_names, options, runs);
+			printf("%-12s %12.4f %12.4f %14zu %18zu\n", preset.first, result.wall_seconds, result.serial_seconds, result.code_bytes, result.reflection_code_bytes);
+		}
+	}
+	catch (const std::exception& e)
+	{
+		fprintf(stderr, "shader_bench: %s\n", e.what());
+		return 1;
+	}
+
+	return 0;
+}
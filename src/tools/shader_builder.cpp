@@ -0,0 +1,260 @@
+/*
+*
+* MIT License
+*
+* Copyright(c) 2017 Michael Walczyk
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files(the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions :
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*
+*/
+
+// An offline tool that compiles GLSL shaders to SPIR-V ahead of time. Every shader named on the command line is
+// compiled in parallel (see `ShaderCompiler::compile_batch()`) and written to `<output_dir>/<shader>.spv`, along 
+// with a Makefile-style depfile (`<shader>.spv.d`) that lists the shader and every file it includes, so that build
+// systems only recompile the shaders whose sources actually changed. If debug info is stripped, the unstripped 
+// SPIR-V is written to `<shader>.refl.spv` for reflection. If a cache directory is given, the compiled shaders are
+// also stored there in the same format that ShaderCompiler reads at runtime, so the application starts with a warm
+// cache.
+//
+// Shader names are relative to `assets_dir` (i.e. "shaders/pbr.frag"), exactly as they are passed to 
+// ShaderCompiler at runtime.
+//
+// Usage: shader_builder <assets_dir> <output_dir> <shader>... [--preset none|size|performance] [--strip] 
+//                       [--debug-info] [--define NAME[=VALUE]] [--include <dir>] [--cache <dir>]
+
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "PackArchive.h"
+#include "ShaderCompiler.h"
+
+using namespace plume;
+
+namespace
+{
+
+	void print_usage()
+	{
+		printf("Usage: shader_builder <assets_dir> <output_dir> <shader>... [options]\n"
+			   "  --preset none|size|performance  optimization preset (default: performance)\n"
+			   "  --strip                         strip debug info from the SPIR-V (implied by the size preset)\n"
+			   "  --debug-info                    generate debug info\n"
+			   "  --define NAME[=VALUE]           add a preprocessor macro (may be repeated)\n"
+			   "  --include <dir>                 add an include directory, relative to assets_dir (may be repeated)\n"
+			   "  --cache <dir>                   also store the compiled shaders in a runtime shader cache\n");
+	}
+
+	fsys::ShaderCompiler::Options parse_preset(const std::string& name)
+	{
+		if (name == "none")		   return fsys::ShaderCompiler::Options();
+		if (name == "size")		   return fsys::ShaderCompiler::Options::size_preset();
+		if (name == "performance") return fsys::ShaderCompiler::Options::performance_preset();
+
+		throw std::runtime_error("Unknown preset: " + name);
+	}
+
+	//! Escapes a path for use in a depfile, which follows the same rules as a Makefile rule.
+	std::string escape_dependency(const std::string& path)
+	{
+		std::string escaped;
+		for (char c : path)
+		{
+			if (c == ' ' || c == '#')
+			{
+				escaped += '\\';
+			}
+			else if (c == '$')
+			{
+				escaped += '$';
+			}
+			escaped += c;
+		}
+
+		return escaped;
+	}
+
+	//! Writes `code` to `path`, creating its parent directory if necessary. Throws on failure.
+	void write_code(const std::string& path, const std::vector<uint32_t>& code)
+	{
+		const size_t separator = path.find_last_of('/');
+		if (separator != std::string::npos)
+		{
+			fsys::ResourceManager::create_directories(path.substr(0, separator));
+		}
+
+		if (!fsys::ResourceManager::write_file_atomic(path, code.data(), code.size() * sizeof(uint32_t)))
+		{
+			throw std::runtime_error("Failed to write " + path);
+		}
+	}
+
+	//! Writes a depfile at `path` that makes `target` depend on every file in `dependencies`. 
+	void write_depfile(const std::string& path, const std::string& target, const std::string& assets_dir, const std::vector<fsys::ShaderDependency>& dependencies)
+	{
+		std::string contents = escape_dependency(target) + ":";
+		for (const auto& dependency : dependencies)
+		{
+			contents += " \\\n  " + escape_dependency(assets_dir + "/" + dependency.name);
+		}
+		contents += "\n";
+
+		if (!fsys::ResourceManager::write_file_atomic(path, contents.data(), contents.size()))
+		{
+			throw std::runtime_error("Failed to write " + path);
+		}
+	}
+
+} // anonymous
+
+int main(int argc, char** argv)
+{
+	if (argc < 4)
+	{
+		print_usage();
+		return 1;
+	}
+
+	std::string assets_dir = argv[1];
+	std::string output_dir = argv[2];
+	std::vector<std::string> shader_names;
+	std::string preset_name = "performance";
+	bool strip_debug_info = false;
+	bool generate_debug_info = false;
+	std::vector<std::string> defines;
+	std::vector<std::string> include_directories;
+	std::string cache_dir;
+
+	for (int i = 3; i < argc; ++i)
+	{
+		if (!strcmp(argv[i], "--preset") && i + 1 < argc) preset_name = argv[++i];
+		else if (!strcmp(argv[i], "--strip")) strip_debug_info = true;
+		else if (!strcmp(argv[i], "--debug-info")) generate_debug_info = true;
+		else if (!strcmp(argv[i], "--define") && i + 1 < argc) defines.push_back(argv[++i]);
+		else if (!strcmp(argv[i], "--include") && i + 1 < argc) include_directories.push_back(argv[++i]);
+		else if (!strcmp(argv[i], "--cache") && i + 1 < argc) cache_dir = argv[++i];
+		else if (strncmp(argv[i], "--", 2) != 0) shader_names.push_back(argv[i]);
+		else
+		{
+			print_usage();
+			return 1;
+		}
+	}
+
+	for (std::string* directory : { &assets_dir, &output_dir })
+	{
+		while (directory->size() > 1 && (directory->back() == '/' || directory->back() == '\\'))
+		{
+			directory->pop_back();
+		}
+	}
+
+	if (shader_names.empty())
+	{
+		print_usage();
+		return 1;
+	}
+
+	try
+	{
+		fsys::ShaderCompiler::Options options = parse_preset(preset_name);
+		if (strip_debug_info)
+		{
+			options.strip_debug_info();
+		}
+		if (generate_debug_info)
+		{
+			options.generate_debug_info();
+		}
+		for (const auto& define : defines)
+		{
+			const size_t equals = define.find('=');
+			options.define(define.substr(0, equals), equals == std::string::npos ? "" : define.substr(equals + 1));
+		}
+		for (const auto& include_directory : include_directories)
+		{
+			options.include_directory(include_directory);
+		}
+
+		// Shader names (and the names of the files that they include) are resolved relative to the assets 
+		// directory, just like they are at runtime, so that cache keys and dependency names match.
+		fsys::ResourceManager::set_default_path(assets_dir + "/");
+
+		std::vector<fsys::ShaderCompiler::Job> jobs;
+		for (const auto& shader_name : shader_names)
+		{
+			jobs.push_back({ shader_name, options });
+		}
+
+		fsys::ShaderCompiler compiler{ cache_dir };
+		const fsys::ShaderBatchResult result = compiler.compile_batch(jobs);
+
+		size_t code_bytes = 0;
+		for (size_t i = 0; i < jobs.size(); ++i)
+		{
+			if (!result.errors[i].empty())
+			{
+				fprintf(stderr, "%s\n", result.errors[i].c_str());
+				continue;
+			}
+
+			const fsys::ShaderBinary& binary = result.binaries[i];
+			const std::string output_path = output_dir + "/" + fsys::PackArchive::normalize_path(jobs[i].file_name) + ".spv";
+
+			const std::string reflection_path = output_dir + "/" + fsys::PackArchive::normalize_path(jobs[i].file_name) + ".refl.spv";
+
+			write_code(output_path, binary.code);
+			if (binary.reflection_code.empty())
+			{
+				// Don't leave a stale file behind from a previous build that stripped debug info.
+				std::remove(reflection_path.c_str());
+			}
+			else
+			{
+				write_code(reflection_path, binary.reflection_code);
+			}
+			write_depfile(output_path + ".d", output_path, assets_dir, binary.dependencies);
+
+			code_bytes += binary.code.size() * sizeof(uint32_t);
+		}
+
+		const fsys::ShaderCompilerStatistics statistics = compiler.get_statistics();
+		printf("Compiled %zu shader(s) (%llu from cache) into %s in %.3f s (%.3f s serial): %zu bytes of SPIR-V\n",
+			   jobs.size() - result.failure_count,
+			   static_cast<unsigned long long>(statistics.cache_hits),
+			   output_dir.c_str(),
+			   result.wall_seconds,
+			   result.serial_seconds,
+			   code_bytes);
+
+		if (!result.succeeded())
+		{
+			fprintf(stderr, "shader_builder: %zu shader(s) failed to compile\n", result.failure_count);
+			return 1;
+		}
+	}
+	catch (const std::exception& e)
+	{
+		fprintf(stderr, "shader_builder: %s\n", e.what());
+		return 1;
+	}
+
+	return 0;
+}
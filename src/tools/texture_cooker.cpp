@@ -0,0 +1,170 @@
+/*
+*
+* MIT License
+*
+* Copyright(c) 2017 Michael Walczyk
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files(the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions :
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*
+*/
+
+// An offline tool that compresses an image (PNG, JPG, TGA, etc.) into a BC1, BC3, BC4, BC5, or BC7 texture 
+// and writes it to a DDS or KTX2 container that `TextureLoader` can load directly.
+//
+// Usage: texture_cooker <input> <output.dds|output.ktx2> [--format bc1|bc1a|bc3|bc4|bc5|bc7] 
+//                       [--quality fast|normal|high] [--srgb] [--mips] [--filter box|kaiser|lanczos] 
+//                       [--alpha-coverage <reference>]
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+#include "MipGenerator.h"
+#include "ResourceManager.h"
+#include "TextureLoader.h"
+
+using namespace plume;
+using plume::fsys::MipFilter;
+
+namespace
+{
+
+	void print_usage()
+	{
+		printf("Usage: texture_cooker <input> <output.dds|output.ktx2> [options]\n"
+			   "  --format bc1|bc1a|bc3|bc4|bc5|bc7   block format (default: bc7)\n"
+			   "  --quality fast|normal|high          encoder quality preset (default: normal)\n"
+			   "  --srgb                              treat the color channels as sRGB-encoded\n"
+			   "  --mips                              generate a full mipmap chain\n"
+			   "  --filter box|kaiser|lanczos         mipmap downsampling filter (default: kaiser)\n"
+			   "  --alpha-coverage <reference>        preserve alpha-test coverage across mipmap levels\n");
+	}
+
+	vk::Format parse_format(const std::string& name, bool is_srgb)
+	{
+		if (name == "bc1")  return is_srgb ? vk::Format::eBc1RgbSrgbBlock : vk::Format::eBc1RgbUnormBlock;
+		if (name == "bc1a") return is_srgb ? vk::Format::eBc1RgbaSrgbBlock : vk::Format::eBc1RgbaUnormBlock;
+		if (name == "bc3")  return is_srgb ? vk::Format::eBc3SrgbBlock : vk::Format::eBc3UnormBlock;
+		if (name == "bc4")  return vk::Format::eBc4UnormBlock;
+		if (name == "bc5")  return vk::Format::eBc5UnormBlock;
+		if (name == "bc7")  return is_srgb ? vk::Format::eBc7SrgbBlock : vk::Format::eBc7UnormBlock;
+
+		throw std::runtime_error("Unknown block format: " + name);
+	}
+
+	utils::EncodeQuality parse_quality(const std::string& name)
+	{
+		if (name == "fast")   return utils::EncodeQuality::QUALITY_FAST;
+		if (name == "normal") return utils::EncodeQuality::QUALITY_NORMAL;
+		if (name == "high")   return utils::EncodeQuality::QUALITY_HIGH;
+
+		throw std::runtime_error("Unknown quality preset: " + name);
+	}
+
+	MipFilter parse_filter(const std::string& name)
+	{
+		if (name == "box")     return MipFilter::FILTER_BOX;
+		if (name == "kaiser")  return MipFilter::FILTER_KAISER;
+		if (name == "lanczos") return MipFilter::FILTER_LANCZOS;
+
+		throw std::runtime_error("Unknown mipmap filter: " + name);
+	}
+
+} // anonymous
+
+int main(int argc, char** argv)
+{
+	if (argc < 3)
+	{
+		print_usage();
+		return 1;
+	}
+
+	const std::string input_path = argv[1];
+	const std::string output_path = argv[2];
+	std::string format_name = "bc7";
+	std::string quality_name = "normal";
+	bool is_srgb = false;
+	bool generate_mips = false;
+	std::string filter_name = "kaiser";
+	float alpha_reference = -1.0f;
+
+	for (int i = 3; i < argc; ++i)
+	{
+		if (!strcmp(argv[i], "--format") && i + 1 < argc) format_name = argv[++i];
+		else if (!strcmp(argv[i], "--quality") && i + 1 < argc) quality_name = argv[++i];
+		else if (!strcmp(argv[i], "--srgb")) is_srgb = true;
+		else if (!strcmp(argv[i], "--mips")) generate_mips = true;
+		else if (!strcmp(argv[i], "--filter") && i + 1 < argc) filter_name = argv[++i];
+		else if (!strcmp(argv[i], "--alpha-coverage") && i + 1 < argc) alpha_reference = static_cast<float>(atof(argv[++i]));
+		else
+		{
+			print_usage();
+			return 1;
+		}
+	}
+
+	try
+	{
+		const vk::Format format = parse_format(format_name, is_srgb);
+		const utils::EncodeQuality quality = parse_quality(quality_name);
+
+		// Paths given on the command line are used as-is.
+		fsys::ResourceManager::set_default_path("");
+		const fsys::ImageResource image = fsys::ResourceManager::load_image(input_path);
+
+		auto mip_options = fsys::MipGenerator::Options().filter(parse_filter(filter_name)).srgb(is_srgb).max_levels(generate_mips ? 0 : 1);
+		if (alpha_reference >= 0.0f)
+		{
+			mip_options.preserve_alpha_coverage(alpha_reference);
+		}
+
+		const fsys::TextureResource texture = fsys::TextureLoader::from_image(fsys::MipGenerator::generate(image, mip_options), is_srgb);
+
+		size_t texel_count = 0;
+		for (const auto& subresource : texture.subresources)
+		{
+			texel_count += static_cast<size_t>(subresource.extent.width) * subresource.extent.height * subresource.extent.depth;
+		}
+
+		const auto start = std::chrono::high_resolution_clock::now();
+		const fsys::TextureResource encoded = fsys::TextureLoader::encode(texture, format, quality);
+		const double seconds = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+
+		fsys::TextureLoader::save(output_path, encoded);
+
+		printf("Encoded %s (%ux%u, %u mip level(s)) as %s in %.3f s: %.2f MP/s\n",
+			   input_path.c_str(),
+			   texture.extent.width,
+			   texture.extent.height,
+			   texture.mip_levels,
+			   vk::to_string(format).c_str(),
+			   seconds,
+			   static_cast<double>(texel_count) / 1.0e6 / std::max(seconds, 1.0e-9));
+	}
+	catch (const std::exception& e)
+	{
+		fprintf(stderr, "texture_cooker: %s\n", e.what());
+		return 1;
+	}
+
+	return 0;
+}
@@ -0,0 +1,1595 @@
+/*
+*
+* MIT License
+*
+* Copyright(c) 2017 Michael Walczyk
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files(the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions :
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*
+*/
+
+#include "BlockCompression.h"
+#include "Simd.h"
+#include "ThreadPool.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+namespace plume
+{
+
+	namespace utils
+	{
+
+		namespace
+		{
+
+			inline uint8_t clamp_to_byte(int v) { return static_cast<uint8_t>(std::min(std::max(v, 0), 255)); }
+
+			inline uint64_t read_le64(const uint8_t* p) { uint64_t v = 0; for (int i = 7; i >= 0; --i) v = (v << 8) | p[i]; return v; }
+
+			inline uint64_t read_be64(const uint8_t* p) { uint64_t v = 0; for (int i = 0; i < 8; ++i) v = (v << 8) | p[i]; return v; }
+
+			//! Expands an `n`-bit value to 8 bits by replicating its most significant bits.
+			inline uint8_t expand_bits(uint32_t v, uint32_t n) { return static_cast<uint8_t>((v << (8 - n)) | (v >> (2 * n - 8))); }
+
+			inline void expand_565(uint16_t c, uint8_t rgb[3])
+			{
+				rgb[0] = expand_bits((c >> 11) & 0x1F, 5);
+				rgb[1] = expand_bits((c >> 5) & 0x3F, 6);
+				rgb[2] = expand_bits(c & 0x1F, 5);
+			}
+
+		   /***********************************************************************************
+			*
+			* BC1-BC5
+			*
+			***********************************************************************************/
+
+			//! Builds the 4-entry palette of a BC1 color block. If `allow_punch_through` is `false`, the block 
+			//! is always decoded in 4-color mode (as required for BC2 and BC3).
+			void build_bc1_palette(uint16_t c0, uint16_t c1, bool allow_punch_through, bool transparent_black, uint8_t palette[4][4])
+			{
+				expand_565(c0, palette[0]);
+				expand_565(c1, palette[1]);
+				palette[0][3] = palette[1][3] = 255;
+
+				if (c0 > c1 || !allow_punch_through)
+				{
+					for (int c = 0; c < 3; ++c)
+					{
+						palette[2][c] = static_cast<uint8_t>((2 * palette[0][c] + palette[1][c]) / 3);
+						palette[3][c] = static_cast<uint8_t>((palette[0][c] + 2 * palette[1][c]) / 3);
+					}
+					palette[2][3] = palette[3][3] = 255;
+				}
+				else
+				{
+					for (int c = 0; c < 3; ++c)
+					{
+						palette[2][c] = static_cast<uint8_t>((palette[0][c] + palette[1][c]) / 2);
+						palette[3][c] = 0;
+					}
+					palette[2][3] = 255;
+					palette[3][3] = transparent_black ? 0 : 255;
+				}
+			}
+
+			//! Decodes the color half of a BC1, BC2 or BC3 block.
+			void decode_bc1_color(const uint8_t* block, uint8_t texels[64], bool allow_punch_through, bool transparent_black)
+			{
+				const uint16_t c0 = static_cast<uint16_t>(block[0] | (block[1] << 8));
+				const uint16_t c1 = static_cast<uint16_t>(block[2] | (block[3] << 8));
+
+				uint8_t palette[4][4];
+				build_bc1_palette(c0, c1, allow_punch_through, transparent_black, palette);
+
+				const uint32_t indices = block[4] | (block[5] << 8) | (block[6] << 16) | (static_cast<uint32_t>(block[7]) << 24);
+				for (int i = 0; i < 16; ++i)
+				{
+					memcpy(texels + i * 4, palette[(indices >> (2 * i)) & 3], 4);
+				}
+			}
+
+			//! Decodes an interpolated 8-bit channel (the alpha half of BC3, or a BC4/BC5 channel) into every 
+			//! 4th byte of `out`, starting at `out`.
+			void decode_bc4_channel(const uint8_t* block, uint8_t* out, bool is_signed)
+			{
+				int palette[8];
+				const int e0 = is_signed ? static_cast<int8_t>(block[0]) : block[0];
+				const int e1 = is_signed ? static_cast<int8_t>(block[1]) : block[1];
+
+				palette[0] = e0;
+				palette[1] = e1;
+				if (e0 > e1)
+				{
+					for (int i = 1; i < 7; ++i) palette[i + 1] = ((7 - i) * e0 + i * e1) / 7;
+				}
+				else
+				{
+					for (int i = 1; i < 5; ++i) palette[i + 1] = ((5 - i) * e0 + i * e1) / 5;
+					palette[6] = is_signed ? -127 : 0;
+					palette[7] = is_signed ? 127 : 255;
+				}
+
+				uint64_t indices = 0;
+				for (int i = 7; i >= 2; --i) indices = (indices << 8) | block[i];
+
+				for (int i = 0; i < 16; ++i)
+				{
+					int v = palette[(indices >> (3 * i)) & 7];
+					if (is_signed)
+					{
+						// -128 and -127 both map to -1.0.
+						out[i * 4] = static_cast<uint8_t>(static_cast<int8_t>(std::max(v, -127)));
+					}
+					else
+					{
+						out[i * 4] = static_cast<uint8_t>(v);
+					}
+				}
+			}
+
+		   /***********************************************************************************
+			*
+			* BC7
+			*
+			***********************************************************************************/
+
+			struct BC7ModeInfo
+			{
+				uint32_t subsets;
+				uint32_t partition_bits;
+				uint32_t rotation_bits;
+				uint32_t index_selection_bits;
+				uint32_t color_bits;
+				uint32_t alpha_bits;
+				uint32_t endpoint_p_bits;
+				uint32_t shared_p_bits;
+				uint32_t index_bits;
+				uint32_t secondary_index_bits;
+			};
+
+			const BC7ModeInfo bc7_modes[8] =
+			{
+				{ 3, 4, 0, 0, 4, 0, 1, 0, 3, 0 },
+				{ 2, 6, 0, 0, 6, 0, 0, 1, 3, 0 },
+				{ 3, 6, 0, 0, 5, 0, 0, 0, 2, 0 },
+				{ 2, 6, 0, 0, 7, 0, 1, 0, 2, 0 },
+				{ 1, 0, 2, 1, 5, 6, 0, 0, 2, 3 },
+				{ 1, 0, 2, 0, 7, 8, 0, 0, 2, 2 },
+				{ 1, 0, 0, 0, 7, 7, 1, 0, 4, 0 },
+				{ 2, 6, 0, 0, 5, 5, 1, 0, 2, 0 }
+			};
+
+			//! 2-subset partitions: bit `i` is the subset of texel `i`.
+			const uint16_t bc7_partitions_2[64] =
+			{
+				0xCCCC, 0x8888, 0xEEEE, 0xECC8, 0xC880, 0xFEEC, 0xFEC8, 0xEC80,
+				0xC800, 0xFFEC, 0xFE80, 0xE800, 0xFFE8, 0xFF00, 0xFFF0, 0xF000,
+				0xF710, 0x008E, 0x7100, 0x08CE, 0x008C, 0x7310, 0x3100, 0x8CCE,
+				0x088C, 0x3110, 0x6666, 0x366C, 0x17E8, 0x0FF0, 0x718E, 0x399C,
+				0xAAAA, 0xF0F0, 0x5A5A, 0x33CC, 0x3C3C, 0x55AA, 0x9696, 0xA55A,
+				0x73CE, 0x13C8, 0x324C, 0x3BDC, 0x6996, 0xC33C, 0x9966, 0x0660,
+				0x0272, 0x04E4, 0x4E40, 0x2720, 0xC936, 0x936C, 0x39C6, 0x639C,
+				0x9336, 0x9CC6, 0x817E, 0xE718, 0xCCF0, 0x0FCC, 0x7744, 0xEE22
+			};
+
+			//! 3-subset partitions, one subset index per texel.
+			const uint8_t bc7_partitions_3[64][16] =
+			{
+				{ 0,0,1,1,0,0,1,1,0,2,2,1,2,2,2,2 }, { 0,0,0,1,0,0,1,1,2,2,1,1,2,2,2,1 },
+				{ 0,0,0,0,2,0,0,1,2,2,1,1,2,2,1,1 }, { 0,2,2,2,0,0,2,2,0,0,1,1,0,1,1,1 },
+				{ 0,0,0,0,0,0,0,0,1,1,2,2,1,1,2,2 }, { 0,0,1,1,0,0,1,1,0,0,2,2,0,0,2,2 },
+				{ 0,0,2,2,0,0,2,2,1,1,1,1,1,1,1,1 }, { 0,0,1,1,0,0,1,1,2,2,1,1,2,2,1,1 },
+				{ 0,0,0,0,0,0,0,0,1,1,1,1,2,2,2,2 }, { 0,0,0,0,1,1,1,1,1,1,1,1,2,2,2,2 },
+				{ 0,0,0,0,1,1,1,1,2,2,2,2,2,2,2,2 }, { 0,0,1,2,0,0,1,2,0,0,1,2,0,0,1,2 },
+				{ 0,1,1,2,0,1,1,2,0,1,1,2,0,1,1,2 }, { 0,1,2,2,0,1,2,2,0,1,2,2,0,1,2,2 },
+				{ 0,0,1,1,0,1,1,2,1,1,2,2,1,2,2,2 }, { 0,0,1,1,2,0,0,1,2,2,0,0,2,2,2,0 },
+				{ 0,0,0,1,0,0,1,1,0,1,1,2,1,1,2,2 }, { 0,1,1,1,0,0,1,1,2,0,0,1,2,2,0,0 },
+				{ 0,0,0,0,1,1,2,2,1,1,2,2,1,1,2,2 }, { 0,0,2,2,0,0,2,2,0,0,2,2,1,1,1,1 },
+				{ 0,1,1,1,0,1,1,1,0,2,2,2,0,2,2,2 }, { 0,0,0,1,0,0,0,1,2,2,2,1,2,2,2,1 },
+				{ 0,0,0,0,0,0,1,1,0,1,2,2,0,1,2,2 }, { 0,0,0,0,1,1,0,0,2,2,1,0,2,2,1,0 },
+				{ 0,1,2,2,0,1,2,2,0,0,1,1,0,0,0,0 }, { 0,0,1,2,0,0,1,2,1,1,2,2,2,2,2,2 },
+				{ 0,1,1,0,1,2,2,1,1,2,2,1,0,1,1,0 }, { 0,0,0,0,0,1,1,0,1,2,2,1,1,2,2,1 },
+				{ 0,0,2,2,1,1,0,2,1,1,0,2,0,0,2,2 }, { 0,1,1,0,0,1,1,0,2,0,0,2,2,2,2,2 },
+				{ 0,0,1,1,0,1,2,2,0,1,2,2,0,0,1,1 }, { 0,0,0,0,2,0,0,0,2,2,1,1,2,2,2,1 },
+				{ 0,0,0,0,0,0,0,2,1,1,2,2,1,2,2,2 }, { 0,2,2,2,0,0,2,2,0,0,1,2,0,0,1,1 },
+				{ 0,0,1,1,0,0,1,2,0,0,2,2,0,2,2,2 }, { 0,1,2,0,0,1,2,0,0,1,2,0,0,1,2,0 },
+				{ 0,0,0,0,1,1,1,1,2,2,2,2,0,0,0,0 }, { 0,1,2,0,1,2,0,1,2,0,1,2,0,1,2,0 },
+				{ 0,1,2,0,2,0,1,2,1,2,0,1,0,1,2,0 }, { 0,0,1,1,2,2,0,0,1,1,2,2,0,0,1,1 },
+				{ 0,0,1,1,1,1,2,2,2,2,0,0,0,0,1,1 }, { 0,1,0,1,0,1,0,1,2,2,2,2,2,2,2,2 },
+				{ 0,0,0,0,0,0,0,0,2,1,2,1,2,1,2,1 }, { 0,0,2,2,1,1,2,2,0,0,2,2,1,1,2,2 },
+				{ 0,0,2,2,0,0,1,1,0,0,2,2,0,0,1,1 }, { 0,2,2,0,1,2,2,1,0,2,2,0,1,2,2,1 },
+				{ 0,1,0,1,2,2,2,2,2,2,2,2,0,1,0,1 }, { 0,0,0,0,2,1,2,1,2,1,2,1,2,1,2,1 },
+				{ 0,1,0,1,0,1,0,1,0,1,0,1,2,2,2,2 }, { 0,2,2,2,0,1,1,1,0,2,2,2,0,1,1,1 },
+				{ 0,0,0,2,1,1,1,2,0,0,0,2,1,1,1,2 }, { 0,0,0,0,2,1,1,2,2,1,1,2,2,1,1,2 },
+				{ 0,2,2,2,0,1,1,1,0,1,1,1,0,2,2,2 }, { 0,0,0,2,1,1,1,2,1,1,1,2,0,0,0,2 },
+				{ 0,1,1,0,0,1,1,0,0,1,1,0,2,2,2,2 }, { 0,0,0,0,0,0,0,0,2,1,1,2,2,1,1,2 },
+				{ 0,1,1,0,0,1,1,0,2,2,2,2,2,2,2,2 }, { 0,0,2,2,0,0,1,1,0,0,1,1,0,0,2,2 },
+				{ 0,0,2,2,1,1,2,2,1,1,2,2,0,0,2,2 }, { 0,0,0,0,0,0,0,0,0,0,0,0,2,1,1,2 },
+				{ 0,0,0,2,0,0,0,1,0,0,0,2,0,0,0,1 }, { 0,2,2,2,1,2,2,2,0,2,2,2,1,2,2,2 },
+				{ 0,1,0,1,2,2,2,2,2,2,2,2,2,2,2,2 }, { 0,1,1,1,2,0,1,1,2,2,0,1,2,2,2,0 }
+			};
+
+			const uint8_t bc7_anchors_2[64] =
+			{
+				15,15,15,15,15,15,15,15, 15,15,15,15,15,15,15,15,
+				15, 2, 8, 2, 2, 8, 8,15,  2, 8, 2, 2, 8, 8, 2, 2,
+				15,15, 6, 8, 2, 8,15,15,  2, 8, 2, 2, 2,15,15, 6,
+				 6, 2, 6, 8,15,15, 2, 2, 15,15,15,15,15, 2, 2,15
+			};
+
+			const uint8_t bc7_anchors_3_second[64] =
+			{
+				 3, 3,15,15, 8, 3,15,15,  8, 8, 6, 6, 6, 5, 3, 3,
+				 3, 3, 8,15, 3, 3, 6,10,  5, 8, 8, 6, 8, 5,15,15,
+				 8,15, 3, 5, 6,10, 8,15, 15, 3,15, 5,15,15,15,15,
+				 3,15, 5, 5, 5, 8, 5,10,  5,10, 8,13,15,12, 3, 3
+			};
+
+			const uint8_t bc7_anchors_3_third[64] =
+			{
+				15, 8, 8, 3,15,15, 3, 8, 15,15,15,15,15,15,15, 8,
+				15, 8,15, 3,15, 8,15, 8,  3,15, 6,10,15,15,10, 8,
+				15, 3,15,10,10, 8, 9,10,  6,15, 8,15, 3, 6, 6, 8,
+				15, 3,15,15,15,15,15,15, 15,15,15,15, 3,15,15, 8
+			};
+
+			const uint8_t bc7_weights_2[4] = { 0, 21, 43, 64 };
+			const uint8_t bc7_weights_3[8] = { 0, 9, 18, 27, 37, 46, 55, 64 };
+			const uint8_t bc7_weights_4[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+			//! Reads bits from a 128-bit block, least significant bit first.
+			class BitReader
+			{
+			public:
+
+				BitReader(const uint8_t* block) :
+					m_lo(read_le64(block)),
+					m_hi(read_le64(block + 8)),
+					m_position(0)
+				{}
+
+				uint32_t read(uint32_t count)
+				{
+					uint32_t value = 0;
+					for (uint32_t i = 0; i < count; ++i, ++m_position)
+					{
+						const uint64_t word = (m_position < 64) ? m_lo : m_hi;
+						value |= static_cast<uint32_t>((word >> (m_position & 63)) & 1) << i;
+					}
+					return value;
+				}
+
+			private:
+
+				uint64_t m_lo;
+				uint64_t m_hi;
+				uint32_t m_position;
+			};
+
+			inline uint32_t bc7_subset_of(uint32_t subsets, uint32_t partition, uint32_t texel)
+			{
+				if (subsets == 2) return (bc7_partitions_2[partition] >> texel) & 1;
+				if (subsets == 3) return bc7_partitions_3[partition][texel];
+				return 0;
+			}
+
+			inline bool bc7_is_anchor(uint32_t subsets, uint32_t partition, uint32_t texel)
+			{
+				if (texel == 0) return true;
+				if (subsets == 2) return texel == bc7_anchors_2[partition];
+				if (subsets == 3) return texel == bc7_anchors_3_second[partition] || texel == bc7_anchors_3_third[partition];
+				return false;
+			}
+
+			inline uint8_t bc7_interpolate(uint8_t e0, uint8_t e1, uint32_t index, uint32_t index_bits)
+			{
+				const uint8_t* weights = (index_bits == 2) ? bc7_weights_2 : (index_bits == 3) ? bc7_weights_3 : bc7_weights_4;
+				const uint32_t w = weights[index];
+				return static_cast<uint8_t>(((64 - w) * e0 + w * e1 + 32) >> 6);
+			}
+
+			void decode_bc7(const uint8_t* block, uint8_t texels[64])
+			{
+				uint32_t mode = 0;
+				while (mode < 8 && !(block[0] & (1 << mode))) ++mode;
+
+				// Reserved mode: the spec requires the block to decode to transparent black.
+				if (mode == 8)
+				{
+					memset(texels, 0, 64);
+					return;
+				}
+
+				const BC7ModeInfo& info = bc7_modes[mode];
+				BitReader reader{ block };
+				reader.read(mode + 1);
+
+				const uint32_t partition = reader.read(info.partition_bits);
+				const uint32_t rotation = reader.read(info.rotation_bits);
+				const uint32_t index_selection = reader.read(info.index_selection_bits);
+
+				// Endpoints are stored channel by channel: all reds, then all greens, etc.
+				uint32_t endpoints[3][2][4] = {};
+				const uint32_t channels = info.alpha_bits ? 4 : 3;
+				for (uint32_t c = 0; c < channels; ++c)
+				{
+					const uint32_t bits = (c == 3) ? info.alpha_bits : info.color_bits;
+					for (uint32_t s = 0; s < info.subsets; ++s)
+					{
+						endpoints[s][0][c] = reader.read(bits);
+						endpoints[s][1][c] = reader.read(bits);
+					}
+				}
+
+				// Apply the p-bits (either one per endpoint or one shared by both endpoints of a subset).
+				uint32_t color_bits = info.color_bits;
+				uint32_t alpha_bits = info.alpha_bits;
+				if (info.endpoint_p_bits || info.shared_p_bits)
+				{
+					for (uint32_t s = 0; s < info.subsets; ++s)
+					{
+						uint32_t p[2];
+						if (info.endpoint_p_bits)
+						{
+							p[0] = reader.read(1);
+							p[1] = reader.read(1);
+						}
+						else
+						{
+							p[0] = p[1] = reader.read(1);
+						}
+
+						for (uint32_t e = 0; e < 2; ++e)
+						{
+							for (uint32_t c = 0; c < channels; ++c)
+							{
+								endpoints[s][e][c] = (endpoints[s][e][c] << 1) | p[e];
+							}
+						}
+					}
+					color_bits++;
+					if (alpha_bits) alpha_bits++;
+				}
+
+				uint8_t unquantized[3][2][4];
+				for (uint32_t s = 0; s < info.subsets; ++s)
+				{
+					for (uint32_t e = 0; e < 2; ++e)
+					{
+						for (uint32_t c = 0; c < 3; ++c)
+						{
+							unquantized[s][e][c] = expand_bits(endpoints[s][e][c], color_bits);
+						}
+						unquantized[s][e][3] = alpha_bits ? expand_bits(endpoints[s][e][3], alpha_bits) : 255;
+					}
+				}
+
+				// Primary indices, followed by the secondary indices (modes 4 and 5 only). The anchor texel 
+				// of each subset drops its most significant index bit.
+				uint32_t indices[16];
+				uint32_t secondary_indices[16] = {};
+				for (uint32_t i = 0; i < 16; ++i)
+				{
+					const bool anchor = bc7_is_anchor(info.subsets, partition, i);
+					indices[i] = reader.read(anchor ? info.index_bits - 1 : info.index_bits);
+				}
+				if (info.secondary_index_bits)
+				{
+					for (uint32_t i = 0; i < 16; ++i)
+					{
+						secondary_indices[i] = reader.read(i == 0 ? info.secondary_index_bits - 1 : info.secondary_index_bits);
+					}
+				}
+
+				for (uint32_t i = 0; i < 16; ++i)
+				{
+					const uint32_t s = bc7_subset_of(info.subsets, partition, i);
+					const uint8_t* e0 = unquantized[s][0];
+					const uint8_t* e1 = unquantized[s][1];
+					uint8_t* texel = texels + i * 4;
+
+					if (info.secondary_index_bits)
+					{
+						// In mode 4, the index selection bit swaps which index set is used for color and alpha.
+						const uint32_t color_index = index_selection ? secondary_indices[i] : indices[i];
+						const uint32_t color_index_bits = index_selection ? info.secondary_index_bits : info.index_bits;
+						const uint32_t alpha_index = index_selection ? indices[i] : secondary_indices[i];
+						const uint32_t alpha_index_bits = index_selection ? info.index_bits : info.secondary_index_bits;
+
+						for (uint32_t c = 0; c < 3; ++c) texel[c] = bc7_interpolate(e0[c], e1[c], color_index, color_index_bits);
+						texel[3] = bc7_interpolate(e0[3], e1[3], alpha_index, alpha_index_bits);
+					}
+					else
+					{
+						for (uint32_t c = 0; c < 4; ++c) texel[c] = bc7_interpolate(e0[c], e1[c], indices[i], info.index_bits);
+					}
+
+					if (rotation)
+					{
+						std::swap(texel[3], texel[rotation - 1]);
+					}
+				}
+			}
+
+		   /***********************************************************************************
+			*
+			* ETC2 and EAC
+			*
+			***********************************************************************************/
+
+			const int etc1_modifiers[8][2] =
+			{
+				{ 2, 8 }, { 5, 17 }, { 9, 29 }, { 13, 42 }, { 18, 60 }, { 24, 80 }, { 33, 106 }, { 47, 183 }
+			};
+
+			const int etc2_distances[8] = { 3, 6, 11, 16, 23, 32, 41, 64 };
+
+			const int eac_modifiers[16][8] =
+			{
+				{ -3, -6, -9, -15, 2, 5, 8, 14 }, { -3, -7, -10, -13, 2, 6, 9, 12 },
+				{ -2, -5, -8, -13, 1, 4, 7, 12 }, { -2, -4, -6, -13, 1, 3, 5, 12 },
+				{ -3, -6, -8, -12, 2, 5, 7, 11 }, { -3, -7, -9, -11, 2, 6, 8, 10 },
+				{ -4, -7, -8, -11, 3, 6, 7, 10 }, { -3, -5, -8, -11, 2, 4, 7, 10 },
+				{ -2, -6, -8, -10, 1, 5, 7, 9 }, { -2, -5, -8, -10, 1, 4, 7, 9 },
+				{ -2, -4, -8, -10, 1, 3, 7, 9 }, { -2, -5, -7, -10, 1, 4, 6, 9 },
+				{ -3, -4, -7, -10, 2, 3, 6, 9 }, { -1, -2, -3, -10, 0, 1, 2, 9 },
+				{ -4, -6, -8, -9, 3, 5, 7, 8 }, { -3, -5, -7, -9, 2, 4, 6, 8 }
+			};
+
+			inline uint32_t bits_of(uint64_t v, uint32_t high, uint32_t low) { return static_cast<uint32_t>((v >> low) & ((1ULL << (high - low + 1)) - 1)); }
+
+			inline int sign_extend_3(uint32_t v) { return (v & 4) ? static_cast<int>(v) - 8 : static_cast<int>(v); }
+
+			//! Decodes an ETC1/ETC2 color block (RGB8 or RGB8A1) into `texels`. Texels are addressed in the
+			//! block's column-major order and written in row-major order.
+			void decode_etc2_color(const uint8_t* block, uint8_t texels[64], bool punch_through)
+			{
+				const uint64_t bits = read_be64(block);
+				const uint32_t diff_bit = bits_of(bits, 33, 33);
+				const uint32_t flip = bits_of(bits, 32, 32);
+
+				// In the punch-through variant, the "differential" bit instead marks the block as opaque, and 
+				// individual mode is not available.
+				const bool differential = punch_through ? true : diff_bit != 0;
+				const bool opaque = punch_through ? diff_bit != 0 : true;
+
+				auto write_texel = [&](uint32_t x, uint32_t y, int r, int g, int b, bool transparent)
+				{
+					uint8_t* texel = texels + (y * 4 + x) * 4;
+					if (transparent)
+					{
+						texel[0] = texel[1] = texel[2] = texel[3] = 0;
+						return;
+					}
+					texel[0] = clamp_to_byte(r);
+					texel[1] = clamp_to_byte(g);
+					texel[2] = clamp_to_byte(b);
+					texel[3] = 255;
+				};
+
+				auto texel_index = [&](uint32_t x, uint32_t y)
+				{
+					const uint32_t i = x * 4 + y;
+					return (bits_of(bits, i + 16, i + 16) << 1) | bits_of(bits, i, i);
+				};
+
+				int base[2][3];
+				if (!differential)
+				{
+					for (int c = 0; c < 3; ++c)
+					{
+						base[0][c] = bits_of(bits, 63 - c * 8, 60 - c * 8) * 17;
+						base[1][c] = bits_of(bits, 59 - c * 8, 56 - c * 8) * 17;
+					}
+				}
+				else
+				{
+					int packed[3];
+					int second[3];
+					for (int c = 0; c < 3; ++c)
+					{
+						packed[c] = bits_of(bits, 63 - c * 8, 59 - c * 8);
+						second[c] = packed[c] + sign_extend_3(bits_of(bits, 58 - c * 8, 56 - c * 8));
+					}
+
+					if (second[0] < 0 || second[0] > 31)
+					{
+						// T mode.
+						int c0[3], c1[3];
+						c0[0] = (bits_of(bits, 60, 59) << 2) | bits_of(bits, 57, 56);
+						c0[1] = bits_of(bits, 55, 52);
+						c0[2] = bits_of(bits, 51, 48);
+						c1[0] = bits_of(bits, 47, 44);
+						c1[1] = bits_of(bits, 43, 40);
+						c1[2] = bits_of(bits, 39, 36);
+						const int d = etc2_distances[(bits_of(bits, 35, 34) << 1) | bits_of(bits, 32, 32)];
+
+						int paint[4][3];
+						for (int c = 0; c < 3; ++c)
+						{
+							paint[0][c] = c0[c] * 17;
+							paint[1][c] = c1[c] * 17 + d;
+							paint[2][c] = c1[c] * 17;
+							paint[3][c] = c1[c] * 17 - d;
+						}
+
+						for (uint32_t y = 0; y < 4; ++y)
+						{
+							for (uint32_t x = 0; x < 4; ++x)
+							{
+								const uint32_t index = texel_index(x, y);
+								write_texel(x, y, paint[index][0], paint[index][1], paint[index][2], !opaque && index == 2);
+							}
+						}
+						return;
+					}
+					if (second[1] < 0 || second[1] > 31)
+					{
+						// H mode.
+						int c0[3], c1[3];
+						c0[0] = bits_of(bits, 62, 59);
+						c0[1] = (bits_of(bits, 58, 56) << 1) | bits_of(bits, 52, 52);
+						c0[2] = (bits_of(bits, 51, 51) << 3) | bits_of(bits, 49, 47);
+						c1[0] = bits_of(bits, 46, 43);
+						c1[1] = bits_of(bits, 42, 39);
+						c1[2] = bits_of(bits, 38, 35);
+
+						const int v0 = (c0[0] << 8) | (c0[1] << 4) | c0[2];
+						const int v1 = (c1[0] << 8) | (c1[1] << 4) | c1[2];
+						const int d = etc2_distances[(bits_of(bits, 34, 34) << 2) | (bits_of(bits, 32, 32) << 1) | (v0 >= v1 ? 1 : 0)];
+
+						int paint[4][3];
+						for (int c = 0; c < 3; ++c)
+						{
+							paint[0][c] = c0[c] * 17 + d;
+							paint[1][c] = c0[c] * 17 - d;
+							paint[2][c] = c1[c] * 17 + d;
+							paint[3][c] = c1[c] * 17 - d;
+						}
+
+						for (uint32_t y = 0; y < 4; ++y)
+						{
+							for (uint32_t x = 0; x < 4; ++x)
+							{
+								const uint32_t index = texel_index(x, y);
+								write_texel(x, y, paint[index][0], paint[index][1], paint[index][2], !opaque && index == 2);
+							}
+						}
+						return;
+					}
+					if (second[2] < 0 || second[2] > 31)
+					{
+						// Planar mode: three 6-7-6 bit colors define a gradient across the block (always opaque).
+						const int ro = expand_bits(bits_of(bits, 62, 57), 6);
+						const int go = expand_bits((bits_of(bits, 56, 56) << 6) | bits_of(bits, 54, 49), 7);
+						const int bo = expand_bits((bits_of(bits, 48, 48) << 5) | (bits_of(bits, 44, 43) << 3) | bits_of(bits, 41, 39), 6);
+						const int rh = expand_bits((bits_of(bits, 38, 34) << 1) | bits_of(bits, 32, 32), 6);
+						const int gh = expand_bits(bits_of(bits, 31, 25), 7);
+						const int bh = expand_bits(bits_of(bits, 24, 19), 6);
+						const int rv = expand_bits(bits_of(bits, 18, 13), 6);
+						const int gv = expand_bits(bits_of(bits, 12, 6), 7);
+						const int bv = expand_bits(bits_of(bits, 5, 0), 6);
+
+						for (int y = 0; y < 4; ++y)
+						{
+							for (int x = 0; x < 4; ++x)
+							{
+								write_texel(x, y,
+									(x * (rh - ro) + y * (rv - ro) + 4 * ro + 2) >> 2,
+									(x * (gh - go) + y * (gv - go) + 4 * go + 2) >> 2,
+									(x * (bh - bo) + y * (bv - bo) + 4 * bo + 2) >> 2,
+									false);
+							}
+						}
+						return;
+					}
+
+					for (int c = 0; c < 3; ++c)
+					{
+						base[0][c] = expand_bits(packed[c], 5);
+						base[1][c] = expand_bits(second[c], 5);
+					}
+				}
+
+				// Individual and differential modes: two sub-blocks, each with a base color and modifier table.
+				const uint32_t tables[2] = { bits_of(bits, 39, 37), bits_of(bits, 36, 34) };
+				for (uint32_t y = 0; y < 4; ++y)
+				{
+					for (uint32_t x = 0; x < 4; ++x)
+					{
+						const uint32_t sub_block = flip ? (y >= 2) : (x >= 2);
+						const uint32_t index = texel_index(x, y);
+
+						int modifier = etc1_modifiers[tables[sub_block]][index & 1];
+						if (index & 2) modifier = -modifier;
+
+						// Without the opaque bit, index 0 carries no modifier and index 2 is transparent.
+						if (!opaque && index == 0) modifier = 0;
+
+						write_texel(x, y,
+							base[sub_block][0] + modifier,
+							base[sub_block][1] + modifier,
+							base[sub_block][2] + modifier,
+							!opaque && index == 2);
+					}
+				}
+			}
+
+			//! Decodes an 8-byte EAC block into every 4th byte of `out`. With `is_r11` set, the block is decoded 
+			//! as an 11-bit channel (EAC R11/RG11) and then reduced to 8 bits, otherwise as ETC2 alpha.
+			void decode_eac(const uint8_t* block, uint8_t* out, bool is_r11)
+			{
+				const uint64_t bits = read_be64(block);
+				const int base = block[0];
+				const int multiplier = block[1] >> 4;
+				const int* modifiers = eac_modifiers[block[1] & 0x0F];
+
+				for (uint32_t x = 0; x < 4; ++x)
+				{
+					for (uint32_t y = 0; y < 4; ++y)
+					{
+						const uint32_t i = x * 4 + y;
+						const int modifier = modifiers[bits_of(bits, 47 - i * 3, 45 - i * 3)];
+
+						int value;
+						if (is_r11)
+						{
+							const int v11 = std::min(std::max(base * 8 + 4 + modifier * (multiplier ? multiplier * 8 : 1), 0), 2047);
+							value = (v11 * 255 + 1023) / 2047;
+						}
+						else
+						{
+							value = clamp_to_byte(base + modifier * multiplier);
+						}
+						out[(y * 4 + x) * 4] = static_cast<uint8_t>(value);
+					}
+				}
+			}
+
+			void fill_channel(uint8_t texels[64], uint32_t channel, uint8_t value)
+			{
+				for (int i = 0; i < 16; ++i) texels[i * 4 + channel] = value;
+			}
+
+		   /***********************************************************************************
+			*
+			* Encoding
+			*
+			***********************************************************************************/
+
+			//! Finds the palette entry closest to each texel (by squared RGBA distance) and returns the total 
+			//! error. If `include_alpha` is `false`, the alpha channel is ignored. If `errors` is not null, the
+			//! error of each individual texel is written to it.
+			uint32_t select_indices(const uint8_t texels[64], const uint8_t (*palette)[4], uint32_t palette_size, bool include_alpha, uint8_t indices[16], uint32_t errors[16] = nullptr)
+			{
+#if defined(PLUME_SSE2)
+				// Process 4 texels per register: each texel is widened to 16 bits, and the squared distance to
+				// every palette entry is accumulated with a multiply-add.
+				const __m128i zero = _mm_setzero_si128();
+				const __m128i mask = include_alpha ? _mm_set1_epi32(-1) : _mm_set1_epi32(0x00FFFFFF);
+
+				__m128i pixels_lo[4];
+				__m128i pixels_hi[4];
+				__m128i best_errors[4];
+				__m128i best_indices[4];
+				for (int r = 0; r < 4; ++r)
+				{
+					const __m128i p = _mm_and_si128(_mm_loadu_si128(reinterpret_cast<const __m128i*>(texels + r * 16)), mask);
+					pixels_lo[r] = _mm_unpacklo_epi8(p, zero);
+					pixels_hi[r] = _mm_unpackhi_epi8(p, zero);
+					best_errors[r] = _mm_set1_epi32(std::numeric_limits<int32_t>::max());
+					best_indices[r] = zero;
+				}
+
+				for (uint32_t j = 0; j < palette_size; ++j)
+				{
+					uint32_t packed;
+					memcpy(&packed, palette[j], 4);
+					const __m128i color = _mm_and_si128(_mm_set1_epi32(static_cast<int32_t>(packed)), mask);
+					const __m128i color_wide = _mm_unpacklo_epi8(color, zero);
+					const __m128i index = _mm_set1_epi32(static_cast<int32_t>(j));
+
+					for (int r = 0; r < 4; ++r)
+					{
+						const __m128i d_lo = _mm_sub_epi16(pixels_lo[r], color_wide);
+						const __m128i d_hi = _mm_sub_epi16(pixels_hi[r], color_wide);
+
+						// Each multiply-add yields (r^2 + g^2, b^2 + a^2) for two texels: sum the pairs.
+						const __m128 sq_lo = _mm_castsi128_ps(_mm_madd_epi16(d_lo, d_lo));
+						const __m128 sq_hi = _mm_castsi128_ps(_mm_madd_epi16(d_hi, d_hi));
+						const __m128i evens = _mm_castps_si128(_mm_shuffle_ps(sq_lo, sq_hi, _MM_SHUFFLE(2, 0, 2, 0)));
+						const __m128i odds = _mm_castps_si128(_mm_shuffle_ps(sq_lo, sq_hi, _MM_SHUFFLE(3, 1, 3, 1)));
+						const __m128i error = _mm_add_epi32(evens, odds);
+
+						const __m128i less = _mm_cmplt_epi32(error, best_errors[r]);
+						best_errors[r] = _mm_or_si128(_mm_and_si128(less, error), _mm_andnot_si128(less, best_errors[r]));
+						best_indices[r] = _mm_or_si128(_mm_and_si128(less, index), _mm_andnot_si128(less, best_indices[r]));
+					}
+				}
+
+				uint32_t total = 0;
+				for (int r = 0; r < 4; ++r)
+				{
+					alignas(16) uint32_t e[4];
+					alignas(16) uint32_t i[4];
+					_mm_store_si128(reinterpret_cast<__m128i*>(e), best_errors[r]);
+					_mm_store_si128(reinterpret_cast<__m128i*>(i), best_indices[r]);
+					for (int k = 0; k < 4; ++k)
+					{
+						indices[r * 4 + k] = static_cast<uint8_t>(i[k]);
+						if (errors) errors[r * 4 + k] = e[k];
+						total += e[k];
+					}
+				}
+				return total;
+#else
+				const uint32_t channels = include_alpha ? 4 : 3;
+				uint32_t total = 0;
+				for (int i = 0; i < 16; ++i)
+				{
+					uint32_t best_error = std::numeric_limits<uint32_t>::max();
+					for (uint32_t j = 0; j < palette_size; ++j)
+					{
+						uint32_t error = 0;
+						for (uint32_t c = 0; c < channels; ++c)
+						{
+							const int d = static_cast<int>(texels[i * 4 + c]) - palette[j][c];
+							error += d * d;
+						}
+						if (error < best_error)
+						{
+							best_error = error;
+							indices[i] = static_cast<uint8_t>(j);
+						}
+					}
+					if (errors) errors[i] = best_error;
+					total += best_error;
+				}
+				return total;
+#endif
+			}
+
+			//! Fits a line segment through the texels for which `include[i]` is `true` (all texels if `include` 
+			//! is null), considering the first `channels` channels. At `QUALITY_FAST`, the segment spans the
+			//! bounding box. Otherwise, it follows the principal axis of the texels' covariance, clipped to the
+			//! extreme projections.
+			void fit_endpoints(const uint8_t texels[64], const bool* include, uint32_t channels, EncodeQuality quality, float e0[4], float e1[4])
+			{
+				float mean[4] = {};
+				float minimum[4] = { 255.0f, 255.0f, 255.0f, 255.0f };
+				float maximum[4] = {};
+				uint32_t count = 0;
+
+				for (int i = 0; i < 16; ++i)
+				{
+					if (include && !include[i]) continue;
+					for (uint32_t c = 0; c < channels; ++c)
+					{
+						const float v = texels[i * 4 + c];
+						mean[c] += v;
+						minimum[c] = std::min(minimum[c], v);
+						maximum[c] = std::max(maximum[c], v);
+					}
+					count++;
+				}
+
+				if (count == 0)
+				{
+					for (int c = 0; c < 4; ++c) e0[c] = e1[c] = 0.0f;
+					return;
+				}
+
+				if (quality == EncodeQuality::QUALITY_FAST)
+				{
+					for (uint32_t c = 0; c < channels; ++c)
+					{
+						e0[c] = minimum[c];
+						e1[c] = maximum[c];
+					}
+					return;
+				}
+
+				for (uint32_t c = 0; c < channels; ++c) mean[c] /= static_cast<float>(count);
+
+				float covariance[4][4] = {};
+				for (int i = 0; i < 16; ++i)
+				{
+					if (include && !include[i]) continue;
+					float d[4];
+					for (uint32_t c = 0; c < channels; ++c) d[c] = texels[i * 4 + c] - mean[c];
+					for (uint32_t a = 0; a < channels; ++a)
+					{
+						for (uint32_t b = 0; b < channels; ++b) covariance[a][b] += d[a] * d[b];
+					}
+				}
+
+				// Power iteration, starting from the diagonal of the bounding box.
+				float axis[4] = {};
+				for (uint32_t c = 0; c < channels; ++c) axis[c] = maximum[c] - minimum[c];
+				for (int iteration = 0; iteration < 8; ++iteration)
+				{
+					float next[4] = {};
+					float length = 0.0f;
+					for (uint32_t a = 0; a < channels; ++a)
+					{
+						for (uint32_t b = 0; b < channels; ++b) next[a] += covariance[a][b] * axis[b];
+						length = std::max(length, std::fabs(next[a]));
+					}
+					if (length < 1e-6f) break;
+					for (uint32_t c = 0; c < channels; ++c) axis[c] = next[c] / length;
+				}
+
+				float norm = 0.0f;
+				for (uint32_t c = 0; c < channels; ++c) norm += axis[c] * axis[c];
+				if (norm < 1e-6f)
+				{
+					// All of the texels are (nearly) identical.
+					for (uint32_t c = 0; c < channels; ++c) e0[c] = e1[c] = mean[c];
+					return;
+				}
+				norm = std::sqrt(norm);
+				for (uint32_t c = 0; c < channels; ++c) axis[c] /= norm;
+
+				float t_min = std::numeric_limits<float>::max();
+				float t_max = -std::numeric_limits<float>::max();
+				for (int i = 0; i < 16; ++i)
+				{
+					if (include && !include[i]) continue;
+					float t = 0.0f;
+					for (uint32_t c = 0; c < channels; ++c) t += (texels[i * 4 + c] - mean[c]) * axis[c];
+					t_min = std::min(t_min, t);
+					t_max = std::max(t_max, t);
+				}
+
+				for (uint32_t c = 0; c < channels; ++c)
+				{
+					e0[c] = std::min(std::max(mean[c] + axis[c] * t_min, 0.0f), 255.0f);
+					e1[c] = std::min(std::max(mean[c] + axis[c] * t_max, 0.0f), 255.0f);
+				}
+			}
+
+			//! Solves for the endpoints that minimize the squared error of the texels for which `include[i]` is
+			//! `true`, given each texel's interpolation weight toward `e1` (in [0..1]). Returns `false` (leaving 
+			//! the endpoints unchanged) if the system is degenerate.
+			bool refine_endpoints(const uint8_t texels[64], const bool* include, const float weights[16], uint32_t channels, float e0[4], float e1[4])
+			{
+				float aa = 0.0f, ab = 0.0f, bb = 0.0f;
+				float ax[4] = {}, bx[4] = {};
+				for (int i = 0; i < 16; ++i)
+				{
+					if (include && !include[i]) continue;
+					const float b = weights[i];
+					const float a = 1.0f - b;
+					aa += a * a;
+					ab += a * b;
+					bb += b * b;
+					for (uint32_t c = 0; c < channels; ++c)
+					{
+						ax[c] += a * texels[i * 4 + c];
+						bx[c] += b * texels[i * 4 + c];
+					}
+				}
+
+				const float determinant = aa * bb - ab * ab;
+				if (std::fabs(determinant) < 1e-6f)
+				{
+					return false;
+				}
+
+				for (uint32_t c = 0; c < channels; ++c)
+				{
+					e0[c] = std::min(std::max((bb * ax[c] - ab * bx[c]) / determinant, 0.0f), 255.0f);
+					e1[c] = std::min(std::max((aa * bx[c] - ab * ax[c]) / determinant, 0.0f), 255.0f);
+				}
+				return true;
+			}
+
+			inline uint32_t get_refinement_count(EncodeQuality quality)
+			{
+				return (quality == EncodeQuality::QUALITY_FAST) ? 0 : (quality == EncodeQuality::QUALITY_NORMAL) ? 1 : 4;
+			}
+
+			inline uint16_t quantize_565(const float rgb[3])
+			{
+				const int r = std::min(std::max(static_cast<int>(rgb[0] * 31.0f / 255.0f + 0.5f), 0), 31);
+				const int g = std::min(std::max(static_cast<int>(rgb[1] * 63.0f / 255.0f + 0.5f), 0), 63);
+				const int b = std::min(std::max(static_cast<int>(rgb[2] * 31.0f / 255.0f + 0.5f), 0), 31);
+				return static_cast<uint16_t>((r << 11) | (g << 5) | b);
+			}
+
+			//! Encodes the color half of a BC1, BC2 or BC3 block. With `allow_punch_through` (plain BC1 with 
+			//! alpha), texels with alpha below 128 are encoded with the transparent index of 3-color mode.
+			void encode_bc1_color(const uint8_t texels[64], uint8_t* block, EncodeQuality quality, bool allow_punch_through)
+			{
+				bool include[16];
+				bool has_transparent = false;
+				for (int i = 0; i < 16; ++i)
+				{
+					include[i] = !(allow_punch_through && texels[i * 4 + 3] < 128);
+					has_transparent |= !include[i];
+				}
+
+				// Alpha is ignored in the color fit.
+				uint8_t opaque_texels[64];
+				for (int i = 0; i < 16; ++i)
+				{
+					memcpy(opaque_texels + i * 4, texels + i * 4, 3);
+					opaque_texels[i * 4 + 3] = 255;
+				}
+
+				float e0[4], e1[4];
+				fit_endpoints(opaque_texels, include, 3, quality, e0, e1);
+
+				uint32_t best_error = std::numeric_limits<uint32_t>::max();
+				uint16_t best_c0 = 0;
+				uint16_t best_c1 = 0;
+				uint8_t best_indices[16] = {};
+
+				const uint32_t refinements = get_refinement_count(quality);
+				for (uint32_t iteration = 0; iteration <= refinements; ++iteration)
+				{
+					uint16_t c0 = quantize_565(e1);
+					uint16_t c1 = quantize_565(e0);
+
+					// 4-color mode requires c0 > c1, 3-color (punch-through) mode requires c0 <= c1.
+					if (has_transparent ? (c0 > c1) : (c0 < c1))
+					{
+						std::swap(c0, c1);
+					}
+
+					uint8_t palette[4][4];
+					build_bc1_palette(c0, c1, allow_punch_through, false, palette);
+					const uint32_t palette_size = (c0 > c1 || !allow_punch_through) ? 4 : 3;
+
+					uint8_t indices[16];
+					uint32_t errors[16];
+					select_indices(opaque_texels, palette, palette_size, false, indices, errors);
+
+					uint32_t error = 0;
+					for (int i = 0; i < 16; ++i)
+					{
+						if (include[i]) error += errors[i];
+						else indices[i] = 3;
+					}
+
+					if (error < best_error)
+					{
+						best_error = error;
+						best_c0 = c0;
+						best_c1 = c1;
+						memcpy(best_indices, indices, 16);
+					}
+					if (best_error == 0 || iteration == refinements)
+					{
+						break;
+					}
+
+					// Refit the (unquantized) endpoints to the chosen indices.
+					const float weights_4[4] = { 0.0f, 1.0f, 1.0f / 3.0f, 2.0f / 3.0f };
+					const float weights_3[4] = { 0.0f, 1.0f, 0.5f, 0.0f };
+					float weights[16];
+					for (int i = 0; i < 16; ++i) weights[i] = (palette_size == 4) ? weights_4[indices[i]] : weights_3[indices[i]];
+
+					// Index 0 selects `c0` (fit from `e1`) and index 1 selects `c1` (fit from `e0`).
+					if (!refine_endpoints(opaque_texels, include, weights, 3, e1, e0))
+					{
+						break;
+					}
+				}
+
+				block[0] = static_cast<uint8_t>(best_c0 & 0xFF);
+				block[1] = static_cast<uint8_t>(best_c0 >> 8);
+				block[2] = static_cast<uint8_t>(best_c1 & 0xFF);
+				block[3] = static_cast<uint8_t>(best_c1 >> 8);
+
+				uint32_t packed = 0;
+				for (int i = 0; i < 16; ++i) packed |= static_cast<uint32_t>(best_indices[i]) << (2 * i);
+				for (int i = 0; i < 4; ++i) block[4 + i] = static_cast<uint8_t>(packed >> (8 * i));
+			}
+
+			//! Returns the squared error of encoding `values` with an interpolated 8-bit channel palette, and 
+			//! writes the chosen indices.
+			uint32_t evaluate_bc4(const uint8_t values[16], int e0, int e1, uint8_t indices[16])
+			{
+				int palette[8];
+				palette[0] = e0;
+				palette[1] = e1;
+				if (e0 > e1)
+				{
+					for (int i = 1; i < 7; ++i) palette[i + 1] = ((7 - i) * e0 + i * e1) / 7;
+				}
+				else
+				{
+					for (int i = 1; i < 5; ++i) palette[i + 1] = ((5 - i) * e0 + i * e1) / 5;
+					palette[6] = 0;
+					palette[7] = 255;
+				}
+
+				uint32_t total = 0;
+				for (int i = 0; i < 16; ++i)
+				{
+					uint32_t best = std::numeric_limits<uint32_t>::max();
+					for (uint8_t j = 0; j < 8; ++j)
+					{
+						const int d = values[i] - palette[j];
+						const uint32_t error = static_cast<uint32_t>(d * d);
+						if (error < best)
+						{
+							best = error;
+							indices[i] = j;
+						}
+					}
+					total += best;
+				}
+				return total;
+			}
+
+			//! Encodes 16 8-bit values as an interpolated channel (the alpha half of BC3, or a BC4/BC5 channel).
+			void encode_bc4_channel(const uint8_t values[16], uint8_t* block, EncodeQuality quality)
+			{
+				int minimum = 255, maximum = 0;
+				int inner_minimum = 255, inner_maximum = 0;
+				for (int i = 0; i < 16; ++i)
+				{
+					minimum = std::min(minimum, static_cast<int>(values[i]));
+					maximum = std::max(maximum, static_cast<int>(values[i]));
+					if (values[i] != 0 && values[i] != 255)
+					{
+						inner_minimum = std::min(inner_minimum, static_cast<int>(values[i]));
+						inner_maximum = std::max(inner_maximum, static_cast<int>(values[i]));
+					}
+				}
+
+				int best_e0 = maximum;
+				int best_e1 = minimum;
+				uint8_t best_indices[16];
+				uint32_t best_error = evaluate_bc4(values, best_e0, best_e1, best_indices);
+
+				auto consider = [&](int e0, int e1)
+				{
+					uint8_t indices[16];
+					const uint32_t error = evaluate_bc4(values, e0, e1, indices);
+					if (error < best_error)
+					{
+						best_error = error;
+						best_e0 = e0;
+						best_e1 = e1;
+						memcpy(best_indices, indices, 16);
+					}
+				};
+
+				if (quality != EncodeQuality::QUALITY_FAST && best_error > 0)
+				{
+					// 6-value mode, which has exact 0 and 255 entries for the remaining values.
+					if (inner_minimum <= inner_maximum) consider(inner_minimum, inner_maximum);
+
+					if (quality == EncodeQuality::QUALITY_HIGH)
+					{
+						// Try insetting the 8-value endpoints, which often lowers the error of interior values.
+						for (int inset_max = 0; inset_max <= 3; ++inset_max)
+						{
+							for (int inset_min = 0; inset_min <= 3; ++inset_min)
+							{
+								const int e0 = maximum - inset_max;
+								const int e1 = minimum + inset_min;
+								if (e0 > e1) consider(e0, e1);
+							}
+						}
+					}
+				}
+
+				block[0] = static_cast<uint8_t>(best_e0);
+				block[1] = static_cast<uint8_t>(best_e1);
+
+				uint64_t packed = 0;
+				for (int i = 0; i < 16; ++i) packed |= static_cast<uint64_t>(best_indices[i]) << (3 * i);
+				for (int i = 0; i < 6; ++i) block[2 + i] = static_cast<uint8_t>(packed >> (8 * i));
+			}
+
+			//! Writes bits into a 128-bit block, least significant bit first.
+			class BitWriter
+			{
+			public:
+
+				BitWriter(uint8_t* block) :
+					m_block(block),
+					m_position(0)
+				{
+					memset(m_block, 0, 16);
+				}
+
+				void write(uint32_t value, uint32_t count)
+				{
+					for (uint32_t i = 0; i < count; ++i, ++m_position)
+					{
+						m_block[m_position >> 3] |= static_cast<uint8_t>(((value >> i) & 1) << (m_position & 7));
+					}
+				}
+
+			private:
+
+				uint8_t* m_block;
+				uint32_t m_position;
+			};
+
+			//! Quantizes an endpoint to `bits` bits per channel plus a p-bit that is shared by all channels. If 
+			//! `forced_p_bit` is 0 or 1, that p-bit is used. Otherwise, the p-bit with the lower error is chosen.
+			//! Returns the squared error of the reconstructed endpoint.
+			float quantize_endpoint_with_p_bit(const float endpoint[4], uint32_t channels, uint32_t bits, int forced_p_bit, uint32_t quantized[4], uint32_t& p_bit)
+			{
+				float best_error = std::numeric_limits<float>::max();
+				const int max_value = (1 << bits) - 1;
+
+				for (int p = 0; p < 2; ++p)
+				{
+					if (forced_p_bit >= 0 && p != forced_p_bit) continue;
+
+					float error = 0.0f;
+					uint32_t candidate[4] = {};
+					for (uint32_t c = 0; c < channels; ++c)
+					{
+						// The reconstructed value is ((q << 1) | p) expanded from `bits + 1` bits.
+						const float scaled = endpoint[c] * static_cast<float>((2 << bits) - 1) / 255.0f;
+						const int q = std::min(std::max(static_cast<int>((scaled - p) / 2.0f + 0.5f), 0), max_value);
+						candidate[c] = static_cast<uint32_t>(q);
+
+						const float d = expand_bits((static_cast<uint32_t>(q) << 1) | p, bits + 1) - endpoint[c];
+						error += d * d;
+					}
+
+					if (error < best_error)
+					{
+						best_error = error;
+						memcpy(quantized, candidate, sizeof(candidate));
+						p_bit = static_cast<uint32_t>(p);
+					}
+				}
+				return best_error;
+			}
+
+			//! Encodes a block with BC7 mode 6: a single RGBA subset with 7.7.7.7 endpoints, one p-bit per 
+			//! endpoint, and 4-bit indices. Returns the squared error of the encoded block.
+			uint32_t encode_bc7_mode_6(const uint8_t texels[64], uint8_t* block, EncodeQuality quality)
+			{
+				float e0[4], e1[4];
+				fit_endpoints(texels, nullptr, 4, quality, e0, e1);
+
+				uint32_t best_error = std::numeric_limits<uint32_t>::max();
+				uint32_t best_q[2][4] = {};
+				uint32_t best_p[2] = {};
+				uint8_t best_indices[16] = {};
+
+				const uint32_t refinements = get_refinement_count(quality);
+				for (uint32_t iteration = 0; iteration <= refinements; ++iteration)
+				{
+					uint32_t q[2][4];
+					uint32_t p[2];
+					quantize_endpoint_with_p_bit(e0, 4, 7, -1, q[0], p[0]);
+					quantize_endpoint_with_p_bit(e1, 4, 7, -1, q[1], p[1]);
+
+					uint8_t endpoints[2][4];
+					for (int e = 0; e < 2; ++e)
+					{
+						for (int c = 0; c < 4; ++c) endpoints[e][c] = expand_bits((q[e][c] << 1) | p[e], 8);
+					}
+
+					uint8_t palette[16][4];
+					for (uint32_t i = 0; i < 16; ++i)
+					{
+						for (int c = 0; c < 4; ++c) palette[i][c] = bc7_interpolate(endpoints[0][c], endpoints[1][c], i, 4);
+					}
+
+					uint8_t indices[16];
+					const uint32_t error = select_indices(texels, palette, 16, true, indices);
+					if (error < best_error)
+					{
+						best_error = error;
+						memcpy(best_q, q, sizeof(q));
+						memcpy(best_p, p, sizeof(p));
+						memcpy(best_indices, indices, 16);
+					}
+					if (best_error == 0 || iteration == refinements)
+					{
+						break;
+					}
+
+					float weights[16];
+					for (int i = 0; i < 16; ++i) weights[i] = bc7_weights_4[indices[i]] / 64.0f;
+					if (!refine_endpoints(texels, nullptr, weights, 4, e0, e1))
+					{
+						break;
+					}
+				}
+
+				// The anchor texel's index must have a 0 MSB: otherwise, swap the endpoints and invert the indices.
+				if (best_indices[0] & 8)
+				{
+					std::swap(best_q[0], best_q[1]);
+					std::swap(best_p[0], best_p[1]);
+					for (int i = 0; i < 16; ++i) best_indices[i] = static_cast<uint8_t>(15 - best_indices[i]);
+				}
+
+				BitWriter writer{ block };
+				writer.write(1 << 6, 7);
+				for (int c = 0; c < 4; ++c)
+				{
+					writer.write(best_q[0][c], 7);
+					writer.write(best_q[1][c], 7);
+				}
+				writer.write(best_p[0], 1);
+				writer.write(best_p[1], 1);
+				for (int i = 0; i < 16; ++i) writer.write(best_indices[i], i == 0 ? 3 : 4);
+
+				return best_error;
+			}
+
+			//! Encodes an opaque block with BC7 mode 1: two RGB subsets with 6.6.6 endpoints, one p-bit per 
+			//! subset, and 3-bit indices. Every partition is tried. Returns the squared error of the encoded block.
+			uint32_t encode_bc7_mode_1(const uint8_t texels[64], uint8_t* block, EncodeQuality quality)
+			{
+				uint32_t best_error = std::numeric_limits<uint32_t>::max();
+				uint32_t best_partition = 0;
+				uint32_t best_q[2][2][4] = {};
+				uint32_t best_p[2] = {};
+				uint8_t best_indices[16] = {};
+
+				for (uint32_t partition = 0; partition < 64; ++partition)
+				{
+					uint32_t partition_error = 0;
+					uint32_t q[2][2][4] = {};
+					uint32_t p[2] = {};
+					uint8_t indices[16] = {};
+
+					for (uint32_t s = 0; s < 2 && partition_error < best_error; ++s)
+					{
+						bool include[16];
+						for (uint32_t i = 0; i < 16; ++i) include[i] = bc7_subset_of(2, partition, i) == s;
+
+						float e0[4], e1[4];
+						fit_endpoints(texels, include, 3, quality, e0, e1);
+
+						uint32_t subset_best = std::numeric_limits<uint32_t>::max();
+						const uint32_t refinements = get_refinement_count(quality);
+						for (uint32_t iteration = 0; iteration <= refinements; ++iteration)
+						{
+							// Both endpoints of a subset share a p-bit: pick the one with the lower combined error.
+							uint32_t candidate_q[2][4];
+							uint32_t candidate_p = 0;
+							float best_p_error = std::numeric_limits<float>::max();
+							for (int shared = 0; shared < 2; ++shared)
+							{
+								uint32_t q0[4], q1[4], unused;
+								const float error = quantize_endpoint_with_p_bit(e0, 3, 6, shared, q0, unused) + 
+													quantize_endpoint_with_p_bit(e1, 3, 6, shared, q1, unused);
+								if (error < best_p_error)
+								{
+									best_p_error = error;
+									memcpy(candidate_q[0], q0, sizeof(q0));
+									memcpy(candidate_q[1], q1, sizeof(q1));
+									candidate_p = static_cast<uint32_t>(shared);
+								}
+							}
+
+							uint8_t palette[8][4];
+							for (uint32_t i = 0; i < 8; ++i)
+							{
+								for (int c = 0; c < 3; ++c)
+								{
+									palette[i][c] = bc7_interpolate(expand_bits((candidate_q[0][c] << 1) | candidate_p, 7),
+																	expand_bits((candidate_q[1][c] << 1) | candidate_p, 7), i, 3);
+								}
+								palette[i][3] = 255;
+							}
+
+							uint8_t candidate_indices[16];
+							uint32_t errors[16];
+							select_indices(texels, palette, 8, false, candidate_indices, errors);
+
+							uint32_t error = 0;
+							for (uint32_t i = 0; i < 16; ++i) if (include[i]) error += errors[i];
+
+							if (error < subset_best)
+							{
+								subset_best = error;
+								memcpy(q[s], candidate_q, sizeof(candidate_q));
+								p[s] = candidate_p;
+								for (uint32_t i = 0; i < 16; ++i) if (include[i]) indices[i] = candidate_indices[i];
+							}
+							if (subset_best == 0 || iteration == refinements)
+							{
+								break;
+							}
+
+							float weights[16];
+							for (int i = 0; i < 16; ++i) weights[i] = bc7_weights_3[candidate_indices[i]] / 64.0f;
+							if (!refine_endpoints(texels, include, weights, 3, e0, e1))
+							{
+								break;
+							}
+						}
+						partition_error += subset_best;
+					}
+
+					if (partition_error < best_error)
+					{
+						best_error = partition_error;
+						best_partition = partition;
+						memcpy(best_q, q, sizeof(q));
+						memcpy(best_p, p, sizeof(p));
+						memcpy(best_indices, indices, 16);
+					}
+				}
+
+				// The anchor texel of each subset must have a 0 index MSB.
+				const uint32_t anchors[2] = { 0, bc7_anchors_2[best_partition] };
+				for (uint32_t s = 0; s < 2; ++s)
+				{
+					if (best_indices[anchors[s]] & 4)
+					{
+						std::swap(best_q[s][0], best_q[s][1]);
+						for (uint32_t i = 0; i < 16; ++i)
+						{
+							if (bc7_subset_of(2, best_partition, i) == s) best_indices[i] = static_cast<uint8_t>(7 - best_indices[i]);
+						}
+					}
+				}
+
+				BitWriter writer{ block };
+				writer.write(1 << 1, 2);
+				writer.write(best_partition, 6);
+				for (int c = 0; c < 3; ++c)
+				{
+					for (int s = 0; s < 2; ++s)
+					{
+						writer.write(best_q[s][0][c], 6);
+						writer.write(best_q[s][1][c], 6);
+					}
+				}
+				writer.write(best_p[0], 1);
+				writer.write(best_p[1], 1);
+				for (uint32_t i = 0; i < 16; ++i) writer.write(best_indices[i], bc7_is_anchor(2, best_partition, i) ? 2 : 3);
+
+				return best_error;
+			}
+
+			void encode_bc7(const uint8_t texels[64], uint8_t* block, EncodeQuality quality)
+			{
+				const uint32_t error = encode_bc7_mode_6(texels, block, quality);
+
+				bool is_opaque = true;
+				for (int i = 0; i < 16; ++i) is_opaque &= texels[i * 4 + 3] == 255;
+
+				if (quality == EncodeQuality::QUALITY_HIGH && is_opaque && error > 0)
+				{
+					uint8_t candidate[16];
+					if (encode_bc7_mode_1(texels, candidate, quality) < error)
+					{
+						memcpy(block, candidate, 16);
+					}
+				}
+			}
+
+		} // anonymous
+
+		size_t get_block_size(BlockFormat format)
+		{
+			switch (format)
+			{
+			case BlockFormat::BLOCK_BC1_RGB:
+			case BlockFormat::BLOCK_BC1_RGBA:
+			case BlockFormat::BLOCK_BC4_UNORM:
+			case BlockFormat::BLOCK_BC4_SNORM:
+			case BlockFormat::BLOCK_ETC2_RGB:
+			case BlockFormat::BLOCK_ETC2_RGB_A1:
+			case BlockFormat::BLOCK_EAC_R:
+				return 8;
+			default:
+				return 16;
+			}
+		}
+
+		void decode_block(BlockFormat format, const uint8_t* block, uint8_t texels[64])
+		{
+			switch (format)
+			{
+			case BlockFormat::BLOCK_BC1_RGB:
+				decode_bc1_color(block, texels, true, false);
+				break;
+			case BlockFormat::BLOCK_BC1_RGBA:
+				decode_bc1_color(block, texels, true, true);
+				break;
+			case BlockFormat::BLOCK_BC2:
+				decode_bc1_color(block + 8, texels, false, false);
+				for (int i = 0; i < 16; ++i)
+				{
+					const uint32_t a = (block[i / 2] >> ((i & 1) * 4)) & 0x0F;
+					texels[i * 4 + 3] = static_cast<uint8_t>(a * 17);
+				}
+				break;
+			case BlockFormat::BLOCK_BC3:
+				decode_bc1_color(block + 8, texels, false, false);
+				decode_bc4_channel(block, texels + 3, false);
+				break;
+			case BlockFormat::BLOCK_BC4_UNORM:
+			case BlockFormat::BLOCK_BC4_SNORM:
+				decode_bc4_channel(block, texels, is_signed_block_format(format));
+				fill_channel(texels, 1, 0);
+				fill_channel(texels, 2, 0);
+				fill_channel(texels, 3, is_signed_block_format(format) ? 127 : 255);
+				break;
+			case BlockFormat::BLOCK_BC5_UNORM:
+			case BlockFormat::BLOCK_BC5_SNORM:
+				decode_bc4_channel(block, texels, is_signed_block_format(format));
+				decode_bc4_channel(block + 8, texels + 1, is_signed_block_format(format));
+				fill_channel(texels, 2, 0);
+				fill_channel(texels, 3, is_signed_block_format(format) ? 127 : 255);
+				break;
+			case BlockFormat::BLOCK_BC7:
+				decode_bc7(block, texels);
+				break;
+			case BlockFormat::BLOCK_ETC2_RGB:
+				decode_etc2_color(block, texels, false);
+				break;
+			case BlockFormat::BLOCK_ETC2_RGB_A1:
+				decode_etc2_color(block, texels, true);
+				break;
+			case BlockFormat::BLOCK_ETC2_RGBA:
+				decode_etc2_color(block + 8, texels, false);
+				decode_eac(block, texels + 3, false);
+				break;
+			case BlockFormat::BLOCK_EAC_R:
+				decode_eac(block, texels, true);
+				fill_channel(texels, 1, 0);
+				fill_channel(texels, 2, 0);
+				fill_channel(texels, 3, 255);
+				break;
+			case BlockFormat::BLOCK_EAC_RG:
+				decode_eac(block, texels, true);
+				decode_eac(block + 8, texels + 1, true);
+				fill_channel(texels, 2, 0);
+				fill_channel(texels, 3, 255);
+				break;
+			default:
+				throw std::runtime_error("Unsupported block format");
+			}
+		}
+
+		bool is_encodable_block_format(BlockFormat format)
+		{
+			switch (format)
+			{
+			case BlockFormat::BLOCK_BC1_RGB:
+			case BlockFormat::BLOCK_BC1_RGBA:
+			case BlockFormat::BLOCK_BC3:
+			case BlockFormat::BLOCK_BC4_UNORM:
+			case BlockFormat::BLOCK_BC5_UNORM:
+			case BlockFormat::BLOCK_BC7:
+				return true;
+			default:
+				return false;
+			}
+		}
+
+		void encode_block(BlockFormat format, const uint8_t texels[64], uint8_t* block, EncodeQuality quality)
+		{
+			uint8_t channel[16];
+			auto gather_channel = [&](uint32_t c)
+			{
+				for (int i = 0; i < 16; ++i) channel[i] = texels[i * 4 + c];
+				return channel;
+			};
+
+			switch (format)
+			{
+			case BlockFormat::BLOCK_BC1_RGB:
+				encode_bc1_color(texels, block, quality, false);
+				break;
+			case BlockFormat::BLOCK_BC1_RGBA:
+				encode_bc1_color(texels, block, quality, true);
+				break;
+			case BlockFormat::BLOCK_BC3:
+				encode_bc4_channel(gather_channel(3), block, quality);
+				encode_bc1_color(texels, block + 8, quality, false);
+				break;
+			case BlockFormat::BLOCK_BC4_UNORM:
+				encode_bc4_channel(gather_channel(0), block, quality);
+				break;
+			case BlockFormat::BLOCK_BC5_UNORM:
+				encode_bc4_channel(gather_channel(0), block, quality);
+				encode_bc4_channel(gather_channel(1), block + 8, quality);
+				break;
+			case BlockFormat::BLOCK_BC7:
+				encode_bc7(texels, block, quality);
+				break;
+			default:
+				throw std::runtime_error("Unsupported block format passed to `encode_block()`");
+			}
+		}
+
+		void encode_blocks(BlockFormat format, const uint8_t* source, uint32_t width, uint32_t height, size_t row_pitch, uint8_t* blocks, EncodeQuality quality)
+		{
+			if (!is_encodable_block_format(format))
+			{
+				throw std::runtime_error("Unsupported block format passed to `encode_blocks()`");
+			}
+
+			const uint32_t blocks_x = (width + 3) / 4;
+			const uint32_t blocks_y = (height + 3) / 4;
+			const size_t block_size = get_block_size(format);
+
+			ThreadPool::global().parallel_for(0, blocks_y, 1, [&](size_t block_row_begin, size_t block_row_end)
+			{
+				uint8_t texels[64];
+				for (size_t by = block_row_begin; by < block_row_end; ++by)
+				{
+					for (uint32_t bx = 0; bx < blocks_x; ++bx)
+					{
+						// Gather the block, clamping to the last row and column of the surface.
+						for (uint32_t y = 0; y < 4; ++y)
+						{
+							const uint32_t sy = std::min(static_cast<uint32_t>(by) * 4 + y, height - 1);
+							for (uint32_t x = 0; x < 4; ++x)
+							{
+								const uint32_t sx = std::min(bx * 4 + x, width - 1);
+								memcpy(texels + (y * 4 + x) * 4, source + sy * row_pitch + sx * 4, 4);
+							}
+						}
+
+						encode_block(format, texels, blocks + (by * blocks_x + bx) * block_size, quality);
+					}
+				}
+			});
+		}
+
+		void decode_blocks(BlockFormat format, const uint8_t* blocks, uint32_t width, uint32_t height, uint8_t* destination, size_t row_pitch)
+		{
+			const uint32_t blocks_x = (width + 3) / 4;
+			const uint32_t blocks_y = (height + 3) / 4;
+			const size_t block_size = get_block_size(format);
+
+			ThreadPool::global().parallel_for(0, blocks_y, 8, [&](size_t block_row_begin, size_t block_row_end)
+			{
+				uint8_t texels[64];
+				for (size_t by = block_row_begin; by < block_row_end; ++by)
+				{
+					for (uint32_t bx = 0; bx < blocks_x; ++bx)
+					{
+						decode_block(format, blocks + (by * blocks_x + bx) * block_size, texels);
+
+						// Crop partial blocks along the right and bottom edges of the surface.
+						const uint32_t copy_width = std::min(4u, width - bx * 4);
+						const uint32_t copy_height = std::min(4u, height - static_cast<uint32_t>(by) * 4);
+						for (uint32_t y = 0; y < copy_height; ++y)
+						{
+							uint8_t* row = destination + (by * 4 + y) * row_pitch + bx * 16;
+							memcpy(row, texels + y * 16, copy_width * 4);
+						}
+					}
+				}
+			});
+		}
+
+	} // namespace utils
+
+} // namespace plume
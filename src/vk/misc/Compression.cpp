@@ -0,0 +1,326 @@
+/*
+*
+* MIT License
+*
+* Copyright(c) 2017 Michael Walczyk
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files(the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions :
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*
+*/
+
+#include "Compression.h"
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+#if defined(PLUME_WITH_ZSTD)
+	#include <zstd.h>
+#endif
+
+namespace plume
+{
+
+	namespace utils
+	{
+
+		namespace
+		{
+
+			// See: https://github.com/lz4/lz4/blob/dev/doc/lz4_Block_format.md
+			const size_t lz4_min_match = 4;
+			const size_t lz4_last_literals = 5;		// the last 5 bytes are always literals
+			const size_t lz4_match_limit = 12;		// the last match must start at least 12 bytes before the end
+			const size_t lz4_max_offset = 65535;
+			const uint32_t lz4_hash_bits = 16;
+
+			inline uint32_t read_u32(const uint8_t* p) { uint32_t v; memcpy(&v, p, sizeof(v)); return v; }
+
+			inline uint32_t lz4_hash(uint32_t sequence)
+			{
+				return (sequence * 2654435761U) >> (32 - lz4_hash_bits);
+			}
+
+			//! Writes the extra bytes of a literal or match length (the part that doesn't fit in the token).
+			inline uint8_t* lz4_write_length(uint8_t* op, size_t length)
+			{
+				while (length >= 255)
+				{
+					*op++ = 255;
+					length -= 255;
+				}
+				*op++ = static_cast<uint8_t>(length);
+				return op;
+			}
+
+			inline uint8_t* lz4_write_sequence(uint8_t* op, const uint8_t* literals, size_t literal_length, size_t offset, size_t match_length)
+			{
+				uint8_t* token = op++;
+				*token = static_cast<uint8_t>(std::min<size_t>(literal_length, 15) << 4);
+				if (literal_length >= 15)
+				{
+					op = lz4_write_length(op, literal_length - 15);
+				}
+				if (literal_length > 0)
+				{
+					memcpy(op, literals, literal_length);
+					op += literal_length;
+				}
+
+				if (match_length > 0)
+				{
+					*op++ = static_cast<uint8_t>(offset & 0xFF);
+					*op++ = static_cast<uint8_t>(offset >> 8);
+
+					const size_t code = match_length - lz4_min_match;
+					*token |= static_cast<uint8_t>(std::min<size_t>(code, 15));
+					if (code >= 15)
+					{
+						op = lz4_write_length(op, code - 15);
+					}
+				}
+
+				return op;
+			}
+
+			//! A greedy LZ4 block compressor with a single-entry hash table (the same approach as the reference
+			//! implementation's fast mode).
+			std::vector<uint8_t> lz4_compress(const uint8_t* src, size_t size)
+			{
+				std::vector<uint8_t> dst(size + size / 255 + 16);
+				uint8_t* op = dst.data();
+
+				const uint8_t* ip = src;
+				const uint8_t* anchor = src;
+				const uint8_t* const end = src + size;
+
+				if (size >= lz4_match_limit + 1)
+				{
+					std::vector<uint32_t> table(1u << lz4_hash_bits, 0);
+					const uint8_t* const match_limit = end - lz4_match_limit;
+					const uint8_t* const match_end_limit = end - lz4_last_literals;
+
+					ip++;
+					while (ip < match_limit)
+					{
+						const uint32_t sequence = read_u32(ip);
+						const uint32_t h = lz4_hash(sequence);
+						const uint8_t* candidate = src + table[h];
+						table[h] = static_cast<uint32_t>(ip - src);
+
+						if (candidate >= ip || static_cast<size_t>(ip - candidate) > lz4_max_offset || read_u32(candidate) != sequence)
+						{
+							ip++;
+							continue;
+						}
+
+						// Extend the match backwards (into pending literals) and forwards.
+						while (ip > anchor && candidate > src && ip[-1] == candidate[-1])
+						{
+							ip--;
+							candidate--;
+						}
+
+						const uint8_t* match_end = ip + lz4_min_match;
+						const uint8_t* candidate_end = candidate + lz4_min_match;
+						while (match_end < match_end_limit && *match_end == *candidate_end)
+						{
+							match_end++;
+							candidate_end++;
+						}
+
+						op = lz4_write_sequence(op, anchor, ip - anchor, ip - candidate, match_end - ip);
+
+						// Seed the table with a position inside the match, so the next search has a recent candidate.
+						if (match_end - 2 > src)
+						{
+							table[lz4_hash(read_u32(match_end - 2))] = static_cast<uint32_t>(match_end - 2 - src);
+						}
+
+						ip = match_end;
+						anchor = ip;
+					}
+				}
+
+				op = lz4_write_sequence(op, anchor, end - anchor, 0, 0);
+
+				dst.resize(op - dst.data());
+				return dst;
+			}
+
+			void lz4_decompress(const uint8_t* src, size_t src_size, uint8_t* dst, size_t dst_size)
+			{
+				const uint8_t* ip = src;
+				const uint8_t* const ip_end = src + src_size;
+				uint8_t* op = dst;
+				uint8_t* const op_end = dst + dst_size;
+
+				auto read_length = [&](size_t length)
+				{
+					if (length == 15)
+					{
+						uint8_t byte;
+						do
+						{
+							if (ip >= ip_end) throw std::runtime_error("Malformed LZ4 block: truncated length");
+							byte = *ip++;
+							length += byte;
+						} while (byte == 255);
+					}
+					return length;
+				};
+
+				while (ip < ip_end)
+				{
+					const uint8_t token = *ip++;
+
+					const size_t literal_length = read_length(token >> 4);
+					if (literal_length > static_cast<size_t>(ip_end - ip) || literal_length > static_cast<size_t>(op_end - op))
+					{
+						throw std::runtime_error("Malformed LZ4 block: literals out of bounds");
+					}
+					if (literal_length > 0)
+					{
+						memcpy(op, ip, literal_length);
+						ip += literal_length;
+						op += literal_length;
+					}
+
+					// The last sequence has no match.
+					if (ip == ip_end)
+					{
+						break;
+					}
+
+					if (ip_end - ip < 2)
+					{
+						throw std::runtime_error("Malformed LZ4 block: truncated offset");
+					}
+					const size_t offset = ip[0] | (static_cast<size_t>(ip[1]) << 8);
+					ip += 2;
+
+					const size_t match_length = read_length(token & 0x0F) + lz4_min_match;
+					if (offset == 0 || offset > static_cast<size_t>(op - dst) || match_length > static_cast<size_t>(op_end - op))
+					{
+						throw std::runtime_error("Malformed LZ4 block: match out of bounds");
+					}
+
+					// Matches may overlap the bytes that they produce, so copy forwards one byte at a time unless 
+					// the source and destination are far enough apart.
+					const uint8_t* match = op - offset;
+					if (offset >= match_length)
+					{
+						memcpy(op, match, match_length);
+						op += match_length;
+					}
+					else
+					{
+						for (size_t i = 0; i < match_length; ++i) *op++ = *match++;
+					}
+				}
+
+				if (op != op_end)
+				{
+					throw std::runtime_error("Malformed LZ4 block: decompressed size mismatch");
+				}
+			}
+
+		} // anonymous
+
+		bool is_compression_supported(CompressionMethod method)
+		{
+			switch (method)
+			{
+			case CompressionMethod::COMPRESSION_NONE:
+			case CompressionMethod::COMPRESSION_LZ4:
+				return true;
+			case CompressionMethod::COMPRESSION_ZSTD:
+#if defined(PLUME_WITH_ZSTD)
+				return true;
+#else
+				return false;
+#endif
+			default:
+				return false;
+			}
+		}
+
+		std::vector<uint8_t> compress(CompressionMethod method, const uint8_t* src, size_t size, int level)
+		{
+#if !defined(PLUME_WITH_ZSTD)
+			static_cast<void>(level);
+#endif
+			switch (method)
+			{
+			case CompressionMethod::COMPRESSION_NONE:
+				return std::vector<uint8_t>(src, src + size);
+			case CompressionMethod::COMPRESSION_LZ4:
+				return lz4_compress(src, size);
+#if defined(PLUME_WITH_ZSTD)
+			case CompressionMethod::COMPRESSION_ZSTD:
+			{
+				std::vector<uint8_t> dst(ZSTD_compressBound(size));
+				const size_t result = ZSTD_compress(dst.data(), dst.size(), src, size, level == 0 ? ZSTD_CLEVEL_DEFAULT : level);
+				if (ZSTD_isError(result))
+				{
+					throw std::runtime_error(std::string("Zstandard compression failed: ") + ZSTD_getErrorName(result));
+				}
+				dst.resize(result);
+				return dst;
+			}
+#endif
+			default:
+				throw std::runtime_error("Unsupported compression method (Zstandard requires building with PLUME_WITH_ZSTD)");
+			}
+		}
+
+		void decompress(CompressionMethod method, const uint8_t* src, size_t src_size, uint8_t* dst, size_t dst_size)
+		{
+			switch (method)
+			{
+			case CompressionMethod::COMPRESSION_NONE:
+				if (src_size != dst_size)
+				{
+					throw std::runtime_error("Stored data does not match its expected size");
+				}
+				memcpy(dst, src, src_size);
+				break;
+			case CompressionMethod::COMPRESSION_LZ4:
+				lz4_decompress(src, src_size, dst, dst_size);
+				break;
+#if defined(PLUME_WITH_ZSTD)
+			case CompressionMethod::COMPRESSION_ZSTD:
+			{
+				const size_t result = ZSTD_decompress(dst, dst_size, src, src_size);
+				if (ZSTD_isError(result) || result != dst_size)
+				{
+					throw std::runtime_error("Zstandard decompression failed");
+				}
+				break;
+			}
+#endif
+			default:
+				throw std::runtime_error("Unsupported compression method (Zstandard requires building with PLUME_WITH_ZSTD)");
+			}
+		}
+
+	} // namespace utils
+
+} // namespace plume
@@ -0,0 +1,256 @@
+/*
+*
+* MIT License
+*
+* Copyright(c) 2017 Michael Walczyk
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files(the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions :
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*
+*/
+
+#include "FileWatcher.h"
+
+#include <stdexcept>
+
+#if defined(__linux__)
+	#include <cerrno>
+	#include <sys/inotify.h>
+	#include <unistd.h>
+#else
+	#include <sys/stat.h>
+#endif
+
+namespace plume
+{
+
+	namespace fsys
+	{
+
+#if defined(__linux__)
+		namespace
+		{
+
+			//! Editors either rewrite a file in place (which ends with it being closed after writing) or write a
+			//! temporary file and rename it over the original (which moves a new file into the directory).
+			const uint32_t watch_mask = IN_CLOSE_WRITE | IN_MOVED_TO;
+
+		} // anonymous
+#endif
+
+		FileWatcher::FileWatcher()
+		{
+#if defined(__linux__)
+			m_inotify_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+			if (m_inotify_fd < 0)
+			{
+				throw std::runtime_error("Failed to initialize inotify");
+			}
+#endif
+		}
+
+		FileWatcher::~FileWatcher()
+		{
+#if defined(__linux__)
+			// Closing the descriptor removes every watch.
+			close(m_inotify_fd);
+#endif
+		}
+
+		bool FileWatcher::watch(const std::string& path)
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+
+			if (m_paths.count(path))
+			{
+				return true;
+			}
+
+#if defined(__linux__)
+			// Watch the directory rather than the file itself, since a watch on a file is lost as soon as an 
+			// editor renames a new version over it.
+			const std::string directory = split_path(path).first;
+			if (!m_watch_descriptors.count(directory))
+			{
+				const int watch_descriptor = inotify_add_watch(m_inotify_fd, directory.empty() ? "." : directory.c_str(), watch_mask);
+				if (watch_descriptor < 0)
+				{
+					return false;
+				}
+
+				// Two spellings of the same directory share a descriptor, which is only removed once neither is used.
+				m_watched_directories[watch_descriptor].insert(directory);
+				m_watch_descriptors[directory] = watch_descriptor;
+			}
+#else
+			m_modification_times[path] = get_modification_time(path);
+#endif
+
+			m_paths.insert(path);
+			return true;
+		}
+
+		void FileWatcher::unwatch(const std::string& path)
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+
+			if (!m_paths.erase(path))
+			{
+				return;
+			}
+
+#if defined(__linux__)
+			// Forget this spelling of the directory once none of its files are watched anymore, and remove the 
+			// watch once no other spelling shares it.
+			const std::string directory = split_path(path).first;
+			for (const auto& other : m_paths)
+			{
+				if (split_path(other).first == directory)
+				{
+					return;
+				}
+			}
+
+			auto it = m_watch_descriptors.find(directory);
+			if (it != m_watch_descriptors.end())
+			{
+				const int watch_descriptor = it->second;
+				m_watch_descriptors.erase(it);
+
+				auto& spellings = m_watched_directories[watch_descriptor];
+				spellings.erase(directory);
+				if (spellings.empty())
+				{
+					inotify_rm_watch(m_inotify_fd, watch_descriptor);
+					m_watched_directories.erase(watch_descriptor);
+				}
+			}
+#else
+			m_modification_times.erase(path);
+#endif
+		}
+
+		bool FileWatcher::is_watched(const std::string& path) const
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+
+			return m_paths.count(path) > 0;
+		}
+
+		std::vector<std::string> FileWatcher::poll()
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+
+			std::set<std::string> changed;
+
+#if defined(__linux__)
+			alignas(inotify_event) char buffer[4096];
+			while (true)
+			{
+				const ssize_t length = read(m_inotify_fd, buffer, sizeof(buffer));
+				if (length <= 0)
+				{
+					// EAGAIN: there are no more events.
+					break;
+				}
+
+				for (ssize_t offset = 0; offset < length; )
+				{
+					const inotify_event* event = reinterpret_cast<const inotify_event*>(buffer + offset);
+					offset += sizeof(inotify_event) + event->len;
+
+					if (event->mask & IN_Q_OVERFLOW)
+					{
+						// Some events were dropped, so any of the files may have changed.
+						changed.insert(m_paths.begin(), m_paths.end());
+						continue;
+					}
+
+					auto it = m_watched_directories.find(event->wd);
+					if (it == m_watched_directories.end() || event->len == 0)
+					{
+						continue;
+					}
+
+					for (const auto& directory : it->second)
+					{
+						const std::string path = join_path(directory, event->name);
+						if (m_paths.count(path))
+						{
+							changed.insert(path);
+						}
+					}
+				}
+			}
+#else
+			for (auto& entry : m_modification_times)
+			{
+				const int64_t modification_time = get_modification_time(entry.first);
+				if (modification_time != entry.second)
+				{
+					entry.second = modification_time;
+
+					// A file that was deleted is only reported once it exists again.
+					if (modification_time != 0)
+					{
+						changed.insert(entry.first);
+					}
+				}
+			}
+#endif
+
+			return std::vector<std::string>(changed.begin(), changed.end());
+		}
+
+		std::pair<std::string, std::string> FileWatcher::split_path(const std::string& path)
+		{
+#if defined(_WIN32)
+			const size_t separator = path.find_last_of("/\\");
+#else
+			const size_t separator = path.find_last_of('/');
+#endif
+			if (separator == std::string::npos)
+			{
+				return std::make_pair(std::string(), path);
+			}
+
+			// The root directory keeps its separator.
+			return std::make_pair(path.substr(0, separator == 0 ? 1 : separator), path.substr(separator + 1));
+		}
+
+		std::string FileWatcher::join_path(const std::string& directory, const std::string& name)
+		{
+			if (directory.empty())
+			{
+				return name;
+			}
+
+			return (directory.back() == '/') ? directory + name : directory + "/" + name;
+		}
+
+#if !defined(__linux__)
+		int64_t FileWatcher::get_modification_time(const std::string& path)
+		{
+			struct stat file_stat;
+			return (stat(path.c_str(), &file_stat) == 0) ? static_cast<int64_t>(file_stat.st_mtime) : 0;
+		}
+#endif
+
+	} // namespace fsys
+
+} // namespace plume
@@ -26,6 +26,8 @@
 
 #include "Geometry.h"
 
+#include <stdexcept>
+
 namespace plume
 {
 
@@ -40,6 +42,56 @@ namespace plume
 			VertexAttribute::ATTRIBUTE_TEXTURE_COORDINATES
 		};
 
+		VertexFormat& VertexFormat::attribute(uint32_t location, VertexAttribute attribute)
+		{
+			if (static_cast<uint32_t>(attribute) > static_cast<uint32_t>(VertexAttribute::ATTRIBUTE_TEXTURE_COORDINATES))
+			{
+				throw std::runtime_error("Custom vertex attributes are not supported by vertex formats");
+			}
+
+			// The location is fixed here, while the binding is filled in by `get_attribute_descriptions()`.
+			m_attribute_descriptions.push_back({ location, 0, Geometry::get_vertex_attribute_format(attribute), m_stride });
+			m_attributes.push_back(attribute);
+			m_stride += Geometry::get_vertex_attribute_size(attribute);
+
+			return *this;
+		}
+
+		VertexFormat& VertexFormat::unread_location(uint32_t location)
+		{
+			m_unread_locations.push_back(location);
+			return *this;
+		}
+
+		std::vector<vk::VertexInputBindingDescription> VertexFormat::get_binding_descriptions(uint32_t binding) const
+		{
+			if (m_attributes.empty())
+			{
+				return {};
+			}
+
+			return { { binding, m_stride, vk::VertexInputRate::eVertex } };
+		}
+
+		std::vector<vk::VertexInputAttributeDescription> VertexFormat::get_attribute_descriptions(uint32_t binding) const
+		{
+			std::vector<vk::VertexInputAttributeDescription> attribute_descriptions = m_attribute_descriptions;
+			if (!m_attributes.empty())
+			{
+				for (uint32_t location : m_unread_locations)
+				{
+					attribute_descriptions.push_back({ location, 0, vk::Format::eR32Sfloat, 0 });
+				}
+			}
+
+			for (auto& attribute_description : attribute_descriptions)
+			{
+				attribute_description.binding = binding;
+			}
+
+			return attribute_descriptions;
+		}
+
 		vk::Format Geometry::get_vertex_attribute_format(VertexAttribute attribute)
 		{
 			switch (attribute)
@@ -189,6 +241,38 @@ namespace plume
 			return packed_vertex_attributes;
 		}
 
+		std::vector<float> Geometry::get_packed_vertex_attributes(const VertexFormat& format) const
+		{
+			std::vector<float> packed_vertex_attributes;
+			packed_vertex_attributes.reserve(get_vertex_count() * format.get_stride() / sizeof(float));
+
+			for (size_t i = 0; i < m_positions.size(); ++i)
+			{
+				for (auto attribute : format.get_attributes())
+				{
+					switch (attribute)
+					{
+					case VertexAttribute::ATTRIBUTE_POSITION: 
+						packed_vertex_attributes.insert(packed_vertex_attributes.end(), glm::value_ptr(m_positions[i]), glm::value_ptr(m_positions[i]) + 3);
+						break;
+					case VertexAttribute::ATTRIBUTE_COLOR: 
+						packed_vertex_attributes.insert(packed_vertex_attributes.end(), glm::value_ptr(m_colors[i]), glm::value_ptr(m_colors[i]) + 3);
+						break;
+					case VertexAttribute::ATTRIBUTE_NORMAL: 
+						packed_vertex_attributes.insert(packed_vertex_attributes.end(), glm::value_ptr(m_normals[i]), glm::value_ptr(m_normals[i]) + 3);
+						break;
+					case VertexAttribute::ATTRIBUTE_TEXTURE_COORDINATES: 
+						packed_vertex_attributes.insert(packed_vertex_attributes.end(), glm::value_ptr(m_texture_coordinates[i]), glm::value_ptr(m_texture_coordinates[i]) + 2);
+						break;
+					default:
+						break;
+					}
+				}
+			}
+
+			return packed_vertex_attributes;
+		}
+
 		float* Geometry::get_vertex_attribute_data_ptr(VertexAttribute attribute)
 		{
 			switch (attribute)
@@ -0,0 +1,316 @@
+/*
+*
+* MIT License
+*
+* Copyright(c) 2017 Michael Walczyk
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files(the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions :
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*
+*/
+
+#include "HdrPacking.h"
+#include "Simd.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+
+namespace plume
+{
+
+	namespace utils
+	{
+
+		namespace
+		{
+
+			//! Reads texel `i` as RGBA, expanding grayscale and filling in a missing alpha channel with 1.
+			inline void load_rgba(const float* src, uint32_t src_channels, size_t i, float rgba[4])
+			{
+				const float* s = src + i * src_channels;
+				switch (src_channels)
+				{
+				case 1:
+					rgba[0] = rgba[1] = rgba[2] = s[0];
+					rgba[3] = 1.0f;
+					break;
+				case 2:
+					rgba[0] = rgba[1] = rgba[2] = s[0];
+					rgba[3] = s[1];
+					break;
+				case 3:
+					rgba[0] = s[0];
+					rgba[1] = s[1];
+					rgba[2] = s[2];
+					rgba[3] = 1.0f;
+					break;
+				default:
+					memcpy(rgba, s, sizeof(float) * 4);
+					break;
+				}
+			}
+
+			//! Converts 4 floats to halves, using F16C when it is available.
+			inline void floats_to_halves(const float values[4], uint16_t halves[4])
+			{
+#if defined(PLUME_F16C)
+				const __m128i packed = _mm_cvtps_ph(_mm_loadu_ps(values), _MM_FROUND_TO_NEAREST_INT);
+				_mm_storel_epi64(reinterpret_cast<__m128i*>(halves), packed);
+#else
+				for (int c = 0; c < 4; ++c) halves[c] = float_to_half(values[c]);
+#endif
+			}
+
+			//! Rounds a float to an unsigned float with a 5-bit exponent (bias 15) and `mantissa_bits` (6 or 5) 
+			//! mantissa bits, to nearest even. Negative values and NaN become 0, and values that are too large 
+			//! (including infinity) clamp to the largest finite value.
+			inline uint32_t float_to_small_float(float value, uint32_t mantissa_bits)
+			{
+				uint32_t bits;
+				memcpy(&bits, &value, sizeof(bits));
+
+				const uint32_t max_finite = (0x1Eu << mantissa_bits) | ((1u << mantissa_bits) - 1);
+				if ((bits & 0x80000000) || bits > 0x7F800000)
+				{
+					// Negative or NaN.
+					return 0;
+				}
+				if (bits < 0x38800000)
+				{
+					// Subnormal (or zero): scale the magnitude by 2^(14 + mantissa_bits) so that the result is the 
+					// mantissa. Rounding up to the smallest normal value yields its encoding as well.
+					return static_cast<uint32_t>(std::nearbyint(std::ldexp(value, 14 + static_cast<int>(mantissa_bits))));
+				}
+
+				// Rebias the exponent (127 -> 15) and drop the low mantissa bits.
+				const uint32_t shift = 23 - mantissa_bits;
+				const uint32_t rebiased = bits - 0x38000000;
+				const uint32_t rounded = (rebiased + ((1u << (shift - 1)) - 1) + ((rebiased >> shift) & 1)) >> shift;
+				return std::min(rounded, max_finite);
+			}
+
+		} // anonymous
+
+		uint16_t float_to_half(float value)
+		{
+			uint32_t bits;
+			memcpy(&bits, &value, sizeof(bits));
+
+			const uint16_t sign = static_cast<uint16_t>((bits >> 16) & 0x8000);
+			bits &= 0x7FFFFFFF;
+
+			if (bits > 0x7F800000)
+			{
+				// NaN (quiet).
+				return sign | 0x7E00;
+			}
+			if (bits >= 0x477FF000)
+			{
+				// Rounds to (or is) infinity.
+				return sign | 0x7C00;
+			}
+			if (bits < 0x38800000)
+			{
+				// Subnormal (or zero) in half precision: scale the magnitude so that the result is the mantissa.
+				float magnitude;
+				memcpy(&magnitude, &bits, sizeof(magnitude));
+				return sign | static_cast<uint16_t>(std::nearbyint(magnitude * 16777216.0f));
+			}
+
+			// Rebias the exponent (127 -> 15) and round the mantissa (23 -> 10 bits) to nearest even.
+			uint32_t half = (bits - 0x38000000) >> 13;
+			const uint32_t remainder = bits & 0x1FFF;
+			if (remainder > 0x1000 || (remainder == 0x1000 && (half & 1)))
+			{
+				half++;
+			}
+
+			return sign | static_cast<uint16_t>(half);
+		}
+
+		float half_to_float(uint16_t value)
+		{
+			const uint32_t sign = static_cast<uint32_t>(value & 0x8000) << 16;
+			const uint32_t exponent = (value >> 10) & 0x1F;
+			const uint32_t mantissa = value & 0x3FF;
+
+			float result;
+			if (exponent == 0)
+			{
+				// Zero or subnormal: mantissa * 2^-24.
+				result = static_cast<float>(mantissa) / 16777216.0f;
+				return sign ? -result : result;
+			}
+
+			uint32_t bits;
+			if (exponent == 0x1F)
+			{
+				bits = sign | 0x7F800000 | (mantissa << 13);
+			}
+			else
+			{
+				bits = sign | ((exponent + 112) << 23) | (mantissa << 13);
+			}
+			memcpy(&result, &bits, sizeof(result));
+
+			return result;
+		}
+
+		uint32_t pack_b10g11r11(float r, float g, float b)
+		{
+			// Rounded straight from the floats, since going through half precision would round twice.
+			return float_to_small_float(r, 6) | 
+				  (float_to_small_float(g, 6) << 11) | 
+				  (float_to_small_float(b, 5) << 22);
+		}
+
+		void unpack_b10g11r11(uint32_t packed, float rgb[3])
+		{
+			rgb[0] = half_to_float(static_cast<uint16_t>((packed & 0x7FF) << 4));
+			rgb[1] = half_to_float(static_cast<uint16_t>(((packed >> 11) & 0x7FF) << 4));
+			rgb[2] = half_to_float(static_cast<uint16_t>(((packed >> 22) & 0x3FF) << 5));
+		}
+
+		uint32_t pack_e5b9g9r9(float r, float g, float b)
+		{
+			// See: "Shared Exponent Format" in the Vulkan specification.
+			const int mantissa_bits = 9;
+			const int exponent_bias = 15;
+			const float max_value = 65408.0f;	// (2^9 - 1) / 2^9 * 2^(31 - 15)
+
+			// Written so that NaNs also clamp to 0.
+			const float rc = (r > 0.0f) ? std::min(r, max_value) : 0.0f;
+			const float gc = (g > 0.0f) ? std::min(g, max_value) : 0.0f;
+			const float bc = (b > 0.0f) ? std::min(b, max_value) : 0.0f;
+			const float max_component = std::max(rc, std::max(gc, bc));
+
+			int exponent = 0;
+			if (max_component > 0.0f)
+			{
+				// frexp() yields a mantissa in [0.5, 1), so floor(log2(x)) = exponent - 1.
+				std::frexp(max_component, &exponent);
+				exponent = std::max(-exponent_bias - 1, exponent - 1);
+			}
+			else
+			{
+				exponent = -exponent_bias - 1;
+			}
+			int shared_exponent = exponent + 1 + exponent_bias;
+
+			float scale = std::ldexp(1.0f, shared_exponent - exponent_bias - mantissa_bits);
+			if (static_cast<int>(std::floor(max_component / scale + 0.5f)) == (1 << mantissa_bits))
+			{
+				shared_exponent++;
+				scale *= 2.0f;
+			}
+
+			const uint32_t rm = static_cast<uint32_t>(std::floor(rc / scale + 0.5f));
+			const uint32_t gm = static_cast<uint32_t>(std::floor(gc / scale + 0.5f));
+			const uint32_t bm = static_cast<uint32_t>(std::floor(bc / scale + 0.5f));
+
+			return rm | (gm << 9) | (bm << 18) | (static_cast<uint32_t>(shared_exponent) << 27);
+		}
+
+		void unpack_e5b9g9r9(uint32_t packed, float rgb[3])
+		{
+			const float scale = std::ldexp(1.0f, static_cast<int>(packed >> 27) - 15 - 9);
+			rgb[0] = static_cast<float>(packed & 0x1FF) * scale;
+			rgb[1] = static_cast<float>((packed >> 9) & 0x1FF) * scale;
+			rgb[2] = static_cast<float>((packed >> 18) & 0x1FF) * scale;
+		}
+
+		bool is_packed_hdr_format(vk::Format format)
+		{
+			return format == vk::Format::eR32G32B32A32Sfloat ||
+				   format == vk::Format::eR16G16B16A16Sfloat ||
+				   format == vk::Format::eB10G11R11UfloatPack32 ||
+				   format == vk::Format::eE5B9G9R9UfloatPack32;
+		}
+
+		size_t get_packed_hdr_texel_size(vk::Format format)
+		{
+			switch (format)
+			{
+			case vk::Format::eR32G32B32A32Sfloat:		return 16;
+			case vk::Format::eR16G16B16A16Sfloat:		return 8;
+			case vk::Format::eB10G11R11UfloatPack32:
+			case vk::Format::eE5B9G9R9UfloatPack32:		return 4;
+			default:
+				throw std::runtime_error("Unsupported HDR storage format: " + vk::to_string(format));
+			}
+		}
+
+		void pack_hdr_texels(vk::Format format, const float* src, uint32_t src_channels, size_t count, void* dst)
+		{
+			if (src_channels < 1 || src_channels > 4)
+			{
+				throw std::runtime_error("HDR texels must have between 1 and 4 channels");
+			}
+
+			uint8_t* out = reinterpret_cast<uint8_t*>(dst);
+			float rgba[4];
+
+			switch (format)
+			{
+			case vk::Format::eR32G32B32A32Sfloat:
+				if (src_channels == 4)
+				{
+					memcpy(out, src, count * sizeof(float) * 4);
+					break;
+				}
+				for (size_t i = 0; i < count; ++i)
+				{
+					load_rgba(src, src_channels, i, rgba);
+					memcpy(out + i * 16, rgba, sizeof(rgba));
+				}
+				break;
+			case vk::Format::eR16G16B16A16Sfloat:
+				for (size_t i = 0; i < count; ++i)
+				{
+					load_rgba(src, src_channels, i, rgba);
+					uint16_t halves[4];
+					floats_to_halves(rgba, halves);
+					memcpy(out + i * 8, halves, sizeof(halves));
+				}
+				break;
+			case vk::Format::eB10G11R11UfloatPack32:
+				for (size_t i = 0; i < count; ++i)
+				{
+					load_rgba(src, src_channels, i, rgba);
+					const uint32_t packed = pack_b10g11r11(rgba[0], rgba[1], rgba[2]);
+					memcpy(out + i * 4, &packed, sizeof(packed));
+				}
+				break;
+			case vk::Format::eE5B9G9R9UfloatPack32:
+				for (size_t i = 0; i < count; ++i)
+				{
+					load_rgba(src, src_channels, i, rgba);
+					const uint32_t packed = pack_e5b9g9r9(rgba[0], rgba[1], rgba[2]);
+					memcpy(out + i * 4, &packed, sizeof(packed));
+				}
+				break;
+			default:
+				throw std::runtime_error("Unsupported HDR storage format: " + vk::to_string(format));
+			}
+		}
+
+	} // namespace utils
+
+} // namespace plume
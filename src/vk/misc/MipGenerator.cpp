@@ -0,0 +1,483 @@
+/*
+*
+* MIT License
+*
+* Copyright(c) 2017 Michael Walczyk
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files(the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions :
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*
+*/
+
+#include "MipGenerator.h"
+#include "Simd.h"
+#include "ThreadPool.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <memory>
+
+namespace plume
+{
+
+	namespace fsys
+	{
+
+		namespace
+		{
+
+			const float pi = 3.14159265358979f;
+
+			//! A mipmap level that is being filtered: 4 linear floats per texel, regardless of the number of
+			//! channels in the source image (unused channels are 0).
+			struct LinearLevel
+			{
+				uint32_t width;
+				uint32_t height;
+				std::vector<float> texels;
+			};
+
+			//! The source texels (and their weights) that contribute to each destination texel along one axis.
+			//! Every destination texel has `taps` entries: unused entries have a weight of 0.
+			struct FilterKernel
+			{
+				uint32_t taps;
+				std::vector<uint32_t> indices;
+				std::vector<float> weights;
+			};
+
+			inline float sinc(float x)
+			{
+				if (std::fabs(x) < 1e-5f) return 1.0f;
+				return std::sin(pi * x) / (pi * x);
+			}
+
+			//! The zeroth-order modified Bessel function of the first kind, which defines the Kaiser window.
+			float bessel_i0(float x)
+			{
+				float sum = 1.0f;
+				float term = 1.0f;
+				for (int k = 1; k < 32; ++k)
+				{
+					term *= (x / (2.0f * k)) * (x / (2.0f * k));
+					sum += term;
+					if (term < sum * 1e-8f) break;
+				}
+				return sum;
+			}
+
+			//! Returns the radius of the filter, in destination texels.
+			float get_filter_radius(MipFilter filter)
+			{
+				return (filter == MipFilter::FILTER_BOX) ? 0.5f : 3.0f;
+			}
+
+			//! Evaluates the filter at `x`, measured in destination texels from the filter's center.
+			float evaluate_filter(MipFilter filter, float x)
+			{
+				const float radius = get_filter_radius(filter);
+				if (std::fabs(x) > radius) return 0.0f;
+
+				switch (filter)
+				{
+				case MipFilter::FILTER_KAISER:
+				{
+					const float alpha = 4.0f;
+					const float t = x / radius;
+					return sinc(x) * bessel_i0(alpha * std::sqrt(std::max(1.0f - t * t, 0.0f))) / bessel_i0(alpha);
+				}
+				case MipFilter::FILTER_LANCZOS:
+					return sinc(x) * sinc(x / radius);
+				case MipFilter::FILTER_BOX:
+				default:
+					return 1.0f;
+				}
+			}
+
+			//! Builds the (normalized) kernel that resamples `src_size` texels to `dst_size` texels. Taps that
+			//! fall outside of the source are clamped to the edge.
+			FilterKernel build_kernel(MipFilter filter, uint32_t src_size, uint32_t dst_size)
+			{
+				const float scale = static_cast<float>(src_size) / static_cast<float>(dst_size);
+				const float radius = get_filter_radius(filter) * scale;
+
+				FilterKernel kernel;
+				kernel.taps = static_cast<uint32_t>(std::ceil(radius * 2.0f)) + 1;
+				kernel.indices.assign(dst_size * kernel.taps, 0);
+				kernel.weights.assign(dst_size * kernel.taps, 0.0f);
+
+				for (uint32_t i = 0; i < dst_size; ++i)
+				{
+					const float center = (i + 0.5f) * scale;
+					const int32_t first = static_cast<int32_t>(std::ceil(center - radius - 0.5f));
+
+					float total = 0.0f;
+					for (uint32_t t = 0; t < kernel.taps; ++t)
+					{
+						const int32_t j = first + static_cast<int32_t>(t);
+						const float weight = evaluate_filter(filter, (j + 0.5f - center) / scale);
+
+						kernel.indices[i * kernel.taps + t] = static_cast<uint32_t>(std::min(std::max(j, 0), static_cast<int32_t>(src_size) - 1));
+						kernel.weights[i * kernel.taps + t] = weight;
+						total += weight;
+					}
+
+					for (uint32_t t = 0; t < kernel.taps; ++t)
+					{
+						kernel.weights[i * kernel.taps + t] /= total;
+					}
+				}
+
+				return kernel;
+			}
+
+			//! `destination[0..count * 4) += source[0..count * 4) * weight`
+			inline void accumulate(float* destination, const float* source, float weight, size_t count)
+			{
+#if defined(PLUME_SSE2)
+				const __m128 w = _mm_set1_ps(weight);
+				for (size_t i = 0; i < count; ++i)
+				{
+					const __m128 d = _mm_loadu_ps(destination + i * 4);
+					_mm_storeu_ps(destination + i * 4, _mm_add_ps(d, _mm_mul_ps(_mm_loadu_ps(source + i * 4), w)));
+				}
+#else
+				for (size_t i = 0; i < count * 4; ++i)
+				{
+					destination[i] += source[i] * weight;
+				}
+#endif
+			}
+
+			//! Clamps every channel of `count` texels to [0..`maximum`]. Negative lobes of the sharper filters
+			//! would otherwise produce values outside of the representable range.
+			inline void clamp_texels(float* texels, size_t count, float maximum)
+			{
+#if defined(PLUME_SSE2)
+				const __m128 lo = _mm_setzero_ps();
+				const __m128 hi = _mm_set1_ps(maximum);
+				for (size_t i = 0; i < count; ++i)
+				{
+					_mm_storeu_ps(texels + i * 4, _mm_min_ps(_mm_max_ps(_mm_loadu_ps(texels + i * 4), lo), hi));
+				}
+#else
+				for (size_t i = 0; i < count * 4; ++i)
+				{
+					texels[i] = std::min(std::max(texels[i], 0.0f), maximum);
+				}
+#endif
+			}
+
+			//! Downsamples `src` to half its size (rounding down, to a minimum of 1), filtering rows and then 
+			//! columns. Both passes run in parallel across rows.
+			std::shared_ptr<LinearLevel> downsample(const LinearLevel& src, MipFilter filter, float maximum)
+			{
+				auto dst = std::make_shared<LinearLevel>();
+				dst->width = std::max(src.width / 2, 1u);
+				dst->height = std::max(src.height / 2, 1u);
+				dst->texels.assign(static_cast<size_t>(dst->width) * dst->height * 4, 0.0f);
+
+				const FilterKernel horizontal = build_kernel(filter, src.width, dst->width);
+				const FilterKernel vertical = build_kernel(filter, src.height, dst->height);
+
+				// Horizontal pass: `src.height` rows of `dst->width` texels.
+				std::vector<float> intermediate(static_cast<size_t>(src.height) * dst->width * 4, 0.0f);
+				utils::ThreadPool::global().parallel_for(0, src.height, 16, [&](size_t begin, size_t end)
+				{
+					for (size_t y = begin; y < end; ++y)
+					{
+						const float* src_row = src.texels.data() + y * src.width * 4;
+						float* dst_row = intermediate.data() + y * dst->width * 4;
+						for (uint32_t x = 0; x < dst->width; ++x)
+						{
+							for (uint32_t t = 0; t < horizontal.taps; ++t)
+							{
+								const size_t k = x * horizontal.taps + t;
+								accumulate(dst_row + x * 4, src_row + horizontal.indices[k] * 4, horizontal.weights[k], 1);
+							}
+						}
+					}
+				});
+
+				// Vertical pass: each destination row is a weighted sum of whole intermediate rows.
+				utils::ThreadPool::global().parallel_for(0, dst->height, 8, [&](size_t begin, size_t end)
+				{
+					for (size_t y = begin; y < end; ++y)
+					{
+						float* dst_row = dst->texels.data() + y * dst->width * 4;
+						for (uint32_t t = 0; t < vertical.taps; ++t)
+						{
+							const size_t k = y * vertical.taps + t;
+							if (vertical.weights[k] != 0.0f)
+							{
+								accumulate(dst_row, intermediate.data() + vertical.indices[k] * dst->width * 4, vertical.weights[k], dst->width);
+							}
+						}
+						clamp_texels(dst_row, dst->width, maximum);
+					}
+				});
+
+				return dst;
+			}
+
+			//! Returns the index of the alpha channel in an image with the specified number of channels, or -1.
+			inline int get_alpha_channel(uint32_t channels)
+			{
+				return (channels == 2 || channels == 4) ? static_cast<int>(channels) - 1 : -1;
+			}
+
+			//! Returns the fraction of texels whose (scaled) alpha exceeds `alpha_reference`.
+			float compute_alpha_coverage(const LinearLevel& level, int alpha_channel, float alpha_scale, float alpha_reference)
+			{
+				const size_t count = static_cast<size_t>(level.width) * level.height;
+				size_t covered = 0;
+				for (size_t i = 0; i < count; ++i)
+				{
+					if (level.texels[i * 4 + alpha_channel] * alpha_scale > alpha_reference) covered++;
+				}
+				return static_cast<float>(covered) / static_cast<float>(count);
+			}
+
+			//! Finds the alpha scale for which the coverage of `level` is closest to `target_coverage`.
+			float find_alpha_scale(const LinearLevel& level, int alpha_channel, float alpha_reference, float target_coverage)
+			{
+				float lo = 0.0f;
+				float hi = 64.0f;
+				float best_scale = 1.0f;
+				float best_difference = std::fabs(compute_alpha_coverage(level, alpha_channel, 1.0f, alpha_reference) - target_coverage);
+
+				for (int iteration = 0; iteration < 16; ++iteration)
+				{
+					const float scale = (lo + hi) * 0.5f;
+					const float coverage = compute_alpha_coverage(level, alpha_channel, scale, alpha_reference);
+					const float difference = std::fabs(coverage - target_coverage);
+					if (difference < best_difference)
+					{
+						best_difference = difference;
+						best_scale = scale;
+					}
+
+					if (coverage < target_coverage) lo = scale;
+					else if (coverage > target_coverage) hi = scale;
+					else break;
+				}
+
+				return best_scale;
+			}
+
+			const std::vector<float>& get_srgb_to_linear_table()
+			{
+				static const std::vector<float> table = []()
+				{
+					std::vector<float> values(256);
+					for (int i = 0; i < 256; ++i)
+					{
+						const float s = i / 255.0f;
+						values[i] = (s <= 0.04045f) ? s / 12.92f : std::pow((s + 0.055f) / 1.055f, 2.4f);
+					}
+					return values;
+				}();
+				return table;
+			}
+
+			//! Maps linear values (quantized to 16 bits) to 8-bit sRGB values. The table is fine enough that 
+			//! results match exact conversion, even in the steep segment near black.
+			const std::vector<uint8_t>& get_linear_to_srgb_table()
+			{
+				static const std::vector<uint8_t> table = []()
+				{
+					std::vector<uint8_t> values(65536);
+					for (int i = 0; i < 65536; ++i)
+					{
+						const float l = i / 65535.0f;
+						const float s = (l <= 0.0031308f) ? l * 12.92f : 1.055f * std::pow(l, 1.0f / 2.4f) - 0.055f;
+						values[i] = static_cast<uint8_t>(std::min(std::max(s * 255.0f + 0.5f, 0.0f), 255.0f));
+					}
+					return values;
+				}();
+				return table;
+			}
+
+			std::shared_ptr<LinearLevel> to_linear(const ImageResource& image, bool srgb)
+			{
+				auto level = std::make_shared<LinearLevel>();
+				level->width = image.width;
+				level->height = image.height;
+				level->texels.assign(static_cast<size_t>(image.width) * image.height * 4, 0.0f);
+
+				const std::vector<float>& srgb_to_linear = get_srgb_to_linear_table();
+				const int alpha_channel = get_alpha_channel(image.channels);
+
+				utils::ThreadPool::global().parallel_for(0, image.height, 32, [&](size_t begin, size_t end)
+				{
+					for (size_t i = begin * image.width; i < end * image.width; ++i)
+					{
+						for (uint32_t c = 0; c < image.channels; ++c)
+						{
+							const uint8_t value = image.contents[i * image.channels + c];
+							const bool is_color = static_cast<int>(c) != alpha_channel;
+							level->texels[i * 4 + c] = (srgb && is_color) ? srgb_to_linear[value] : value / 255.0f;
+						}
+					}
+				});
+
+				return level;
+			}
+
+			std::shared_ptr<LinearLevel> to_linear(const ImageResourceHDR& image, bool)
+			{
+				auto level = std::make_shared<LinearLevel>();
+				level->width = image.width;
+				level->height = image.height;
+				level->texels.assign(static_cast<size_t>(image.width) * image.height * 4, 0.0f);
+
+				const size_t count = static_cast<size_t>(image.width) * image.height;
+				for (size_t i = 0; i < count; ++i)
+				{
+					for (uint32_t c = 0; c < image.channels; ++c)
+					{
+						// Negative radiance is meaningless, and would be amplified by the filters' negative lobes.
+						level->texels[i * 4 + c] = std::max(image.contents[i * image.channels + c], 0.0f);
+					}
+				}
+
+				return level;
+			}
+
+			void from_linear(const LinearLevel& level, bool srgb, float alpha_scale, ImageResource& image)
+			{
+				image.width = level.width;
+				image.height = level.height;
+				image.contents.resize(static_cast<size_t>(level.width) * level.height * image.channels);
+
+				const std::vector<uint8_t>& linear_to_srgb = get_linear_to_srgb_table();
+				const int alpha_channel = get_alpha_channel(image.channels);
+
+				const size_t count = static_cast<size_t>(level.width) * level.height;
+				for (size_t i = 0; i < count; ++i)
+				{
+					for (uint32_t c = 0; c < image.channels; ++c)
+					{
+						float value = level.texels[i * 4 + c];
+						if (static_cast<int>(c) == alpha_channel)
+						{
+							value = std::min(value * alpha_scale, 1.0f);
+						}
+						else if (srgb)
+						{
+							image.contents[i * image.channels + c] = linear_to_srgb[static_cast<size_t>(value * 65535.0f + 0.5f)];
+							continue;
+						}
+						image.contents[i * image.channels + c] = static_cast<uint8_t>(value * 255.0f + 0.5f);
+					}
+				}
+			}
+
+			void from_linear(const LinearLevel& level, bool, float alpha_scale, ImageResourceHDR& image)
+			{
+				image.width = level.width;
+				image.height = level.height;
+				image.contents.resize(static_cast<size_t>(level.width) * level.height * image.channels);
+
+				const int alpha_channel = get_alpha_channel(image.channels);
+
+				const size_t count = static_cast<size_t>(level.width) * level.height;
+				for (size_t i = 0; i < count; ++i)
+				{
+					for (uint32_t c = 0; c < image.channels; ++c)
+					{
+						const float value = level.texels[i * 4 + c];
+						image.contents[i * image.channels + c] = (static_cast<int>(c) == alpha_channel) ? std::min(value * alpha_scale, 1.0f) : value;
+					}
+				}
+			}
+
+			template<class ImageType>
+			std::vector<ImageType> generate_chain(const ImageType& image, bool srgb, MipFilter filter, bool preserve_alpha_coverage, float alpha_reference, uint32_t max_levels, float maximum)
+			{
+				if (image.channels < 1 || image.channels > 4)
+				{
+					throw std::runtime_error("Images passed to `MipGenerator::generate()` must have between 1 and 4 channels");
+				}
+				if (image.width == 0 || image.height == 0)
+				{
+					throw std::runtime_error("Images passed to `MipGenerator::generate()` must not be empty");
+				}
+
+				uint32_t level_count = MipGenerator::get_level_count(image.width, image.height);
+				if (max_levels > 0) level_count = std::min(level_count, max_levels);
+
+				std::vector<ImageType> levels(level_count);
+				levels[0] = image;
+				for (auto& level : levels) level.channels = image.channels;
+
+				const int alpha_channel = get_alpha_channel(image.channels);
+				preserve_alpha_coverage &= alpha_channel >= 0;
+
+				std::vector<std::shared_ptr<LinearLevel>> linear_levels(level_count);
+				linear_levels[0] = to_linear(image, srgb);
+				const float base_coverage = preserve_alpha_coverage ? compute_alpha_coverage(*linear_levels[0], alpha_channel, 1.0f, alpha_reference) : 0.0f;
+
+				// Filtering is sequential (each level is built from the previous one), but converting the levels back to 
+				// the storage format is not. `parallel_for()` has the calling thread work through the levels as well, so
+				// this cannot deadlock when it is called from inside of a pool task (i.e. an asynchronous texture load).
+				for (uint32_t i = 1; i < level_count; ++i)
+				{
+					linear_levels[i] = downsample(*linear_levels[i - 1], filter, maximum);
+				}
+
+				utils::ThreadPool::global().parallel_for(1, level_count, 1, [&](size_t begin, size_t end)
+				{
+					for (size_t i = begin; i < end; ++i)
+					{
+						const float alpha_scale = preserve_alpha_coverage ? find_alpha_scale(*linear_levels[i], alpha_channel, alpha_reference, base_coverage) : 1.0f;
+						from_linear(*linear_levels[i], srgb, alpha_scale, levels[i]);
+					}
+				});
+
+				return levels;
+			}
+
+		} // anonymous
+
+		std::vector<ImageResource> MipGenerator::generate(const ImageResource& image, const Options& options)
+		{
+			return generate_chain(image, options.m_srgb, options.m_filter, options.m_preserve_alpha_coverage, options.m_alpha_reference, options.m_max_levels, 1.0f);
+		}
+
+		std::vector<ImageResourceHDR> MipGenerator::generate(const ImageResourceHDR& image, const Options& options)
+		{
+			return generate_chain(image, false, options.m_filter, options.m_preserve_alpha_coverage, options.m_alpha_reference, options.m_max_levels, std::numeric_limits<float>::max());
+		}
+
+		uint32_t MipGenerator::get_level_count(uint32_t width, uint32_t height)
+		{
+			uint32_t levels = 1;
+			while (width > 1 || height > 1)
+			{
+				width = std::max(width / 2, 1u);
+				height = std::max(height / 2, 1u);
+				levels++;
+			}
+			return levels;
+		}
+
+	} // namespace fsys
+
+} // namespace plume
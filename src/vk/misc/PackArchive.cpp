@@ -0,0 +1,599 @@
+/*
+*
+* MIT License
+*
+* Copyright(c) 2017 Michael Walczyk
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files(the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions :
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*
+*/
+
+#include "PackArchive.h"
+#include "Hash.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <mutex>
+#include <stdexcept>
+#include <unordered_set>
+
+namespace plume
+{
+
+	namespace fsys
+	{
+
+		namespace
+		{
+
+			const char pack_magic[4] = { 'P', 'L', 'P', 'K' };
+			const uint32_t pack_version = 1;
+
+			//! Set in a chunk table entry if the chunk is stored uncompressed (because it didn't compress).
+			const uint32_t raw_chunk_bit = 0x80000000u;
+
+			//! An entry is only stored compressed if that saves at least ~5% of its size.
+			const double max_compression_ratio = 0.95;
+
+			//! The header at the start of every pack archive, exactly as it is stored on disk.
+			struct Header
+			{
+				char magic[4];
+				uint32_t version;
+				uint32_t entry_count;
+				uint32_t chunk_size;
+				uint64_t index_offset;
+				uint64_t names_offset;
+				uint64_t names_size;
+				uint64_t total_size;
+				uint8_t reserved[16];
+			};
+
+			static_assert(sizeof(Header) == 64, "The pack archive header must be 64 bytes");
+
+			inline size_t align_up(size_t value, size_t alignment)
+			{
+				return (value + alignment - 1) & ~(alignment - 1);
+			}
+
+			inline size_t get_chunk_count(uint64_t size, uint32_t chunk_size)
+			{
+				return static_cast<size_t>((size + chunk_size - 1) / chunk_size);
+			}
+
+			void write_padding(std::ofstream& stream, size_t count)
+			{
+				static const char zeros[64] = {};
+				while (count > 0)
+				{
+					const size_t n = std::min(count, sizeof(zeros));
+					stream.write(zeros, n);
+					count -= n;
+				}
+			}
+
+		} // anonymous
+
+		PackArchive::PackArchive(const std::string& path) :
+
+			m_mapping(std::make_shared<const MappedFileResource>(path, MappedFileResource::AccessPattern::ACCESS_RANDOM)),
+			m_names(nullptr),
+			m_names_size(0),
+			m_chunk_size(0)
+		{
+			const size_t archive_size = m_mapping->size();
+
+			Header header;
+			if (archive_size < sizeof(Header))
+			{
+				throw std::runtime_error("File is too small to be a pack archive: " + path);
+			}
+			memcpy(&header, m_mapping->data(), sizeof(Header));
+
+			if (memcmp(header.magic, pack_magic, sizeof(pack_magic)) != 0 || header.version != pack_version)
+			{
+				throw std::runtime_error("File is not a supported pack archive: " + path);
+			}
+
+			const uint64_t index_size = static_cast<uint64_t>(header.entry_count) * sizeof(Entry);
+			if (header.total_size != archive_size ||
+				header.chunk_size == 0 ||
+				header.index_offset > archive_size || index_size > archive_size - header.index_offset ||
+				header.names_offset > archive_size || header.names_size > archive_size - header.names_offset)
+			{
+				throw std::runtime_error("Pack archive is truncated or corrupt: " + path);
+			}
+
+			m_names = reinterpret_cast<const char*>(m_mapping->data() + header.names_offset);
+			m_names_size = static_cast<size_t>(header.names_size);
+			m_chunk_size = header.chunk_size;
+
+			m_entries.resize(header.entry_count);
+			if (header.entry_count > 0)
+			{
+				memcpy(m_entries.data(), m_mapping->data() + header.index_offset, static_cast<size_t>(index_size));
+			}
+
+			// Validate the index up-front, so that lookups never have to worry about reading out of bounds.
+			for (size_t i = 0; i < m_entries.size(); ++i)
+			{
+				const Entry& entry = m_entries[i];
+
+				const bool is_compressed = entry.compression != static_cast<uint32_t>(utils::CompressionMethod::COMPRESSION_NONE);
+				const bool is_valid = entry.offset <= archive_size &&
+									  entry.stored_size <= archive_size - entry.offset &&
+									  static_cast<uint64_t>(entry.name_offset) + entry.name_length <= m_names_size &&
+									  entry.compression <= static_cast<uint32_t>(utils::CompressionMethod::COMPRESSION_ZSTD) &&
+									  (is_compressed ? entry.chunk_count == get_chunk_count(entry.size, m_chunk_size) : entry.stored_size == entry.size) &&
+									  (i == 0 || m_entries[i - 1].path_hash <= entry.path_hash);
+				if (!is_valid)
+				{
+					throw std::runtime_error("Pack archive has a corrupt index: " + path);
+				}
+			}
+		}
+
+		bool PackArchive::contains(const std::string& name) const
+		{
+			return find(normalize_path(name)) != nullptr;
+		}
+
+		MappedFileResource PackArchive::map_entry(const std::string& name, MappedFileResource::AccessPattern access_pattern) const
+		{
+			const std::string normalized = normalize_path(name);
+			const Entry& entry = find_or_throw(normalized);
+			const std::string entry_path = get_path() + ":" + normalized;
+
+			if (entry.compression == static_cast<uint32_t>(utils::CompressionMethod::COMPRESSION_NONE))
+			{
+				const uint8_t* data = entry.size > 0 ? m_mapping->data() + entry.offset : nullptr;
+
+				MappedFileResource resource = MappedFileResource::from_memory(entry_path, data, static_cast<size_t>(entry.size), m_mapping, true);
+				resource.advise(access_pattern);
+
+				return resource;
+			}
+
+			auto contents = std::make_shared<std::vector<uint8_t>>(static_cast<size_t>(entry.size));
+			decompress_entry(entry, contents->data());
+
+			return MappedFileResource::from_memory(entry_path, contents->data(), contents->size(), contents, false);
+		}
+
+		FileResource PackArchive::read_entry(const std::string& name) const
+		{
+			const Entry& entry = find_or_throw(normalize_path(name));
+
+			FileResource resource = { std::vector<uint8_t>(static_cast<size_t>(entry.size)) };
+			decompress_entry(entry, resource.contents.data());
+
+			return resource;
+		}
+
+		void PackArchive::prefetch_entry(const std::string& name) const
+		{
+			// Note that a length of zero would apply the hint to the rest of the archive.
+			const Entry* entry = find(normalize_path(name));
+			if (entry && entry->stored_size > 0)
+			{
+				m_mapping->advise(MappedFileResource::AccessPattern::ACCESS_WILL_NEED, static_cast<size_t>(entry->offset), static_cast<size_t>(entry->stored_size));
+			}
+		}
+
+		size_t PackArchive::get_entry_size(const std::string& name) const
+		{
+			return static_cast<size_t>(find_or_throw(normalize_path(name)).size);
+		}
+
+		std::vector<std::string> PackArchive::get_entry_names() const
+		{
+			std::vector<std::string> names;
+			names.reserve(m_entries.size());
+
+			for (const auto& entry : m_entries)
+			{
+				names.push_back(get_name(entry));
+			}
+
+			return names;
+		}
+
+		std::vector<std::string> PackArchive::verify() const
+		{
+			std::mutex mutex;
+			std::vector<std::string> mismatches;
+
+			utils::ThreadPool::global().parallel_for(0, m_entries.size(), 1, [&](size_t begin, size_t end)
+			{
+				std::vector<uint8_t> contents;
+				for (size_t i = begin; i < end; ++i)
+				{
+					const Entry& entry = m_entries[i];
+
+					bool is_intact = true;
+					try
+					{
+						contents.resize(static_cast<size_t>(entry.size));
+						decompress_entry(entry, contents.data());
+						is_intact = utils::hash_bytes(contents.data(), contents.size()) == entry.content_hash;
+					}
+					catch (const std::exception&)
+					{
+						is_intact = false;
+					}
+
+					if (!is_intact)
+					{
+						std::lock_guard<std::mutex> lock(mutex);
+						mismatches.push_back(get_name(entry));
+					}
+				}
+			});
+
+			std::sort(mismatches.begin(), mismatches.end());
+
+			return mismatches;
+		}
+
+		std::string PackArchive::normalize_path(const std::string& path)
+		{
+			std::string normalized;
+			normalized.reserve(path.size());
+
+			size_t component_begin = 0;
+			while (component_begin <= path.size())
+			{
+				size_t component_end = path.find_first_of("/\\", component_begin);
+				if (component_end == std::string::npos)
+				{
+					component_end = path.size();
+				}
+
+				// Skip empty components (leading or repeated separators) and references to the current directory, 
+				// and let references to the parent directory cancel out the preceding component (if there is one).
+				const size_t length = component_end - component_begin;
+				const bool is_parent = length == 2 && path.compare(component_begin, 2, "..") == 0;
+				const size_t last_separator = normalized.find_last_of('/');
+				const size_t last_begin = last_separator == std::string::npos ? 0 : last_separator + 1;
+				const bool can_pop = !normalized.empty() && normalized.compare(last_begin, std::string::npos, "..") != 0;
+
+				if (is_parent && can_pop)
+				{
+					normalized.erase(last_separator == std::string::npos ? 0 : last_separator);
+				}
+				else if (length > 0 && !(length == 1 && path[component_begin] == '.'))
+				{
+					if (!normalized.empty())
+					{
+						normalized += '/';
+					}
+					normalized.append(path, component_begin, length);
+				}
+
+				component_begin = component_end + 1;
+			}
+
+			return normalized;
+		}
+
+		uint64_t PackArchive::hash_path(const std::string& name)
+		{
+			return utils::hash_string(name);
+		}
+
+		PackArchive::BuildStatistics PackArchive::build(const std::string& output_path, const std::vector<Source>& sources, utils::CompressionMethod method, int level, size_t alignment)
+		{
+			if (!utils::is_compression_supported(method))
+			{
+				throw std::runtime_error("The requested compression method is not supported by this build");
+			}
+			if (alignment < 16 || (alignment & (alignment - 1)) != 0)
+			{
+				throw std::runtime_error("Pack archive alignment must be a power of two and at least 16 bytes");
+			}
+
+			// Everything that is known about an entry before it is written.
+			struct PreparedEntry
+			{
+				std::string name;
+				uint64_t size = 0;
+				uint64_t content_hash = 0;
+				uint32_t chunk_count = 0;
+				std::vector<uint8_t> payload;	// The chunk table and chunks, or empty if the entry is stored uncompressed.
+			};
+
+			std::vector<PreparedEntry> prepared(sources.size());
+			std::unordered_set<std::string> names;
+			for (size_t i = 0; i < sources.size(); ++i)
+			{
+				prepared[i].name = normalize_path(sources[i].name);
+				if (prepared[i].name.empty() || !names.insert(prepared[i].name).second)
+				{
+					throw std::runtime_error("Pack archive entry names must be unique and non-empty: " + sources[i].name);
+				}
+			}
+
+			const uint32_t chunk_size = default_chunk_size;
+
+			// Hash and compress every entry (and every chunk of every entry) in parallel.
+			utils::ThreadPool::global().parallel_for(0, sources.size(), 1, [&](size_t begin, size_t end)
+			{
+				for (size_t i = begin; i < end; ++i)
+				{
+					PreparedEntry& entry = prepared[i];
+
+					MappedFileResource mapped{ sources[i].path };
+					entry.size = mapped.size();
+					entry.content_hash = utils::hash_bytes(mapped.data(), mapped.size());
+
+					if (method == utils::CompressionMethod::COMPRESSION_NONE || mapped.empty())
+					{
+						continue;
+					}
+
+					const size_t chunk_count = get_chunk_count(entry.size, chunk_size);
+					std::vector<std::vector<uint8_t>> chunks(chunk_count);
+					utils::ThreadPool::global().parallel_for(0, chunk_count, 1, [&](size_t chunk_begin, size_t chunk_end)
+					{
+						for (size_t c = chunk_begin; c < chunk_end; ++c)
+						{
+							const size_t offset = c * chunk_size;
+							chunks[c] = utils::compress(method, mapped.data() + offset, std::min<size_t>(chunk_size, mapped.size() - offset), level);
+						}
+					});
+
+					// Lay out the chunk table, followed by the chunks themselves.
+					std::vector<uint32_t> table(chunk_count);
+					size_t payload_size = chunk_count * sizeof(uint32_t);
+					for (size_t c = 0; c < chunk_count; ++c)
+					{
+						const size_t raw_size = std::min<size_t>(chunk_size, mapped.size() - c * chunk_size);
+						const bool is_raw = chunks[c].size() >= raw_size;
+						table[c] = is_raw ? (static_cast<uint32_t>(raw_size) | raw_chunk_bit) : static_cast<uint32_t>(chunks[c].size());
+						payload_size += is_raw ? raw_size : chunks[c].size();
+					}
+
+					if (payload_size > max_compression_ratio * static_cast<double>(mapped.size()))
+					{
+						continue;
+					}
+
+					entry.chunk_count = static_cast<uint32_t>(chunk_count);
+					entry.payload.resize(payload_size);
+					memcpy(entry.payload.data(), table.data(), chunk_count * sizeof(uint32_t));
+
+					uint8_t* dst = entry.payload.data() + chunk_count * sizeof(uint32_t);
+					for (size_t c = 0; c < chunk_count; ++c)
+					{
+						if (table[c] & raw_chunk_bit)
+						{
+							const size_t raw_size = table[c] & ~raw_chunk_bit;
+							memcpy(dst, mapped.data() + c * chunk_size, raw_size);
+							dst += raw_size;
+						}
+						else
+						{
+							memcpy(dst, chunks[c].data(), chunks[c].size());
+							dst += chunks[c].size();
+						}
+					}
+				}
+			});
+
+			std::ofstream stream(output_path, std::ios::binary | std::ios::trunc);
+			if (!stream.is_open())
+			{
+				throw std::runtime_error("Failed to open pack archive for writing: " + output_path);
+			}
+
+			// Entries are written in the order that they were given, so callers control the on-disk locality of
+			// assets that are loaded together. Only the index is sorted.
+			BuildStatistics statistics;
+			std::vector<Entry> index(prepared.size());
+			std::string name_table;
+			size_t position = sizeof(Header);
+			write_padding(stream, sizeof(Header));
+
+			for (size_t i = 0; i < prepared.size(); ++i)
+			{
+				const PreparedEntry& source = prepared[i];
+				const bool is_compressed = !source.payload.empty();
+
+				const size_t offset = align_up(position, alignment);
+				write_padding(stream, offset - position);
+
+				Entry& entry = index[i];
+				memset(&entry, 0, sizeof(Entry));
+				entry.path_hash = hash_path(source.name);
+				entry.offset = offset;
+				entry.size = source.size;
+				entry.content_hash = source.content_hash;
+				entry.name_offset = static_cast<uint32_t>(name_table.size());
+				entry.name_length = static_cast<uint32_t>(source.name.size());
+				entry.compression = static_cast<uint32_t>(is_compressed ? method : utils::CompressionMethod::COMPRESSION_NONE);
+				entry.chunk_count = source.chunk_count;
+
+				if (is_compressed)
+				{
+					stream.write(reinterpret_cast<const char*>(source.payload.data()), source.payload.size());
+					entry.stored_size = source.payload.size();
+					++statistics.compressed_entry_count;
+				}
+				else
+				{
+					// Uncompressed entries are not held in memory: map the file again and copy it straight out.
+					MappedFileResource mapped{ sources[i].path };
+					if (mapped.size() != source.size)
+					{
+						throw std::runtime_error("File changed while the pack archive was being built: " + sources[i].path);
+					}
+					stream.write(reinterpret_cast<const char*>(mapped.data()), mapped.size());
+					entry.stored_size = source.size;
+				}
+
+				name_table += source.name;
+				position = offset + static_cast<size_t>(entry.stored_size);
+
+				statistics.raw_bytes += entry.size;
+				statistics.stored_bytes += entry.stored_size;
+			}
+
+			Header header;
+			memset(&header, 0, sizeof(Header));
+			memcpy(header.magic, pack_magic, sizeof(pack_magic));
+			header.version = pack_version;
+			header.entry_count = static_cast<uint32_t>(index.size());
+			header.chunk_size = chunk_size;
+
+			header.names_offset = position;
+			header.names_size = name_table.size();
+			stream.write(name_table.data(), name_table.size());
+			position += name_table.size();
+
+			std::sort(index.begin(), index.end(), [&](const Entry& a, const Entry& b)
+			{
+				return a.path_hash < b.path_hash;
+			});
+
+			header.index_offset = align_up(position, alignof(Entry));
+			write_padding(stream, static_cast<size_t>(header.index_offset) - position);
+			stream.write(reinterpret_cast<const char*>(index.data()), index.size() * sizeof(Entry));
+			header.total_size = header.index_offset + index.size() * sizeof(Entry);
+
+			stream.seekp(0);
+			stream.write(reinterpret_cast<const char*>(&header), sizeof(Header));
+			stream.close();
+
+			if (!stream)
+			{
+				throw std::runtime_error("Failed to write pack archive: " + output_path);
+			}
+
+			statistics.entry_count = index.size();
+			statistics.archive_bytes = header.total_size;
+
+			return statistics;
+		}
+
+		const PackArchive::Entry* PackArchive::find(const std::string& name) const
+		{
+			const uint64_t path_hash = hash_path(name);
+			auto it = std::lower_bound(m_entries.begin(), m_entries.end(), path_hash, [](const Entry& entry, uint64_t hash)
+			{
+				return entry.path_hash < hash;
+			});
+
+			// Compare the names as well, in case two paths share a hash.
+			for (; it != m_entries.end() && it->path_hash == path_hash; ++it)
+			{
+				if (it->name_length == name.size() && memcmp(m_names + it->name_offset, name.data(), name.size()) == 0)
+				{
+					return &(*it);
+				}
+			}
+
+			return nullptr;
+		}
+
+		const PackArchive::Entry& PackArchive::find_or_throw(const std::string& name) const
+		{
+			const Entry* entry = find(name);
+			if (!entry)
+			{
+				throw std::runtime_error("Pack archive " + get_path() + " does not contain: " + name);
+			}
+
+			return *entry;
+		}
+
+		std::string PackArchive::get_name(const Entry& entry) const
+		{
+			return std::string(m_names + entry.name_offset, entry.name_length);
+		}
+
+		void PackArchive::decompress_entry(const Entry& entry, uint8_t* dst) const
+		{
+			const uint8_t* src = m_mapping->data() + entry.offset;
+			const auto method = static_cast<utils::CompressionMethod>(entry.compression);
+
+			if (method == utils::CompressionMethod::COMPRESSION_NONE)
+			{
+				if (entry.size > 0)
+				{
+					memcpy(dst, src, static_cast<size_t>(entry.size));
+				}
+				return;
+			}
+
+			const std::string corrupt_message = "Pack archive " + get_path() + " has a corrupt entry: " + get_name(entry);
+
+			// Locate every chunk up-front from the chunk table.
+			const size_t chunk_count = entry.chunk_count;
+			const size_t table_size = chunk_count * sizeof(uint32_t);
+			if (table_size > entry.stored_size)
+			{
+				throw std::runtime_error(corrupt_message);
+			}
+
+			std::vector<uint32_t> table(chunk_count);
+			memcpy(table.data(), src, table_size);
+
+			std::vector<uint64_t> chunk_offsets(chunk_count + 1);
+			chunk_offsets[0] = table_size;
+			for (size_t c = 0; c < chunk_count; ++c)
+			{
+				chunk_offsets[c + 1] = chunk_offsets[c] + (table[c] & ~raw_chunk_bit);
+			}
+			if (chunk_offsets[chunk_count] != entry.stored_size)
+			{
+				throw std::runtime_error(corrupt_message);
+			}
+
+			// Start reading the whole entry in now, rather than faulting its pages in one at a time from each chunk.
+			m_mapping->advise(MappedFileResource::AccessPattern::ACCESS_WILL_NEED, static_cast<size_t>(entry.offset), static_cast<size_t>(entry.stored_size));
+
+			utils::ThreadPool::global().parallel_for(0, chunk_count, 1, [&](size_t begin, size_t end)
+			{
+				for (size_t c = begin; c < end; ++c)
+				{
+					const size_t dst_offset = c * m_chunk_size;
+					const size_t dst_size = std::min<size_t>(m_chunk_size, static_cast<size_t>(entry.size) - dst_offset);
+					const uint8_t* chunk = src + chunk_offsets[c];
+					const size_t chunk_size = static_cast<size_t>(chunk_offsets[c + 1] - chunk_offsets[c]);
+
+					if (table[c] & raw_chunk_bit)
+					{
+						if (chunk_size != dst_size)
+						{
+							throw std::runtime_error(corrupt_message);
+						}
+						memcpy(dst + dst_offset, chunk, chunk_size);
+					}
+					else
+					{
+						utils::decompress(method, chunk, chunk_size, dst + dst_offset, dst_size);
+					}
+				}
+			});
+		}
+
+	} // namespace fsys
+
+} // namespace plume
@@ -0,0 +1,267 @@
+/*
+*
+* MIT License
+*
+* Copyright(c) 2017 Michael Walczyk
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files(the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions :
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*
+*/
+
+#include "ResourceCache.h"
+
+namespace plume
+{
+
+	namespace fsys
+	{
+
+		ResourceCache::ResourceCache(size_t budget_bytes)
+		{
+			m_statistics.budget_bytes = budget_bytes;
+		}
+
+		template<class T, class DecodeFunc, class SizeFunc>
+		CacheHandle<T> ResourceCache::load(const std::string& file_name, const std::string& options, DecodeFunc decode, SizeFunc size_of)
+		{
+			const std::string key = build_key(file_name, options);
+
+			// Fast path: this exact request has been seen before.
+			{
+				std::lock_guard<std::mutex> lock(m_mutex);
+
+				auto it = m_keys_to_content.find(key);
+				if (it != m_keys_to_content.end())
+				{
+					auto& entry = m_entries.at(it->second);
+					touch(entry);
+
+					m_statistics.hits++;
+					m_statistics.bytes_served += entry.size;
+
+					return std::static_pointer_cast<const T>(entry.resource);
+				}
+			}
+
+			// Slow path: map and hash the file without holding the lock. The load options are folded into the
+			// content hash, since the same file decoded with different options is a different resource.
+			MappedFileResource mapped = ResourceManager::map_file(file_name);
+			const uint64_t content_hash = utils::hash_combine(utils::hash_bytes(mapped.data(), mapped.size()), utils::hash_string(options));
+
+			// Registers `key` as an alias of an existing entry, returning the shared resource.
+			auto share_existing = [&](Entry& entry)
+			{
+				if (std::find(entry.keys.begin(), entry.keys.end(), key) == entry.keys.end())
+				{
+					entry.keys.push_back(key);
+				}
+				m_keys_to_content[key] = content_hash;
+				touch(entry);
+
+				m_statistics.deduplications++;
+				m_statistics.bytes_served += entry.size;
+
+				return std::static_pointer_cast<const T>(entry.resource);
+			};
+
+			{
+				std::lock_guard<std::mutex> lock(m_mutex);
+				m_statistics.misses++;
+
+				auto it = m_entries.find(content_hash);
+				if (it != m_entries.end())
+				{
+					return share_existing(it->second);
+				}
+			}
+
+			std::shared_ptr<const T> resource = std::make_shared<T>(decode(mapped));
+			const size_t resource_size = size_of(*resource);
+
+			std::lock_guard<std::mutex> lock(m_mutex);
+
+			// Another thread may have decoded the same contents while the lock was released.
+			auto it = m_entries.find(content_hash);
+			if (it != m_entries.end())
+			{
+				return share_existing(it->second);
+			}
+
+			m_lru.push_front(content_hash);
+
+			Entry entry;
+			entry.resource = resource;
+			entry.size = resource_size;
+			entry.keys = { key };
+			entry.lru_position = m_lru.begin();
+
+			m_entries.emplace(content_hash, std::move(entry));
+			m_keys_to_content[key] = content_hash;
+
+			m_statistics.bytes_loaded += resource_size;
+			m_statistics.resident_bytes += resource_size;
+			m_statistics.resident_entries = m_entries.size();
+			m_statistics.peak_resident_bytes = std::max(m_statistics.peak_resident_bytes, m_statistics.resident_bytes);
+
+			// The resource that was just loaded is referenced by `resource`, so it is never a candidate here.
+			trim_unlocked(m_statistics.budget_bytes);
+
+			return resource;
+		}
+
+		CacheHandle<FileResource> ResourceCache::load_binary_file(const std::string& file_name)
+		{
+			return load<FileResource>(file_name, "",
+				[](const MappedFileResource& mapped) { return FileResource{ std::vector<uint8_t>(mapped.begin(), mapped.end()) }; },
+				[](const FileResource& resource) { return resource.contents.size(); });
+		}
+
+		CacheHandle<ImageResource> ResourceCache::load_image(const std::string& file_name, bool force_alpha)
+		{
+			return load<ImageResource>(file_name, force_alpha ? "ldr:rgba" : "ldr:rgb",
+				[=](const MappedFileResource& mapped) { return ResourceManager::load_image(mapped, force_alpha); },
+				[](const ImageResource& resource) { return resource.contents.size(); });
+		}
+
+		CacheHandle<ImageResourceHDR> ResourceCache::load_image_hdr(const std::string& file_name, bool force_alpha)
+		{
+			return load<ImageResourceHDR>(file_name, force_alpha ? "hdr:rgba" : "hdr:rgb",
+				[=](const MappedFileResource& mapped) { return ResourceManager::load_image_hdr(mapped, force_alpha); },
+				[](const ImageResourceHDR& resource) { return resource.contents.size() * sizeof(float); });
+		}
+
+		void ResourceCache::invalidate(const std::string& file_name)
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+
+			const std::string prefix = build_key(file_name, "");
+
+			auto it = m_keys_to_content.begin();
+			while (it != m_keys_to_content.end())
+			{
+				if (it->first.compare(0, prefix.size(), prefix) != 0)
+				{
+					++it;
+					continue;
+				}
+
+				auto& entry = m_entries.at(it->second);
+				entry.keys.erase(std::remove(entry.keys.begin(), entry.keys.end(), it->first), entry.keys.end());
+
+				// Drop the entry once no request key refers to it anymore. Outstanding handles keep the resource
+				// itself alive, but it no longer counts against the cache's budget.
+				if (entry.keys.empty())
+				{
+					m_statistics.resident_bytes -= entry.size;
+					m_lru.erase(entry.lru_position);
+					m_entries.erase(it->second);
+					m_statistics.resident_entries = m_entries.size();
+				}
+
+				it = m_keys_to_content.erase(it);
+			}
+		}
+
+		void ResourceCache::set_budget(size_t budget_bytes)
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+
+			m_statistics.budget_bytes = budget_bytes;
+			trim_unlocked(budget_bytes);
+		}
+
+		size_t ResourceCache::get_budget() const
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			return m_statistics.budget_bytes;
+		}
+
+		size_t ResourceCache::trim(size_t target_bytes)
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			return trim_unlocked(target_bytes);
+		}
+
+		CacheStatistics ResourceCache::get_statistics() const
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			return m_statistics;
+		}
+
+		void ResourceCache::reset_statistics()
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+
+			CacheStatistics fresh;
+			fresh.resident_bytes = m_statistics.resident_bytes;
+			fresh.peak_resident_bytes = m_statistics.resident_bytes;
+			fresh.budget_bytes = m_statistics.budget_bytes;
+			fresh.resident_entries = m_statistics.resident_entries;
+
+			m_statistics = fresh;
+		}
+
+		void ResourceCache::touch(Entry& entry)
+		{
+			// Move the entry to the front of the list without reallocating its node.
+			m_lru.splice(m_lru.begin(), m_lru, entry.lru_position);
+			entry.lru_position = m_lru.begin();
+		}
+
+		size_t ResourceCache::trim_unlocked(size_t target_bytes)
+		{
+			size_t released_bytes = 0;
+
+			// Walk from the least recently used entry towards the most recently used one.
+			auto it = m_lru.end();
+			while (it != m_lru.begin() && m_statistics.resident_bytes > target_bytes)
+			{
+				--it;
+
+				auto entry_it = m_entries.find(*it);
+				Entry& entry = entry_it->second;
+
+				// The cache's own reference is the only one: nobody else is using this resource.
+				if (entry.resource.use_count() > 1)
+				{
+					continue;
+				}
+
+				for (const auto& key : entry.keys)
+				{
+					m_keys_to_content.erase(key);
+				}
+
+				released_bytes += entry.size;
+				m_statistics.resident_bytes -= entry.size;
+				m_statistics.bytes_evicted += entry.size;
+				m_statistics.evictions++;
+
+				it = m_lru.erase(it);
+				m_entries.erase(entry_it);
+			}
+
+			m_statistics.resident_entries = m_entries.size();
+
+			return released_bytes;
+		}
+
+	} // namespace fsys
+
+} // namespace plume
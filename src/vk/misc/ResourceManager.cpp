@@ -25,6 +25,27 @@
 */
 
 #include "ResourceManager.h"
+#include "ResourceCache.h"
+#include "VirtualFileSystem.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <thread>
+
+#if defined(_WIN32)
+	#ifndef NOMINMAX
+		#define NOMINMAX
+	#endif
+	#include <windows.h>
+#else
+	#include <fcntl.h>
+	#include <sys/mman.h>
+	#include <sys/stat.h>
+	#include <unistd.h>
+#endif
 
 #define STB_IMAGE_IMPLEMENTATION
 #include "stb_image.h"
@@ -37,39 +58,358 @@ namespace plume
 
 		std::string ResourceManager::default_path = "../assets/";
 
-		// Compiles a shader to a SPIR-V binary. Returns the binary as
-		// a vector of 32-bit words.
-		const char kShaderSource[] =
-		"#version 310 es\n"
-		"void mdsasain() { int x = MY_DEFINE; }\n";
-  	
-		// auto spirv = compile_file("shader_src", shaderc_glsl_vertex_shader, kShaderSource);
-        	// std::cout << "Compiled to a binary module with " << spirv.size() << " words." << std::endl;
-//shaderc_glslc_infer_from_source
-		std::vector<uint32_t> compile_file(const std::string& source_name,
-					           const std::string& source,
-					           bool optimize = false) 
+		namespace
+		{
+
+			//! Writes `height` rows of `width` texels with `src_channels` channels each into `dst`, expanding
+			//! every texel to `dst_channels` channels. Missing color channels replicate the first channel (so 
+			//! grayscale images remain gray), and a missing alpha channel is filled with `opaque`.
+			template<class T>
+			void write_rows(const T* src, uint32_t src_channels, uint8_t* dst, size_t dst_row_pitch, uint32_t dst_channels, uint32_t width, size_t row_begin, size_t row_end, T opaque)
+			{
+				const size_t src_row_size = static_cast<size_t>(width) * src_channels;
+				const size_t dst_row_size = static_cast<size_t>(width) * dst_channels * sizeof(T);
+
+				for (size_t row = row_begin; row < row_end; ++row)
+				{
+					const T* src_row = src + row * src_row_size;
+					T* dst_row = reinterpret_cast<T*>(dst + row * dst_row_pitch);
+
+					if (src_channels == dst_channels)
+					{
+						memcpy(dst_row, src_row, dst_row_size);
+						continue;
+					}
+
+					for (uint32_t x = 0; x < width; ++x)
+					{
+						const T* s = src_row + x * src_channels;
+						T* d = dst_row + x * dst_channels;
+
+						switch (src_channels)
+						{
+						case 1:
+							d[0] = d[1] = d[2] = s[0];
+							break;
+						case 2:
+							d[0] = d[1] = d[2] = s[0];
+							break;
+						default:
+							d[0] = s[0];
+							d[1] = s[1];
+							d[2] = s[2];
+							break;
+						}
+
+						if (dst_channels == 4)
+						{
+							d[3] = (src_channels == 2) ? s[1] : (src_channels == 4) ? s[3] : opaque;
+						}
+					}
+				}
+			}
+
+			//! Checks that `destination` can hold `height` rows of `dst_row_size` bytes, then splits the rows into 
+			//! strips and calls `write_strip(row_begin, row_end)` for each strip across the worker pool.
+			void for_each_destination_strip(uint32_t height, size_t dst_row_size, const PixelDestination& destination, const std::function<void(size_t, size_t)>& write_strip)
+			{
+				if (destination.row_pitch < dst_row_size ||
+					destination.size < destination.row_pitch * (height - 1) + dst_row_size)
+				{
+					throw std::runtime_error("The pixel destination is too small to hold the decoded image");
+				}
+
+				// Aim for strips of roughly 256 KB, so that small images are written by the calling thread alone.
+				const size_t target_strip_bytes = 256 * 1024;
+				const size_t rows_per_strip = std::max<size_t>(1, target_strip_bytes / dst_row_size);
+
+				utils::ThreadPool::global().parallel_for(0, height, rows_per_strip, write_strip);
+			}
+
+			//! Splits the rows of an image into strips and writes them into `destination` across the worker pool.
+			template<class T>
+			void write_to_destination(const T* src, uint32_t src_channels, const ImageInfo& info, const PixelDestination& destination, uint32_t dst_channels, T opaque)
+			{
+				uint8_t* dst = reinterpret_cast<uint8_t*>(destination.data);
+				for_each_destination_strip(info.height, static_cast<size_t>(info.width) * dst_channels * sizeof(T), destination, [&](size_t row_begin, size_t row_end)
+				{
+					write_rows(src, src_channels, dst, destination.row_pitch, dst_channels, info.width, row_begin, row_end, opaque);
+				});
+			}
+
+			//! Same as `write_to_destination()`, but each texel is converted to a packed HDR format.
+			void pack_to_destination(const float* src, uint32_t src_channels, uint32_t width, uint32_t height, const PixelDestination& destination, vk::Format format)
+			{
+				const size_t dst_row_size = static_cast<size_t>(width) * utils::get_packed_hdr_texel_size(format);
+
+				uint8_t* dst = reinterpret_cast<uint8_t*>(destination.data);
+				for_each_destination_strip(height, dst_row_size, destination, [&](size_t row_begin, size_t row_end)
+				{
+					for (size_t row = row_begin; row < row_end; ++row)
+					{
+						utils::pack_hdr_texels(format, src + row * width * src_channels, src_channels, width, dst + row * destination.row_pitch);
+					}
+				});
+			}
+
+			//! The mount point that `ResourceManager::default_path` is served from. The default path is a public 
+			//! static, so it is read on every call rather than captured when the mount point is created.
+			class DefaultPathMount : public MountPoint
+			{
+			public:
+
+				bool exists(const std::string& file_name) const override { return get_directory().exists(file_name); }
+
+				MappedFileResource map(const std::string& file_name, MappedFileResource::AccessPattern access_pattern) const override { return get_directory().map(file_name, access_pattern); }
+
+				FileResource read(const std::string& file_name) const override { return get_directory().read(file_name); }
+
+				void prefetch(const std::string& file_name) const override { get_directory().prefetch(file_name); }
+
+				std::string describe() const override { return "default path " + ResourceManager::default_path; }
+
+				std::string get_disk_path(const std::string& file_name) const override { return get_directory().get_full_path(file_name); }
+
+			private:
+
+				DirectoryMount get_directory() const { return DirectoryMount{ ResourceManager::default_path }; }
+			};
+
+		} // anonymous
+
+		MappedFileResource::MappedFileResource(const std::string& path, AccessPattern access_pattern) :
+
+			m_path(path)
+		{
+#if defined(_WIN32)
+			HANDLE file_handle = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+			if (file_handle == INVALID_HANDLE_VALUE)
+			{
+				throw std::runtime_error("Failed to open file for mapping: " + path);
+			}
+			m_file_handle = file_handle;
+
+			LARGE_INTEGER file_size;
+			if (!GetFileSizeEx(file_handle, &file_size))
+			{
+				release();
+				throw std::runtime_error("Failed to query the size of file: " + path);
+			}
+			m_size = static_cast<size_t>(file_size.QuadPart);
+
+			// Mapping a zero-length file is an error on Windows, so leave empty files unmapped.
+			if (m_size == 0)
+			{
+				return;
+			}
+
+			m_mapping_handle = CreateFileMappingA(file_handle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+			if (!m_mapping_handle)
+			{
+				release();
+				throw std::runtime_error("Failed to create a file mapping for: " + path);
+			}
+
+			m_data = static_cast<const uint8_t*>(MapViewOfFile(m_mapping_handle, FILE_MAP_READ, 0, 0, 0));
+			if (!m_data)
+			{
+				release();
+				throw std::runtime_error("Failed to map file: " + path);
+			}
+#else
+			int fd = open(path.c_str(), O_RDONLY);
+			if (fd < 0)
+			{
+				throw std::runtime_error("Failed to open file for mapping: " + path);
+			}
+
+			struct stat file_stat;
+			if (fstat(fd, &file_stat) != 0)
+			{
+				close(fd);
+				throw std::runtime_error("Failed to query the size of file: " + path);
+			}
+			m_size = static_cast<size_t>(file_stat.st_size);
+
+			// `mmap()` rejects zero-length mappings, so leave empty files unmapped.
+			if (m_size == 0)
+			{
+				close(fd);
+				return;
+			}
+
+			void* mapped_ptr = mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, fd, 0);
+
+			// The mapping holds its own reference to the file, so the descriptor can be closed right away.
+			close(fd);
+
+			if (mapped_ptr == MAP_FAILED)
+			{
+				m_size = 0;
+				throw std::runtime_error("Failed to map file: " + path);
+			}
+			m_data = static_cast<const uint8_t*>(mapped_ptr);
+#endif
+			advise(access_pattern);
+		}
+
+		MappedFileResource MappedFileResource::from_memory(const std::string& path, const uint8_t* data, size_t size, std::shared_ptr<const void> owner, bool is_file_backed)
+		{
+			MappedFileResource resource;
+			resource.m_path = path;
+			resource.m_data = data;
+			resource.m_size = size;
+			resource.m_owner = std::move(owner);
+			resource.m_is_file_backed = is_file_backed;
+
+			return resource;
+		}
+
+		MappedFileResource::~MappedFileResource()
+		{
+			release();
+		}
+
+		MappedFileResource::MappedFileResource(MappedFileResource&& other) noexcept
 		{
-		  	shaderc::Compiler compiler;
-		  	shaderc::CompileOptions options;
+			*this = std::move(other);
+		}
 
-			if (optimize) 
+		MappedFileResource& MappedFileResource::operator=(MappedFileResource&& other) noexcept
+		{
+			if (this != &other)
 			{
-			    	options.SetOptimizationLevel(shaderc_optimization_level_size);
+				release();
+
+				m_path = std::move(other.m_path);
+				m_data = other.m_data;
+				m_size = other.m_size;
+				m_owner = std::move(other.m_owner);
+				m_is_file_backed = other.m_is_file_backed;
+				other.m_data = nullptr;
+				other.m_size = 0;
+#if defined(_WIN32)
+				m_file_handle = other.m_file_handle;
+				m_mapping_handle = other.m_mapping_handle;
+				other.m_file_handle = nullptr;
+				other.m_mapping_handle = nullptr;
+#endif
 			}
-			shaderc::SpvCompilationResult module =  compiler.CompileGlslToSpv(source, shaderc_glsl_vertex_shader, source_name.c_str(), options);
 
-			if (module.GetCompilationStatus() != shaderc_compilation_status_success) 
+			return *this;
+		}
+
+		void MappedFileResource::advise(AccessPattern access_pattern, size_t offset, size_t length) const
+		{
+			// Hints on heap memory are meaningless (and `MADV_DONTNEED` would discard its contents).
+			if (!m_data || offset >= m_size || !m_is_file_backed)
+			{
+				return;
+			}
+
+			if (length == 0 || offset + length > m_size)
 			{
-				std::cerr << module.GetErrorMessage();
-			    	return std::vector<uint32_t>();
+				length = m_size - offset;
 			}
 
-			return { module.cbegin(), module.cend() };
+#if defined(_WIN32)
+			// Windows only exposes a prefetch hint (and only on Windows 8+), which is what `ACCESS_WILL_NEED` maps to.
+			if (access_pattern == AccessPattern::ACCESS_WILL_NEED)
+			{
+				WIN32_MEMORY_RANGE_ENTRY range_entry;
+				range_entry.VirtualAddress = const_cast<uint8_t*>(m_data + offset);
+				range_entry.NumberOfBytes = length;
+				PrefetchVirtualMemory(GetCurrentProcess(), 1, &range_entry, 0);
+			}
+#else
+			int advice = MADV_NORMAL;
+			switch (access_pattern)
+			{
+			case AccessPattern::ACCESS_SEQUENTIAL:
+				advice = MADV_SEQUENTIAL;
+				break;
+			case AccessPattern::ACCESS_RANDOM:
+				advice = MADV_RANDOM;
+				break;
+			case AccessPattern::ACCESS_WILL_NEED:
+				advice = MADV_WILLNEED;
+				break;
+			case AccessPattern::ACCESS_DONT_NEED:
+				advice = MADV_DONTNEED;
+				break;
+			case AccessPattern::ACCESS_NORMAL:
+			default:
+				break;
+			}
+
+			// `madvise()` requires a page-aligned address, so round the start of the range down. Views into a pack 
+			// archive's mapping are not necessarily page-aligned themselves.
+			static const size_t page_size = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+			const uintptr_t start = reinterpret_cast<uintptr_t>(m_data + offset);
+			const uintptr_t aligned_start = start - (start % page_size);
+
+			// The hint is purely advisory: failures are not fatal.
+			madvise(reinterpret_cast<void*>(aligned_start), length + (start - aligned_start), advice);
+#endif
+		}
+
+		void MappedFileResource::release()
+		{
+			if (m_owner)
+			{
+				// This is a view: the memory belongs to the owner.
+				m_owner.reset();
+				m_data = nullptr;
+				m_size = 0;
+				return;
+			}
+
+#if defined(_WIN32)
+			if (m_data)
+			{
+				UnmapViewOfFile(m_data);
+			}
+			if (m_mapping_handle)
+			{
+				CloseHandle(m_mapping_handle);
+			}
+			if (m_file_handle)
+			{
+				CloseHandle(m_file_handle);
+			}
+			m_mapping_handle = nullptr;
+			m_file_handle = nullptr;
+#else
+			if (m_data)
+			{
+				munmap(const_cast<uint8_t*>(m_data), m_size);
+			}
+#endif
+			m_data = nullptr;
+			m_size = 0;
+		}
+
+		VirtualFileSystem& ResourceManager::get_file_system()
+		{
+			static VirtualFileSystem file_system;
+			static const VirtualFileSystem::MountId default_mount = file_system.mount(std::make_shared<const DefaultPathMount>(), std::numeric_limits<int>::min());
+			static_cast<void>(default_mount);
+
+			return file_system;
+		}
+
+		void ResourceManager::prefetch(const std::vector<std::string>& file_names)
+		{
+			get_file_system().prefetch(file_names);
 		}
 
 		FileResource ResourceManager::load_binary_file(const std::string& file_name)
 		{
+			if (auto mount_point = get_file_system().resolve(file_name))
+			{
+				return mount_point->read(PackArchive::normalize_path(file_name));
+			}
+
 			std::string path_to = default_path + file_name;
 
 			// Start reading at the end of the file to determine file size.
@@ -93,24 +433,97 @@ namespace plume
 			return resource;
 		}
 
+		MappedFileResource ResourceManager::map_file(const std::string& file_name, MappedFileResource::AccessPattern access_pattern)
+		{
+			if (auto mount_point = get_file_system().resolve(file_name))
+			{
+				return mount_point->map(PackArchive::normalize_path(file_name), access_pattern);
+			}
+
+			return MappedFileResource{ default_path + file_name, access_pattern };
+		}
+
+		void ResourceManager::create_directories(const std::string& path)
+		{
+			for (size_t separator = path.find_first_of("/\\", 1); ; separator = path.find_first_of("/\\", separator + 1))
+			{
+				const std::string directory = path.substr(0, separator);
+#if defined(_WIN32)
+				CreateDirectoryA(directory.c_str(), nullptr);
+#else
+				mkdir(directory.c_str(), 0755);
+#endif
+				if (separator == std::string::npos)
+				{
+					break;
+				}
+			}
+		}
+
+		bool ResourceManager::write_file_atomic(const std::string& path, const void* data, size_t size)
+		{
+			// The temporary file is unique to this process and thread, since several processes (i.e. the shader builder 
+			// running in parallel during a build) may write the same entry at once.
+#if defined(_WIN32)
+			const unsigned long process_id = GetCurrentProcessId();
+#else
+			const unsigned long process_id = static_cast<unsigned long>(getpid());
+#endif
+			const std::string temporary_path = path + "." + std::to_string(process_id) + "." +
+											   std::to_string(std::hash<std::thread::id>()(std::this_thread::get_id())) + ".tmp";
+
+			std::ofstream stream(temporary_path, std::ios::binary | std::ios::trunc);
+			stream.write(reinterpret_cast<const char*>(data), size);
+			stream.close();
+
+			if (!stream)
+			{
+				std::remove(temporary_path.c_str());
+				return false;
+			}
+
+#if defined(_WIN32)
+			// `rename()` does not replace existing files on Windows.
+			std::remove(path.c_str());
+#endif
+			if (std::rename(temporary_path.c_str(), path.c_str()) != 0)
+			{
+				std::remove(temporary_path.c_str());
+				return false;
+			}
+
+			return true;
+		}
+
 		ImageResource ResourceManager::load_image(const std::string& file_name, bool force_alpha)
 		{
-			std::string path_to = default_path + file_name;
+			return load_image(map_file(file_name), force_alpha);
+		}
 
+		ImageResource ResourceManager::load_image(const MappedFileResource& mapped, bool force_alpha)
+		{
 			ImageResource resource;
 
-			// Read the image contents.
-			stbi_uc* pixels = stbi_load(path_to.c_str(), 
-									    (int*)(&resource.width), 
-									    (int*)(&resource.height), 
-									    (int*)(&resource.channels), 
-									    force_alpha ? STBI_rgb_alpha : STBI_rgb);
+			// Decode directly from the mapped pages: stb never sees an intermediate copy of the file. Note that
+			// the channel count reported by stb is the number of channels in the file, whereas the number of 
+			// channels in the decoded output is the number that was requested.
+			int width, height, channels_in_file;
+			const int channels = force_alpha ? STBI_rgb_alpha : STBI_rgb;
+			stbi_uc* pixels = stbi_load_from_memory(mapped.data(),
+													static_cast<int>(mapped.size()),
+													&width,
+													&height,
+													&channels_in_file,
+													channels);
 
 			if (!pixels)
 			{
-				throw std::runtime_error("Failed to load image: " + path_to);
+				throw std::runtime_error("Failed to load image: " + mapped.get_path());
 			}
 
+			resource.width = static_cast<uint32_t>(width);
+			resource.height = static_cast<uint32_t>(height);
+			resource.channels = static_cast<uint32_t>(channels);
 			resource.contents = std::vector<uint8_t>(pixels, pixels + resource.width * resource.height * resource.channels);
 
 			stbi_image_free(pixels);
@@ -120,21 +533,29 @@ namespace plume
 
 		ImageResourceHDR ResourceManager::load_image_hdr(const std::string& file_name, bool force_alpha)
 		{
-			std::string path_to = default_path + file_name;
+			return load_image_hdr(map_file(file_name), force_alpha);
+		}
 
+		ImageResourceHDR ResourceManager::load_image_hdr(const MappedFileResource& mapped, bool force_alpha)
+		{
 			ImageResourceHDR resource;
 
-			// Read the image contents.
-			float* pixels = stbi_loadf(path_to.c_str(), 
-									   (int*)(&resource.width), 
-									   (int*)(&resource.height), 
-									   (int*)(&resource.channels), 
-									   force_alpha ? STBI_rgb_alpha : STBI_rgb);
+			int width, height, channels_in_file;
+			const int channels = force_alpha ? STBI_rgb_alpha : STBI_rgb;
+			float* pixels = stbi_loadf_from_memory(mapped.data(),
+												   static_cast<int>(mapped.size()),
+												   &width,
+												   &height,
+												   &channels_in_file,
+												   channels);
 			if (!pixels)
 			{
-				throw std::runtime_error("Failed to load image: " + path_to);
+				throw std::runtime_error("Failed to load image: " + mapped.get_path());
 			}
 
+			resource.width = static_cast<uint32_t>(width);
+			resource.height = static_cast<uint32_t>(height);
+			resource.channels = static_cast<uint32_t>(channels);
 			resource.contents = std::vector<float>(pixels, pixels + resource.width * resource.height * resource.channels);
 
 			stbi_image_free(pixels);
@@ -142,6 +563,237 @@ namespace plume
 			return resource;
 		}
 
+		ImageInfo ResourceManager::get_image_info(const MappedFileResource& mapped)
+		{
+			int width, height, channels_in_file;
+			if (!stbi_info_from_memory(mapped.data(), static_cast<int>(mapped.size()), &width, &height, &channels_in_file))
+			{
+				throw std::runtime_error("Failed to read image info: " + mapped.get_path());
+			}
+
+			ImageInfo info;
+			info.width = static_cast<uint32_t>(width);
+			info.height = static_cast<uint32_t>(height);
+			info.channels_in_file = static_cast<uint32_t>(channels_in_file);
+			info.is_hdr = stbi_is_hdr_from_memory(mapped.data(), static_cast<int>(mapped.size())) != 0;
+
+			return info;
+		}
+
+		ImageInfo ResourceManager::decode_image(const MappedFileResource& mapped, const PixelDestination& destination, bool force_alpha)
+		{
+			// Decode with the file's native channel count: this skips stb's own full-image channel conversion 
+			// pass, which is instead fused with the (parallel) write into the destination.
+			int width, height, channels_in_file;
+			stbi_uc* pixels = stbi_load_from_memory(mapped.data(), static_cast<int>(mapped.size()), &width, &height, &channels_in_file, 0);
+			if (!pixels)
+			{
+				throw std::runtime_error("Failed to load image: " + mapped.get_path());
+			}
+
+			ImageInfo info = { static_cast<uint32_t>(width), static_cast<uint32_t>(height), static_cast<uint32_t>(channels_in_file), false };
+
+			try
+			{
+				write_to_destination<uint8_t>(pixels, info.channels_in_file, info, destination, force_alpha ? 4 : 3, 255);
+			}
+			catch (...)
+			{
+				stbi_image_free(pixels);
+				throw;
+			}
+
+			stbi_image_free(pixels);
+
+			return info;
+		}
+
+		ImageInfo ResourceManager::decode_image_hdr(const MappedFileResource& mapped, const PixelDestination& destination, bool force_alpha)
+		{
+			int width, height, channels_in_file;
+			float* pixels = stbi_loadf_from_memory(mapped.data(), static_cast<int>(mapped.size()), &width, &height, &channels_in_file, 0);
+			if (!pixels)
+			{
+				throw std::runtime_error("Failed to load image: " + mapped.get_path());
+			}
+
+			ImageInfo info = { static_cast<uint32_t>(width), static_cast<uint32_t>(height), static_cast<uint32_t>(channels_in_file), true };
+
+			try
+			{
+				write_to_destination<float>(pixels, info.channels_in_file, info, destination, force_alpha ? 4 : 3, 1.0f);
+			}
+			catch (...)
+			{
+				stbi_image_free(pixels);
+				throw;
+			}
+
+			stbi_image_free(pixels);
+
+			return info;
+		}
+
+		ImageInfo ResourceManager::decode_image_hdr(const MappedFileResource& mapped, const PixelDestination& destination, vk::Format format)
+		{
+			if (!utils::is_packed_hdr_format(format))
+			{
+				throw std::runtime_error("Unsupported HDR storage format: " + vk::to_string(format));
+			}
+
+			int width, height, channels_in_file;
+			float* pixels = stbi_loadf_from_memory(mapped.data(), static_cast<int>(mapped.size()), &width, &height, &channels_in_file, 0);
+			if (!pixels)
+			{
+				throw std::runtime_error("Failed to load image: " + mapped.get_path());
+			}
+
+			ImageInfo info = { static_cast<uint32_t>(width), static_cast<uint32_t>(height), static_cast<uint32_t>(channels_in_file), true };
+
+			try
+			{
+				pack_to_destination(pixels, info.channels_in_file, info.width, info.height, destination, format);
+			}
+			catch (...)
+			{
+				stbi_image_free(pixels);
+				throw;
+			}
+
+			stbi_image_free(pixels);
+
+			return info;
+		}
+
+		void ResourceManager::pack_image_hdr(const ImageResourceHDR& image, const PixelDestination& destination, vk::Format format)
+		{
+			if (!utils::is_packed_hdr_format(format))
+			{
+				throw std::runtime_error("Unsupported HDR storage format: " + vk::to_string(format));
+			}
+
+			pack_to_destination(image.contents.data(), image.channels, image.width, image.height, destination, format);
+		}
+
+		template<class T>
+		LoadHandle<T> ResourceManager::load_async(std::function<T(const utils::CancellationToken&)> loader,
+												  utils::TaskPriority priority,
+												  UploadFuncType<T> on_loaded)
+		{
+			utils::CancellationToken token;
+			std::shared_future<T> future = get_thread_pool().submit([loader, token]() { return loader(token); }, token, priority).share();
+
+			if (on_loaded)
+			{
+				PendingUpload pending_upload;
+				pending_upload.is_ready = [future]() { return future.wait_for(std::chrono::seconds(0)) == std::future_status::ready; };
+				pending_upload.run = [future, on_loaded]()
+				{
+					try
+					{
+						future.get();
+					}
+					catch (...)
+					{
+						// The error (or cancellation) is reported to whoever holds the load handle.
+						return false;
+					}
+
+					on_loaded(future.get());
+					return true;
+				};
+
+				auto& manager = resource_manager();
+				std::lock_guard<std::mutex> lock(manager.m_upload_mutex);
+				manager.m_pending_uploads.push_back(pending_upload);
+			}
+
+			return LoadHandle<T>{ future, token };
+		}
+
+		LoadHandle<FileResource> ResourceManager::load_binary_file_async(const std::string& file_name, utils::TaskPriority priority, UploadFuncType<FileResource> on_loaded)
+		{
+			return load_async<FileResource>([file_name](const utils::CancellationToken&)
+			{
+				return load_binary_file(file_name);
+			}, priority, on_loaded);
+		}
+
+		LoadHandle<ImageResource> ResourceManager::load_image_async(const std::string& file_name, bool force_alpha, utils::TaskPriority priority, UploadFuncType<ImageResource> on_loaded)
+		{
+			return load_async<ImageResource>([file_name, force_alpha](const utils::CancellationToken& token)
+			{
+				// Fault the file in before decoding, then give the caller one last chance to bail out before 
+				// the (expensive) decode step.
+				auto mapped = map_file(file_name, MappedFileResource::AccessPattern::ACCESS_WILL_NEED);
+				token.throw_if_cancelled();
+
+				return load_image(mapped, force_alpha);
+			}, priority, on_loaded);
+		}
+
+		LoadHandle<ImageResourceHDR> ResourceManager::load_image_hdr_async(const std::string& file_name, bool force_alpha, utils::TaskPriority priority, UploadFuncType<ImageResourceHDR> on_loaded)
+		{
+			return load_async<ImageResourceHDR>([file_name, force_alpha](const utils::CancellationToken& token)
+			{
+				auto mapped = map_file(file_name, MappedFileResource::AccessPattern::ACCESS_WILL_NEED);
+				token.throw_if_cancelled();
+
+				return load_image_hdr(mapped, force_alpha);
+			}, priority, on_loaded);
+		}
+
+		size_t ResourceManager::process_uploads(size_t max_uploads)
+		{
+			auto& manager = resource_manager();
+
+			// Pull all of the finished loads out of the queue first, so that callbacks are free to request 
+			// more asynchronous loads without deadlocking.
+			std::vector<PendingUpload> ready_uploads;
+			{
+				std::lock_guard<std::mutex> lock(manager.m_upload_mutex);
+
+				auto it = manager.m_pending_uploads.begin();
+				while (it != manager.m_pending_uploads.end() && ready_uploads.size() < max_uploads)
+				{
+					if (it->is_ready())
+					{
+						ready_uploads.push_back(std::move(*it));
+						it = manager.m_pending_uploads.erase(it);
+					}
+					else
+					{
+						++it;
+					}
+				}
+			}
+
+			size_t uploads_invoked = 0;
+			for (auto& upload : ready_uploads)
+			{
+				if (upload.run())
+				{
+					++uploads_invoked;
+				}
+			}
+
+			return uploads_invoked;
+		}
+
+		ResourceCache& ResourceManager::get_cache()
+		{
+			static ResourceCache cache;
+			return cache;
+		}
+
+		size_t ResourceManager::get_pending_upload_count()
+		{
+			auto& manager = resource_manager();
+			std::lock_guard<std::mutex> lock(manager.m_upload_mutex);
+
+			return manager.m_pending_uploads.size();
+		}
+
 	} // namespace fsys
 
 } // namespace plume
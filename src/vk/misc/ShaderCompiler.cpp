@@ -0,0 +1,721 @@
+/*
+*
+* MIT License
+*
+* Copyright(c) 2017 Michael Walczyk
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files(the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions :
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*
+*/
+
+#include "ShaderCompiler.h"
+#include "Hash.h"
+#include "PackArchive.h"
+#include "Serialization.h"
+#include "VirtualFileSystem.h"
+
+#include "spirv-tools/optimizer.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <stdexcept>
+
+namespace plume
+{
+
+	namespace fsys
+	{
+
+		namespace
+		{
+
+			using utils::serialization::append;
+			using utils::serialization::append_string;
+			using utils::serialization::consume;
+			using utils::serialization::consume_string;
+			using utils::serialization::fits_count;
+
+			const char cache_magic[4] = { 'P', 'L', 'S', 'C' };
+
+			//! Bump this whenever the cache format or the way that keys are computed changes.
+			const uint32_t cache_version = 3;
+
+			//! The header of a cache entry, which is followed by the entry's dependencies (each stored as a 64-bit 
+			//! content hash followed by a string), the edges of its include graph (each stored as two strings), and
+			//! finally the SPIR-V code followed by the unstripped SPIR-V code for reflection (if any). Strings are
+			//! stored as a 32-bit length followed by the characters.
+			struct CacheHeader
+			{
+				char magic[4];
+				uint32_t version;
+				uint64_t cache_key;
+				uint32_t dependency_count;
+				uint32_t edge_count;
+				uint32_t code_size;				// In 32-bit words.
+				uint32_t reflection_code_size;	// In 32-bit words: 0 unless debug info was stripped from the code.
+			};
+
+			shaderc_shader_kind stage_to_shader_kind(vk::ShaderStageFlagBits stage)
+			{
+				switch (stage)
+				{
+				case vk::ShaderStageFlagBits::eVertex:
+					return shaderc_glsl_vertex_shader;
+				case vk::ShaderStageFlagBits::eTessellationControl:
+					return shaderc_glsl_tess_control_shader;
+				case vk::ShaderStageFlagBits::eTessellationEvaluation:
+					return shaderc_glsl_tess_evaluation_shader;
+				case vk::ShaderStageFlagBits::eGeometry:
+					return shaderc_glsl_geometry_shader;
+				case vk::ShaderStageFlagBits::eFragment:
+					return shaderc_glsl_fragment_shader;
+				case vk::ShaderStageFlagBits::eCompute:
+					return shaderc_glsl_compute_shader;
+				default:
+					throw std::runtime_error("Unsupported shader stage: " + vk::to_string(stage));
+				}
+			}
+
+			//! Resolves `#include` directives through the virtual file system and records every file that is 
+			//! included (once, in the order of first inclusion) along with the hash of its contents, as well as
+			//! the edges of the include graph.
+			class Includer : public shaderc::CompileOptions::IncluderInterface
+			{
+			public:
+
+				Includer(const std::vector<std::string>& include_directories, std::vector<ShaderDependency>& dependencies, ShaderIncludeGraph& include_graph) :
+					m_include_directories(include_directories),
+					m_dependencies(dependencies),
+					m_include_graph(include_graph)
+				{}
+
+				shaderc_include_result* GetInclude(const char* requested_source, shaderc_include_type type, const char* requesting_source, size_t /* include_depth */) override
+				{
+					auto data = new IncludeData;
+
+					// This is called from within shaderc's C API, so exceptions must not escape: errors are reported
+					// to the compiler by leaving the source name empty and putting the message in the content.
+					try
+					{
+						const std::string name = resolve(requested_source, type, requesting_source);
+						if (name.empty())
+						{
+							data->content = "Cannot find include file: " + std::string(requested_source);
+						}
+						else
+						{
+							data->mapped = ResourceManager::map_file(name);
+							data->name = name;
+
+							const uint64_t content_hash = utils::hash_bytes(data->mapped.data(), data->mapped.size());
+							if (std::find_if(m_dependencies.begin(), m_dependencies.end(), [&](const ShaderDependency& dependency) { return dependency.name == name; }) == m_dependencies.end())
+							{
+								m_dependencies.push_back({ name, content_hash });
+							}
+							m_include_graph.add_edge(requesting_source, name);
+						}
+					}
+					catch (const std::exception& e)
+					{
+						data->name.clear();
+						data->content = e.what();
+					}
+
+					data->result.source_name = data->name.c_str();
+					data->result.source_name_length = data->name.size();
+					if (data->name.empty())
+					{
+						data->result.content = data->content.c_str();
+						data->result.content_length = data->content.size();
+					}
+					else
+					{
+						data->result.content = reinterpret_cast<const char*>(data->mapped.data());
+						data->result.content_length = data->mapped.size();
+					}
+					data->result.user_data = data;
+
+					return &data->result;
+				}
+
+				void ReleaseInclude(shaderc_include_result* result) override
+				{
+					delete static_cast<IncludeData*>(result->user_data);
+				}
+
+			private:
+
+				struct IncludeData
+				{
+					shaderc_include_result result;
+					std::string name;
+					std::string content;
+					MappedFileResource mapped;
+				};
+
+				//! Returns the name of the file that `requested_source` refers to, or an empty string if there is 
+				//! no such file. Relative includes are resolved against the directory of the including file first,
+				//! then against the include directories (standard includes only use the latter).
+				std::string resolve(const std::string& requested_source, shaderc_include_type type, const std::string& requesting_source) const
+				{
+					const auto& file_system = ResourceManager::get_file_system();
+
+					if (type == shaderc_include_type_relative)
+					{
+						const size_t separator = requesting_source.find_last_of('/');
+						const std::string directory = separator == std::string::npos ? "" : requesting_source.substr(0, separator + 1);
+						const std::string candidate = PackArchive::normalize_path(directory + requested_source);
+						if (file_system.exists(candidate))
+						{
+							return candidate;
+						}
+					}
+
+					for (const auto& include_directory : m_include_directories)
+					{
+						const std::string candidate = PackArchive::normalize_path(include_directory + "/" + requested_source);
+						if (file_system.exists(candidate))
+						{
+							return candidate;
+						}
+					}
+
+					return "";
+				}
+
+				const std::vector<std::string>& m_include_directories;
+				std::vector<ShaderDependency>& m_dependencies;
+				ShaderIncludeGraph& m_include_graph;
+			};
+
+			//! shaderc compilers are not safe to use from several threads at once, so each thread gets its own.
+			const shaderc::Compiler& get_thread_compiler()
+			{
+				thread_local shaderc::Compiler compiler;
+				return compiler;
+			}
+
+		} // anonymous
+
+		void ShaderIncludeGraph::add_edge(const std::string& includer, const std::string& included)
+		{
+			m_includes[includer].insert(included);
+			m_includers[included].insert(includer);
+		}
+
+		void ShaderIncludeGraph::merge(const ShaderIncludeGraph& other)
+		{
+			for (const auto& node : other.m_includes)
+			{
+				for (const auto& included : node.second)
+				{
+					add_edge(node.first, included);
+				}
+			}
+		}
+
+		std::vector<std::string> ShaderIncludeGraph::get_includes(const std::string& file_name) const
+		{
+			auto it = m_includes.find(file_name);
+			return it == m_includes.end() ? std::vector<std::string>{} : std::vector<std::string>(it->second.begin(), it->second.end());
+		}
+
+		std::vector<std::string> ShaderIncludeGraph::get_includers(const std::string& file_name) const
+		{
+			auto it = m_includers.find(file_name);
+			return it == m_includers.end() ? std::vector<std::string>{} : std::vector<std::string>(it->second.begin(), it->second.end());
+		}
+
+		std::vector<std::string> ShaderIncludeGraph::get_transitive_includes(const std::string& file_name) const
+		{
+			return traverse(m_includes, file_name);
+		}
+
+		std::vector<std::string> ShaderIncludeGraph::get_transitive_includers(const std::string& file_name) const
+		{
+			return traverse(m_includers, file_name);
+		}
+
+		std::vector<std::pair<std::string, std::string>> ShaderIncludeGraph::get_edges() const
+		{
+			std::vector<std::pair<std::string, std::string>> edges;
+			for (const auto& node : m_includes)
+			{
+				for (const auto& included : node.second)
+				{
+					edges.emplace_back(node.first, included);
+				}
+			}
+
+			return edges;
+		}
+
+		std::vector<std::string> ShaderIncludeGraph::traverse(const std::map<std::string, std::set<std::string>>& adjacency, const std::string& file_name)
+		{
+			// Include graphs may contain cycles (guarded headers that include each other), so track visited nodes.
+			std::set<std::string> visited = { file_name };
+			std::vector<std::string> reached;
+			std::deque<std::string> frontier = { file_name };
+
+			while (!frontier.empty())
+			{
+				auto it = adjacency.find(frontier.front());
+				frontier.pop_front();
+
+				if (it == adjacency.end())
+				{
+					continue;
+				}
+				for (const auto& next : it->second)
+				{
+					if (visited.insert(next).second)
+					{
+						reached.push_back(next);
+						frontier.push_back(next);
+					}
+				}
+			}
+
+			return reached;
+		}
+
+		void ShaderBatchResult::throw_if_failed() const
+		{
+			if (succeeded())
+			{
+				return;
+			}
+
+			std::string message = std::to_string(failure_count) + " shader(s) failed to compile:";
+			for (const auto& error : errors)
+			{
+				if (!error.empty())
+				{
+					message += "\n" + error;
+				}
+			}
+
+			throw std::runtime_error(message);
+		}
+
+		uint64_t ShaderCompiler::Options::hash() const
+		{
+			uint64_t seed = utils::hash_combine(0, m_defines.size());
+			for (const auto& define : m_defines)
+			{
+				seed = utils::hash_combine(seed, utils::hash_string(define.first));
+				seed = utils::hash_combine(seed, utils::hash_string(define.second));
+			}
+
+			seed = utils::hash_combine(seed, m_include_directories.size());
+			for (const auto& include_directory : m_include_directories)
+			{
+				seed = utils::hash_combine(seed, utils::hash_string(include_directory));
+			}
+
+			seed = utils::hash_combine(seed, static_cast<uint64_t>(m_optimization));
+			seed = utils::hash_combine(seed, m_generate_debug_info);
+			seed = utils::hash_combine(seed, m_strip_debug_info);
+			seed = utils::hash_combine(seed, m_warnings_as_errors);
+
+			return seed;
+		}
+
+		ShaderCompiler::ShaderCompiler(const std::string& cache_directory) :
+
+			m_cache_directory(cache_directory),
+			m_cache_hits(0),
+			m_cache_misses(0),
+			m_cache_writes(0)
+		{
+			while (m_cache_directory.size() > 1 && (m_cache_directory.back() == '/' || m_cache_directory.back() == '\\'))
+			{
+				m_cache_directory.pop_back();
+			}
+
+			if (is_cache_enabled())
+			{
+				ResourceManager::create_directories(m_cache_directory);
+			}
+		}
+
+		ShaderBinary ShaderCompiler::compile_file(const std::string& file_name, const Options& options)
+		{
+			return compile(file_name, nullptr, infer_stage(file_name), options);
+		}
+
+		ShaderBinary ShaderCompiler::compile_file(const std::string& file_name, vk::ShaderStageFlagBits stage, const Options& options)
+		{
+			return compile(file_name, nullptr, stage, options);
+		}
+
+		ShaderBinary ShaderCompiler::compile_source(const std::string& source, const std::string& source_name, vk::ShaderStageFlagBits stage, const Options& options)
+		{
+			return compile(source_name, &source, stage, options);
+		}
+
+		ShaderIncludeGraph ShaderCompiler::get_include_graph() const
+		{
+			std::lock_guard<std::mutex> lock(m_graph_mutex);
+			return m_include_graph;
+		}
+
+		std::vector<std::string> ShaderCompiler::get_dependent_shaders(const std::string& file_name) const
+		{
+			const std::string name = PackArchive::normalize_path(file_name);
+
+			std::lock_guard<std::mutex> lock(m_graph_mutex);
+
+			std::vector<std::string> candidates = m_include_graph.get_transitive_includers(name);
+			candidates.push_back(name);
+
+			std::vector<std::string> shaders;
+			for (const auto& candidate : candidates)
+			{
+				if (m_shader_names.count(candidate))
+				{
+					shaders.push_back(candidate);
+				}
+			}
+			std::sort(shaders.begin(), shaders.end());
+
+			return shaders;
+		}
+
+		void ShaderCompiler::record_shader(const std::string& name, const ShaderBinary& binary)
+		{
+			std::lock_guard<std::mutex> lock(m_graph_mutex);
+			m_include_graph.merge(binary.include_graph);
+			m_shader_names.insert(name);
+		}
+
+		ShaderBatchResult ShaderCompiler::compile_batch(const std::vector<Job>& jobs)
+		{
+			using clock = std::chrono::high_resolution_clock;
+
+			ShaderBatchResult result;
+			result.binaries.resize(jobs.size());
+			result.errors.resize(jobs.size());
+
+			std::vector<double> job_seconds(jobs.size(), 0.0);
+
+			const auto start = clock::now();
+			utils::ThreadPool::global().parallel_for(0, jobs.size(), 1, [&](size_t begin, size_t end)
+			{
+				for (size_t i = begin; i < end; ++i)
+				{
+					const auto job_start = clock::now();
+					try
+					{
+						result.binaries[i] = compile(jobs[i].file_name, nullptr, jobs[i].stage, jobs[i].options);
+					}
+					catch (const std::exception& e)
+					{
+						result.binaries[i].stage = jobs[i].stage;
+						result.binaries[i].from_cache = false;
+						result.errors[i] = e.what();
+					}
+					job_seconds[i] = std::chrono::duration<double>(clock::now() - job_start).count();
+				}
+			});
+			result.wall_seconds = std::chrono::duration<double>(clock::now() - start).count();
+
+			for (size_t i = 0; i < jobs.size(); ++i)
+			{
+				result.serial_seconds += job_seconds[i];
+				if (!result.errors[i].empty())
+				{
+					++result.failure_count;
+				}
+			}
+
+			return result;
+		}
+
+		vk::ShaderStageFlagBits ShaderCompiler::infer_stage(const std::string& file_name)
+		{
+			std::string name = file_name;
+
+			const std::string glsl_extension = ".glsl";
+			if (name.size() > glsl_extension.size() && name.compare(name.size() - glsl_extension.size(), std::string::npos, glsl_extension) == 0)
+			{
+				name.erase(name.size() - glsl_extension.size());
+			}
+
+			const size_t dot = name.find_last_of('.');
+			const std::string extension = dot == std::string::npos ? "" : name.substr(dot);
+
+			if (extension == ".vert") return vk::ShaderStageFlagBits::eVertex;
+			if (extension == ".tesc") return vk::ShaderStageFlagBits::eTessellationControl;
+			if (extension == ".tese") return vk::ShaderStageFlagBits::eTessellationEvaluation;
+			if (extension == ".geom") return vk::ShaderStageFlagBits::eGeometry;
+			if (extension == ".frag") return vk::ShaderStageFlagBits::eFragment;
+			if (extension == ".comp") return vk::ShaderStageFlagBits::eCompute;
+
+			throw std::runtime_error("Unable to infer the shader stage of: " + file_name);
+		}
+
+		ShaderCompilerStatistics ShaderCompiler::get_statistics() const
+		{
+			ShaderCompilerStatistics statistics;
+			statistics.cache_hits = m_cache_hits.load();
+			statistics.cache_misses = m_cache_misses.load();
+			statistics.cache_writes = m_cache_writes.load();
+
+			return statistics;
+		}
+
+		ShaderBinary ShaderCompiler::compile(const std::string& source_name, const std::string* source, vk::ShaderStageFlagBits stage, const Options& options)
+		{
+			const std::string name = PackArchive::normalize_path(source_name);
+
+			// The key identifies the request. The contents of the files involved are validated separately (from
+			// the dependencies stored in the entry), except for in-memory source, which is part of the key.
+			uint64_t cache_key = utils::hash_combine(cache_version, utils::hash_string(name));
+			cache_key = utils::hash_combine(cache_key, static_cast<uint64_t>(stage));
+			cache_key = utils::hash_combine(cache_key, options.hash());
+			if (source)
+			{
+				cache_key = utils::hash_combine(cache_key, utils::hash_string(*source));
+			}
+
+			ShaderBinary binary;
+			binary.stage = stage;
+			binary.from_cache = false;
+
+			if (is_cache_enabled() && read_cache(cache_key, binary))
+			{
+				++m_cache_hits;
+				binary.from_cache = true;
+				record_shader(name, binary);
+				return binary;
+			}
+			++m_cache_misses;
+
+			MappedFileResource mapped;
+			const char* source_text = nullptr;
+			size_t source_size = 0;
+			if (source)
+			{
+				source_text = source->data();
+				source_size = source->size();
+			}
+			else
+			{
+				mapped = ResourceManager::map_file(name);
+				source_text = reinterpret_cast<const char*>(mapped.data());
+				source_size = mapped.size();
+				binary.dependencies.push_back({ name, utils::hash_bytes(mapped.data(), mapped.size()) });
+			}
+
+			shaderc::CompileOptions compile_options;
+			for (const auto& define : options.m_defines)
+			{
+				compile_options.AddMacroDefinition(define.first, define.second);
+			}
+			switch (options.m_optimization)
+			{
+			case ShaderOptimization::OPTIMIZATION_SIZE:
+				compile_options.SetOptimizationLevel(shaderc_optimization_level_size);
+				break;
+			case ShaderOptimization::OPTIMIZATION_PERFORMANCE:
+				compile_options.SetOptimizationLevel(shaderc_optimization_level_performance);
+				break;
+			case ShaderOptimization::OPTIMIZATION_NONE:
+			default:
+				compile_options.SetOptimizationLevel(shaderc_optimization_level_zero);
+				break;
+			}
+			if (options.m_generate_debug_info)
+			{
+				compile_options.SetGenerateDebugInfo();
+			}
+			if (options.m_warnings_as_errors)
+			{
+				compile_options.SetWarningsAsErrors();
+			}
+			compile_options.SetTargetEnvironment(shaderc_target_env_vulkan, shaderc_env_version_vulkan_1_0);
+			compile_options.SetIncluder(std::unique_ptr<shaderc::CompileOptions::IncluderInterface>(new Includer(options.m_include_directories, binary.dependencies, binary.include_graph)));
+
+			shaderc::SpvCompilationResult result = get_thread_compiler().CompileGlslToSpv(source_text, source_size, stage_to_shader_kind(stage), name.c_str(), "main", compile_options);
+			if (result.GetCompilationStatus() != shaderc_compilation_status_success)
+			{
+				throw std::runtime_error("Failed to compile shader " + name + ":\n" + result.GetErrorMessage());
+			}
+			binary.code.assign(result.cbegin(), result.cend());
+
+			if (options.m_strip_debug_info)
+			{
+				spvtools::Optimizer optimizer(SPV_ENV_VULKAN_1_0);
+				optimizer.RegisterPass(spvtools::CreateStripDebugInfoPass());
+
+				std::vector<uint32_t> stripped;
+				if (!optimizer.Run(binary.code.data(), binary.code.size(), &stripped))
+				{
+					throw std::runtime_error("Failed to strip debug info from shader " + name);
+				}
+				binary.reflection_code = std::move(binary.code);
+				binary.code = std::move(stripped);
+			}
+
+			if (is_cache_enabled())
+			{
+				write_cache(cache_key, binary);
+			}
+			record_shader(name, binary);
+
+			return binary;
+		}
+
+		std::string ShaderCompiler::get_cache_path(uint64_t cache_key) const
+		{
+			char key_string[17];
+			snprintf(key_string, sizeof(key_string), "%016llx", static_cast<unsigned long long>(cache_key));
+
+			return m_cache_directory + "/" + key_string + ".spvc";
+		}
+
+		bool ShaderCompiler::read_cache(uint64_t cache_key, ShaderBinary& binary) const
+		{
+			MappedFileResource mapped;
+			try
+			{
+				mapped = MappedFileResource{ get_cache_path(cache_key) };
+			}
+			catch (const std::exception&)
+			{
+				return false;
+			}
+
+			const uint8_t* it = mapped.begin();
+			const uint8_t* const end = mapped.end();
+
+			CacheHeader header;
+			if (!consume(it, end, header) ||
+				memcmp(header.magic, cache_magic, sizeof(cache_magic)) != 0 ||
+				header.version != cache_version ||
+				header.cache_key != cache_key)
+			{
+				return false;
+			}
+
+			// The counts come straight from disk, so reject any that the rest of the entry could not hold (each dependency 
+			// is at least a hash and a string length, and each edge at least two string lengths).
+			if (!fits_count(it, end, sizeof(uint64_t) + sizeof(uint32_t), header.dependency_count) ||
+				!fits_count(it, end, sizeof(uint32_t) * 2, header.edge_count))
+			{
+				return false;
+			}
+
+			std::vector<ShaderDependency> dependencies(header.dependency_count);
+			for (auto& dependency : dependencies)
+			{
+				if (!consume(it, end, dependency.content_hash) || !consume_string(it, end, dependency.name))
+				{
+					return false;
+				}
+			}
+
+			ShaderIncludeGraph include_graph;
+			for (uint32_t i = 0; i < header.edge_count; ++i)
+			{
+				std::string includer, included;
+				if (!consume_string(it, end, includer) || !consume_string(it, end, included))
+				{
+					return false;
+				}
+				include_graph.add_edge(includer, included);
+			}
+
+			if (static_cast<size_t>(end - it) != (static_cast<size_t>(header.code_size) + header.reflection_code_size) * sizeof(uint32_t))
+			{
+				return false;
+			}
+
+			// Re-hash every dependency: the entry is only valid if none of them have changed (or disappeared).
+			const auto& file_system = ResourceManager::get_file_system();
+			for (const auto& dependency : dependencies)
+			{
+				if (!file_system.exists(dependency.name))
+				{
+					return false;
+				}
+
+				const MappedFileResource contents = ResourceManager::map_file(dependency.name);
+				if (utils::hash_bytes(contents.data(), contents.size()) != dependency.content_hash)
+				{
+					return false;
+				}
+			}
+
+			binary.code.resize(header.code_size);
+			memcpy(binary.code.data(), it, binary.code.size() * sizeof(uint32_t));
+			it += binary.code.size() * sizeof(uint32_t);
+			binary.reflection_code.resize(header.reflection_code_size);
+			memcpy(binary.reflection_code.data(), it, binary.reflection_code.size() * sizeof(uint32_t));
+			binary.dependencies = std::move(dependencies);
+			binary.include_graph = std::move(include_graph);
+
+			return true;
+		}
+
+		void ShaderCompiler::write_cache(uint64_t cache_key, const ShaderBinary& binary)
+		{
+			const auto edges = binary.include_graph.get_edges();
+
+			CacheHeader header;
+			memcpy(header.magic, cache_magic, sizeof(cache_magic));
+			header.version = cache_version;
+			header.cache_key = cache_key;
+			header.dependency_count = static_cast<uint32_t>(binary.dependencies.size());
+			header.edge_count = static_cast<uint32_t>(edges.size());
+			header.code_size = static_cast<uint32_t>(binary.code.size());
+			header.reflection_code_size = static_cast<uint32_t>(binary.reflection_code.size());
+
+			std::string buffer;
+			append(buffer, header);
+			for (const auto& dependency : binary.dependencies)
+			{
+				append(buffer, dependency.content_hash);
+				append_string(buffer, dependency.name);
+			}
+			for (const auto& edge : edges)
+			{
+				append_string(buffer, edge.first);
+				append_string(buffer, edge.second);
+			}
+			buffer.append(reinterpret_cast<const char*>(binary.code.data()), binary.code.size() * sizeof(uint32_t));
+			buffer.append(reinterpret_cast<const char*>(binary.reflection_code.data()), binary.reflection_code.size() * sizeof(uint32_t));
+
+			// Written to a temporary file and renamed into place, so that a concurrent (or interrupted) write 
+			// never leaves a partial entry behind.
+			if (!ResourceManager::write_file_atomic(get_cache_path(cache_key), buffer.data(), buffer.size()))
+			{
+				return;
+			}
+
+			++m_cache_writes;
+		}
+
+	} // namespace fsys
+
+} // namespace plume
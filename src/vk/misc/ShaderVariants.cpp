@@ -0,0 +1,512 @@
+/*
+*
+* MIT License
+*
+* Copyright(c) 2017 Michael Walczyk
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files(the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions :
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*
+*/
+
+#include "ShaderVariants.h"
+#include "PackArchive.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cctype>
+#include <sstream>
+#include <stdexcept>
+
+namespace plume
+{
+
+	namespace fsys
+	{
+
+		namespace
+		{
+
+			//! Returns `true` if `token` only consists of the characters that may appear in an identifier. Axis values 
+			//! may start with a digit (i.e. `SAMPLE_COUNT 1 2 4`), since they are only ever appended to the keyword.
+			bool is_identifier_suffix(const std::string& token)
+			{
+				return !token.empty() && std::all_of(token.begin(), token.end(), [](char c) { return isalnum(static_cast<unsigned char>(c)) || c == '_'; });
+			}
+
+			bool is_identifier(const std::string& token)
+			{
+				return is_identifier_suffix(token) && !isdigit(static_cast<unsigned char>(token[0]));
+			}
+
+			//! Returns the number of bits needed to store a value index in [0, `count`).
+			uint32_t get_bit_count(size_t count)
+			{
+				uint32_t bits = 0;
+				while ((size_t(1) << bits) < count)
+				{
+					++bits;
+				}
+
+				return bits;
+			}
+
+			//! Splits `text` into lines and calls `func(line)` for each one, with surrounding whitespace removed.
+			template<class F>
+			void for_each_line(const char* begin, const char* end, F func)
+			{
+				while (begin < end)
+				{
+					const char* line_end = std::find(begin, end, '\n');
+
+					const char* first = begin;
+					const char* last = line_end;
+					while (first < last && isspace(static_cast<unsigned char>(*first))) ++first;
+					while (last > first && isspace(static_cast<unsigned char>(*(last - 1)))) --last;
+
+					func(std::string(first, last));
+
+					begin = line_end + 1;
+				}
+			}
+
+			//! If `line` is a `#pragma variant` directive, returns `true` and stores the tokens that follow it.
+			bool parse_variant_directive(const std::string& line, std::vector<std::string>& tokens)
+			{
+				if (line.empty() || line[0] != '#')
+				{
+					return false;
+				}
+
+				std::istringstream stream(line.substr(1));
+				std::string pragma, variant;
+				if (!(stream >> pragma >> variant) || pragma != "pragma" || variant != "variant")
+				{
+					return false;
+				}
+
+				tokens.clear();
+				std::string token;
+				while (stream >> token)
+				{
+					// Allow trailing comments.
+					if (token.compare(0, 2, "//") == 0)
+					{
+						break;
+					}
+					tokens.push_back(token);
+				}
+
+				return true;
+			}
+
+		} // anonymous
+
+		ShaderVariantSet::ShaderVariantSet(ShaderCompiler& compiler, const std::string& file_name, const ShaderCompiler::Options& base_options) :
+
+			m_compiler(compiler),
+			m_file_name(PackArchive::normalize_path(file_name)),
+			m_stage(ShaderCompiler::infer_stage(file_name)),
+			m_base_options(base_options),
+			m_key_bits(0)
+		{
+			const MappedFileResource source = ResourceManager::map_file(m_file_name);
+			const char* begin = reinterpret_cast<const char*>(source.begin());
+			const char* end = reinterpret_cast<const char*>(source.end());
+
+			for_each_line(begin, end, [&](const std::string& line)
+			{
+				std::vector<std::string> tokens;
+				if (!parse_variant_directive(line, tokens))
+				{
+					return;
+				}
+
+				if (tokens.empty() || tokens.size() == 2 || !is_identifier(tokens[0]) || !std::all_of(tokens.begin() + 1, tokens.end(), is_identifier_suffix))
+				{
+					throw std::runtime_error("Malformed variant directive in " + m_file_name + " (expected a keyword followed by no values or at least two values): " + line);
+				}
+
+				ShaderVariantAxis axis;
+				axis.name = tokens[0];
+				axis.is_boolean = tokens.size() == 1;
+				axis.values = axis.is_boolean ? std::vector<std::string>{ "0", "1" } : std::vector<std::string>(tokens.begin() + 1, tokens.end());
+				axis.shift = m_key_bits;
+				axis.bits = get_bit_count(axis.values.size());
+
+				for (size_t i = 0; i < axis.values.size(); ++i)
+				{
+					if (std::count(axis.values.begin(), axis.values.end(), axis.values[i]) > 1)
+					{
+						throw std::runtime_error("Duplicate value " + axis.values[i] + " for variant axis " + axis.name + " in " + m_file_name);
+					}
+				}
+				for (const auto& other : m_axes)
+				{
+					if (other.name == axis.name)
+					{
+						throw std::runtime_error("Duplicate variant axis " + axis.name + " in " + m_file_name);
+					}
+				}
+
+				m_key_bits += axis.bits;
+				if (m_key_bits > max_key_bits)
+				{
+					throw std::runtime_error("Too many shader variants in " + m_file_name + ": the variant axes need more than " + std::to_string(max_key_bits) + " key bits");
+				}
+
+				m_axes.push_back(axis);
+			});
+
+			m_slots.resize(size_t(1) << m_key_bits);
+			m_is_used.resize(m_slots.size(), false);
+		}
+
+		std::shared_ptr<const ShaderBinary> ShaderVariantSet::get(VariantKey key)
+		{
+			if (!is_valid_key(key))
+			{
+				throw std::runtime_error("Invalid variant key " + std::to_string(key) + " for " + m_file_name);
+			}
+
+			std::promise<std::shared_ptr<const ShaderBinary>> promise;
+			BinaryFuture future;
+			bool is_owner = false;
+			{
+				std::lock_guard<std::mutex> lock(m_mutex);
+
+				BinaryFuture& slot = m_slots[key];
+				if (!slot.valid())
+				{
+					slot = promise.get_future().share();
+					is_owner = true;
+				}
+				future = slot;
+
+				if (!m_is_used[key])
+				{
+					m_is_used[key] = true;
+					m_used_keys.push_back(key);
+				}
+			}
+
+			// The first request for a variant compiles it, while any concurrent requests wait on its future.
+			if (is_owner)
+			{
+				try
+				{
+					promise.set_value(std::make_shared<const ShaderBinary>(m_compiler.compile_file(m_file_name, m_stage, get_options(key))));
+				}
+				catch (...)
+				{
+					{
+						std::lock_guard<std::mutex> lock(m_mutex);
+						m_slots[key] = BinaryFuture();
+						m_is_used[key] = false;
+						m_used_keys.erase(std::remove(m_used_keys.begin(), m_used_keys.end(), key), m_used_keys.end());
+					}
+					promise.set_exception(std::current_exception());
+				}
+			}
+
+			return future.get();
+		}
+
+		ShaderVariantSet::VariantKey ShaderVariantSet::make_key(const std::map<std::string, std::string>& values) const
+		{
+			VariantKey key = 0;
+			for (const auto& value : values)
+			{
+				key = with(key, value.first, value.second);
+			}
+
+			return key;
+		}
+
+		ShaderVariantSet::VariantKey ShaderVariantSet::with(VariantKey key, const std::string& axis_name, const std::string& value) const
+		{
+			const ShaderVariantAxis& axis = find_axis(axis_name);
+
+			auto it = std::find(axis.values.begin(), axis.values.end(), value);
+			if (it == axis.values.end())
+			{
+				throw std::runtime_error("Variant axis " + axis.name + " of " + m_file_name + " has no value: " + value);
+			}
+
+			const VariantKey mask = ((VariantKey(1) << axis.bits) - 1) << axis.shift;
+			const VariantKey index = static_cast<VariantKey>(it - axis.values.begin());
+
+			return (key & ~mask) | (index << axis.shift);
+		}
+
+		std::string ShaderVariantSet::describe(VariantKey key) const
+		{
+			std::string description;
+			for (const auto& axis : m_axes)
+			{
+				const VariantKey index = (key >> axis.shift) & ((VariantKey(1) << axis.bits) - 1);
+
+				if (!description.empty())
+				{
+					description += ' ';
+				}
+				description += axis.name + "=" + (index < axis.values.size() ? axis.values[index] : "?");
+			}
+
+			return description;
+		}
+
+		ShaderVariantSet::VariantKey ShaderVariantSet::parse_key(const std::string& description) const
+		{
+			VariantKey key = 0;
+
+			std::istringstream stream(description);
+			std::string token;
+			while (stream >> token)
+			{
+				const size_t equals = token.find('=');
+				if (equals == std::string::npos)
+				{
+					throw std::runtime_error("Malformed variant description for " + m_file_name + ": " + description);
+				}
+				key = with(key, token.substr(0, equals), token.substr(equals + 1));
+			}
+
+			return key;
+		}
+
+		bool ShaderVariantSet::is_valid_key(VariantKey key) const
+		{
+			if (key >= m_slots.size())
+			{
+				return false;
+			}
+
+			for (const auto& axis : m_axes)
+			{
+				if (((key >> axis.shift) & ((VariantKey(1) << axis.bits) - 1)) >= axis.values.size())
+				{
+					return false;
+				}
+			}
+
+			return true;
+		}
+
+		void ShaderVariantSet::precompile(const std::vector<VariantKey>& keys)
+		{
+			// Validate every key before claiming any slots, so that an invalid key doesn't leave the slots of the
+			// keys before it claimed by a batch that never runs.
+			for (VariantKey key : keys)
+			{
+				if (!is_valid_key(key))
+				{
+					throw std::runtime_error("Invalid variant key " + std::to_string(key) + " for " + m_file_name);
+				}
+			}
+
+			// Claim the slots of every variant that hasn't been requested yet, so that concurrent calls to `get()`
+			// wait for the batch instead of compiling the same variants again.
+			std::vector<VariantKey> claimed_keys;
+			std::vector<std::promise<std::shared_ptr<const ShaderBinary>>> promises;
+			promises.reserve(keys.size());
+			{
+				std::lock_guard<std::mutex> lock(m_mutex);
+				for (VariantKey key : keys)
+				{
+					if (!m_slots[key].valid())
+					{
+						promises.emplace_back();
+						m_slots[key] = promises.back().get_future().share();
+						claimed_keys.push_back(key);
+					}
+				}
+			}
+
+			// Releases a claimed slot (so that a later request will try again) and fails anyone waiting on it.
+			auto release = [&](size_t i, std::exception_ptr exception)
+			{
+				{
+					std::lock_guard<std::mutex> lock(m_mutex);
+					m_slots[claimed_keys[i]] = BinaryFuture();
+				}
+				promises[i].set_exception(exception);
+			};
+
+			size_t fulfilled = 0;
+			try
+			{
+				std::vector<ShaderCompiler::Job> jobs;
+				jobs.reserve(claimed_keys.size());
+				for (VariantKey key : claimed_keys)
+				{
+					jobs.emplace_back(m_file_name, m_stage, get_options(key));
+				}
+
+				ShaderBatchResult result = m_compiler.compile_batch(jobs);
+
+				for (; fulfilled < claimed_keys.size(); ++fulfilled)
+				{
+					if (result.errors[fulfilled].empty())
+					{
+						promises[fulfilled].set_value(std::make_shared<const ShaderBinary>(std::move(result.binaries[fulfilled])));
+					}
+					else
+					{
+						release(fulfilled, std::make_exception_ptr(std::runtime_error(result.errors[fulfilled])));
+					}
+				}
+
+				result.throw_if_failed();
+			}
+			catch (...)
+			{
+				for (; fulfilled < claimed_keys.size(); ++fulfilled)
+				{
+					release(fulfilled, std::current_exception());
+				}
+				throw;
+			}
+		}
+
+		size_t ShaderVariantSet::precompile_from_manifest(const std::string& manifest_name)
+		{
+			const MappedFileResource manifest = ResourceManager::map_file(manifest_name);
+			const char* begin = reinterpret_cast<const char*>(manifest.begin());
+			const char* end = reinterpret_cast<const char*>(manifest.end());
+
+			std::vector<VariantKey> keys;
+			for_each_line(begin, end, [&](const std::string& line)
+			{
+				if (line.empty() || line[0] == '#')
+				{
+					return;
+				}
+
+				const size_t separator = line.find_first_of(" \t");
+				if (PackArchive::normalize_path(line.substr(0, separator)) == m_file_name)
+				{
+					keys.push_back(parse_key(separator == std::string::npos ? "" : line.substr(separator + 1)));
+				}
+			});
+
+			precompile(keys);
+
+			return keys.size();
+		}
+
+		std::string ShaderVariantSet::get_usage_manifest() const
+		{
+			std::string manifest;
+			for (VariantKey key : get_used_keys())
+			{
+				manifest += m_file_name + " " + describe(key) + "\n";
+			}
+
+			return manifest;
+		}
+
+		size_t ShaderVariantSet::invalidate(const std::string& file_name)
+		{
+			const std::string name = PackArchive::normalize_path(file_name);
+
+			std::lock_guard<std::mutex> lock(m_mutex);
+
+			// Walk every slot rather than the used keys, since precompiled variants may not have been requested yet.
+			size_t invalidated = 0;
+			for (BinaryFuture& slot : m_slots)
+			{
+				if (!slot.valid() || slot.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+				{
+					continue;
+				}
+
+				// Failed compilations reset their slot, so a ready slot always holds a binary.
+				const auto& dependencies = slot.get()->dependencies;
+				const bool is_affected = std::any_of(dependencies.begin(), dependencies.end(), [&](const ShaderDependency& dependency) {
+					return dependency.name == name;
+				});
+
+				if (is_affected)
+				{
+					slot = BinaryFuture();
+					++invalidated;
+				}
+			}
+
+			return invalidated;
+		}
+
+		std::vector<ShaderVariantSet::VariantKey> ShaderVariantSet::get_used_keys() const
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			return m_used_keys;
+		}
+
+		size_t ShaderVariantSet::get_variant_count() const
+		{
+			size_t count = 1;
+			for (const auto& axis : m_axes)
+			{
+				count *= axis.values.size();
+			}
+
+			return count;
+		}
+
+		ShaderCompiler::Options ShaderVariantSet::get_options(VariantKey key) const
+		{
+			ShaderCompiler::Options options = m_base_options;
+
+			for (const auto& axis : m_axes)
+			{
+				const VariantKey index = (key >> axis.shift) & ((VariantKey(1) << axis.bits) - 1);
+
+				if (axis.is_boolean)
+				{
+					if (index == 1)
+					{
+						options.define(axis.name, "1");
+					}
+				}
+				else
+				{
+					options.define(axis.name, std::to_string(index));
+					options.define(axis.name + "_" + axis.values[index], "1");
+				}
+			}
+
+			return options;
+		}
+
+		const ShaderVariantAxis& ShaderVariantSet::find_axis(const std::string& name) const
+		{
+			for (const auto& axis : m_axes)
+			{
+				if (axis.name == name)
+				{
+					return axis;
+				}
+			}
+
+			throw std::runtime_error("Shader " + m_file_name + " has no variant axis: " + name);
+		}
+
+	} // namespace fsys
+
+} // namespace plume
@@ -0,0 +1,872 @@
+/*
+*
+* MIT License
+*
+* Copyright(c) 2017 Michael Walczyk
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files(the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions :
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*
+*/
+
+#include "TextureLoader.h"
+#include "ThreadPool.h"
+#include "Utils.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+
+namespace plume
+{
+
+	namespace fsys
+	{
+
+		namespace
+		{
+
+			inline uint32_t read_u32(const uint8_t* p) { uint32_t v; memcpy(&v, p, sizeof(v)); return v; }
+
+			inline uint64_t read_u64(const uint8_t* p) { uint64_t v; memcpy(&v, p, sizeof(v)); return v; }
+
+			inline void write_u32(uint8_t* p, uint32_t v) { memcpy(p, &v, sizeof(v)); }
+
+			inline void write_u64(uint8_t* p, uint64_t v) { memcpy(p, &v, sizeof(v)); }
+
+			constexpr uint32_t make_four_cc(char a, char b, char c, char d)
+			{
+				return static_cast<uint32_t>(a) | (static_cast<uint32_t>(b) << 8) | (static_cast<uint32_t>(c) << 16) | (static_cast<uint32_t>(d) << 24);
+			}
+
+			const uint8_t ktx2_identifier[12] = { 0xAB, 0x4B, 0x54, 0x58, 0x20, 0x32, 0x30, 0xBB, 0x0D, 0x0A, 0x1A, 0x0A };
+
+			// See: https://docs.microsoft.com/en-us/windows/desktop/direct3ddds/dds-header
+			const size_t dds_header_size = 4 + 124;
+			const size_t dds_dx10_header_size = 20;
+			const uint32_t dds_pixel_format_four_cc = 0x4;
+			const uint32_t dds_pixel_format_rgb = 0x40;
+			const uint32_t dds_caps2_cube_map = 0x200;
+			const uint32_t dds_caps2_volume = 0x200000;
+			const uint32_t dds_dx10_misc_texture_cube = 0x4;
+			const uint32_t dds_dx10_dimension_texture_1d = 2;
+			const uint32_t dds_dx10_dimension_texture_2d = 3;
+			const uint32_t dds_dx10_dimension_texture_3d = 4;
+			const uint32_t dds_flags_required = 0x1 | 0x2 | 0x4 | 0x1000;	// CAPS | HEIGHT | WIDTH | PIXELFORMAT
+			const uint32_t dds_flags_mip_map_count = 0x20000;
+			const uint32_t dds_flags_linear_size = 0x80000;
+			const uint32_t dds_flags_depth = 0x800000;
+			const uint32_t dds_caps_complex = 0x8;
+			const uint32_t dds_caps_texture = 0x1000;
+			const uint32_t dds_caps_mip_map = 0x400000;
+			const uint32_t dds_caps2_all_faces = 0xFC00;
+
+			//! Pairs of DXGI_FORMAT values (from a DDS file's DX10 header) and the equivalent vk::Format.
+			const std::pair<uint32_t, vk::Format> dxgi_formats[] =
+			{
+				{ 2,  vk::Format::eR32G32B32A32Sfloat },
+				{ 6,  vk::Format::eR32G32B32Sfloat },
+				{ 10, vk::Format::eR16G16B16A16Sfloat },
+				{ 11, vk::Format::eR16G16B16A16Unorm },
+				{ 16, vk::Format::eR32G32Sfloat },
+				{ 24, vk::Format::eA2B10G10R10UnormPack32 },
+				{ 26, vk::Format::eB10G11R11UfloatPack32 },
+				{ 28, vk::Format::eR8G8B8A8Unorm },
+				{ 29, vk::Format::eR8G8B8A8Srgb },
+				{ 31, vk::Format::eR8G8B8A8Snorm },
+				{ 34, vk::Format::eR16G16Sfloat },
+				{ 35, vk::Format::eR16G16Unorm },
+				{ 41, vk::Format::eR32Sfloat },
+				{ 49, vk::Format::eR8G8Unorm },
+				{ 51, vk::Format::eR8G8Snorm },
+				{ 54, vk::Format::eR16Sfloat },
+				{ 56, vk::Format::eR16Unorm },
+				{ 61, vk::Format::eR8Unorm },
+				{ 63, vk::Format::eR8Snorm },
+				{ 67, vk::Format::eE5B9G9R9UfloatPack32 },
+				{ 71, vk::Format::eBc1RgbaUnormBlock },
+				{ 72, vk::Format::eBc1RgbaSrgbBlock },
+				{ 74, vk::Format::eBc2UnormBlock },
+				{ 75, vk::Format::eBc2SrgbBlock },
+				{ 77, vk::Format::eBc3UnormBlock },
+				{ 78, vk::Format::eBc3SrgbBlock },
+				{ 80, vk::Format::eBc4UnormBlock },
+				{ 81, vk::Format::eBc4SnormBlock },
+				{ 83, vk::Format::eBc5UnormBlock },
+				{ 84, vk::Format::eBc5SnormBlock },
+				{ 87, vk::Format::eB8G8R8A8Unorm },
+				{ 91, vk::Format::eB8G8R8A8Srgb },
+				{ 95, vk::Format::eBc6HUfloatBlock },
+				{ 96, vk::Format::eBc6HSfloatBlock },
+				{ 98, vk::Format::eBc7UnormBlock },
+				{ 99, vk::Format::eBc7SrgbBlock }
+			};
+
+			//! Translates a DXGI_FORMAT into the equivalent vk::Format.
+			vk::Format dxgi_to_format(uint32_t dxgi_format)
+			{
+				for (const auto& pair : dxgi_formats)
+				{
+					if (pair.first == dxgi_format) return pair.second;
+				}
+				throw std::runtime_error("Unsupported DXGI format in DDS file: " + std::to_string(dxgi_format));
+			}
+
+			//! Translates a vk::Format into the equivalent DXGI_FORMAT. DXGI has no opaque BC1 format, so
+			//! opaque BC1 textures are stored as BC1 with alpha (which decodes identically for opaque blocks).
+			uint32_t format_to_dxgi(vk::Format format)
+			{
+				if (format == vk::Format::eBc1RgbUnormBlock) format = vk::Format::eBc1RgbaUnormBlock;
+				if (format == vk::Format::eBc1RgbSrgbBlock) format = vk::Format::eBc1RgbaSrgbBlock;
+
+				for (const auto& pair : dxgi_formats)
+				{
+					if (pair.second == format) return pair.first;
+				}
+				throw std::runtime_error("Format cannot be stored in a DDS file: " + vk::to_string(format));
+			}
+
+			//! Translates a legacy (pre-DX10) DDS pixel format into the equivalent vk::Format.
+			vk::Format legacy_dds_to_format(const uint8_t* pixel_format)
+			{
+				const uint32_t flags = read_u32(pixel_format + 4);
+				const uint32_t four_cc = read_u32(pixel_format + 8);
+
+				if (flags & dds_pixel_format_four_cc)
+				{
+					switch (four_cc)
+					{
+					case make_four_cc('D', 'X', 'T', '1'): return vk::Format::eBc1RgbaUnormBlock;
+					case make_four_cc('D', 'X', 'T', '2'):
+					case make_four_cc('D', 'X', 'T', '3'): return vk::Format::eBc2UnormBlock;
+					case make_four_cc('D', 'X', 'T', '4'):
+					case make_four_cc('D', 'X', 'T', '5'): return vk::Format::eBc3UnormBlock;
+					case make_four_cc('A', 'T', 'I', '1'):
+					case make_four_cc('B', 'C', '4', 'U'): return vk::Format::eBc4UnormBlock;
+					case make_four_cc('B', 'C', '4', 'S'): return vk::Format::eBc4SnormBlock;
+					case make_four_cc('A', 'T', 'I', '2'):
+					case make_four_cc('B', 'C', '5', 'U'): return vk::Format::eBc5UnormBlock;
+					case make_four_cc('B', 'C', '5', 'S'): return vk::Format::eBc5SnormBlock;
+					case 113: return vk::Format::eR16G16B16A16Sfloat;		// D3DFMT_A16B16G16R16F
+					case 116: return vk::Format::eR32G32B32A32Sfloat;		// D3DFMT_A32B32G32R32F
+					default:
+						break;
+					}
+				}
+				else if (flags & dds_pixel_format_rgb)
+				{
+					const uint32_t bit_count = read_u32(pixel_format + 12);
+					const uint32_t r_mask = read_u32(pixel_format + 16);
+					const uint32_t b_mask = read_u32(pixel_format + 24);
+
+					if (bit_count == 32 && r_mask == 0x000000FF && b_mask == 0x00FF0000) return vk::Format::eR8G8B8A8Unorm;
+					if (bit_count == 32 && r_mask == 0x00FF0000 && b_mask == 0x000000FF) return vk::Format::eB8G8R8A8Unorm;
+				}
+
+				throw std::runtime_error("Unsupported legacy pixel format in DDS file");
+			}
+
+			vk::Extent3D get_mip_extent(const vk::Extent3D& extent, uint32_t mip_level)
+			{
+				return{ std::max(extent.width >> mip_level, 1u),
+						std::max(extent.height >> mip_level, 1u),
+						std::max(extent.depth >> mip_level, 1u) };
+			}
+
+			size_t get_subresource_size(vk::Format format, const vk::Extent3D& extent)
+			{
+				const utils::FormatBlockInfo info = utils::get_format_block_info(format);
+				const size_t blocks_x = (extent.width + info.block_width - 1) / info.block_width;
+				const size_t blocks_y = (extent.height + info.block_height - 1) / info.block_height;
+
+				return blocks_x * blocks_y * extent.depth * info.block_size;
+			}
+
+			void check_subresource_bounds(const TextureResource& texture, size_t file_size)
+			{
+				for (const auto& subresource : texture.subresources)
+				{
+					if (subresource.offset + subresource.size > file_size)
+					{
+						throw std::runtime_error("Texture file is truncated: " + texture.file->get_path());
+					}
+				}
+			}
+
+			utils::BlockFormat format_to_block_format(vk::Format format)
+			{
+				switch (format)
+				{
+				case vk::Format::eBc1RgbUnormBlock:
+				case vk::Format::eBc1RgbSrgbBlock:			return utils::BlockFormat::BLOCK_BC1_RGB;
+				case vk::Format::eBc1RgbaUnormBlock:
+				case vk::Format::eBc1RgbaSrgbBlock:			return utils::BlockFormat::BLOCK_BC1_RGBA;
+				case vk::Format::eBc2UnormBlock:
+				case vk::Format::eBc2SrgbBlock:				return utils::BlockFormat::BLOCK_BC2;
+				case vk::Format::eBc3UnormBlock:
+				case vk::Format::eBc3SrgbBlock:				return utils::BlockFormat::BLOCK_BC3;
+				case vk::Format::eBc4UnormBlock:			return utils::BlockFormat::BLOCK_BC4_UNORM;
+				case vk::Format::eBc4SnormBlock:			return utils::BlockFormat::BLOCK_BC4_SNORM;
+				case vk::Format::eBc5UnormBlock:			return utils::BlockFormat::BLOCK_BC5_UNORM;
+				case vk::Format::eBc5SnormBlock:			return utils::BlockFormat::BLOCK_BC5_SNORM;
+				case vk::Format::eBc7UnormBlock:
+				case vk::Format::eBc7SrgbBlock:				return utils::BlockFormat::BLOCK_BC7;
+				case vk::Format::eEtc2R8G8B8UnormBlock:
+				case vk::Format::eEtc2R8G8B8SrgbBlock:		return utils::BlockFormat::BLOCK_ETC2_RGB;
+				case vk::Format::eEtc2R8G8B8A1UnormBlock:
+				case vk::Format::eEtc2R8G8B8A1SrgbBlock:	return utils::BlockFormat::BLOCK_ETC2_RGB_A1;
+				case vk::Format::eEtc2R8G8B8A8UnormBlock:
+				case vk::Format::eEtc2R8G8B8A8SrgbBlock:	return utils::BlockFormat::BLOCK_ETC2_RGBA;
+				case vk::Format::eEacR11UnormBlock:			return utils::BlockFormat::BLOCK_EAC_R;
+				case vk::Format::eEacR11G11UnormBlock:		return utils::BlockFormat::BLOCK_EAC_RG;
+				default:
+					throw std::runtime_error("No CPU decoder is available for format: " + vk::to_string(format));
+				}
+			}
+
+			//! Builds the data format descriptor (a single basic descriptor block) that KTX2 files use to 
+			//! describe their texel layout. Only 8-bit RGBA and the BC formats are supported.
+			std::vector<uint8_t> build_ktx2_dfd(vk::Format format)
+			{
+				// See: https://registry.khronos.org/DataFormat/specs/1.3/dataformat.1.3.html
+				const uint8_t color_model_rgbsda = 1;
+				const uint8_t color_model_bc1a = 128;
+				const uint8_t color_model_bc2 = 129;
+				const uint8_t color_model_bc3 = 130;
+				const uint8_t color_model_bc4 = 131;
+				const uint8_t color_model_bc5 = 132;
+				const uint8_t color_model_bc7 = 134;
+				const uint8_t channel_alpha = 15;
+				const uint8_t qualifier_linear = 0x80;
+				const uint8_t qualifier_signed = 0x40;
+
+				struct Sample
+				{
+					uint16_t bit_offset;
+					uint8_t bit_length;
+					uint8_t channel;
+					uint32_t upper;
+				};
+
+				const bool is_srgb = utils::is_srgb_format(format);
+				const uint8_t alpha = channel_alpha | (is_srgb ? qualifier_linear : 0);
+
+				uint8_t color_model;
+				std::vector<Sample> samples;
+				samples.reserve(4);
+				switch (format)
+				{
+				case vk::Format::eR8G8B8A8Unorm:
+				case vk::Format::eR8G8B8A8Srgb:
+					color_model = color_model_rgbsda;
+					samples = { { 0, 8, 0, 255 }, { 8, 8, 1, 255 }, { 16, 8, 2, 255 }, { 24, 8, alpha, 255 } };
+					break;
+				case vk::Format::eBc1RgbUnormBlock:
+				case vk::Format::eBc1RgbSrgbBlock:
+					color_model = color_model_bc1a;
+					samples = { { 0, 64, 0, 0xFFFFFFFF } };
+					break;
+				case vk::Format::eBc1RgbaUnormBlock:
+				case vk::Format::eBc1RgbaSrgbBlock:
+					color_model = color_model_bc1a;
+					samples = { { 0, 64, alpha, 0xFFFFFFFF } };
+					break;
+				case vk::Format::eBc2UnormBlock:
+				case vk::Format::eBc2SrgbBlock:
+					color_model = color_model_bc2;
+					samples = { { 0, 64, alpha, 0xFFFFFFFF }, { 64, 64, 0, 0xFFFFFFFF } };
+					break;
+				case vk::Format::eBc3UnormBlock:
+				case vk::Format::eBc3SrgbBlock:
+					color_model = color_model_bc3;
+					samples = { { 0, 64, alpha, 0xFFFFFFFF }, { 64, 64, 0, 0xFFFFFFFF } };
+					break;
+				case vk::Format::eBc4UnormBlock:
+					color_model = color_model_bc4;
+					samples = { { 0, 64, 0, 0xFFFFFFFF } };
+					break;
+				case vk::Format::eBc4SnormBlock:
+					color_model = color_model_bc4;
+					samples = { { 0, 64, qualifier_signed, 0x7FFFFFFF } };
+					break;
+				case vk::Format::eBc5UnormBlock:
+					color_model = color_model_bc5;
+					samples = { { 0, 64, 0, 0xFFFFFFFF }, { 64, 64, 1, 0xFFFFFFFF } };
+					break;
+				case vk::Format::eBc5SnormBlock:
+					color_model = color_model_bc5;
+					samples = { { 0, 64, qualifier_signed, 0x7FFFFFFF }, { 64, 64, 1 | qualifier_signed, 0x7FFFFFFF } };
+					break;
+				case vk::Format::eBc7UnormBlock:
+				case vk::Format::eBc7SrgbBlock:
+					color_model = color_model_bc7;
+					samples = { { 0, 128, 0, 0xFFFFFFFF } };
+					break;
+				default:
+					throw std::runtime_error("Format cannot be stored in a KTX2 file: " + vk::to_string(format));
+				}
+
+				const utils::FormatBlockInfo info = utils::get_format_block_info(format);
+				const uint32_t block_size = 24 + 16 * static_cast<uint32_t>(samples.size());
+
+				std::vector<uint8_t> dfd(4 + block_size, 0);
+				write_u32(dfd.data(), static_cast<uint32_t>(dfd.size()));
+				write_u32(dfd.data() + 4, 0);											// vendor ID and descriptor type (basic)
+				write_u32(dfd.data() + 8, 2 | (block_size << 16));						// version number and block size
+				dfd[12] = color_model;
+				dfd[13] = 1;															// color primaries (BT.709)
+				dfd[14] = is_srgb ? 2 : 1;												// transfer function (sRGB or linear)
+				dfd[15] = 0;															// flags (straight alpha)
+				dfd[16] = static_cast<uint8_t>(info.block_width - 1);
+				dfd[17] = static_cast<uint8_t>(info.block_height - 1);
+				dfd[20] = static_cast<uint8_t>(info.block_size);						// bytes in plane 0
+
+				for (size_t i = 0; i < samples.size(); ++i)
+				{
+					uint8_t* sample = dfd.data() + 28 + 16 * i;
+					memcpy(sample, &samples[i].bit_offset, sizeof(uint16_t));
+					sample[2] = static_cast<uint8_t>(samples[i].bit_length - 1);
+					sample[3] = samples[i].channel;
+					write_u32(sample + 8, (samples[i].channel & qualifier_signed) ? 0x80000000 : 0);
+					write_u32(sample + 12, samples[i].upper);
+				}
+
+				return dfd;
+			}
+
+			const TextureSubresource& find_subresource(const TextureResource& texture, uint32_t mip_level, uint32_t array_layer)
+			{
+				return texture.subresources.at(mip_level * texture.array_layers + array_layer);
+			}
+
+		} // anonymous
+
+		TextureResource TextureLoader::load(const std::string& file_name)
+		{
+			return load(std::make_shared<const MappedFileResource>(ResourceManager::map_file(file_name)));
+		}
+
+		TextureResource TextureLoader::load(std::shared_ptr<const MappedFileResource> mapped)
+		{
+			if (mapped->size() >= sizeof(ktx2_identifier) && memcmp(mapped->data(), ktx2_identifier, sizeof(ktx2_identifier)) == 0)
+			{
+				return load_ktx2(mapped);
+			}
+			if (mapped->size() >= 4 && read_u32(mapped->data()) == make_four_cc('D', 'D', 'S', ' '))
+			{
+				return load_dds(mapped);
+			}
+
+			throw std::runtime_error("Unrecognized texture container (expected DDS or KTX2): " + mapped->get_path());
+		}
+
+		TextureResource TextureLoader::load_dds(std::shared_ptr<const MappedFileResource> mapped)
+		{
+			if (mapped->size() < dds_header_size)
+			{
+				throw std::runtime_error("DDS file is truncated: " + mapped->get_path());
+			}
+
+			const uint8_t* header = mapped->data() + 4;
+			const uint32_t height = read_u32(header + 8);
+			const uint32_t width = read_u32(header + 12);
+			const uint32_t depth = read_u32(header + 20);
+			const uint32_t mip_count = read_u32(header + 24);
+			const uint8_t* pixel_format = header + 72;
+			const uint32_t caps2 = read_u32(header + 108);
+
+			TextureResource texture;
+			texture.file = mapped;
+			texture.image_type = (caps2 & dds_caps2_volume) ? vk::ImageType::e3D : vk::ImageType::e2D;
+			texture.extent = { width, std::max(height, 1u), (caps2 & dds_caps2_volume) ? std::max(depth, 1u) : 1u };
+			texture.mip_levels = std::max(mip_count, 1u);
+			texture.is_cube = (caps2 & dds_caps2_cube_map) != 0;
+			texture.array_layers = texture.is_cube ? 6 : 1;
+
+			size_t data_offset = dds_header_size;
+			if ((read_u32(pixel_format + 4) & dds_pixel_format_four_cc) && read_u32(pixel_format + 8) == make_four_cc('D', 'X', '1', '0'))
+			{
+				if (mapped->size() < dds_header_size + dds_dx10_header_size)
+				{
+					throw std::runtime_error("DDS file is truncated: " + mapped->get_path());
+				}
+
+				const uint8_t* dx10_header = mapped->data() + dds_header_size;
+				texture.format = dxgi_to_format(read_u32(dx10_header));
+
+				const uint32_t dimension = read_u32(dx10_header + 4);
+				const uint32_t array_size = std::max(read_u32(dx10_header + 12), 1u);
+				texture.is_cube = (read_u32(dx10_header + 8) & dds_dx10_misc_texture_cube) != 0;
+				texture.array_layers = texture.is_cube ? array_size * 6 : array_size;
+
+				if (dimension == dds_dx10_dimension_texture_1d) texture.image_type = vk::ImageType::e1D;
+				if (dimension == dds_dx10_dimension_texture_3d) texture.image_type = vk::ImageType::e3D;
+				if (texture.image_type != vk::ImageType::e3D) texture.extent.depth = 1;
+
+				data_offset += dds_dx10_header_size;
+			}
+			else
+			{
+				texture.format = legacy_dds_to_format(pixel_format);
+			}
+
+			// DDS files store every mipmap level of the first layer, followed by every level of the second 
+			// layer, and so on.
+			std::vector<size_t> offsets(texture.array_layers * texture.mip_levels);
+			size_t offset = data_offset;
+			for (uint32_t layer = 0; layer < texture.array_layers; ++layer)
+			{
+				for (uint32_t level = 0; level < texture.mip_levels; ++level)
+				{
+					offsets[layer * texture.mip_levels + level] = offset;
+					offset += get_subresource_size(texture.format, get_mip_extent(texture.extent, level));
+				}
+			}
+
+			for (uint32_t level = 0; level < texture.mip_levels; ++level)
+			{
+				const vk::Extent3D mip_extent = get_mip_extent(texture.extent, level);
+				for (uint32_t layer = 0; layer < texture.array_layers; ++layer)
+				{
+					texture.subresources.push_back({ level, layer, mip_extent, offsets[layer * texture.mip_levels + level], get_subresource_size(texture.format, mip_extent) });
+				}
+			}
+
+			check_subresource_bounds(texture, mapped->size());
+
+			return texture;
+		}
+
+		TextureResource TextureLoader::load_ktx2(std::shared_ptr<const MappedFileResource> mapped)
+		{
+			// See: https://github.khronos.org/KTX-Specification/
+			const size_t header_size = 80;
+			if (mapped->size() < header_size)
+			{
+				throw std::runtime_error("KTX2 file is truncated: " + mapped->get_path());
+			}
+
+			const uint8_t* header = mapped->data();
+			const uint32_t vk_format = read_u32(header + 12);
+			const uint32_t width = read_u32(header + 20);
+			const uint32_t height = read_u32(header + 24);
+			const uint32_t depth = read_u32(header + 28);
+			const uint32_t layer_count = read_u32(header + 32);
+			const uint32_t face_count = read_u32(header + 36);
+			const uint32_t level_count = read_u32(header + 40);
+			const uint32_t supercompression_scheme = read_u32(header + 44);
+
+			if (vk_format == VK_FORMAT_UNDEFINED)
+			{
+				throw std::runtime_error("KTX2 files with universal (Basis) encoding are not supported: " + mapped->get_path());
+			}
+			if (supercompression_scheme != 0)
+			{
+				throw std::runtime_error("KTX2 files with supercompression are not supported: " + mapped->get_path());
+			}
+
+			TextureResource texture;
+			texture.file = mapped;
+			texture.format = static_cast<vk::Format>(vk_format);
+			texture.image_type = (height == 0) ? vk::ImageType::e1D : (depth == 0) ? vk::ImageType::e2D : vk::ImageType::e3D;
+			texture.extent = { width, std::max(height, 1u), std::max(depth, 1u) };
+			texture.mip_levels = std::max(level_count, 1u);
+			texture.is_cube = face_count == 6;
+			texture.array_layers = std::max(layer_count, 1u) * std::max(face_count, 1u);
+
+			const size_t level_index_size = 24 * texture.mip_levels;
+			if (mapped->size() < header_size + level_index_size)
+			{
+				throw std::runtime_error("KTX2 file is truncated: " + mapped->get_path());
+			}
+
+			// Each level holds every layer (and face, and depth slice) of that level, back-to-back.
+			for (uint32_t level = 0; level < texture.mip_levels; ++level)
+			{
+				const uint8_t* level_index = header + header_size + level * 24;
+				const size_t level_offset = static_cast<size_t>(read_u64(level_index));
+				const size_t level_size = static_cast<size_t>(read_u64(level_index + 8));
+
+				const vk::Extent3D mip_extent = get_mip_extent(texture.extent, level);
+				const size_t subresource_size = get_subresource_size(texture.format, mip_extent);
+				if (subresource_size * texture.array_layers > level_size)
+				{
+					throw std::runtime_error("KTX2 level " + std::to_string(level) + " is smaller than expected: " + mapped->get_path());
+				}
+
+				for (uint32_t layer = 0; layer < texture.array_layers; ++layer)
+				{
+					texture.subresources.push_back({ level, layer, mip_extent, level_offset + layer * subresource_size, subresource_size });
+				}
+			}
+
+			check_subresource_bounds(texture, mapped->size());
+
+			return texture;
+		}
+
+		bool TextureLoader::can_transcode(vk::Format format)
+		{
+			try
+			{
+				format_to_block_format(format);
+				return true;
+			}
+			catch (const std::runtime_error&)
+			{
+				return false;
+			}
+		}
+
+		vk::Format TextureLoader::get_transcoded_format(vk::Format format)
+		{
+			if (utils::is_block_compressed_format(format))
+			{
+				if (utils::is_signed_block_format(format_to_block_format(format)))
+				{
+					return vk::Format::eR8G8B8A8Snorm;
+				}
+				return utils::is_srgb_format(format) ? vk::Format::eR8G8B8A8Srgb : vk::Format::eR8G8B8A8Unorm;
+			}
+
+			return format;
+		}
+
+		TextureResource TextureLoader::transcode(const TextureResource& texture)
+		{
+			const utils::BlockFormat block_format = format_to_block_format(texture.format);
+			const size_t block_size = utils::get_block_size(block_format);
+
+			TextureResource transcoded;
+			transcoded.format = get_transcoded_format(texture.format);
+			transcoded.image_type = texture.image_type;
+			transcoded.extent = texture.extent;
+			transcoded.array_layers = texture.array_layers;
+			transcoded.mip_levels = texture.mip_levels;
+			transcoded.is_cube = texture.is_cube;
+
+			size_t total_size = 0;
+			for (const auto& subresource : texture.subresources)
+			{
+				const vk::Extent3D& e = subresource.extent;
+				transcoded.subresources.push_back({ subresource.mip_level, subresource.array_layer, e, total_size, static_cast<size_t>(e.width) * e.height * e.depth * 4 });
+				total_size += transcoded.subresources.back().size;
+			}
+			transcoded.contents.resize(total_size);
+
+			for (size_t i = 0; i < texture.subresources.size(); ++i)
+			{
+				const TextureSubresource& src = texture.subresources[i];
+				const TextureSubresource& dst = transcoded.subresources[i];
+				const size_t src_slice_size = static_cast<size_t>((src.extent.width + 3) / 4) * ((src.extent.height + 3) / 4) * block_size;
+				const size_t dst_slice_size = static_cast<size_t>(dst.extent.width) * dst.extent.height * 4;
+
+				for (uint32_t z = 0; z < src.extent.depth; ++z)
+				{
+					utils::decode_blocks(block_format,
+										 texture.data(src) + z * src_slice_size,
+										 src.extent.width,
+										 src.extent.height,
+										 transcoded.contents.data() + dst.offset + z * dst_slice_size,
+										 dst.extent.width * 4);
+				}
+			}
+
+			return transcoded;
+		}
+
+		TextureResource TextureLoader::from_image(const ImageResource& image, bool is_srgb)
+		{
+			if (image.channels < 1 || image.channels > 4)
+			{
+				throw std::runtime_error("Images passed to `from_image()` must have between 1 and 4 channels");
+			}
+
+			TextureResource texture;
+			texture.format = is_srgb ? vk::Format::eR8G8B8A8Srgb : vk::Format::eR8G8B8A8Unorm;
+			texture.image_type = vk::ImageType::e2D;
+			texture.extent = { image.width, image.height, 1 };
+			texture.array_layers = 1;
+			texture.mip_levels = 1;
+			texture.is_cube = false;
+
+			const size_t texel_count = static_cast<size_t>(image.width) * image.height;
+			texture.subresources.push_back({ 0, 0, texture.extent, 0, texel_count * 4 });
+
+			if (image.channels == 4)
+			{
+				texture.contents = image.contents;
+				return texture;
+			}
+
+			texture.contents.resize(texel_count * 4);
+			for (size_t i = 0; i < texel_count; ++i)
+			{
+				const uint8_t* src = image.contents.data() + i * image.channels;
+				uint8_t* dst = texture.contents.data() + i * 4;
+
+				// 1 = grey, 2 = grey + alpha, 3 = RGB.
+				dst[0] = src[0];
+				dst[1] = (image.channels >= 3) ? src[1] : src[0];
+				dst[2] = (image.channels >= 3) ? src[2] : src[0];
+				dst[3] = (image.channels == 2) ? src[1] : 255;
+			}
+
+			return texture;
+		}
+
+		TextureResource TextureLoader::from_image(const std::vector<ImageResource>& mip_chain, bool is_srgb)
+		{
+			if (mip_chain.empty())
+			{
+				throw std::runtime_error("The mip chain passed to `from_image()` must contain at least one image");
+			}
+
+			TextureResource texture = from_image(mip_chain[0], is_srgb);
+			for (uint32_t level = 1; level < mip_chain.size(); ++level)
+			{
+				const TextureResource level_texture = from_image(mip_chain[level], is_srgb);
+				texture.subresources.push_back({ level, 0, level_texture.extent, texture.contents.size(), level_texture.contents.size() });
+				texture.contents.insert(texture.contents.end(), level_texture.contents.begin(), level_texture.contents.end());
+			}
+			texture.mip_levels = static_cast<uint32_t>(mip_chain.size());
+
+			return texture;
+		}
+
+		bool TextureLoader::can_encode(vk::Format format)
+		{
+			return can_transcode(format) && 
+				   utils::is_block_compressed_format(format) && 
+				   utils::is_encodable_block_format(format_to_block_format(format));
+		}
+
+		TextureResource TextureLoader::encode(const TextureResource& texture, vk::Format format, utils::EncodeQuality quality)
+		{
+			if (texture.format != vk::Format::eR8G8B8A8Unorm && texture.format != vk::Format::eR8G8B8A8Srgb)
+			{
+				throw std::runtime_error("Only 8-bit RGBA textures can be encoded, got: " + vk::to_string(texture.format));
+			}
+			if (!can_encode(format))
+			{
+				throw std::runtime_error("No CPU encoder is available for format: " + vk::to_string(format));
+			}
+
+			const utils::BlockFormat block_format = format_to_block_format(format);
+
+			TextureResource encoded;
+			encoded.format = format;
+			encoded.image_type = texture.image_type;
+			encoded.extent = texture.extent;
+			encoded.array_layers = texture.array_layers;
+			encoded.mip_levels = texture.mip_levels;
+			encoded.is_cube = texture.is_cube;
+
+			size_t total_size = 0;
+			for (const auto& subresource : texture.subresources)
+			{
+				encoded.subresources.push_back({ subresource.mip_level, subresource.array_layer, subresource.extent, total_size, get_subresource_size(format, subresource.extent) });
+				total_size += encoded.subresources.back().size;
+			}
+			encoded.contents.resize(total_size);
+
+			// Small mipmap levels only contain a handful of blocks, so subresources are distributed across the
+			// pool as well (`encode_blocks()` is safe to call from within a worker).
+			utils::ThreadPool::global().parallel_for(0, texture.subresources.size(), 1, [&](size_t begin, size_t end)
+			{
+				for (size_t i = begin; i < end; ++i)
+				{
+					const TextureSubresource& src = texture.subresources[i];
+					const TextureSubresource& dst = encoded.subresources[i];
+					const size_t src_slice_size = static_cast<size_t>(src.extent.width) * src.extent.height * 4;
+					const size_t dst_slice_size = dst.size / dst.extent.depth;
+
+					for (uint32_t z = 0; z < src.extent.depth; ++z)
+					{
+						utils::encode_blocks(block_format,
+											 texture.data(src) + z * src_slice_size,
+											 src.extent.width,
+											 src.extent.height,
+											 src.extent.width * 4,
+											 encoded.contents.data() + dst.offset + z * dst_slice_size,
+											 quality);
+					}
+				}
+			});
+
+			return encoded;
+		}
+
+		void TextureLoader::save(const std::string& file_path, const TextureResource& texture)
+		{
+			auto has_extension = [&](const std::string& extension)
+			{
+				if (file_path.size() < extension.size()) return false;
+
+				std::string tail = file_path.substr(file_path.size() - extension.size());
+				std::transform(tail.begin(), tail.end(), tail.begin(), ::tolower);
+				return tail == extension;
+			};
+
+			std::vector<uint8_t> contents;
+			if (has_extension(".dds"))
+			{
+				contents = save_dds(texture);
+			}
+			else if (has_extension(".ktx2"))
+			{
+				contents = save_ktx2(texture);
+			}
+			else
+			{
+				throw std::runtime_error("Unrecognized texture container extension (expected .dds or .ktx2): " + file_path);
+			}
+
+			std::ofstream file(file_path, std::ios::binary | std::ios::trunc);
+			if (!file.is_open() || !file.write(reinterpret_cast<const char*>(contents.data()), contents.size()))
+			{
+				throw std::runtime_error("Failed to write texture file: " + file_path);
+			}
+		}
+
+		std::vector<uint8_t> TextureLoader::save_dds(const TextureResource& texture)
+		{
+			const uint32_t dxgi_format = format_to_dxgi(texture.format);
+			const bool is_volume = texture.image_type == vk::ImageType::e3D;
+
+			size_t data_size = 0;
+			for (const auto& subresource : texture.subresources) data_size += subresource.size;
+
+			std::vector<uint8_t> contents(dds_header_size + dds_dx10_header_size + data_size, 0);
+			write_u32(contents.data(), make_four_cc('D', 'D', 'S', ' '));
+
+			uint8_t* header = contents.data() + 4;
+			const bool is_compressed = utils::is_block_compressed_format(texture.format);
+			uint32_t flags = dds_flags_required | dds_flags_mip_map_count | (is_volume ? dds_flags_depth : 0);
+			flags |= is_compressed ? dds_flags_linear_size : 0;
+
+			write_u32(header, 124);
+			write_u32(header + 4, flags);
+			write_u32(header + 8, texture.extent.height);
+			write_u32(header + 12, texture.extent.width);
+			write_u32(header + 16, static_cast<uint32_t>(is_compressed ? get_subresource_size(texture.format, { texture.extent.width, texture.extent.height, 1 }) : 
+																		  utils::get_format_block_info(texture.format).block_size * texture.extent.width));
+			write_u32(header + 20, is_volume ? texture.extent.depth : 0);
+			write_u32(header + 24, texture.mip_levels);
+
+			uint8_t* pixel_format = header + 72;
+			write_u32(pixel_format, 32);
+			write_u32(pixel_format + 4, dds_pixel_format_four_cc);
+			write_u32(pixel_format + 8, make_four_cc('D', 'X', '1', '0'));
+
+			const bool is_complex = texture.mip_levels > 1 || texture.array_layers > 1 || is_volume;
+			write_u32(header + 104, dds_caps_texture | (is_complex ? dds_caps_complex : 0) | (texture.mip_levels > 1 ? dds_caps_mip_map : 0));
+			write_u32(header + 108, (texture.is_cube ? dds_caps2_cube_map | dds_caps2_all_faces : 0) | (is_volume ? dds_caps2_volume : 0));
+
+			uint8_t* dx10_header = contents.data() + dds_header_size;
+			const uint32_t dimension = (texture.image_type == vk::ImageType::e1D) ? dds_dx10_dimension_texture_1d : 
+									   is_volume ? dds_dx10_dimension_texture_3d : dds_dx10_dimension_texture_2d;
+			write_u32(dx10_header, dxgi_format);
+			write_u32(dx10_header + 4, dimension);
+			write_u32(dx10_header + 8, texture.is_cube ? dds_dx10_misc_texture_cube : 0);
+			write_u32(dx10_header + 12, texture.is_cube ? texture.array_layers / 6 : texture.array_layers);
+
+			// Every mipmap level of the first layer, followed by every level of the second layer, and so on.
+			size_t offset = dds_header_size + dds_dx10_header_size;
+			for (uint32_t layer = 0; layer < texture.array_layers; ++layer)
+			{
+				for (uint32_t level = 0; level < texture.mip_levels; ++level)
+				{
+					const TextureSubresource& subresource = find_subresource(texture, level, layer);
+					memcpy(contents.data() + offset, texture.data(subresource), subresource.size);
+					offset += subresource.size;
+				}
+			}
+
+			return contents;
+		}
+
+		std::vector<uint8_t> TextureLoader::save_ktx2(const TextureResource& texture)
+		{
+			const size_t header_size = 80;
+			const size_t level_index_size = 24 * texture.mip_levels;
+			const std::vector<uint8_t> dfd = build_ktx2_dfd(texture.format);
+
+			// Levels must start at a multiple of both the block size and 4.
+			const utils::FormatBlockInfo info = utils::get_format_block_info(texture.format);
+			size_t alignment = info.block_size;
+			while (alignment % 4 != 0) alignment += info.block_size;
+			auto align = [&](size_t value) { return (value + alignment - 1) / alignment * alignment; };
+
+			// Levels are stored from the smallest to the largest.
+			std::vector<size_t> level_offsets(texture.mip_levels);
+			std::vector<size_t> level_sizes(texture.mip_levels, 0);
+			size_t offset = header_size + level_index_size + dfd.size();
+			for (uint32_t level = texture.mip_levels; level-- > 0; )
+			{
+				for (uint32_t layer = 0; layer < texture.array_layers; ++layer)
+				{
+					level_sizes[level] += find_subresource(texture, level, layer).size;
+				}
+				offset = align(offset);
+				level_offsets[level] = offset;
+				offset += level_sizes[level];
+			}
+
+			std::vector<uint8_t> contents(offset, 0);
+			uint8_t* header = contents.data();
+			const uint32_t face_count = texture.is_cube ? 6 : 1;
+			const uint32_t layer_count = texture.array_layers / face_count;
+
+			memcpy(header, ktx2_identifier, sizeof(ktx2_identifier));
+			write_u32(header + 12, static_cast<uint32_t>(texture.format));
+			write_u32(header + 16, 1);												// type size (bytes)
+			write_u32(header + 20, texture.extent.width);
+			write_u32(header + 24, (texture.image_type == vk::ImageType::e1D) ? 0 : texture.extent.height);
+			write_u32(header + 28, (texture.image_type == vk::ImageType::e3D) ? texture.extent.depth : 0);
+			write_u32(header + 32, (layer_count > 1) ? layer_count : 0);
+			write_u32(header + 36, face_count);
+			write_u32(header + 40, texture.mip_levels);
+			write_u32(header + 44, 0);
+			write_u32(header + 48, static_cast<uint32_t>(header_size + level_index_size));
+			write_u32(header + 52, static_cast<uint32_t>(dfd.size()));
+
+			memcpy(contents.data() + header_size + level_index_size, dfd.data(), dfd.size());
+
+			for (uint32_t level = 0; level < texture.mip_levels; ++level)
+			{
+				uint8_t* level_index = header + header_size + level * 24;
+				write_u64(level_index, level_offsets[level]);
+				write_u64(level_index + 8, level_sizes[level]);
+				write_u64(level_index + 16, level_sizes[level]);
+
+				size_t layer_offset = level_offsets[level];
+				for (uint32_t layer = 0; layer < texture.array_layers; ++layer)
+				{
+					const TextureSubresource& subresource = find_subresource(texture, level, layer);
+					memcpy(contents.data() + layer_offset, texture.data(subresource), subresource.size);
+					layer_offset += subresource.size;
+				}
+			}
+
+			return contents;
+		}
+
+	} // namespace fsys
+
+} // namespace plume
@@ -0,0 +1,221 @@
+/*
+*
+* MIT License
+*
+* Copyright(c) 2017 Michael Walczyk
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files(the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions :
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*
+*/
+
+#include "ThreadPool.h"
+
+#include <algorithm>
+
+namespace plume
+{
+
+	namespace utils
+	{
+
+		ThreadPool::ThreadPool(size_t thread_count) :
+
+			m_active_tasks(0),
+			m_stopping(false)
+		{
+			// `hardware_concurrency()` is allowed to return 0 if the value is not computable.
+			thread_count = std::max<size_t>(thread_count, 1);
+
+			m_workers.reserve(thread_count);
+			for (size_t i = 0; i < thread_count; ++i)
+			{
+				m_workers.emplace_back(&ThreadPool::worker_loop, this);
+			}
+		}
+
+		ThreadPool::~ThreadPool()
+		{
+			{
+				std::lock_guard<std::mutex> lock(m_mutex);
+				m_stopping = true;
+			}
+			m_task_available.notify_all();
+
+			for (auto& worker : m_workers)
+			{
+				worker.join();
+			}
+		}
+
+		void ThreadPool::enqueue(std::function<void()> task, TaskPriority priority)
+		{
+			{
+				std::lock_guard<std::mutex> lock(m_mutex);
+				if (m_stopping)
+				{
+					throw std::runtime_error("Attempting to submit a task to a thread pool that is shutting down");
+				}
+				m_queues[static_cast<size_t>(priority)].push_back(std::move(task));
+			}
+			m_task_available.notify_one();
+		}
+
+		bool ThreadPool::pop_task(std::function<void()>& task)
+		{
+			for (auto& queue : m_queues)
+			{
+				if (!queue.empty())
+				{
+					task = std::move(queue.front());
+					queue.pop_front();
+					return true;
+				}
+			}
+
+			return false;
+		}
+
+		void ThreadPool::worker_loop()
+		{
+			while (true)
+			{
+				std::function<void()> task;
+				{
+					std::unique_lock<std::mutex> lock(m_mutex);
+					m_task_available.wait(lock, [this]() { return m_stopping || get_pending_task_count_unlocked() > 0; });
+
+					// Keep draining the queues on shutdown, so that no future is left without a value.
+					if (!pop_task(task))
+					{
+						return;
+					}
+					++m_active_tasks;
+				}
+
+				// Any exception thrown by the task is captured by its packaged task (and rethrown from the future).
+				task();
+
+				{
+					std::lock_guard<std::mutex> lock(m_mutex);
+					--m_active_tasks;
+					if (m_active_tasks == 0 && get_pending_task_count_unlocked() == 0)
+					{
+						m_idle.notify_all();
+					}
+				}
+			}
+		}
+
+		void ThreadPool::parallel_for(size_t begin, size_t end, size_t grain_size, const std::function<void(size_t, size_t)>& func)
+		{
+			if (begin >= end)
+			{
+				return;
+			}
+
+			grain_size = std::max<size_t>(grain_size, 1);
+			const size_t chunk_count = (end - begin + grain_size - 1) / grain_size;
+
+			// Chunks are claimed through a shared counter, so the calling thread can work on the same range as the
+			// workers. This also means that nested calls (i.e. from inside of a task) cannot deadlock: the caller
+			// will simply process every chunk itself if all of the workers are busy.
+			struct SharedState
+			{
+				std::atomic<size_t> next_chunk{ 0 };
+				std::atomic<size_t> completed_chunks{ 0 };
+				std::mutex mutex;
+				std::condition_variable done;
+				std::exception_ptr exception;
+			};
+			auto state = std::make_shared<SharedState>();
+
+			auto run_chunks = [=, &func]()
+			{
+				size_t chunk;
+				while ((chunk = state->next_chunk.fetch_add(1)) < chunk_count)
+				{
+					const size_t chunk_begin = begin + chunk * grain_size;
+					const size_t chunk_end = std::min(chunk_begin + grain_size, end);
+
+					try
+					{
+						func(chunk_begin, chunk_end);
+					}
+					catch (...)
+					{
+						std::lock_guard<std::mutex> lock(state->mutex);
+						if (!state->exception)
+						{
+							state->exception = std::current_exception();
+						}
+					}
+
+					if (state->completed_chunks.fetch_add(1) + 1 == chunk_count)
+					{
+						std::lock_guard<std::mutex> lock(state->mutex);
+						state->done.notify_all();
+					}
+				}
+			};
+
+			// Wake up (at most) one helper per remaining chunk.
+			const size_t helper_count = std::min(chunk_count - 1, m_workers.size());
+			for (size_t i = 0; i < helper_count; ++i)
+			{
+				enqueue(run_chunks, TaskPriority::PRIORITY_HIGH);
+			}
+
+			run_chunks();
+
+			{
+				std::unique_lock<std::mutex> lock(state->mutex);
+				state->done.wait(lock, [&]() { return state->completed_chunks.load() == chunk_count; });
+			}
+
+			if (state->exception)
+			{
+				std::rethrow_exception(state->exception);
+			}
+		}
+
+		void ThreadPool::wait_idle()
+		{
+			std::unique_lock<std::mutex> lock(m_mutex);
+			m_idle.wait(lock, [this]() { return m_active_tasks == 0 && get_pending_task_count_unlocked() == 0; });
+		}
+
+		size_t ThreadPool::get_pending_task_count() const
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			return get_pending_task_count_unlocked();
+		}
+
+		size_t ThreadPool::get_pending_task_count_unlocked() const
+		{
+			size_t count = 0;
+			for (const auto& queue : m_queues)
+			{
+				count += queue.size();
+			}
+			return count;
+		}
+
+	} // namespace utils
+
+} // namespace plume
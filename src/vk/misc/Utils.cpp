@@ -60,6 +60,100 @@ namespace plume
 			return image_aspect_flags;
 		}
 
+		FormatBlockInfo get_format_block_info(vk::Format format)
+		{
+			// The block-compressed formats are contiguous ranges in the vk::Format enum.
+			const int value = static_cast<int>(format);
+			if (value >= VK_FORMAT_BC1_RGB_UNORM_BLOCK && value <= VK_FORMAT_BC7_SRGB_BLOCK)
+			{
+				const bool is_8_bytes = value <= VK_FORMAT_BC1_RGBA_SRGB_BLOCK || value == VK_FORMAT_BC4_UNORM_BLOCK || value == VK_FORMAT_BC4_SNORM_BLOCK;
+				return{ 4, 4, is_8_bytes ? 8u : 16u };
+			}
+			if (value >= VK_FORMAT_ETC2_R8G8B8_UNORM_BLOCK && value <= VK_FORMAT_EAC_R11G11_SNORM_BLOCK)
+			{
+				const bool is_16_bytes = value == VK_FORMAT_ETC2_R8G8B8A8_UNORM_BLOCK || value == VK_FORMAT_ETC2_R8G8B8A8_SRGB_BLOCK ||
+										 value == VK_FORMAT_EAC_R11G11_UNORM_BLOCK || value == VK_FORMAT_EAC_R11G11_SNORM_BLOCK;
+				return{ 4, 4, is_16_bytes ? 16u : 8u };
+			}
+			if (value >= VK_FORMAT_ASTC_4x4_UNORM_BLOCK && value <= VK_FORMAT_ASTC_12x12_SRGB_BLOCK)
+			{
+				// Every ASTC block is 16 bytes: only the footprint varies (UNORM and SRGB variants alternate).
+				static const uint32_t footprints[14][2] =
+				{
+					{ 4, 4 }, { 5, 4 }, { 5, 5 }, { 6, 5 }, { 6, 6 }, { 8, 5 }, { 8, 6 },
+					{ 8, 8 }, { 10, 5 }, { 10, 6 }, { 10, 8 }, { 10, 10 }, { 12, 10 }, { 12, 12 }
+				};
+				const uint32_t* footprint = footprints[(value - VK_FORMAT_ASTC_4x4_UNORM_BLOCK) / 2];
+				return{ footprint[0], footprint[1], 16 };
+			}
+
+			switch (format)
+			{
+			case vk::Format::eR8Unorm:
+			case vk::Format::eR8Snorm:
+				return{ 1, 1, 1 };
+			case vk::Format::eR8G8Unorm:
+			case vk::Format::eR8G8Snorm:
+			case vk::Format::eR16Sfloat:
+			case vk::Format::eR16Unorm:
+				return{ 1, 1, 2 };
+			case vk::Format::eR8G8B8A8Unorm:
+			case vk::Format::eR8G8B8A8Snorm:
+			case vk::Format::eR8G8B8A8Srgb:
+			case vk::Format::eB8G8R8A8Unorm:
+			case vk::Format::eB8G8R8A8Srgb:
+			case vk::Format::eA2B10G10R10UnormPack32:
+			case vk::Format::eB10G11R11UfloatPack32:
+			case vk::Format::eE5B9G9R9UfloatPack32:
+			case vk::Format::eR16G16Sfloat:
+			case vk::Format::eR16G16Unorm:
+			case vk::Format::eR32Sfloat:
+				return{ 1, 1, 4 };
+			case vk::Format::eR16G16B16A16Sfloat:
+			case vk::Format::eR16G16B16A16Unorm:
+			case vk::Format::eR32G32Sfloat:
+				return{ 1, 1, 8 };
+			case vk::Format::eR32G32B32Sfloat:
+				return{ 1, 1, 12 };
+			case vk::Format::eR32G32B32A32Sfloat:
+				return{ 1, 1, 16 };
+			default:
+				throw std::runtime_error("Unsupported format passed to `get_format_block_info()`: " + vk::to_string(format));
+			}
+		}
+
+		bool is_block_compressed_format(vk::Format format)
+		{
+			const int value = static_cast<int>(format);
+			return value >= VK_FORMAT_BC1_RGB_UNORM_BLOCK && value <= VK_FORMAT_ASTC_12x12_SRGB_BLOCK;
+		}
+
+		bool is_srgb_format(vk::Format format)
+		{
+			const int value = static_cast<int>(format);
+			if (value >= VK_FORMAT_ASTC_4x4_UNORM_BLOCK && value <= VK_FORMAT_ASTC_12x12_SRGB_BLOCK)
+			{
+				return (value - VK_FORMAT_ASTC_4x4_UNORM_BLOCK) % 2 == 1;
+			}
+
+			switch (format)
+			{
+			case vk::Format::eR8G8B8A8Srgb:
+			case vk::Format::eB8G8R8A8Srgb:
+			case vk::Format::eBc1RgbSrgbBlock:
+			case vk::Format::eBc1RgbaSrgbBlock:
+			case vk::Format::eBc2SrgbBlock:
+			case vk::Format::eBc3SrgbBlock:
+			case vk::Format::eBc7SrgbBlock:
+			case vk::Format::eEtc2R8G8B8SrgbBlock:
+			case vk::Format::eEtc2R8G8B8A1SrgbBlock:
+			case vk::Format::eEtc2R8G8B8A8SrgbBlock:
+				return true;
+			default:
+				return false;
+			}
+		}
+
 		vk::SampleCountFlagBits sample_count_to_flags(uint32_t count)
 		{
 			switch (count)
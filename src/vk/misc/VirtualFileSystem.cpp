@@ -0,0 +1,452 @@
+/*
+*
+* MIT License
+*
+* Copyright(c) 2017 Michael Walczyk
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files(the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions :
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*
+*/
+
+#include "VirtualFileSystem.h"
+
+#include <algorithm>
+#include <cctype>
+#include <fstream>
+#include <limits>
+#include <stdexcept>
+
+#if defined(_WIN32)
+	#ifndef NOMINMAX
+		#define NOMINMAX
+	#endif
+	#include <windows.h>
+#else
+	#include <fcntl.h>
+	#include <sys/stat.h>
+	#include <unistd.h>
+#endif
+
+namespace plume
+{
+
+	namespace fsys
+	{
+
+		FileResource MountPoint::read(const std::string& file_name) const
+		{
+			const MappedFileResource mapped = map(file_name, MappedFileResource::AccessPattern::ACCESS_SEQUENTIAL);
+
+			return { std::vector<uint8_t>(mapped.begin(), mapped.end()) };
+		}
+
+		DirectoryMount::DirectoryMount(const std::string& root) :
+
+			m_root(root)
+		{
+			if (!m_root.empty() && m_root.back() != '/' && m_root.back() != '\\')
+			{
+				m_root += '/';
+			}
+		}
+
+		bool DirectoryMount::exists(const std::string& file_name) const
+		{
+			const std::string path = get_full_path(file_name);
+
+#if defined(_WIN32)
+			const DWORD attributes = GetFileAttributesA(path.c_str());
+			return attributes != INVALID_FILE_ATTRIBUTES && !(attributes & FILE_ATTRIBUTE_DIRECTORY);
+#else
+			struct stat file_stat;
+			return stat(path.c_str(), &file_stat) == 0 && S_ISREG(file_stat.st_mode);
+#endif
+		}
+
+		MappedFileResource DirectoryMount::map(const std::string& file_name, MappedFileResource::AccessPattern access_pattern) const
+		{
+			return MappedFileResource{ get_full_path(file_name), access_pattern };
+		}
+
+		FileResource DirectoryMount::read(const std::string& file_name) const
+		{
+			const std::string path = get_full_path(file_name);
+
+			std::ifstream file(path, std::ios::ate | std::ios::binary);
+			if (!file.is_open())
+			{
+				throw std::runtime_error("Failed to load file: " + path);
+			}
+
+			size_t total_size = static_cast<size_t>(file.tellg());
+			file.seekg(0);
+
+			FileResource resource = { std::vector<uint8_t>(total_size) };
+			file.read(reinterpret_cast<char*>(resource.contents.data()), total_size);
+
+			return resource;
+		}
+
+		void DirectoryMount::prefetch(const std::string& file_name) const
+		{
+			const std::string path = get_full_path(file_name);
+
+#if defined(_WIN32)
+			// There is no file-level read-ahead hint on Windows, so map the file and prefetch the mapping instead.
+			// The pages stay in the standby list after the view is unmapped.
+			try
+			{
+				MappedFileResource mapped{ path, MappedFileResource::AccessPattern::ACCESS_WILL_NEED };
+			}
+			catch (const std::exception&)
+			{
+			}
+#else
+			int fd = open(path.c_str(), O_RDONLY);
+			if (fd < 0)
+			{
+				return;
+			}
+
+	#if defined(__linux__)
+			// `readahead()` queues the reads and returns without waiting for them to complete.
+			struct stat file_stat;
+			if (fstat(fd, &file_stat) == 0)
+			{
+				readahead(fd, 0, static_cast<size_t>(file_stat.st_size));
+			}
+	#elif defined(__APPLE__)
+			struct stat file_stat;
+			if (fstat(fd, &file_stat) == 0)
+			{
+				radvisory advisory;
+				advisory.ra_offset = 0;
+				advisory.ra_count = static_cast<int>(std::min<off_t>(file_stat.st_size, std::numeric_limits<int>::max()));
+				fcntl(fd, F_RDADVISE, &advisory);
+			}
+	#else
+			posix_fadvise(fd, 0, 0, POSIX_FADV_WILLNEED);
+	#endif
+
+			close(fd);
+#endif
+		}
+
+		ArchiveMount::ArchiveMount(const std::string& path) :
+
+			m_archive(path)
+		{
+		}
+
+		void MemoryMount::add_file(const std::string& file_name, std::vector<uint8_t> contents)
+		{
+			auto file = std::make_shared<const std::vector<uint8_t>>(std::move(contents));
+
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_files[PackArchive::normalize_path(file_name)] = file;
+		}
+
+		bool MemoryMount::remove_file(const std::string& file_name)
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			return m_files.erase(PackArchive::normalize_path(file_name)) > 0;
+		}
+
+		void MemoryMount::clear()
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_files.clear();
+		}
+
+		bool MemoryMount::exists(const std::string& file_name) const
+		{
+			return find(file_name) != nullptr;
+		}
+
+		MappedFileResource MemoryMount::map(const std::string& file_name, MappedFileResource::AccessPattern /* access_pattern */) const
+		{
+			auto file = find(file_name);
+			if (!file)
+			{
+				throw std::runtime_error("In-memory mount point does not contain: " + file_name);
+			}
+
+			return MappedFileResource::from_memory("memory:" + file_name, file->data(), file->size(), file, false);
+		}
+
+		std::shared_ptr<const std::vector<uint8_t>> MemoryMount::find(const std::string& file_name) const
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+
+			auto it = m_files.find(file_name);
+			return it != m_files.end() ? it->second : nullptr;
+		}
+
+		VirtualFileSystem::VirtualFileSystem() :
+
+			m_mounts(std::make_shared<const MountList>()),
+			m_next_mount_id(0),
+			m_prefetch_active(false),
+			m_stopping(false)
+		{
+			m_prefetch_thread = std::thread(&VirtualFileSystem::prefetch_loop, this);
+		}
+
+		VirtualFileSystem::~VirtualFileSystem()
+		{
+			{
+				std::lock_guard<std::mutex> lock(m_prefetch_mutex);
+				m_stopping = true;
+				m_prefetch_queue.clear();
+			}
+			m_prefetch_available.notify_all();
+
+			m_prefetch_thread.join();
+		}
+
+		VirtualFileSystem::MountId VirtualFileSystem::mount(std::shared_ptr<const MountPoint> mount_point, int priority)
+		{
+			if (!mount_point)
+			{
+				throw std::runtime_error("Attempting to mount a null mount point");
+			}
+
+			std::lock_guard<std::mutex> lock(m_mount_mutex);
+
+			// Copy-on-write: lookups that are in flight keep using the previous list.
+			auto mounts = std::make_shared<MountList>(*m_mounts);
+			const MountId id = m_next_mount_id++;
+
+			// Insert before the first mount point with a lower or equal priority, so that among equal priorities 
+			// the newest mount point is searched first.
+			auto position = std::find_if(mounts->begin(), mounts->end(), [&](const MountRecord& record)
+			{
+				return record.priority <= priority;
+			});
+			mounts->insert(position, { id, priority, std::move(mount_point) });
+
+			m_mounts = mounts;
+
+			return id;
+		}
+
+		VirtualFileSystem::MountId VirtualFileSystem::mount_directory(const std::string& root, int priority)
+		{
+			return mount(std::make_shared<const DirectoryMount>(root), priority);
+		}
+
+		VirtualFileSystem::MountId VirtualFileSystem::mount_archive(const std::string& path, int priority)
+		{
+			return mount(std::make_shared<const ArchiveMount>(path), priority);
+		}
+
+		VirtualFileSystem::MountId VirtualFileSystem::mount_memory(std::shared_ptr<MemoryMount> memory_mount, int priority)
+		{
+			return mount(std::move(memory_mount), priority);
+		}
+
+		bool VirtualFileSystem::unmount(MountId id)
+		{
+			std::lock_guard<std::mutex> lock(m_mount_mutex);
+
+			auto mounts = std::make_shared<MountList>(*m_mounts);
+			auto it = std::find_if(mounts->begin(), mounts->end(), [&](const MountRecord& record)
+			{
+				return record.id == id;
+			});
+
+			if (it == mounts->end())
+			{
+				return false;
+			}
+
+			mounts->erase(it);
+			m_mounts = mounts;
+
+			return true;
+		}
+
+		void VirtualFileSystem::unmount_all()
+		{
+			std::lock_guard<std::mutex> lock(m_mount_mutex);
+			m_mounts = std::make_shared<const MountList>();
+		}
+
+		size_t VirtualFileSystem::get_mount_count() const
+		{
+			return get_mounts()->size();
+		}
+
+		std::shared_ptr<const MountPoint> VirtualFileSystem::resolve(const std::string& file_name) const
+		{
+			const auto mounts = get_mounts();
+			const std::string normalized = PackArchive::normalize_path(file_name);
+
+			for (const auto& record : *mounts)
+			{
+				if (record.mount_point->exists(normalized))
+				{
+					return record.mount_point;
+				}
+			}
+
+			return nullptr;
+		}
+
+		MappedFileResource VirtualFileSystem::map_file(const std::string& file_name, MappedFileResource::AccessPattern access_pattern) const
+		{
+			auto mount_point = resolve(file_name);
+			if (!mount_point)
+			{
+				throw std::runtime_error("File not found in any mount point: " + file_name);
+			}
+
+			return mount_point->map(PackArchive::normalize_path(file_name), access_pattern);
+		}
+
+		FileResource VirtualFileSystem::read_file(const std::string& file_name) const
+		{
+			auto mount_point = resolve(file_name);
+			if (!mount_point)
+			{
+				throw std::runtime_error("File not found in any mount point: " + file_name);
+			}
+
+			return mount_point->read(PackArchive::normalize_path(file_name));
+		}
+
+		std::string VirtualFileSystem::get_disk_path(const std::string& file_name) const
+		{
+			auto mount_point = resolve(file_name);
+			return mount_point ? mount_point->get_disk_path(PackArchive::normalize_path(file_name)) : std::string();
+		}
+
+		void VirtualFileSystem::prefetch(const std::vector<std::string>& file_names)
+		{
+			if (file_names.empty())
+			{
+				return;
+			}
+
+			{
+				std::lock_guard<std::mutex> lock(m_prefetch_mutex);
+				m_prefetch_queue.insert(m_prefetch_queue.end(), file_names.begin(), file_names.end());
+			}
+			m_prefetch_available.notify_one();
+		}
+
+		size_t VirtualFileSystem::prefetch_manifest(const std::string& manifest_name)
+		{
+			const MappedFileResource manifest = map_file(manifest_name);
+
+			std::vector<std::string> file_names;
+			const char* it = reinterpret_cast<const char*>(manifest.begin());
+			const char* const end = reinterpret_cast<const char*>(manifest.end());
+			while (it < end)
+			{
+				const char* line_end = std::find(it, end, '\n');
+
+				// Trim surrounding whitespace (including the '\r' of Windows line endings).
+				const char* first = it;
+				const char* last = line_end;
+				while (first < last && isspace(static_cast<unsigned char>(*first))) ++first;
+				while (last > first && isspace(static_cast<unsigned char>(*(last - 1)))) --last;
+
+				if (first < last && *first != '#')
+				{
+					file_names.emplace_back(first, last);
+				}
+
+				it = line_end + 1;
+			}
+
+			prefetch(file_names);
+
+			return file_names.size();
+		}
+
+		void VirtualFileSystem::cancel_prefetch()
+		{
+			{
+				std::lock_guard<std::mutex> lock(m_prefetch_mutex);
+				m_prefetch_queue.clear();
+			}
+			m_prefetch_idle.notify_all();
+		}
+
+		void VirtualFileSystem::wait_prefetch_idle()
+		{
+			std::unique_lock<std::mutex> lock(m_prefetch_mutex);
+			m_prefetch_idle.wait(lock, [this]() { return m_prefetch_queue.empty() && !m_prefetch_active; });
+		}
+
+		size_t VirtualFileSystem::get_pending_prefetch_count() const
+		{
+			std::lock_guard<std::mutex> lock(m_prefetch_mutex);
+			return m_prefetch_queue.size();
+		}
+
+		std::shared_ptr<const VirtualFileSystem::MountList> VirtualFileSystem::get_mounts() const
+		{
+			std::lock_guard<std::mutex> lock(m_mount_mutex);
+			return m_mounts;
+		}
+
+		void VirtualFileSystem::prefetch_loop()
+		{
+			while (true)
+			{
+				std::string file_name;
+				{
+					std::unique_lock<std::mutex> lock(m_prefetch_mutex);
+					m_prefetch_active = false;
+					if (m_prefetch_queue.empty())
+					{
+						m_prefetch_idle.notify_all();
+					}
+
+					m_prefetch_available.wait(lock, [this]() { return m_stopping || !m_prefetch_queue.empty(); });
+					if (m_stopping)
+					{
+						return;
+					}
+
+					file_name = std::move(m_prefetch_queue.front());
+					m_prefetch_queue.pop_front();
+					m_prefetch_active = true;
+				}
+
+				// Prefetching is purely an optimization: a file that can't be found or read is simply skipped (the 
+				// error will surface when the file is actually loaded).
+				try
+				{
+					if (auto mount_point = resolve(file_name))
+					{
+						mount_point->prefetch(PackArchive::normalize_path(file_name));
+					}
+				}
+				catch (const std::exception&)
+				{
+				}
+			}
+		}
+
+	} // namespace fsys
+
+} // namespace plume
@@ -0,0 +1,84 @@
+/*
+*
+* MIT License
+*
+* Copyright(c) 2017 Michael Walczyk
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files(the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions :
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*
+*/
+
+#include "BufferLayout.h"
+
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+
+namespace plume
+{
+
+	namespace graphics
+	{
+
+		void validate_buffer_layout(const ShaderModule::BlockLayout& block, const std::vector<BufferMemberLayout>& members, uint32_t declared_size)
+		{
+			if (block.members.size() != members.size())
+			{
+				throw std::runtime_error("Block " + block.name + " has " + std::to_string(block.members.size()) + " member(s) (including nested members), but its layout describes " + std::to_string(members.size()));
+			}
+
+			for (size_t i = 0; i < members.size(); ++i)
+			{
+				const ShaderModule::BlockMember& reflected = block.members[i];
+				const BufferMemberLayout& member = members[i];
+
+				auto check = [&](const char* property, uint32_t reflected_value, uint32_t value)
+				{
+					if (reflected_value != value)
+					{
+						throw std::runtime_error("Member " + reflected.name + " of block " + block.name + " has " + property + " " + std::to_string(reflected_value) + 
+												 " in the shader, but " + std::to_string(value) + " in its layout");
+					}
+				};
+
+				check("offset", reflected.offset, member.offset);
+				check("array stride", reflected.array_stride, member.array_stride);
+				check("matrix stride", reflected.matrix_stride, member.matrix_stride);
+
+				// The reflected size of a struct that isn't an array is not rounded up to the struct's alignment, so
+				// it is covered by the checks on its nested members instead. Runtime arrays have no size.
+				const bool is_sized = reflected.array_size != ShaderModule::runtime_array_size && !(member.is_struct && member.array_stride == 0);
+				if (is_sized)
+				{
+					check("size", reflected.size, member.size);
+				}
+			}
+
+			// The reflected size of a block excludes a runtime array at its end, which is described by an array of 
+			// one element instead.
+			const bool has_runtime_array = std::any_of(block.members.begin(), block.members.end(), [](const ShaderModule::BlockMember& member) { return member.array_size == ShaderModule::runtime_array_size; });
+			if (!has_runtime_array && block.size != declared_size)
+			{
+				throw std::runtime_error("Block " + block.name + " is " + std::to_string(block.size) + " bytes in the shader, but " + std::to_string(declared_size) + " bytes in its layout");
+			}
+		}
+
+	} // namespace graphics
+
+} // namespace plume
@@ -205,6 +205,27 @@ namespace plume
 			get_handle().clearDepthStencilImage(image.get_handle(), image.get_current_layout(), clear_value, image_subresource_range);
 		}
 
+		void CommandBuffer::copy_buffer_to_image(const Buffer& buffer, const Image& image, const std::vector<vk::BufferImageCopy>& regions)
+		{
+			check_recording_state();
+
+			if (!(buffer.get_buffer_usage_flags() & vk::BufferUsageFlagBits::eTransferSrc))
+			{
+				throw std::runtime_error("Attempting to copy from a buffer that was not created with usage flags vk::BufferUsageFlagBits::eTransferSrc");
+			}
+			if (!(image.get_image_usage_flags() & vk::ImageUsageFlagBits::eTransferDst))
+			{
+				throw std::runtime_error("Attempting to copy into an image that was not created with usage flags vk::ImageUsageFlagBits::eTransferDst");
+			}
+			if (image.get_current_layout() != vk::ImageLayout::eTransferDstOptimal &&
+				image.get_current_layout() != vk::ImageLayout::eGeneral)
+			{
+				throw std::runtime_error("Attempting to copy into an image that is not in layout vk::ImageLayout::eTransferDstOptimal or vk::ImageLayout::eGeneral");
+			}
+
+			get_handle().copyBufferToImage(buffer.get_handle(), image.get_handle(), image.get_current_layout(), regions);
+		}
+
 		void CommandBuffer::transition_image_layout(const Image& image,
 			vk::ImageLayout from,
 			vk::ImageLayout to,
@@ -260,8 +281,7 @@ namespace plume
 				image_memory_barrier.srcAccessMask = vk::AccessFlagBits::eDepthStencilAttachmentRead;
 				break;
 			case vk::ImageLayout::eShaderReadOnlyOptimal:
-				if (!(image.get_image_usage_flags() & vk::ImageUsageFlagBits::eSampled) ||
-					!(image.get_image_usage_flags() & vk::ImageUsageFlagBits::eInputAttachment))
+				if (!(image.get_image_usage_flags() & (vk::ImageUsageFlagBits::eSampled | vk::ImageUsageFlagBits::eInputAttachment)))
 				{
 					throw std::runtime_error("Attempting to create an image memory barrier with `oldLayout` vk::ImageLayout::eShaderReadOnlyOptimal,\
 										      but this image was not created with usage flags vk::ImageUsageFlagBits::eSampled or vk::ImageUsageFlagBits::eInputAttachment");
@@ -339,8 +359,7 @@ namespace plume
 				image_memory_barrier.dstAccessMask = vk::AccessFlagBits::eDepthStencilAttachmentRead;
 				break;
 			case vk::ImageLayout::eShaderReadOnlyOptimal:
-				if (!(image.get_image_usage_flags() & vk::ImageUsageFlagBits::eSampled) ||
-					!(image.get_image_usage_flags() & vk::ImageUsageFlagBits::eInputAttachment))
+				if (!(image.get_image_usage_flags() & (vk::ImageUsageFlagBits::eSampled | vk::ImageUsageFlagBits::eInputAttachment)))
 				{
 					throw std::runtime_error("Attempting to create an image memory barrier with `newLayout` vk::ImageLayout::eShaderReadOnlyOptimal,\
 										      but this image was not created with usage flags vk::ImageUsageFlagBits::eSampled or vk::ImageUsageFlagBits::eInputAttachment");
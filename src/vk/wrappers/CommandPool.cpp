@@ -34,7 +34,8 @@ namespace plume
 
 		CommandPool::CommandPool(const Device& device, QueueType queue_type, vk::CommandPoolCreateFlags command_pool_create_flags) :
 
-			m_device_ptr(&device)
+			m_device_ptr(&device),
+			m_queue_type(queue_type)
 		{
 			vk::CommandPoolCreateInfo command_pool_create_info;
 			command_pool_create_info.flags = command_pool_create_flags;
@@ -25,6 +25,10 @@
 */
 
 #include "Device.h"
+
+#include <algorithm>
+#include <cstring>
+
 #include "CommandBuffer.h"
 #include "Synchronization.h"
 #include "Swapchain.h"
@@ -38,7 +42,8 @@ namespace plume
 					   vk::SurfaceKHR surface, 
 					   vk::QueueFlags required_queue_flags, 
 					   bool use_swapchain, 
-					   const std::vector<const char*>& required_device_extensions) :
+					   const std::vector<const char*>& required_device_extensions,
+					   uint32_t instance_api_version) :
 
 			m_required_device_extensions(required_device_extensions)
 		{
@@ -153,6 +158,31 @@ namespace plume
 				enabled_features.geometryShader = VK_TRUE;
 			}*/
 
+			// Timeline semaphores are core in Vulkan 1.2 and available through VK_KHR_timeline_semaphore on Vulkan 1.1 
+			// (querying the feature requires vkGetPhysicalDeviceFeatures2, which is core in Vulkan 1.1). Either way, they
+			// have to be enabled as a feature. The device can only use the lower of its own and the instance's version.
+			const uint32_t api_version = std::min(instance_api_version, m_gpu_details.m_properties.apiVersion);
+			const bool use_timeline_semaphore_extension = api_version < VK_API_VERSION_1_2 && 
+														  std::any_of(m_gpu_details.m_extension_properties.begin(), m_gpu_details.m_extension_properties.end(), [](const vk::ExtensionProperties& properties) {
+															  return strcmp(properties.extensionName, VK_KHR_TIMELINE_SEMAPHORE_EXTENSION_NAME) == 0;
+														  });
+
+			vk::PhysicalDeviceTimelineSemaphoreFeatures timeline_semaphore_features;
+			if (api_version >= VK_API_VERSION_1_2 || (api_version >= VK_API_VERSION_1_1 && use_timeline_semaphore_extension))
+			{
+				vk::PhysicalDeviceFeatures2 features;
+				features.pNext = &timeline_semaphore_features;
+				m_gpu_details.m_handle.getFeatures2(&features);
+
+				m_supports_timeline_semaphores = timeline_semaphore_features.timelineSemaphore == VK_TRUE;
+				timeline_semaphore_features.pNext = nullptr;
+
+				if (m_supports_timeline_semaphores && use_timeline_semaphore_extension)
+				{
+					m_required_device_extensions.push_back(VK_KHR_TIMELINE_SEMAPHORE_EXTENSION_NAME);
+				}
+			}
+
 			// Create the logical device: note that device layers were deprecated, and device layer 
 			// requests should be ignored by the driver. 
 			// See: https://www.khronos.org/registry/vulkan/specs/1.0/html/vkspec.html#extended-functionality-device-layer-deprecation
@@ -162,9 +192,24 @@ namespace plume
 			device_create_info.ppEnabledExtensionNames = m_required_device_extensions.data();
 			device_create_info.pQueueCreateInfos = device_queue_create_infos.data();
 			device_create_info.queueCreateInfoCount = static_cast<uint32_t>(device_queue_create_infos.size());
+			if (m_supports_timeline_semaphores)
+			{
+				device_create_info.pNext = &timeline_semaphore_features;
+			}
 
 			m_device_handle = m_gpu_details.m_handle.createDeviceUnique(device_create_info);
 
+			if (m_supports_timeline_semaphores)
+			{
+				// The extension's entry points have the same signatures as the core ones, just with a suffix.
+				const std::string suffix = use_timeline_semaphore_extension ? "KHR" : "";
+				auto device_handle = m_device_handle.get();
+
+				m_timeline_semaphore_functions.get_semaphore_counter_value = (PFN_vkGetSemaphoreCounterValue)vkGetDeviceProcAddr(device_handle, ("vkGetSemaphoreCounterValue" + suffix).c_str());
+				m_timeline_semaphore_functions.wait_semaphores = (PFN_vkWaitSemaphores)vkGetDeviceProcAddr(device_handle, ("vkWaitSemaphores" + suffix).c_str());
+				m_timeline_semaphore_functions.signal_semaphore = (PFN_vkSignalSemaphore)vkGetDeviceProcAddr(device_handle, ("vkSignalSemaphore" + suffix).c_str());
+			}
+
 			// Store handles to each of the newly created queues.
 			m_queue_families_mapping[QueueType::GRAPHICS].handle = m_device_handle->getQueue(m_queue_families_mapping[QueueType::GRAPHICS].index, 0);
 			m_queue_families_mapping[QueueType::COMPUTE].handle = m_device_handle->getQueue(m_queue_families_mapping[QueueType::COMPUTE].index, 0);
@@ -260,20 +305,56 @@ namespace plume
 											const Fence& fence,
 											vk::PipelineStageFlags pipeline_stage_flags)
 		{
-			auto command_buffer_handle = command_buffer.get_handle();
-			auto wait_handle = wait.get_handle();
-			auto signal_handle = signal.get_handle();
+			submit(type, { Submission().command_buffer(command_buffer).wait(wait, pipeline_stage_flags).signal(signal) }, fence);
+		}
 
-			vk::SubmitInfo submit_info = {};
-			submit_info.waitSemaphoreCount = 1;
-			submit_info.pWaitSemaphores = &wait_handle;
-			submit_info.pWaitDstStageMask = &pipeline_stage_flags;
-			submit_info.commandBufferCount = 1;
-			submit_info.pCommandBuffers = &command_buffer_handle;
-			submit_info.signalSemaphoreCount = 1;
-			submit_info.pSignalSemaphores = &signal_handle;
+		void Device::submit(QueueType type, const std::vector<Submission>& submissions)
+		{
+			submit(type, submissions, {});
+		}
+
+		void Device::submit(QueueType type, const std::vector<Submission>& submissions, const Fence& fence)
+		{
+			// The submit infos point into both the submissions and the timeline infos, so the latter must not reallocate
+			// while they are being filled out.
+			std::vector<vk::SubmitInfo> submit_infos;
+			std::vector<vk::TimelineSemaphoreSubmitInfo> timeline_submit_infos(submissions.size());
+			submit_infos.reserve(submissions.size());
+
+			for (size_t i = 0; i < submissions.size(); ++i)
+			{
+				const auto& submission = submissions[i];
+				if (submission.uses_timeline_semaphores() && !m_supports_timeline_semaphores)
+				{
+					throw std::runtime_error("A submission waits on or signals a timeline semaphore, but timeline semaphores are not enabled on this device");
+				}
+
+				vk::SubmitInfo submit_info = {};
+				submit_info.waitSemaphoreCount = static_cast<uint32_t>(submission.m_wait_semaphores.size());
+				submit_info.pWaitSemaphores = submission.m_wait_semaphores.data();
+				submit_info.pWaitDstStageMask = submission.m_wait_stage_flags.data();
+				submit_info.commandBufferCount = static_cast<uint32_t>(submission.m_command_buffers.size());
+				submit_info.pCommandBuffers = submission.m_command_buffers.data();
+				submit_info.signalSemaphoreCount = static_cast<uint32_t>(submission.m_signal_semaphores.size());
+				submit_info.pSignalSemaphores = submission.m_signal_semaphores.data();
+
+				// Only chain the timeline values when they are needed, so that batches of binary semaphores can still be 
+				// submitted on devices without timeline semaphore support.
+				if (submission.uses_timeline_semaphores())
+				{
+					auto& timeline_submit_info = timeline_submit_infos[i];
+					timeline_submit_info.waitSemaphoreValueCount = static_cast<uint32_t>(submission.m_wait_values.size());
+					timeline_submit_info.pWaitSemaphoreValues = submission.m_wait_values.data();
+					timeline_submit_info.signalSemaphoreValueCount = static_cast<uint32_t>(submission.m_signal_values.size());
+					timeline_submit_info.pSignalSemaphoreValues = submission.m_signal_values.data();
+
+					submit_info.pNext = &timeline_submit_info;
+				}
+
+				submit_infos.push_back(submit_info);
+			}
 
-			get_queue_handle(type).submit(submit_info, fence.get_handle());
+			get_queue_handle(type).submit(submit_infos, fence.get_handle());
 		}
 
 		void one_time_submit(QueueType type, std::function<void(const CommandBuffer&)> func)
@@ -281,7 +362,7 @@ namespace plume
 			// TODO: create a standard command pool that is maintained by this device.
 		}
 
-		void Device::one_time_submit(QueueType type, const CommandBuffer& command_buffer)
+		void Device::one_time_submit(QueueType type, const CommandBuffer& command_buffer) const
 		{
 			if (command_buffer.is_inside_render_pass())
 			{
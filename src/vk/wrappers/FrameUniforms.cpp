@@ -0,0 +1,103 @@
+/*
+*
+* MIT License
+*
+* Copyright(c) 2017 Michael Walczyk
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files(the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions :
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*
+*/
+
+#include "FrameUniforms.h"
+
+#include <algorithm>
+
+namespace plume
+{
+
+	namespace graphics
+	{
+
+		namespace
+		{
+
+			//! Returns the distance between slots: the size of the block rounded up to the device's minimum 
+			//! alignment for dynamic uniform buffer offsets (which is a power of two).
+			uint32_t get_slot_stride(const Device& device)
+			{
+				const uint32_t alignment = static_cast<uint32_t>(device.get_physical_device_limits().minUniformBufferOffsetAlignment);
+				return align_up(FrameUniforms::Layout::get_size(), alignment);
+			}
+
+		} // anonymous
+
+		FrameUniforms::FrameUniforms(const Device& device, uint32_t frames_in_flight) :
+
+			m_device_ptr(&device),
+			m_frames_in_flight(std::max(frames_in_flight, 1u)),
+			m_slot_stride(get_slot_stride(device)),
+			m_current_slot(m_frames_in_flight - 1),
+			m_buffer(device, vk::BufferUsageFlagBits::eUniformBuffer, static_cast<size_t>(m_slot_stride) * m_frames_in_flight),
+			m_layout_builder(DescriptorSetLayoutBuilder::create(device)),
+			m_descriptor_pool(device, { { vk::DescriptorType::eUniformBufferDynamic, 1 } })
+		{
+			// The buffer is host coherent, so it stays mapped and each update is a plain write.
+			m_mapped_ptr = static_cast<uint8_t*>(m_buffer.map());
+
+			// This layout is identical to the one that every pipeline infers for the reserved set, so the set
+			// can be bound with any of them.
+			m_layout_builder->begin_descriptor_set_record(reserved_set);
+			m_layout_builder->add_ubo_dynamic(reserved_binding);
+			m_layout_builder->end_descriptor_set_record();
+
+			m_descriptor_set = m_descriptor_pool.allocate_descriptor_sets(m_layout_builder, { reserved_set })[0];
+
+			// The descriptor covers a single slot: the dynamic offset selects which one.
+			vk::DescriptorBufferInfo descriptor_buffer_info = m_buffer.build_descriptor_info(0, Layout::get_size());
+			vk::WriteDescriptorSet write_descriptor_set = { m_descriptor_set, reserved_binding, 0, 1, vk::DescriptorType::eUniformBufferDynamic, nullptr, &descriptor_buffer_info };
+			m_device_ptr->get_handle().updateDescriptorSets(write_descriptor_set, {});
+		}
+
+		FrameUniforms::~FrameUniforms()
+		{
+			m_buffer.unmap();
+		}
+
+		void FrameUniforms::update(const Window& window)
+		{
+			update(utils::app::get_elapsed_seconds(), glm::vec2(window.get_dimensions()), window.get_mouse_position(true, true));
+		}
+
+		void FrameUniforms::update(float time, const glm::vec2& resolution, const glm::vec2& mouse)
+		{
+			m_current_slot = (m_current_slot + 1) % m_frames_in_flight;
+			Layout::write(m_mapped_ptr + get_dynamic_offset(), time, resolution, mouse);
+		}
+
+		void FrameUniforms::bind(CommandBuffer& command_buffer, const Pipeline& pipeline) const
+		{
+			if (pipeline.uses_frame_uniforms())
+			{
+				command_buffer.bind_descriptor_sets(pipeline, reserved_set, { m_descriptor_set }, { get_dynamic_offset() });
+			}
+		}
+
+	} // namespace graphics
+
+} // namespace plume
@@ -25,6 +25,7 @@
 */
 
 #include "Image.h"
+#include "CommandBuffer.h"
 
 namespace plume
 {
@@ -92,6 +93,277 @@ namespace plume
 			initialize_device_memory_with_flags(device, vk::MemoryPropertyFlagBits::eDeviceLocal);
 		}
 
+		Image::Image(const Device& device,
+			vk::ImageType image_type,
+			vk::ImageUsageFlags image_usage_flags,
+			vk::Format format,
+			vk::Extent3D dimensions,
+			const void* pixels,
+			size_t texel_size) :
+
+			Image(device, image_type, image_usage_flags, format, dimensions, [&](const fsys::PixelDestination& destination)
+			{
+				const uint8_t* src_ptr = reinterpret_cast<const uint8_t*>(pixels);
+				uint8_t* dst_ptr = reinterpret_cast<uint8_t*>(destination.data);
+
+				// The subresource has no additional padding, so we can directly copy the pixel data into the image.
+				// This usually happens when the requested image is a power-of-two texture.
+				const size_t row_size = dimensions.width * texel_size;
+				if (destination.row_pitch == row_size)
+				{
+					memcpy(dst_ptr, src_ptr, row_size * dimensions.height);
+				}
+				else
+				{
+					for (size_t i = 0; i < dimensions.height; ++i)
+					{
+						memcpy(dst_ptr + i * destination.row_pitch, src_ptr + i * row_size, row_size);
+					}
+				}
+			})
+		{
+		}
+
+		Image::Image(const Device& device,
+			vk::ImageType image_type,
+			vk::ImageUsageFlags image_usage_flags,
+			vk::Format format,
+			vk::Extent3D dimensions,
+			const PixelWriterFuncType& pixel_writer) :
+
+			m_device_ptr(&device),
+			m_image_type(image_type),
+			m_image_usage_flags(image_usage_flags),
+			m_format(format),
+			m_dimensions(dimensions),
+			m_array_layers(1),
+			m_mip_levels(1),
+			m_image_tiling(vk::ImageTiling::eLinear),
+			m_sample_count(vk::SampleCountFlagBits::e1),
+			m_current_layout(vk::ImageLayout::ePreinitialized),
+			m_is_host_accessible(true)
+		{
+			check_image_parameters();
+
+			vk::ImageCreateInfo image_create_info;
+			image_create_info.arrayLayers = m_array_layers;
+			image_create_info.extent = m_dimensions;
+			image_create_info.format = m_format;
+			image_create_info.initialLayout = m_current_layout;
+			image_create_info.imageType = m_image_type;
+			image_create_info.mipLevels = m_mip_levels;
+			image_create_info.pQueueFamilyIndices = nullptr;
+			image_create_info.queueFamilyIndexCount = 0;
+			image_create_info.samples = m_sample_count;
+			image_create_info.sharingMode = (image_create_info.pQueueFamilyIndices) ? vk::SharingMode::eConcurrent : vk::SharingMode::eExclusive;
+			image_create_info.tiling = m_image_tiling;
+			image_create_info.usage = m_image_usage_flags;
+
+			m_image_handle = m_device_ptr->get_handle().createImageUnique(image_create_info);
+
+			initialize_device_memory_with_flags(device, vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent);
+
+			// Fill the first array layer and mipmap level.
+			vk::ImageSubresource image_subresource;
+			image_subresource.aspectMask = utils::format_to_aspect_mask(m_format);
+			image_subresource.arrayLayer = 0;
+			image_subresource.mipLevel = 0;
+
+			vk::SubresourceLayout subresource_layout = m_device_ptr->get_handle().getImageSubresourceLayout(m_image_handle.get(), image_subresource);
+
+			// Hand the mapped memory to the writer, which fills the image in-place.
+			uint8_t* mapped_ptr = reinterpret_cast<uint8_t*>(m_device_memory->map(0, m_device_memory->get_allocation_size()));
+
+			fsys::PixelDestination destination;
+			destination.data = mapped_ptr + subresource_layout.offset;
+			destination.row_pitch = static_cast<size_t>(subresource_layout.rowPitch);
+			destination.size = static_cast<size_t>(subresource_layout.size);
+
+			try
+			{
+				pixel_writer(destination);
+			}
+			catch (...)
+			{
+				m_device_memory->unmap();
+				throw;
+			}
+
+			m_device_memory->unmap();
+		}
+
+		Image::Image(const Device& device,
+			vk::ImageType image_type,
+			vk::ImageUsageFlags image_usage_flags,
+			vk::Format format,
+			const fsys::MappedFileResource& mapped,
+			bool force_alpha) :
+
+			Image(device, image_type, image_usage_flags, format, [&]()
+			{
+				const fsys::ImageInfo info = fsys::ResourceManager::get_image_info(mapped);
+				return vk::Extent3D{ info.width, info.height, 1 };
+			}(), [&](const fsys::PixelDestination& destination)
+			{
+				if (fsys::ResourceManager::get_image_info(mapped).is_hdr)
+				{
+					if (utils::is_packed_hdr_format(format))
+					{
+						fsys::ResourceManager::decode_image_hdr(mapped, destination, format);
+					}
+					else
+					{
+						fsys::ResourceManager::decode_image_hdr(mapped, destination, force_alpha);
+					}
+				}
+				else
+				{
+					fsys::ResourceManager::decode_image(mapped, destination, force_alpha);
+				}
+			})
+		{
+		}
+
+		Image::Image(const Device& device,
+			vk::ImageType image_type,
+			vk::ImageUsageFlags image_usage_flags,
+			vk::Format format,
+			const fsys::ImageResourceHDR& resource) :
+
+			Image(device, image_type, image_usage_flags, format, { resource.width, resource.height, 1 }, [&](const fsys::PixelDestination& destination)
+			{
+				if (utils::is_packed_hdr_format(format))
+				{
+					fsys::ResourceManager::pack_image_hdr(resource, destination, format);
+					return;
+				}
+
+				const size_t row_size = static_cast<size_t>(resource.width) * resource.channels * sizeof(float);
+				for (uint32_t row = 0; row < resource.height; ++row)
+				{
+					memcpy(static_cast<uint8_t*>(destination.data) + row * destination.row_pitch, resource.contents.data() + row * resource.width * resource.channels, row_size);
+				}
+			})
+		{
+		}
+
+		Image::Image(const Device& device,
+			const CommandPool& command_pool,
+			vk::ImageUsageFlags image_usage_flags,
+			const fsys::TextureResource& texture) :
+
+			m_device_ptr(&device),
+			m_image_type(texture.image_type),
+			m_image_usage_flags(image_usage_flags | vk::ImageUsageFlagBits::eTransferDst),
+			m_format(texture.format),
+			m_dimensions(texture.extent),
+			m_array_layers(texture.array_layers),
+			m_mip_levels(texture.mip_levels),
+			m_image_tiling(vk::ImageTiling::eOptimal),
+			m_sample_count(vk::SampleCountFlagBits::e1),
+			m_image_create_flags(texture.is_cube ? vk::ImageCreateFlags{ vk::ImageCreateFlagBits::eCubeCompatible } : vk::ImageCreateFlags{}),
+			m_current_layout(vk::ImageLayout::eUndefined),
+			m_is_host_accessible(false)
+		{
+			// Fall back to decoding the texture on the CPU if the device can't sample its native format.
+			const fsys::TextureResource* source = &texture;
+			fsys::TextureResource transcoded;
+			if (!is_format_sampleable(device, texture.format))
+			{
+				if (!fsys::TextureLoader::can_transcode(texture.format))
+				{
+					throw std::runtime_error("The device does not support sampling format " + vk::to_string(texture.format) + ", and it cannot be decoded on the CPU");
+				}
+
+				PL_LOG_DEBUG("Format %s is not supported by this device: transcoding to %s on the CPU\n", 
+							 vk::to_string(texture.format).c_str(), 
+							 vk::to_string(fsys::TextureLoader::get_transcoded_format(texture.format)).c_str());
+
+				transcoded = fsys::TextureLoader::transcode(texture);
+				source = &transcoded;
+				m_format = transcoded.format;
+			}
+
+			check_image_parameters();
+
+			vk::ImageCreateInfo image_create_info;
+			image_create_info.arrayLayers = m_array_layers;
+			image_create_info.extent = m_dimensions;
+			image_create_info.flags = m_image_create_flags;
+			image_create_info.format = m_format;
+			image_create_info.initialLayout = m_current_layout;
+			image_create_info.imageType = m_image_type;
+			image_create_info.mipLevels = m_mip_levels;
+			image_create_info.pQueueFamilyIndices = nullptr;
+			image_create_info.queueFamilyIndexCount = 0;
+			image_create_info.samples = m_sample_count;
+			image_create_info.sharingMode = vk::SharingMode::eExclusive;
+			image_create_info.tiling = m_image_tiling;
+			image_create_info.usage = m_image_usage_flags;
+
+			m_image_handle = m_device_ptr->get_handle().createImageUnique(image_create_info);
+
+			initialize_device_memory_with_flags(device, vk::MemoryPropertyFlagBits::eDeviceLocal);
+
+			// Pack every subresource into a single staging buffer. Each copy must start at a multiple of both 
+			// 4 bytes and the format's block size, so subresources are realigned rather than copied at the 
+			// offsets they had in the file.
+			const utils::FormatBlockInfo block_info = utils::get_format_block_info(m_format);
+			size_t alignment = block_info.block_size;
+			while (alignment % 4) alignment += block_info.block_size;
+
+			std::vector<vk::BufferImageCopy> regions;
+			size_t staging_size = 0;
+			for (const auto& subresource : source->subresources)
+			{
+				staging_size = (staging_size + alignment - 1) / alignment * alignment;
+
+				vk::BufferImageCopy region;
+				region.bufferOffset = staging_size;
+				region.bufferRowLength = 0;		// Tightly packed
+				region.bufferImageHeight = 0;
+				region.imageSubresource.aspectMask = utils::format_to_aspect_mask(m_format);
+				region.imageSubresource.mipLevel = subresource.mip_level;
+				region.imageSubresource.baseArrayLayer = subresource.array_layer;
+				region.imageSubresource.layerCount = 1;
+				region.imageOffset = vk::Offset3D{ 0, 0, 0 };
+				region.imageExtent = subresource.extent;
+				regions.push_back(region);
+
+				staging_size += subresource.size;
+			}
+
+			Buffer staging_buffer{ device, vk::BufferUsageFlagBits::eTransferSrc, staging_size };
+
+			// Copy straight from the (memory-mapped) container into the staging buffer.
+			uint8_t* staging_ptr = reinterpret_cast<uint8_t*>(staging_buffer.map());
+			utils::ThreadPool::global().parallel_for(0, regions.size(), 1, [&](size_t begin, size_t end)
+			{
+				for (size_t i = begin; i < end; ++i)
+				{
+					memcpy(staging_ptr + regions[i].bufferOffset, source->data(source->subresources[i]), source->subresources[i].size);
+				}
+			});
+			staging_buffer.unmap();
+
+			vk::ImageSubresourceRange subresource_range;
+			subresource_range.aspectMask = utils::format_to_aspect_mask(m_format);
+			subresource_range.baseArrayLayer = 0;
+			subresource_range.layerCount = m_array_layers;
+			subresource_range.baseMipLevel = 0;
+			subresource_range.levelCount = m_mip_levels;
+
+			CommandBuffer command_buffer{ device, command_pool };
+			command_buffer.begin();
+			command_buffer.transition_image_layout(*this, m_current_layout, vk::ImageLayout::eTransferDstOptimal, subresource_range);
+			command_buffer.copy_buffer_to_image(staging_buffer, *this, regions);
+			command_buffer.transition_image_layout(*this, m_current_layout, vk::ImageLayout::eShaderReadOnlyOptimal, subresource_range);
+			command_buffer.end();
+
+			// The staging buffer must outlive the copy, so wait for the submission to complete.
+			m_device_ptr->one_time_submit(command_pool.get_queue_type(), command_buffer);
+		}
+
 		bool Image::is_image_view_type_compatible(vk::ImageViewType image_view_type) const
 		{
 			// See the spec: https://www.khronos.org/registry/vulkan/specs/1.0/html/vkspec.html#resources-image-views-compatibility
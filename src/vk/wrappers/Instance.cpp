@@ -60,7 +60,7 @@ namespace plume
 
 		Instance::Options::Options()
 		{
-			m_application_info.apiVersion = VK_API_VERSION_1_0;
+			m_application_info.apiVersion = std::min<uint32_t>(VK_API_VERSION_1_2, get_loader_api_version());
 			m_application_info.applicationVersion = VK_MAKE_VERSION(1, 0, 0);
 			m_application_info.engineVersion = VK_MAKE_VERSION(1, 0, 0);
 			m_application_info.pApplicationName = "Plume Application";
@@ -71,6 +71,7 @@ namespace plume
 
 		Instance::Instance(const Options& options) :
 
+			m_api_version(options.m_application_info.apiVersion),
 			m_required_layers(options.m_required_layers),
 			m_required_extensions(options.m_required_extensions)
 		{
@@ -125,6 +126,20 @@ namespace plume
 			destroy_debug_report_callback(m_instance_handle.get(), m_debug_report_callback, nullptr);
 		}
 
+		uint32_t Instance::get_loader_api_version()
+		{
+			// vkEnumerateInstanceVersion was added in Vulkan 1.1, so a loader without it only supports Vulkan 1.0.
+			auto func = (PFN_vkEnumerateInstanceVersion)vkGetInstanceProcAddr(VK_NULL_HANDLE, "vkEnumerateInstanceVersion");
+
+			uint32_t api_version = VK_API_VERSION_1_0;
+			if (func != nullptr && func(&api_version) != VK_SUCCESS)
+			{
+				api_version = VK_API_VERSION_1_0;
+			}
+
+			return api_version;
+		}
+
 		vk::PhysicalDevice Instance::pick_physical_device(const std::function<bool(vk::PhysicalDevice)>& func)
 		{
 			for (const auto& physical_device : m_physical_devices)
@@ -25,6 +25,12 @@
 */
 
 #include "Pipeline.h"
+#include "FrameUniforms.h"
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <set>
 
 namespace plume
 {
@@ -32,12 +38,219 @@ namespace plume
 	namespace graphics
 	{
 
-		vk::PipelineShaderStageCreateInfo Pipeline::build_shader_stage_create_info(const std::shared_ptr<ShaderModule>& module)
+		namespace
+		{
+
+			const char* base_type_to_string(ShaderModule::BaseType base_type)
+			{
+				switch (base_type)
+				{
+				case ShaderModule::BaseType::BASE_TYPE_BOOL: return "bool";
+				case ShaderModule::BaseType::BASE_TYPE_INT: return "int";
+				case ShaderModule::BaseType::BASE_TYPE_UINT: return "uint";
+				case ShaderModule::BaseType::BASE_TYPE_INT64: return "int64_t";
+				case ShaderModule::BaseType::BASE_TYPE_UINT64: return "uint64_t";
+				case ShaderModule::BaseType::BASE_TYPE_FLOAT: return "float";
+				case ShaderModule::BaseType::BASE_TYPE_DOUBLE: return "double";
+				case ShaderModule::BaseType::BASE_TYPE_STRUCT: return "struct";
+				default: return "unknown";
+				}
+			}
+
+			bool is_integer(ShaderModule::BaseType base_type)
+			{
+				return base_type == ShaderModule::BaseType::BASE_TYPE_INT ||
+					   base_type == ShaderModule::BaseType::BASE_TYPE_UINT ||
+					   base_type == ShaderModule::BaseType::BASE_TYPE_INT64 ||
+					   base_type == ShaderModule::BaseType::BASE_TYPE_UINT64;
+			}
+
+		} // anonymous
+
+		vk::SpecializationInfo SpecializationConstants::StageData::get_info() const
+		{
+			vk::SpecializationInfo specialization_info;
+			specialization_info.mapEntryCount = static_cast<uint32_t>(entries.size());
+			specialization_info.pMapEntries = entries.data();
+			specialization_info.dataSize = data.size();
+			specialization_info.pData = data.data();
+
+			return specialization_info;
+		}
+
+		SpecializationConstants::Value SpecializationConstants::make_value(bool value)
+		{
+			// Booleans are passed to the driver as 32-bit VkBool32 values.
+			return { ShaderModule::BaseType::BASE_TYPE_BOOL, sizeof(VkBool32), value ? VK_TRUE : VK_FALSE };
+		}
+
+		SpecializationConstants::Value SpecializationConstants::make_value(int32_t value)
+		{
+			return { ShaderModule::BaseType::BASE_TYPE_INT, sizeof(int32_t), static_cast<uint32_t>(value) };
+		}
+
+		SpecializationConstants::Value SpecializationConstants::make_value(uint32_t value)
+		{
+			return { ShaderModule::BaseType::BASE_TYPE_UINT, sizeof(uint32_t), value };
+		}
+
+		SpecializationConstants::Value SpecializationConstants::make_value(int64_t value)
+		{
+			return { ShaderModule::BaseType::BASE_TYPE_INT64, sizeof(int64_t), static_cast<uint64_t>(value) };
+		}
+
+		SpecializationConstants::Value SpecializationConstants::make_value(uint64_t value)
+		{
+			return { ShaderModule::BaseType::BASE_TYPE_UINT64, sizeof(uint64_t), value };
+		}
+
+		SpecializationConstants::Value SpecializationConstants::make_value(float value)
+		{
+			uint32_t bits;
+			memcpy(&bits, &value, sizeof(bits));
+			return { ShaderModule::BaseType::BASE_TYPE_FLOAT, sizeof(float), bits };
+		}
+
+		SpecializationConstants::Value SpecializationConstants::make_value(double value)
+		{
+			uint64_t bits;
+			memcpy(&bits, &value, sizeof(bits));
+			return { ShaderModule::BaseType::BASE_TYPE_DOUBLE, sizeof(double), bits };
+		}
+
+		std::string SpecializationConstants::get_key() const
+		{
+			auto append_value = [](std::string& key, const Value& value) {
+				key.append(reinterpret_cast<const char*>(&value.base_type), sizeof(value.base_type));
+				key.append(reinterpret_cast<const char*>(&value.bits), sizeof(value.bits));
+			};
+
+			// Both maps are ordered, so equal sets of values always produce the same key.
+			std::string key;
+			for (const auto& entry : m_values_by_id)
+			{
+				key.append(reinterpret_cast<const char*>(&entry.first), sizeof(entry.first));
+				append_value(key, entry.second);
+			}
+			key += '\0';
+			for (const auto& entry : m_values_by_name)
+			{
+				key += entry.first;
+				key += '\0';
+				append_value(key, entry.second);
+			}
+
+			return key;
+		}
+
+		std::vector<SpecializationConstants::StageData> SpecializationConstants::build(const std::vector<std::shared_ptr<ShaderModule>>& modules) const
+		{
+			std::vector<StageData> stages(modules.size());
+			std::set<uint32_t> used_ids;
+			std::set<std::string> used_names;
+
+			for (size_t i = 0; i < modules.size(); ++i)
+			{
+				for (const auto& constant : modules[i]->get_specialization_constants())
+				{
+					// A value that is set by ID takes precedence over one that is set by name.
+					auto by_id = m_values_by_id.find(constant.constant_id);
+					auto by_name = m_values_by_name.find(constant.name);
+
+					if (by_id != m_values_by_id.end())
+					{
+						append(constant, by_id->second, stages[i]);
+						used_ids.insert(constant.constant_id);
+					}
+					else if (!constant.name.empty() && by_name != m_values_by_name.end())
+					{
+						append(constant, by_name->second, stages[i]);
+						used_names.insert(constant.name);
+					}
+				}
+			}
+
+			for (const auto& entry : m_values_by_id)
+			{
+				if (!used_ids.count(entry.first))
+				{
+					throw std::runtime_error("No shader stage has a specialization constant with ID " + std::to_string(entry.first));
+				}
+			}
+			for (const auto& entry : m_values_by_name)
+			{
+				if (!used_names.count(entry.first))
+				{
+					throw std::runtime_error("No shader stage has a specialization constant named " + entry.first);
+				}
+			}
+
+			return stages;
+		}
+
+		void SpecializationConstants::append(const ShaderModule::SpecializationConstant& constant, const Value& value, StageData& stage_data)
+		{
+			const bool is_compatible = value.base_type == constant.base_type || (is_integer(value.base_type) && is_integer(constant.base_type));
+			if (!is_compatible || value.size != constant.size)
+			{
+				throw std::runtime_error("Specialization constant " + (constant.name.empty() ? std::to_string(constant.constant_id) : constant.name) +
+										 " is declared as " + base_type_to_string(constant.base_type) + " but was given a value of type " + base_type_to_string(value.base_type));
+			}
+
+			vk::SpecializationMapEntry entry;
+			entry.constantID = constant.constant_id;
+			entry.offset = static_cast<uint32_t>(stage_data.data.size());
+			entry.size = value.size;
+			stage_data.entries.push_back(entry);
+
+			// The bits are stored in the low bytes of `value.bits` (on little-endian hosts).
+			const uint8_t* bytes = reinterpret_cast<const uint8_t*>(&value.bits);
+			stage_data.data.insert(stage_data.data.end(), bytes, bytes + value.size);
+		}
+
+		void PushConstantLayout::validate(const ShaderModule::BlockLayout& block) const
+		{
+			for (const auto& member : m_members)
+			{
+				const ShaderModule::BlockMember* reflected = block.find_member(member.name);
+				if (!reflected)
+				{
+					throw std::runtime_error("Push constants block " + block.name + " has no member named " + member.name);
+				}
+				if (reflected->offset != member.offset || reflected->size != member.size)
+				{
+					throw std::runtime_error("Push constant " + member.name + " is declared at offset " + std::to_string(reflected->offset) + " with size " + std::to_string(reflected->size) +
+											 " but is registered at offset " + std::to_string(member.offset) + " with size " + std::to_string(member.size));
+				}
+			}
+
+			// Nested members are covered by their parent, so only top-level members have to be registered.
+			for (const auto& reflected : block.members)
+			{
+				if (reflected.name.find('.') != std::string::npos)
+				{
+					continue;
+				}
+
+				auto it = std::find_if(m_members.begin(), m_members.end(), [&](const Member& member) { return member.name == reflected.name; });
+				if (it == m_members.end())
+				{
+					throw std::runtime_error("Push constant " + reflected.name + " is not registered in the push constant layout");
+				}
+			}
+
+			if (m_size < block.size)
+			{
+				throw std::runtime_error("Push constants block " + block.name + " is " + std::to_string(block.size) + " bytes, but the registered struct is only " + std::to_string(m_size) + " bytes");
+			}
+		}
+
+		vk::PipelineShaderStageCreateInfo Pipeline::build_shader_stage_create_info(const std::shared_ptr<ShaderModule>& module, const vk::SpecializationInfo* specialization_info)
 		{
 			vk::PipelineShaderStageCreateInfo shader_stage_create_info;
 			shader_stage_create_info.module = module->get_handle();
 			shader_stage_create_info.pName = module->get_entry_points()[0].c_str();
-			shader_stage_create_info.pSpecializationInfo = nullptr;
+			shader_stage_create_info.pSpecializationInfo = specialization_info;
 			shader_stage_create_info.stage = module->get_stage();
 
 			return shader_stage_create_info;
@@ -66,16 +279,91 @@ namespace plume
 			}
 		}
 
+		void Pipeline::build_push_constant_range(const std::vector<std::shared_ptr<ShaderModule>>& modules, const PushConstantLayout& layout)
+		{
+			// A single range whose stage flags include every stage keeps `pushConstants()` valid for any subset of 
+			// the block: Vulkan requires the stage flags of a push to include those of every range that it overlaps.
+			uint32_t begin = std::numeric_limits<uint32_t>::max();
+			uint32_t end = 0;
+			vk::ShaderStageFlags stage_flags;
+			for (const auto& mapping : m_push_constants_mapping)
+			{
+				begin = std::min(begin, mapping.second.offset);
+				end = std::max(end, mapping.second.offset + mapping.second.size);
+				stage_flags |= mapping.second.stageFlags;
+			}
+
+			m_push_constant_range = vk::PushConstantRange{};
+			if (end > 0)
+			{
+				m_push_constant_range.offset = begin;
+				m_push_constant_range.size = end - begin;
+				m_push_constant_range.stageFlags = stage_flags;
+			}
+			for (auto& mapping : m_push_constants_mapping)
+			{
+				mapping.second.stageFlags = stage_flags;
+			}
+
+			if (layout.empty())
+			{
+				return;
+			}
+
+			bool has_block = false;
+			for (const auto& module : modules)
+			{
+				if (const ShaderModule::BlockLayout* block = module->get_push_constant_block())
+				{
+					layout.validate(*block);
+					has_block = true;
+				}
+			}
+			if (!has_block)
+			{
+				throw std::runtime_error("A push constant layout was registered, but none of the pipeline's shader stages use push constants");
+			}
+
+			m_push_constant_layout = layout;
+		}
+
 		void Pipeline::add_descriptors_to_global_map(const std::shared_ptr<ShaderModule>& module)
 		{
+			const ShaderModule::BlockLayout* frame_uniforms_block = module->get_frame_uniforms_block();
+			if (frame_uniforms_block)
+			{
+				if (frame_uniforms_block->layout_set != FrameUniforms::reserved_set || frame_uniforms_block->layout_binding != FrameUniforms::reserved_binding)
+				{
+					throw std::runtime_error("The frame uniforms block " + frame_uniforms_block->name + " must be declared at set " + std::to_string(FrameUniforms::reserved_set) + 
+											 ", binding " + std::to_string(FrameUniforms::reserved_binding));
+				}
+
+				// The toolkit writes the block, so its layout must match exactly.
+				FrameUniforms::Layout::validate(*frame_uniforms_block);
+				m_uses_frame_uniforms = true;
+			}
+
 			for (const auto& descriptor : module->get_descriptors())
 			{
 				// Iterate over every descriptor found in this shader stage.
 				uint32_t set = descriptor.layout_set;
 
+				vk::DescriptorSetLayoutBinding layout_binding = descriptor.layout_binding;
+				if (set == FrameUniforms::reserved_set)
+				{
+					if (!frame_uniforms_block || descriptor.name != frame_uniforms_block->name)
+					{
+						throw std::runtime_error("Descriptor set " + std::to_string(set) + " is reserved for the frame uniforms, but " + descriptor.name + " is bound to it");
+					}
+
+					// Each frame selects its slot of the ring with a dynamic offset (see FrameUniforms).
+					layout_binding.descriptorType = vk::DescriptorType::eUniformBufferDynamic;
+					layout_binding.stageFlags = vk::ShaderStageFlagBits::eAll;
+				}
+
 				if (m_descriptors_mapping.find(set) == m_descriptors_mapping.end())
 				{
-					std::vector<vk::DescriptorSetLayoutBinding> fresh_descriptor_set_layout_bindings = { descriptor.layout_binding };
+					std::vector<vk::DescriptorSetLayoutBinding> fresh_descriptor_set_layout_bindings = { layout_binding };
 					m_descriptors_mapping.insert(std::make_pair(set, fresh_descriptor_set_layout_bindings));
 				}
 				else
@@ -89,12 +377,12 @@ namespace plume
 					auto it = std::find_if(existing_descriptor_set_layout_bindings.begin(), existing_descriptor_set_layout_bindings.end(),
 						[&](const vk::DescriptorSetLayoutBinding &tDescriptorSetLayoutBinding)
 					{
-						return tDescriptorSetLayoutBinding.binding == descriptor.layout_binding.binding;
+						return tDescriptorSetLayoutBinding.binding == layout_binding.binding;
 					});
 
 					if (it == existing_descriptor_set_layout_bindings.end())
 					{
-						existing_descriptor_set_layout_bindings.push_back(descriptor.layout_binding);
+						existing_descriptor_set_layout_bindings.push_back(layout_binding);
 					}
 					else
 					{
@@ -116,15 +404,26 @@ namespace plume
 			// Iterate through the map of descriptors, which maps descriptor set IDs (i.e. 0, 1, 2) to
 			// a list of descriptors (i.e. uniform buffers, samplers), and create a descriptor set layout
 			// for each set.
-			for (const auto& mapping : m_descriptors_mapping)
+			if (m_descriptors_mapping.empty())
 			{
-				vk::DescriptorSetLayoutCreateInfo descriptor_set_layout_create_info;
-				descriptor_set_layout_create_info.bindingCount = static_cast<uint32_t>(mapping.second.size());
-				descriptor_set_layout_create_info.pBindings = mapping.second.data();
+				return;
+			}
 
-				vk::DescriptorSetLayout descriptor_set_layout = m_device_ptr->get_handle().createDescriptorSetLayout(descriptor_set_layout_create_info);
+			// The pipeline layout identifies each set by its position, so any sets that are skipped (i.e. between the
+			// application's sets and the frame uniforms' reserved set) are filled in with empty layouts.
+			const uint32_t last_set = m_descriptors_mapping.rbegin()->first;
+			for (uint32_t set = 0; set <= last_set; ++set)
+			{
+				auto it = m_descriptors_mapping.find(set);
 
-				m_descriptor_set_layouts_mapping.insert(std::make_pair(mapping.first, descriptor_set_layout));
+				vk::DescriptorSetLayoutCreateInfo descriptor_set_layout_create_info;
+				if (it != m_descriptors_mapping.end())
+				{
+					descriptor_set_layout_create_info.bindingCount = static_cast<uint32_t>(it->second.size());
+					descriptor_set_layout_create_info.pBindings = it->second.data();
+				}
+
+				m_descriptor_set_layouts_mapping.emplace(set, m_device_ptr->get_handle().createDescriptorSetLayoutUnique(descriptor_set_layout_create_info));
 			}
 		}
 
@@ -243,14 +542,26 @@ namespace plume
 			Pipeline(device),
 			m_dynamic_states_active(options.m_dynamic_states)
 		{
+			// Resolve the specialization constants of every stage: the infos point into `specialization_data`, which 
+			// must outlive the creation of the pipeline.
+			const auto specialization_data = options.m_specialization_constants.build(options.m_shader_stages);
+
+			std::vector<vk::SpecializationInfo> specialization_infos;
+			for (const auto& stage_data : specialization_data)
+			{
+				specialization_infos.push_back(stage_data.get_info());
+			}
+
 			// Group the shader create info structs together.
 			std::vector<vk::PipelineShaderStageCreateInfo> shader_stage_create_infos;
-			for (const auto& stage : options.m_shader_stages)
+			for (size_t i = 0; i < options.m_shader_stages.size(); ++i)
 			{
+				const auto& stage = options.m_shader_stages[i];
+
 				// Mark this shader stage as active.
 				m_shader_stage_active_mapping.at(stage->get_stage()) = true;
 
-				auto shader_stage_info = build_shader_stage_create_info(stage);
+				auto shader_stage_info = build_shader_stage_create_info(stage, specialization_infos[i].mapEntryCount > 0 ? &specialization_infos[i] : nullptr);
 				shader_stage_create_infos.push_back(shader_stage_info);
 
 				// Update the containers used by this pipeline to track push constant / descriptor usage.
@@ -258,6 +569,8 @@ namespace plume
 				add_descriptors_to_global_map(stage);
 			}
 
+			build_push_constant_range(options.m_shader_stages, options.m_push_constant_layout);
+
 			if (!m_shader_stage_active_mapping.at(vk::ShaderStageFlagBits::eVertex))
 			{
 				throw std::runtime_error("At least one vertex shader stage is required to build a graphics pipeline");
@@ -291,17 +604,18 @@ namespace plume
 			bool infer_layouts = true;
 			if (infer_layouts) build_descriptor_set_layouts();
 
-			// Get all of the values in the push constant ranges map. 
+			// All push constants share a single range (see `build_push_constant_range()`).
 			std::vector<vk::PushConstantRange> push_constant_ranges;
-			std::transform(m_push_constants_mapping.begin(),
-						   m_push_constants_mapping.end(),
-						   std::back_inserter(push_constant_ranges), [](const auto& val) { return val.second; });
+			if (m_push_constant_range.size > 0)
+			{
+				push_constant_ranges.push_back(m_push_constant_range);
+			}
 
 			// Get all of the values in the descriptor set layouts map.
 			std::vector<vk::DescriptorSetLayout> descriptor_set_layouts;
 			std::transform(m_descriptor_set_layouts_mapping.begin(),
 						   m_descriptor_set_layouts_mapping.end(),
-						   std::back_inserter(descriptor_set_layouts), [](const auto& val) { return val.second; });
+						   std::back_inserter(descriptor_set_layouts), [](const auto& val) { return val.second.get(); });
 
 			// Encapsulate any descriptor sets and push constant ranges into a pipeline layout.
 			vk::PipelineLayoutCreateInfo pipeline_layout_create_info;
@@ -334,29 +648,34 @@ namespace plume
 			m_pipeline_handle = m_device_ptr->get_handle().createGraphicsPipelineUnique({}, graphics_pipeline_create_info);
 		}
 
-		ComputePipeline::ComputePipeline(const Device& device, const std::shared_ptr<ShaderModule>& compute_shader_module) :
+		ComputePipeline::ComputePipeline(const Device& device, 
+										 const std::shared_ptr<ShaderModule>& compute_shader_module, 
+										 const SpecializationConstants& constants, 
+										 const PushConstantLayout& push_constant_layout) :
 
 			Pipeline(device)
 		{
 			// Update the containers used by this pipeline to track push constant / descriptor usage.
 			add_push_constants_to_global_map(compute_shader_module);
 			add_descriptors_to_global_map(compute_shader_module);
+			build_push_constant_range({ compute_shader_module }, push_constant_layout);
 
 			// TODO: there should be another constructor that takes a vector of descriptor set layouts as a parameter.
 			bool infer_layouts = true;
 			if (infer_layouts) build_descriptor_set_layouts();
 
-			// Get all of the values in the push constant ranges map. 
+			// All push constants share a single range (see `build_push_constant_range()`).
 			std::vector<vk::PushConstantRange> push_constant_ranges;
-			std::transform(m_push_constants_mapping.begin(),
-						   m_push_constants_mapping.end(),
-						   std::back_inserter(push_constant_ranges), [](const auto& val) { return val.second; });
+			if (m_push_constant_range.size > 0)
+			{
+				push_constant_ranges.push_back(m_push_constant_range);
+			}
 
 			// Get all of the values in the descriptor set layouts map.
 			std::vector<vk::DescriptorSetLayout> descriptor_set_layouts;
 			std::transform(m_descriptor_set_layouts_mapping.begin(),
 						   m_descriptor_set_layouts_mapping.end(),
-						   std::back_inserter(descriptor_set_layouts), [](const auto& val) { return val.second; });
+						   std::back_inserter(descriptor_set_layouts), [](const auto& val) { return val.second.get(); });
 
 			// Encapsulate any descriptor sets and push constant ranges into a pipeline layout.
 			vk::PipelineLayoutCreateInfo pipeline_layout_create_info;
@@ -372,7 +691,9 @@ namespace plume
 			compute_pipeline_create_info.basePipelineHandle = vk::Pipeline{};
 			compute_pipeline_create_info.basePipelineIndex = -1;
 			compute_pipeline_create_info.layout = m_pipeline_layout_handle.get();
-			compute_pipeline_create_info.stage = build_shader_stage_create_info(compute_shader_module);
+			const auto specialization_data = constants.build({ compute_shader_module });
+			const vk::SpecializationInfo specialization_info = specialization_data[0].get_info();
+			compute_pipeline_create_info.stage = build_shader_stage_create_info(compute_shader_module, specialization_info.mapEntryCount > 0 ? &specialization_info : nullptr);
 
 			m_pipeline_handle = m_device_ptr->get_handle().createComputePipelineUnique({}, compute_pipeline_create_info);
 		}
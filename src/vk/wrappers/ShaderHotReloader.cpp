@@ -0,0 +1,225 @@
+/*
+*
+* MIT License
+*
+* Copyright(c) 2017 Michael Walczyk
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files(the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions :
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*
+*/
+
+#include "ShaderHotReloader.h"
+
+#include <algorithm>
+#include <chrono>
+#include <set>
+
+#include "ThreadPool.h"
+#include "VirtualFileSystem.h"
+
+namespace plume
+{
+
+	namespace graphics
+	{
+
+		ShaderHotReloader::ShaderHotReloader(const Device& device, fsys::ShaderCompiler& compiler) :
+
+			m_device_ptr(&device),
+			m_compiler_ptr(&compiler)
+		{
+		}
+
+		ShaderHotReloader::~ShaderHotReloader()
+		{
+			// The rebuilds refer to the device and the compiler, which may be destroyed right after this.
+			for (auto& entry : m_entries)
+			{
+				if (entry.pending.valid())
+				{
+					entry.pending.wait();
+				}
+			}
+		}
+
+		ShaderHotReloader::PipelineId ShaderHotReloader::add(const std::vector<fsys::ShaderCompiler::Job>& jobs, FactoryFuncType factory)
+		{
+			Build initial = build(*m_device_ptr, *m_compiler_ptr, jobs, factory);
+			watch(initial.dependencies);
+
+			Entry entry;
+			entry.jobs = jobs;
+			entry.factory = factory;
+			entry.pipeline = std::move(initial.pipeline);
+			entry.modules = std::move(initial.modules);
+			entry.is_stale = false;
+			m_entries.push_back(std::move(entry));
+
+			return m_entries.size() - 1;
+		}
+
+		std::vector<ShaderHotReloader::ReloadEvent> ShaderHotReloader::update(const Fence& last_submitted)
+		{
+			std::vector<ReloadEvent> events;
+
+			// Destroy the pipelines that the device has finished with. A fence that has since been reset for a later
+			// frame only delays this until that frame has finished as well.
+			m_retired.erase(std::remove_if(m_retired.begin(), m_retired.end(), [](const RetiredPipeline& retired) 
+			{ 
+				return retired.fence->get_status() == vk::Result::eSuccess; 
+			}), m_retired.end());
+
+			// Swap in the pipelines that have finished rebuilding.
+			for (size_t id = 0; id < m_entries.size(); ++id)
+			{
+				Entry& entry = m_entries[id];
+				if (!entry.pending.valid() || entry.pending.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+				{
+					continue;
+				}
+
+				// The worker's write to `pending_seconds` happens before the future becomes ready.
+				ReloadEvent event = { id, false, std::string(), *entry.pending_seconds };
+				try
+				{
+					Build rebuilt = entry.pending.get();
+					watch(rebuilt.dependencies);
+
+					// Frames up to (and including) the one that `last_submitted` guards may still be using the old pipeline.
+					m_retired.push_back({ std::move(entry.pipeline), &last_submitted });
+					entry.pipeline = std::move(rebuilt.pipeline);
+					entry.modules = std::move(rebuilt.modules);
+					event.succeeded = true;
+				}
+				catch (const std::exception& e)
+				{
+					event.error = e.what();
+				}
+				events.push_back(event);
+
+				if (entry.is_stale)
+				{
+					launch(entry);
+				}
+			}
+
+			// Start rebuilding the pipelines whose shaders depend on a file that changed.
+			std::set<std::string> changed_shaders;
+			for (const auto& path : m_watcher.poll())
+			{
+				for (const auto& shader_name : m_compiler_ptr->get_dependent_shaders(m_watched_names.at(path)))
+				{
+					changed_shaders.insert(shader_name);
+				}
+			}
+
+			if (!changed_shaders.empty())
+			{
+				for (auto& entry : m_entries)
+				{
+					const bool is_affected = std::any_of(entry.jobs.begin(), entry.jobs.end(), [&](const fsys::ShaderCompiler::Job& job) { return changed_shaders.count(fsys::PackArchive::normalize_path(job.file_name)) > 0; });
+					if (!is_affected)
+					{
+						continue;
+					}
+
+					if (entry.pending.valid())
+					{
+						// The rebuild that is in progress may have read the file before it changed.
+						entry.is_stale = true;
+					}
+					else
+					{
+						launch(entry);
+					}
+				}
+			}
+
+			return events;
+		}
+
+		size_t ShaderHotReloader::get_pending_count() const
+		{
+			return std::count_if(m_entries.begin(), m_entries.end(), [](const Entry& entry) { return entry.pending.valid(); });
+		}
+
+		ShaderHotReloader::Build ShaderHotReloader::build(const Device& device, fsys::ShaderCompiler& compiler, const std::vector<fsys::ShaderCompiler::Job>& jobs, const FactoryFuncType& factory)
+		{
+			auto batch = compiler.compile_batch(jobs);
+			batch.throw_if_failed();
+
+			Build result;
+			for (const auto& binary : batch.binaries)
+			{
+				result.modules.push_back(ShaderModule::create(device, binary));
+
+				for (const auto& dependency : binary.dependencies)
+				{
+					result.dependencies.push_back(dependency.name);
+				}
+			}
+			result.pipeline = factory(result.modules);
+
+			return result;
+		}
+
+		void ShaderHotReloader::launch(Entry& entry)
+		{
+			const Device* device_ptr = m_device_ptr;
+			fsys::ShaderCompiler* compiler_ptr = m_compiler_ptr;
+			auto jobs = entry.jobs;
+			auto factory = entry.factory;
+
+			const auto start = std::chrono::high_resolution_clock::now();
+			auto seconds = std::make_shared<double>(0.0);
+
+			entry.is_stale = false;
+			entry.pending_seconds = seconds;
+			entry.pending = utils::ThreadPool::global().submit([=]()
+			{
+				try
+				{
+					Build rebuilt = build(*device_ptr, *compiler_ptr, jobs, factory);
+					*seconds = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+					return rebuilt;
+				}
+				catch (...)
+				{
+					*seconds = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+					throw;
+				}
+			});
+		}
+
+		void ShaderHotReloader::watch(const std::vector<std::string>& dependencies)
+		{
+			for (const auto& name : dependencies)
+			{
+				// Files that come from an archive or from memory cannot change on disk.
+				const std::string path = fsys::ResourceManager::get_file_system().get_disk_path(name);
+				if (!path.empty() && m_watcher.watch(path))
+				{
+					m_watched_names[path] = name;
+				}
+			}
+		}
+
+	} // namespace graphics
+
+} // namespace plume
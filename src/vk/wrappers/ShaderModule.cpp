@@ -25,6 +25,16 @@
 */
 
 #include "ShaderModule.h"
+#include "Hash.h"
+#include "Serialization.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <iterator>
+#include <mutex>
 
 namespace plume
 {
@@ -35,6 +45,12 @@ namespace plume
 		namespace
 		{
 
+			using utils::serialization::append;
+			using utils::serialization::append_string;
+			using utils::serialization::consume;
+			using utils::serialization::consume_count;
+			using utils::serialization::consume_string;
+
 			const std::string plume_uniform_names[] =
 			{
 				"pl_time",
@@ -50,10 +66,55 @@ namespace plume
 				"pl_texcoord"
 			};
 
-			uint32_t get_size_from_type(spirv_cross::SPIRType base_type, uint32_t rows, uint32_t cols)
+			//! Maps a vertex shader input onto the geometry attribute that feeds it (see ShaderModule::get_vertex_format()).
+			geom::VertexAttribute to_vertex_attribute(const ShaderModule::StageInput& input)
+			{
+				const size_t name_count = sizeof(plume_input_names) / sizeof(plume_input_names[0]);
+
+				auto it = std::find(plume_input_names, plume_input_names + name_count, input.name);
+				if (it != plume_input_names + name_count)
+				{
+					return static_cast<geom::VertexAttribute>(it - plume_input_names);
+				}
+				if (input.layout_location < name_count)
+				{
+					return static_cast<geom::VertexAttribute>(input.layout_location);
+				}
+
+				throw std::runtime_error("Vertex shader input " + input.name + " at location " + std::to_string(input.layout_location) + " does not correspond to any geometry attribute");
+			}
+
+			//! Returns the number of elements in an array type (the product of every dimension), 0 if the type is
+			//! not an array, or ShaderModule::runtime_array_size if any dimension is unsized.
+			uint32_t get_array_size(const spirv_cross::CompilerGLSL& compiler, const spirv_cross::SPIRType& type)
+			{
+				if (type.array.empty())
+				{
+					return 0;
+				}
+
+				uint32_t array_size = 1;
+				for (size_t i = 0; i < type.array.size(); ++i)
+				{
+					// Arrays can also be sized by (specialization) constants.
+					const uint32_t dimension = type.array_size_literal[i] ? type.array[i] : compiler.get_constant(type.array[i]).scalar();
+					if (dimension == 0)
+					{
+						return ShaderModule::runtime_array_size;
+					}
+					array_size *= dimension;
+				}
+
+				return array_size;
+			}
+
+			uint32_t get_size_from_type(const spirv_cross::CompilerGLSL& compiler, const spirv_cross::SPIRType& type)
 			{
+				const uint32_t rows = type.vecsize;
+				const uint32_t cols = type.columns;
+
 				uint32_t size = 0;
-				switch (base_type.basetype)
+				switch (type.basetype)
 				{
 				case spirv_cross::SPIRType::Float:
 					size = rows * cols * sizeof(float);
@@ -86,15 +147,100 @@ namespace plume
 				case spirv_cross::SPIRType::SampledImage:
 					break;
 				case spirv_cross::SPIRType::Struct:
+					size = static_cast<uint32_t>(compiler.get_declared_struct_size(type));
 					break;
 				default:
 					// Unknown type
 					break;
 				}
 
-				return size;
+				const uint32_t array_size = get_array_size(compiler, type);
+				if (array_size == ShaderModule::runtime_array_size)
+				{
+					return 0;
+				}
+
+				return array_size ? size * array_size : size;
 			}
 
+			ShaderModule::BaseType to_base_type(const spirv_cross::SPIRType& type)
+			{
+				switch (type.basetype)
+				{
+				case spirv_cross::SPIRType::Boolean:
+					return ShaderModule::BaseType::BASE_TYPE_BOOL;
+				case spirv_cross::SPIRType::Int:
+					return ShaderModule::BaseType::BASE_TYPE_INT;
+				case spirv_cross::SPIRType::UInt:
+					return ShaderModule::BaseType::BASE_TYPE_UINT;
+				case spirv_cross::SPIRType::Int64:
+					return ShaderModule::BaseType::BASE_TYPE_INT64;
+				case spirv_cross::SPIRType::UInt64:
+					return ShaderModule::BaseType::BASE_TYPE_UINT64;
+				case spirv_cross::SPIRType::Float:
+					return ShaderModule::BaseType::BASE_TYPE_FLOAT;
+				case spirv_cross::SPIRType::Double:
+					return ShaderModule::BaseType::BASE_TYPE_DOUBLE;
+				case spirv_cross::SPIRType::Struct:
+					return ShaderModule::BaseType::BASE_TYPE_STRUCT;
+				default:
+					return ShaderModule::BaseType::BASE_TYPE_OTHER;
+				}
+			}
+
+			//! Appends the members of `type` (and, recursively, the members of any nested structs) to `members`.
+			void reflect_members(const spirv_cross::CompilerGLSL& compiler, const spirv_cross::SPIRType& type, uint32_t base_offset, const std::string& prefix, std::vector<ShaderModule::BlockMember>& members)
+			{
+				for (uint32_t i = 0; i < static_cast<uint32_t>(type.member_types.size()); ++i)
+				{
+					const auto& member_type = compiler.get_type(type.member_types[i]);
+
+					ShaderModule::BlockMember member;
+					member.name = prefix + compiler.get_member_name(type.self, i);
+					member.offset = base_offset + compiler.type_struct_member_offset(type, i);
+					member.base_type = to_base_type(member_type);
+					member.vector_size = member_type.vecsize;
+					member.columns = member_type.columns;
+					member.array_size = get_array_size(compiler, member_type);
+					member.size = member.array_size == ShaderModule::runtime_array_size ? 0 : static_cast<uint32_t>(compiler.get_declared_struct_member_size(type, i));
+					member.array_stride = member.array_size ? compiler.type_struct_member_array_stride(type, i) : 0;
+					member.matrix_stride = member_type.columns > 1 ? compiler.type_struct_member_matrix_stride(type, i) : 0;
+					member.is_row_major = compiler.has_member_decoration(type.self, i, spv::DecorationRowMajor);
+					members.push_back(member);
+
+					if (member_type.basetype == spirv_cross::SPIRType::Struct)
+					{
+						reflect_members(compiler, member_type, member.offset, member.name + ".", members);
+					}
+				}
+			}
+
+			const char reflection_magic[4] = { 'P', 'L', 'R', 'F' };
+
+			//! Bump this whenever the reflection data or the way that it is stored changes.
+			const uint32_t reflection_version = 3;
+
+			//! The header of a reflection cache entry, which is followed by the reflection data itself. Strings are
+			//! stored as a 32-bit length followed by the characters, and lists as a 32-bit count followed by the
+			//! elements.
+			struct ReflectionHeader
+			{
+				char magic[4];
+				uint32_t version;
+				uint64_t code_hash;					// Also covers the unstripped code for reflection (if any).
+				uint64_t code_size;					// In 32-bit words.
+				uint64_t reflection_nanoseconds;	// The time that spirv-cross took to produce the entry.
+			};
+
+			std::mutex reflection_cache_mutex;
+			std::string reflection_cache_directory;
+
+			std::atomic<uint64_t> reflection_cache_hits{ 0 };
+			std::atomic<uint64_t> reflection_cache_misses{ 0 };
+			std::atomic<uint64_t> total_reflection_nanoseconds{ 0 };
+			std::atomic<uint64_t> total_cache_load_nanoseconds{ 0 };
+			std::atomic<uint64_t> total_saved_nanoseconds{ 0 };
+
 			vk::ShaderStageFlagBits spv_to_vk_execution_mode(spv::ExecutionModel mode)
 			{
 				switch (mode)
@@ -119,35 +265,117 @@ namespace plume
 
 		} // anonymous
 
-		ShaderModule::ShaderModule(const Device& device, const fsys::FileResource& resource) :
+		const uint32_t ShaderModule::no_constant_id;
+		const uint32_t ShaderModule::runtime_array_size;
+
+		ShaderModule::ShaderModule(const Device& device, const uint8_t* code, size_t size, const std::vector<uint32_t>& reflection_code) :
 
 			m_device_ptr(&device)
 		{
-			auto shader_src = resource.contents;
-			if (shader_src.size() % 4)
+			if (size % 4)
 			{
 				throw std::runtime_error("Shader source code is an invalid size");
 			}
 
-			// Store the SPIR-V code for reflection.
-			auto p_code = reinterpret_cast<const uint32_t*>(shader_src.data());
-			m_shader_code = std::vector<uint32_t>(p_code, p_code + shader_src.size() / sizeof(uint32_t));
+			// Create the actual shader module directly from the caller's memory (which may be a file mapping).
+			auto p_code = reinterpret_cast<const uint32_t*>(code);
 
-			// Create the actual shader module.
 			vk::ShaderModuleCreateInfo shader_module_create_info;
-			shader_module_create_info.codeSize = shader_src.size();
+			shader_module_create_info.codeSize = size;
 			shader_module_create_info.pCode = p_code;
 
 			m_shader_module_handle = m_device_ptr->get_handle().createShaderModuleUnique(shader_module_create_info);
 
-			perform_reflection();
+			// Keep a copy of the SPIR-V code for `get_shader_code()` (the caller's memory may be a temporary file mapping).
+			m_shader_code = std::vector<uint32_t>(p_code, p_code + size / sizeof(uint32_t));
+
+			std::string cache_path;
+			{
+				std::lock_guard<std::mutex> lock(reflection_cache_mutex);
+				if (!reflection_cache_directory.empty())
+				{
+					cache_path = reflection_cache_directory;
+				}
+			}
+
+			using clock = std::chrono::high_resolution_clock;
+			const auto start = clock::now();
+			auto elapsed_nanoseconds = [&]() {
+				return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(clock::now() - start).count());
+			};
+
+			uint64_t code_hash = 0;
+			if (!cache_path.empty())
+			{
+				code_hash = utils::hash_bytes(code, size);
+
+				// Stripped code reflects without names, so entries reflected from the unstripped code must not be
+				// shared with (or served to) modules that only have the stripped code.
+				if (!reflection_code.empty())
+				{
+					code_hash = utils::hash_combine(code_hash, utils::hash_bytes(reflection_code.data(), reflection_code.size() * sizeof(uint32_t)));
+				}
+
+				char key_string[17];
+				snprintf(key_string, sizeof(key_string), "%016llx", static_cast<unsigned long long>(code_hash));
+				cache_path += "/" + std::string(key_string) + ".refl";
+
+				uint64_t reflection_nanoseconds;
+				if (load_reflection(cache_path, code_hash, reflection_nanoseconds))
+				{
+					const uint64_t load_nanoseconds = elapsed_nanoseconds();
+					++reflection_cache_hits;
+					total_cache_load_nanoseconds += load_nanoseconds;
+					total_saved_nanoseconds += reflection_nanoseconds - std::min(reflection_nanoseconds, load_nanoseconds);
+					return;
+				}
+			}
+
+			perform_reflection(reflection_code.empty() ? m_shader_code : reflection_code);
+
+			const uint64_t reflection_nanoseconds = elapsed_nanoseconds();
+			++reflection_cache_misses;
+			total_reflection_nanoseconds += reflection_nanoseconds;
+
+			if (!cache_path.empty())
+			{
+				save_reflection(cache_path, code_hash, reflection_nanoseconds);
+			}
 		}
 
-		void ShaderModule::perform_reflection()
+		void ShaderModule::set_reflection_cache_directory(const std::string& directory)
 		{
-			// Parse the shader resources.
-			spirv_cross::CompilerGLSL compiler_glsl(std::move(m_shader_code));
-		//	spirv_cross::CompilerGLSL compiler_glsl = spirv_cross::CompilerGLSL(m_shader_code);
+			std::string trimmed = directory;
+			while (trimmed.size() > 1 && (trimmed.back() == '/' || trimmed.back() == '\\'))
+			{
+				trimmed.pop_back();
+			}
+
+			if (!trimmed.empty())
+			{
+				fsys::ResourceManager::create_directories(trimmed);
+			}
+
+			std::lock_guard<std::mutex> lock(reflection_cache_mutex);
+			reflection_cache_directory = trimmed;
+		}
+
+		ShaderModule::ReflectionStatistics ShaderModule::get_reflection_statistics()
+		{
+			ReflectionStatistics statistics;
+			statistics.cache_hits = reflection_cache_hits.load();
+			statistics.cache_misses = reflection_cache_misses.load();
+			statistics.reflection_seconds = total_reflection_nanoseconds.load() * 1e-9;
+			statistics.cache_load_seconds = total_cache_load_nanoseconds.load() * 1e-9;
+			statistics.seconds_saved = total_saved_nanoseconds.load() * 1e-9;
+
+			return statistics;
+		}
+
+		void ShaderModule::perform_reflection(const std::vector<uint32_t>& code)
+		{
+			// Parse the shader resources. Note that spirv-cross makes its own copy of the SPIR-V words.
+			spirv_cross::CompilerGLSL compiler_glsl(code.data(), code.size());
 			spirv_cross::ShaderResources shader_resources = compiler_glsl.get_shader_resources();
 			m_shader_stage = spv_to_vk_execution_mode(compiler_glsl.get_execution_model());
 			m_entry_points = compiler_glsl.get_entry_points();
@@ -173,9 +401,12 @@ namespace plume
 
 					m_push_constants.emplace_back(push_constant);
 				}
+
+				resource_to_block(compiler_glsl, resource, BlockType::BLOCK_TYPE_PUSH_CONSTANT);
 			}
 
 			// Parse stage inputs.
+			const auto active_variables = compiler_glsl.get_active_interface_variables();
 			for (const auto& resource : shader_resources.stage_inputs)
 			{
 				auto type = compiler_glsl.get_type(resource.type_id);
@@ -183,17 +414,30 @@ namespace plume
 				StageInput input;
 				input.layout_location = compiler_glsl.get_decoration(resource.id, spv::Decoration::DecorationLocation);
 				input.name = resource.name;
-				input.size = get_size_from_type(type, type.vecsize, 1);
+				input.size = get_size_from_type(compiler_glsl, type);
+				input.is_read = active_variables.count(resource.id) > 0;
 
-				//std::cout << "Stage input - location: " << input.layout_location << ", name: " << input.name << ", size: " << input.size << " (rows: " << type.vecsize << ", cols: " << type.columns << ")\n";
 				m_stage_inputs.emplace_back(input);
 			}
+			std::sort(m_stage_inputs.begin(), m_stage_inputs.end(), [](const StageInput& a, const StageInput& b) {
+				return a.layout_location < b.layout_location;
+			});
 
 			// Stage outputs
 			for (const auto &resource : shader_resources.stage_outputs)
 			{
-				// TODO
+				auto type = compiler_glsl.get_type(resource.type_id);
+
+				StageOutput output;
+				output.layout_location = compiler_glsl.get_decoration(resource.id, spv::Decoration::DecorationLocation);
+				output.name = resource.name;
+				output.size = get_size_from_type(compiler_glsl, type);
+
+				m_stage_outputs.emplace_back(output);
 			}
+			std::sort(m_stage_outputs.begin(), m_stage_outputs.end(), [](const StageOutput& a, const StageOutput& b) {
+				return a.layout_location < b.layout_location;
+			});
 
 			// Sampled images
 			for (const auto &resource : shader_resources.sampled_images)
@@ -229,6 +473,7 @@ namespace plume
 			for (const auto &resource : shader_resources.storage_buffers)
 			{
 				resource_to_descriptor(compiler_glsl, resource, vk::DescriptorType::eStorageBuffer);
+				resource_to_block(compiler_glsl, resource, BlockType::BLOCK_TYPE_STORAGE_BUFFER);
 			}
 
 			// Storage images
@@ -241,17 +486,64 @@ namespace plume
 			for (const auto &resource : shader_resources.uniform_buffers)
 			{
 				resource_to_descriptor(compiler_glsl, resource, vk::DescriptorType::eUniformBuffer);
+				resource_to_block(compiler_glsl, resource, BlockType::BLOCK_TYPE_UNIFORM_BUFFER);
+			}
+
+			// Specialization constants (composites, like the built-in workgroup size, are skipped: their 
+			// components are listed separately)
+			for (const auto& constant : compiler_glsl.get_specialization_constants())
+			{
+				const auto& value = compiler_glsl.get_constant(constant.id);
+				const auto& type = compiler_glsl.get_type(value.constant_type);
+				if (type.vecsize > 1 || type.columns > 1)
+				{
+					continue;
+				}
+
+				SpecializationConstant specialization_constant;
+				specialization_constant.constant_id = constant.constant_id;
+				specialization_constant.name = compiler_glsl.get_name(constant.id);
+				specialization_constant.base_type = to_base_type(type);
+				specialization_constant.size = type.width == 64 ? 8 : 4;
+				specialization_constant.default_value = type.width == 64 ? value.scalar_u64() : value.scalar();
+
+				m_specialization_constants.push_back(specialization_constant);
+			}
+			std::sort(m_specialization_constants.begin(), m_specialization_constants.end(), [](const SpecializationConstant& a, const SpecializationConstant& b) {
+				return a.constant_id < b.constant_id;
+			});
+
+			// Workgroup size
+			m_workgroup_size = { 1, 1, 1, { no_constant_id, no_constant_id, no_constant_id } };
+			if (m_shader_stage == vk::ShaderStageFlagBits::eCompute)
+			{
+				m_workgroup_size.x = compiler_glsl.get_execution_mode_argument(spv::ExecutionModeLocalSize, 0);
+				m_workgroup_size.y = compiler_glsl.get_execution_mode_argument(spv::ExecutionModeLocalSize, 1);
+				m_workgroup_size.z = compiler_glsl.get_execution_mode_argument(spv::ExecutionModeLocalSize, 2);
+
+				spirv_cross::SpecializationConstant x, y, z;
+				compiler_glsl.get_work_group_size_specialization_constants(x, y, z);
+
+				const spirv_cross::SpecializationConstant* dimensions[] = { &x, &y, &z };
+				for (size_t i = 0; i < 3; ++i)
+				{
+					if (uint32_t(dimensions[i]->id) != 0)
+					{
+						m_workgroup_size.constant_ids[i] = dimensions[i]->constant_id;
+					}
+				}
 			}
 		}
 
 		void ShaderModule::resource_to_descriptor(const spirv_cross::CompilerGLSL& compiler, const spirv_cross::Resource& resource, vk::DescriptorType descriptor_type)
 		{
-			// TODO: parse the descriptor count (array size)
+			// Arrays of descriptors take one descriptor per element (unsized arrays are given a single descriptor)
 			auto full_type = compiler.get_type(resource.type_id);
+			const uint32_t array_size = get_array_size(compiler, full_type);
 
 			vk::DescriptorSetLayoutBinding descriptor_set_layout_binding;
 			descriptor_set_layout_binding.binding = compiler.get_decoration(resource.id, spv::Decoration::DecorationBinding);
-			descriptor_set_layout_binding.descriptorCount = 1;
+			descriptor_set_layout_binding.descriptorCount = (array_size == 0 || array_size == runtime_array_size) ? 1 : array_size;
 			descriptor_set_layout_binding.descriptorType = descriptor_type;
 			descriptor_set_layout_binding.pImmutableSamplers = nullptr;
 			descriptor_set_layout_binding.stageFlags = vk::ShaderStageFlagBits::eAll; // TODO: for now, use `all` to prevent error messages - should be: m_shader_stage;
@@ -264,6 +556,387 @@ namespace plume
 			m_descriptors.push_back(descriptor);
 		}
 
+		void ShaderModule::resource_to_block(const spirv_cross::CompilerGLSL& compiler, const spirv_cross::Resource& resource, BlockType block_type)
+		{
+			const auto& type = compiler.get_type(resource.base_type_id);
+
+			BlockLayout block;
+			block.name = resource.name;
+			block.block_type = block_type;
+			block.layout_set = 0;
+			block.layout_binding = 0;
+			if (block_type != BlockType::BLOCK_TYPE_PUSH_CONSTANT)
+			{
+				block.layout_set = compiler.get_decoration(resource.id, spv::Decoration::DecorationDescriptorSet);
+				block.layout_binding = compiler.get_decoration(resource.id, spv::Decoration::DecorationBinding);
+			}
+			block.size = static_cast<uint32_t>(compiler.get_declared_struct_size(type));
+			reflect_members(compiler, type, 0, "", block.members);
+
+			m_blocks.push_back(block);
+		}
+
+		const ShaderModule::BlockMember* ShaderModule::BlockLayout::find_member(const std::string& name) const
+		{
+			auto it = std::find_if(members.begin(), members.end(), [&](const BlockMember& member) { return member.name == name; });
+			return it == members.end() ? nullptr : &(*it);
+		}
+
+		geom::VertexFormat ShaderModule::get_vertex_format() const
+		{
+			if (m_shader_stage != vk::ShaderStageFlagBits::eVertex)
+			{
+				throw std::runtime_error("Only vertex shaders have a vertex format");
+			}
+
+			// The inputs are sorted by location, which is the order that the attributes are packed in.
+			geom::VertexFormat format;
+			for (const auto& input : m_stage_inputs)
+			{
+				if (input.is_read)
+				{
+					format.attribute(input.layout_location, to_vertex_attribute(input));
+				}
+				else
+				{
+					format.unread_location(input.layout_location);
+				}
+			}
+
+			return format;
+		}
+
+		const ShaderModule::BlockLayout* ShaderModule::find_block(const std::string& name) const
+		{
+			auto it = std::find_if(m_blocks.begin(), m_blocks.end(), [&](const BlockLayout& block) { return block.name == name; });
+			return it == m_blocks.end() ? nullptr : &(*it);
+		}
+
+		const ShaderModule::BlockLayout* ShaderModule::get_push_constant_block() const
+		{
+			auto it = std::find_if(m_blocks.begin(), m_blocks.end(), [](const BlockLayout& block) { return block.block_type == BlockType::BLOCK_TYPE_PUSH_CONSTANT; });
+			return it == m_blocks.end() ? nullptr : &(*it);
+		}
+
+		const ShaderModule::BlockLayout* ShaderModule::get_frame_uniforms_block() const
+		{
+			auto is_frame_uniform = [](const BlockMember& member)
+			{
+				return std::find(std::begin(plume_uniform_names), std::end(plume_uniform_names), member.name) != std::end(plume_uniform_names);
+			};
+
+			auto it = std::find_if(m_blocks.begin(), m_blocks.end(), [&](const BlockLayout& block) 
+			{ 
+				return block.block_type == BlockType::BLOCK_TYPE_UNIFORM_BUFFER && std::any_of(block.members.begin(), block.members.end(), is_frame_uniform); 
+			});
+			return it == m_blocks.end() ? nullptr : &(*it);
+		}
+
+		const ShaderModule::SpecializationConstant* ShaderModule::find_specialization_constant(const std::string& name) const
+		{
+			auto it = std::find_if(m_specialization_constants.begin(), m_specialization_constants.end(), [&](const SpecializationConstant& constant) { return constant.name == name; });
+			return it == m_specialization_constants.end() ? nullptr : &(*it);
+		}
+
+		bool ShaderModule::load_reflection(const std::string& path, uint64_t code_hash, uint64_t& reflection_nanoseconds)
+		{
+			fsys::MappedFileResource mapped;
+			try
+			{
+				mapped = fsys::MappedFileResource{ path };
+			}
+			catch (const std::exception&)
+			{
+				return false;
+			}
+
+			const uint8_t* it = mapped.begin();
+			const uint8_t* const end = mapped.end();
+
+			ReflectionHeader header;
+			if (!consume(it, end, header) ||
+				memcmp(header.magic, reflection_magic, sizeof(reflection_magic)) != 0 ||
+				header.version != reflection_version ||
+				header.code_hash != code_hash ||
+				header.code_size != m_shader_code.size())
+			{
+				return false;
+			}
+			reflection_nanoseconds = header.reflection_nanoseconds;
+
+			auto parse = [&]() {
+				uint32_t stage, count;
+				if (!consume(it, end, stage))
+				{
+					return false;
+				}
+				m_shader_stage = static_cast<vk::ShaderStageFlagBits>(stage);
+
+				if (!consume_count(it, end, sizeof(uint32_t), count))
+				{
+					return false;
+				}
+				m_entry_points.resize(count);
+				for (auto& entry_point : m_entry_points)
+				{
+					if (!consume_string(it, end, entry_point))
+					{
+						return false;
+					}
+				}
+
+				if (!consume_count(it, end, sizeof(uint32_t) * 4, count))
+				{
+					return false;
+				}
+				m_push_constants.resize(count);
+				for (auto& push_constant : m_push_constants)
+				{
+					if (!consume(it, end, push_constant.index) ||
+						!consume(it, end, push_constant.size) ||
+						!consume(it, end, push_constant.offset) ||
+						!consume_string(it, end, push_constant.name))
+					{
+						return false;
+					}
+				}
+
+				if (!consume_count(it, end, sizeof(uint32_t) * 4, count))
+				{
+					return false;
+				}
+				m_stage_inputs.resize(count);
+				for (auto& input : m_stage_inputs)
+				{
+					uint32_t is_read;
+					if (!consume(it, end, input.layout_location) ||
+						!consume(it, end, input.size) ||
+						!consume_string(it, end, input.name) ||
+						!consume(it, end, is_read))
+					{
+						return false;
+					}
+					input.is_read = is_read != 0;
+				}
+
+				if (!consume_count(it, end, sizeof(uint32_t) * 3, count))
+				{
+					return false;
+				}
+				m_stage_outputs.resize(count);
+				for (auto& output : m_stage_outputs)
+				{
+					if (!consume(it, end, output.layout_location) ||
+						!consume(it, end, output.size) ||
+						!consume_string(it, end, output.name))
+					{
+						return false;
+					}
+				}
+
+				if (!consume_count(it, end, sizeof(uint32_t) * 6, count))
+				{
+					return false;
+				}
+				m_descriptors.resize(count);
+				for (auto& descriptor : m_descriptors)
+				{
+					uint32_t binding, descriptor_type, descriptor_count, stage_flags;
+					if (!consume(it, end, descriptor.layout_set) ||
+						!consume_string(it, end, descriptor.name) ||
+						!consume(it, end, binding) ||
+						!consume(it, end, descriptor_type) ||
+						!consume(it, end, descriptor_count) ||
+						!consume(it, end, stage_flags))
+					{
+						return false;
+					}
+					descriptor.layout_binding.binding = binding;
+					descriptor.layout_binding.descriptorType = static_cast<vk::DescriptorType>(descriptor_type);
+					descriptor.layout_binding.descriptorCount = descriptor_count;
+					descriptor.layout_binding.stageFlags = static_cast<vk::ShaderStageFlags>(stage_flags);
+					descriptor.layout_binding.pImmutableSamplers = nullptr;
+				}
+
+				if (!consume_count(it, end, sizeof(uint32_t) * 6, count))
+				{
+					return false;
+				}
+				m_blocks.resize(count);
+				for (auto& block : m_blocks)
+				{
+					uint32_t block_type, member_count;
+					if (!consume_string(it, end, block.name) ||
+						!consume(it, end, block_type) ||
+						!consume(it, end, block.layout_set) ||
+						!consume(it, end, block.layout_binding) ||
+						!consume(it, end, block.size) ||
+						!consume_count(it, end, sizeof(uint32_t) * 10, member_count))
+					{
+						return false;
+					}
+					block.block_type = static_cast<BlockType>(block_type);
+
+					block.members.resize(member_count);
+					for (auto& member : block.members)
+					{
+						uint32_t base_type, is_row_major;
+						if (!consume_string(it, end, member.name) ||
+							!consume(it, end, member.offset) ||
+							!consume(it, end, member.size) ||
+							!consume(it, end, base_type) ||
+							!consume(it, end, member.vector_size) ||
+							!consume(it, end, member.columns) ||
+							!consume(it, end, member.array_size) ||
+							!consume(it, end, member.array_stride) ||
+							!consume(it, end, member.matrix_stride) ||
+							!consume(it, end, is_row_major))
+						{
+							return false;
+						}
+						member.base_type = static_cast<BaseType>(base_type);
+						member.is_row_major = is_row_major != 0;
+					}
+				}
+
+				if (!consume_count(it, end, sizeof(uint32_t) * 4 + sizeof(uint64_t), count))
+				{
+					return false;
+				}
+				m_specialization_constants.resize(count);
+				for (auto& constant : m_specialization_constants)
+				{
+					uint32_t base_type;
+					if (!consume(it, end, constant.constant_id) ||
+						!consume_string(it, end, constant.name) ||
+						!consume(it, end, base_type) ||
+						!consume(it, end, constant.size) ||
+						!consume(it, end, constant.default_value))
+					{
+						return false;
+					}
+					constant.base_type = static_cast<BaseType>(base_type);
+				}
+
+				if (!consume(it, end, m_workgroup_size))
+				{
+					return false;
+				}
+
+				return it == end;
+			};
+
+			if (!parse())
+			{
+				m_entry_points.clear();
+				m_push_constants.clear();
+				m_stage_inputs.clear();
+				m_stage_outputs.clear();
+				m_descriptors.clear();
+				m_blocks.clear();
+				m_specialization_constants.clear();
+				return false;
+			}
+
+			return true;
+		}
+
+		void ShaderModule::save_reflection(const std::string& path, uint64_t code_hash, uint64_t reflection_nanoseconds) const
+		{
+			ReflectionHeader header;
+			memcpy(header.magic, reflection_magic, sizeof(reflection_magic));
+			header.version = reflection_version;
+			header.code_hash = code_hash;
+			header.code_size = m_shader_code.size();
+			header.reflection_nanoseconds = reflection_nanoseconds;
+
+			std::string buffer;
+			append(buffer, header);
+			append(buffer, static_cast<uint32_t>(m_shader_stage));
+
+			append(buffer, static_cast<uint32_t>(m_entry_points.size()));
+			for (const auto& entry_point : m_entry_points)
+			{
+				append_string(buffer, entry_point);
+			}
+
+			append(buffer, static_cast<uint32_t>(m_push_constants.size()));
+			for (const auto& push_constant : m_push_constants)
+			{
+				append(buffer, push_constant.index);
+				append(buffer, push_constant.size);
+				append(buffer, push_constant.offset);
+				append_string(buffer, push_constant.name);
+			}
+
+			append(buffer, static_cast<uint32_t>(m_stage_inputs.size()));
+			for (const auto& input : m_stage_inputs)
+			{
+				append(buffer, input.layout_location);
+				append(buffer, input.size);
+				append_string(buffer, input.name);
+				append(buffer, static_cast<uint32_t>(input.is_read));
+			}
+
+			append(buffer, static_cast<uint32_t>(m_stage_outputs.size()));
+			for (const auto& output : m_stage_outputs)
+			{
+				append(buffer, output.layout_location);
+				append(buffer, output.size);
+				append_string(buffer, output.name);
+			}
+
+			append(buffer, static_cast<uint32_t>(m_descriptors.size()));
+			for (const auto& descriptor : m_descriptors)
+			{
+				append(buffer, descriptor.layout_set);
+				append_string(buffer, descriptor.name);
+				append(buffer, descriptor.layout_binding.binding);
+				append(buffer, static_cast<uint32_t>(descriptor.layout_binding.descriptorType));
+				append(buffer, descriptor.layout_binding.descriptorCount);
+				append(buffer, static_cast<uint32_t>(descriptor.layout_binding.stageFlags));
+			}
+
+			append(buffer, static_cast<uint32_t>(m_blocks.size()));
+			for (const auto& block : m_blocks)
+			{
+				append_string(buffer, block.name);
+				append(buffer, static_cast<uint32_t>(block.block_type));
+				append(buffer, block.layout_set);
+				append(buffer, block.layout_binding);
+				append(buffer, block.size);
+
+				append(buffer, static_cast<uint32_t>(block.members.size()));
+				for (const auto& member : block.members)
+				{
+					append_string(buffer, member.name);
+					append(buffer, member.offset);
+					append(buffer, member.size);
+					append(buffer, static_cast<uint32_t>(member.base_type));
+					append(buffer, member.vector_size);
+					append(buffer, member.columns);
+					append(buffer, member.array_size);
+					append(buffer, member.array_stride);
+					append(buffer, member.matrix_stride);
+					append(buffer, static_cast<uint32_t>(member.is_row_major));
+				}
+			}
+
+			append(buffer, static_cast<uint32_t>(m_specialization_constants.size()));
+			for (const auto& constant : m_specialization_constants)
+			{
+				append(buffer, constant.constant_id);
+				append_string(buffer, constant.name);
+				append(buffer, static_cast<uint32_t>(constant.base_type));
+				append(buffer, constant.size);
+				append(buffer, constant.default_value);
+			}
+
+			append(buffer, m_workgroup_size);
+
+			fsys::ResourceManager::write_file_atomic(path, buffer.data(), buffer.size());
+		}
+
 	} // namespace graphics
 
 } // namespace plume
\ No newline at end of file
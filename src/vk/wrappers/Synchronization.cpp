@@ -26,6 +26,10 @@
 
 #include "Synchronization.h"
 
+#include <algorithm>
+
+#include "CommandBuffer.h"
+
 namespace plume
 {
 
@@ -60,6 +64,112 @@ namespace plume
 			m_event_handle = m_device_ptr->get_handle().createEventUnique({});
 		}
 
+		TimelineSemaphore::TimelineSemaphore(const Device& device, uint64_t initial_value) :
+
+			m_device_ptr(&device),
+			m_last_value(initial_value)
+		{
+			if (!m_device_ptr->supports_timeline_semaphores())
+			{
+				throw std::runtime_error("Timeline semaphores are not supported by this device: they require Vulkan 1.2 or VK_KHR_timeline_semaphore");
+			}
+
+			vk::SemaphoreTypeCreateInfo semaphore_type_create_info;
+			semaphore_type_create_info.semaphoreType = vk::SemaphoreType::eTimeline;
+			semaphore_type_create_info.initialValue = initial_value;
+
+			vk::SemaphoreCreateInfo semaphore_create_info;
+			semaphore_create_info.pNext = &semaphore_type_create_info;
+
+			m_semaphore_handle = m_device_ptr->get_handle().createSemaphoreUnique(semaphore_create_info);
+		}
+
+		uint64_t TimelineSemaphore::get_value() const
+		{
+			uint64_t value = 0;
+			const auto result = m_device_ptr->get_timeline_semaphore_functions().get_semaphore_counter_value(m_device_ptr->get_handle(), get_handle(), &value);
+			if (result != VK_SUCCESS)
+			{
+				throw std::runtime_error("Failed to query the value of a timeline semaphore: " + vk::to_string(static_cast<vk::Result>(result)));
+			}
+
+			return value;
+		}
+
+		void TimelineSemaphore::signal(uint64_t value)
+		{
+			vk::SemaphoreSignalInfo semaphore_signal_info;
+			semaphore_signal_info.semaphore = get_handle();
+			semaphore_signal_info.value = value;
+
+			const VkSemaphoreSignalInfo& info = semaphore_signal_info;
+			const auto result = m_device_ptr->get_timeline_semaphore_functions().signal_semaphore(m_device_ptr->get_handle(), &info);
+			if (result != VK_SUCCESS)
+			{
+				throw std::runtime_error("Failed to signal a timeline semaphore: " + vk::to_string(static_cast<vk::Result>(result)));
+			}
+
+			// Keep `advance()` from handing out points that the host has already passed.
+			m_last_value = std::max(m_last_value, value);
+		}
+
+		bool TimelineSemaphore::wait_for(uint64_t value, uint64_t timeout) const
+		{
+			auto semaphore_handle = get_handle();
+
+			vk::SemaphoreWaitInfo semaphore_wait_info;
+			semaphore_wait_info.semaphoreCount = 1;
+			semaphore_wait_info.pSemaphores = &semaphore_handle;
+			semaphore_wait_info.pValues = &value;
+
+			const VkSemaphoreWaitInfo& info = semaphore_wait_info;
+			const auto result = m_device_ptr->get_timeline_semaphore_functions().wait_semaphores(m_device_ptr->get_handle(), &info, timeout);
+			if (result != VK_SUCCESS && result != VK_TIMEOUT)
+			{
+				throw std::runtime_error("Failed to wait on a timeline semaphore: " + vk::to_string(static_cast<vk::Result>(result)));
+			}
+
+			return result == VK_SUCCESS;
+		}
+
+		Submission& Submission::command_buffer(const CommandBuffer& command_buffer)
+		{
+			m_command_buffers.push_back(command_buffer.get_handle());
+			return *this;
+		}
+
+		Submission& Submission::wait(const Semaphore& semaphore, vk::PipelineStageFlags stage_flags)
+		{
+			m_wait_semaphores.push_back(semaphore.get_handle());
+			m_wait_values.push_back(0);
+			m_wait_stage_flags.push_back(stage_flags);
+			return *this;
+		}
+
+		Submission& Submission::wait(const TimelineSemaphore& semaphore, uint64_t value, vk::PipelineStageFlags stage_flags)
+		{
+			m_wait_semaphores.push_back(semaphore.get_handle());
+			m_wait_values.push_back(value);
+			m_wait_stage_flags.push_back(stage_flags);
+			m_uses_timeline_semaphores = true;
+			return *this;
+		}
+
+		Submission& Submission::signal(const Semaphore& semaphore)
+		{
+			m_signal_semaphores.push_back(semaphore.get_handle());
+			m_signal_values.push_back(0);
+			return *this;
+		}
+
+		Submission& Submission::signal(const TimelineSemaphore& semaphore, uint64_t value)
+		{
+			m_signal_semaphores.push_back(semaphore.get_handle());
+			m_signal_values.push_back(value);
+			m_uses_timeline_semaphores = true;
+			return *this;
+		}
+
 	} // namespace graphics
 
 } // namespace plume
\ No newline at end of file